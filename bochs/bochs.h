@@ -121,6 +121,7 @@ class bx_list_c;
 // prototypes
 int  bx_begin_simulation(int argc, char *argv[]);
 void bx_stop_simulation();
+void bx_snapshot_process(void);
 char *bx_find_bochsrc(void);
 const char *get_builtin_variable(const char *varname);
 void get_bxshare_path(char *path);
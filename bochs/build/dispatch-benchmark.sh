@@ -0,0 +1,57 @@
+#!/bin/bash
+#
+# Builds Bochs with each of the instruction dispatch engines and runs the
+# same guest in benchmark mode with all of them:
+#
+#   default   - a call through the execute1 pointer of every instruction
+#   chaining  - --enable-handlers-chaining, handlers call the next one
+#   threaded  - --enable-threaded-dispatch, computed goto dispatch loop
+#
+# usage: build/dispatch-benchmark.sh <bochsrc> [millions of ticks] [configure options]
+#
+# Run from the top of the source tree. The bochsrc must boot without user
+# interaction, the builds are kept in dispatch-* and reused by later runs.
+
+if [ $# -lt 1 ]; then
+  echo "usage: $0 <bochsrc> [millions of ticks] [configure options]"
+  exit 1
+fi
+
+rc=`cd \`dirname $1\` && pwd`/`basename $1`
+ticks=${2:-500}
+shift; shift
+options="$@"
+top=`pwd`
+
+engines="default chaining threaded"
+
+for engine in $engines; do
+  case $engine in
+    default)  flags="" ;;
+    chaining) flags="--enable-handlers-chaining" ;;
+    threaded) flags="--enable-threaded-dispatch" ;;
+  esac
+  echo "*** Building the $engine dispatch in dispatch-$engine ***"
+  mkdir -p dispatch-$engine
+  if [ ! -f dispatch-$engine/Makefile ]; then
+    (cd dispatch-$engine && ../configure $options $flags > configure.log 2>&1) || {
+      echo "configure failed, see dispatch-$engine/configure.log"
+      exit 1
+    }
+  fi
+  make -C dispatch-$engine bochs > dispatch-$engine/make.log 2>&1 || {
+    echo "make failed, see dispatch-$engine/make.log"
+    exit 1
+  }
+done
+
+echo ""
+printf "%-10s %10s %10s\n" "dispatch" "seconds" "MIPS"
+for engine in $engines; do
+  start=`date +%s.%N`
+  (cd `dirname $rc` && \
+    echo c | $top/dispatch-$engine/bochs -q -f $rc -benchmark $ticks > $top/dispatch-$engine/run.log 2>&1)
+  end=`date +%s.%N`
+  echo "$start $end $ticks $engine" | \
+    awk '{ t = $2 - $1; printf "%-10s %10.2f %10.1f\n", $4, t, $3 / t }'
+done
@@ -1616,13 +1616,23 @@ void bx_dbg_tlb_lookup(bx_lin_address laddr)
 
   char cpu_param_name[16];
 
-  Bit32u index = cpu->ITLB.get_index_of(laddr);
-  sprintf(cpu_param_name, "ITLB.entry%d", index);
-  bx_dbg_show_param_command(cpu_param_name, 0);
+  bx_TLB_entry *tlbEntry = cpu->ITLB.find_entry_of(laddr);
+  if (tlbEntry) {
+    sprintf(cpu_param_name, "ITLB.entry%d", (int)(tlbEntry - cpu->ITLB.entry));
+    bx_dbg_show_param_command(cpu_param_name, 0);
+  }
+  else {
+    dbg_printf("linear page 0x" FMT_ADDRX " is not cached in ITLB\n", laddr);
+  }
 
-  index = cpu->DTLB.get_index_of(laddr);
-  sprintf(cpu_param_name, "DTLB.entry%d", index);
-  bx_dbg_show_param_command(cpu_param_name, 0);
+  tlbEntry = cpu->DTLB.find_entry_of(laddr);
+  if (tlbEntry) {
+    sprintf(cpu_param_name, "DTLB.entry%d", (int)(tlbEntry - cpu->DTLB.entry));
+    bx_dbg_show_param_command(cpu_param_name, 0);
+  }
+  else {
+    dbg_printf("linear page 0x" FMT_ADDRX " is not cached in DTLB\n", laddr);
+  }
 }
 
 unsigned dbg_show_mask = 0;
@@ -2210,6 +2220,9 @@ one_more:
       BX_TICKN(max_executed);
     }
 #endif
+
+    if (bx_pc_system.snapshot_request)
+      bx_snapshot_process();
   }
 
   sim_running->set(0);
@@ -204,6 +204,7 @@ void bx_dbg_info_symbols_command(const char *Symbol);
 int bx_dbg_lbreakpoint_symbol_command(const char *Symbol, const char *condition);
 bx_address bx_dbg_get_symbol_value(const char *Symbol);
 const char* bx_dbg_disasm_symbolic_address(bx_address eip, bx_address base);
+const char* bx_dbg_symbol_name(bx_address context, bx_address laddr);
 
 typedef enum {
   STOP_NO_REASON = 0,
@@ -64,6 +64,11 @@ const char* bx_dbg_disasm_symbolic_address(bx_address eip, bx_address base)
   return 0;
 }
 
+const char* bx_dbg_symbol_name(bx_address context, bx_address laddr)
+{
+  return 0;
+}
+
 #else   /* if BX_HAVE_MAP == 1 */
 
 #if BX_HAVE_MAP
@@ -179,9 +184,10 @@ symbol_entry_t* context_t::get_symbol_entry(bx_address ip)
     return 0;
   }
 
+  if (iter == m_syms.begin()) // ip is below the first symbol
+    return 0;
+
   --iter;
-  if(iter == m_syms.end())
-      return 0;
   return *iter;
 }
 
@@ -254,6 +260,22 @@ const char* bx_dbg_symbolic_address(bx_address context, bx_address xip, bx_addre
   return buf;
 }
 
+// name of the symbol containing laddr without the offset, used by the profiler
+const char* bx_dbg_symbol_name(bx_address context, bx_address laddr)
+{
+  context_t* cntx = context_t::get_context(context);
+  if (!cntx) {
+    // Try global context
+    cntx = context_t::get_context(0);
+    if (!cntx) return 0;
+  }
+
+  symbol_entry_t* entr = cntx->get_symbol_entry(laddr);
+  if (!entr) return 0;
+
+  return entr->name;
+}
+
 const char* bx_dbg_disasm_symbolic_address(bx_address xip, bx_address base)
 {
   static char buf[80];
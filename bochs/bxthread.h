@@ -38,11 +38,13 @@
 #define BX_INIT_MUTEX(mutex) InitializeCriticalSection(&(mutex))
 #define BX_FINI_MUTEX(mutex) DeleteCriticalSection(&(mutex))
 #define BX_MSLEEP(val) Sleep(val)
+#define BX_THREAD_YIELD() SwitchToThread()
 
 #else
 
 #include <pthread.h>
 #include <semaphore.h>
+#include <sched.h>
 
 #define BX_THREAD_VAR(name) pthread_t name
 #define BX_THREAD_FUNC(name,arg) void name(void* arg)
@@ -57,6 +59,42 @@
 #define BX_INIT_MUTEX(mutex) pthread_mutex_init(&(mutex),NULL)
 #define BX_FINI_MUTEX(mutex) pthread_mutex_destroy(&(mutex))
 #define BX_MSLEEP(val) usleep(val*1000)
+#define BX_THREAD_YIELD() sched_yield()
+
+#endif
+
+// Atomic operations on data shared between host threads. All of them are
+// full memory barriers. The compare-and-swap variants return true if the
+// memory contained the expected value and was updated.
+
+#if defined(_MSC_VER)
+
+#include <intrin.h>
+
+#define BX_ATOMIC_OR32(ptr, val) _InterlockedOr((volatile long*)(ptr), (long)(val))
+#define BX_ATOMIC_AND32(ptr, val) _InterlockedAnd((volatile long*)(ptr), (long)(val))
+#define BX_ATOMIC_CAS8(ptr, expected, val) \
+    (_InterlockedCompareExchange8((volatile char*)(ptr), (char)(val), (char)(expected)) == (char)(expected))
+#define BX_ATOMIC_CAS16(ptr, expected, val) \
+    (_InterlockedCompareExchange16((volatile short*)(ptr), (short)(val), (short)(expected)) == (short)(expected))
+#define BX_ATOMIC_CAS32(ptr, expected, val) \
+    (_InterlockedCompareExchange((volatile long*)(ptr), (long)(val), (long)(expected)) == (long)(expected))
+#define BX_ATOMIC_CAS64(ptr, expected, val) \
+    (_InterlockedCompareExchange64((volatile __int64*)(ptr), (__int64)(val), (__int64)(expected)) == (__int64)(expected))
+#define BX_ATOMIC_CASPTR(ptr, expected, val) \
+    (_InterlockedCompareExchangePointer((void* volatile*)(ptr), (void*)(val), (void*)(expected)) == (void*)(expected))
+#define BX_MEMORY_FENCE() MemoryBarrier()
+
+#else
+
+#define BX_ATOMIC_OR32(ptr, val) __sync_fetch_and_or((ptr), (val))
+#define BX_ATOMIC_AND32(ptr, val) __sync_fetch_and_and((ptr), (val))
+#define BX_ATOMIC_CAS8(ptr, expected, val) __sync_bool_compare_and_swap((ptr), (expected), (val))
+#define BX_ATOMIC_CAS16(ptr, expected, val) __sync_bool_compare_and_swap((ptr), (expected), (val))
+#define BX_ATOMIC_CAS32(ptr, expected, val) __sync_bool_compare_and_swap((ptr), (expected), (val))
+#define BX_ATOMIC_CAS64(ptr, expected, val) __sync_bool_compare_and_swap((ptr), (expected), (val))
+#define BX_ATOMIC_CASPTR(ptr, expected, val) __sync_bool_compare_and_swap((ptr), (expected), (val))
+#define BX_MEMORY_FENCE() __sync_synchronize()
 
 #endif
 
@@ -572,6 +572,18 @@ void bx_init_options()
       "dumpstats mode",
       "dump statistics period",
       0, BX_MAX_BIT32U, 0);
+  // periodic incremental checkpoints, set by command line arg
+  new bx_param_num_c(menu,
+      "checkpoint",
+      "checkpoint period",
+      "save a checkpoint every N millions of ticks",
+      0, BX_MAX_BIT32U, 0);
+  new bx_param_string_c(menu,
+    "checkpoint_path",
+    "Path to the checkpoints",
+    "Folder receiving the periodic checkpoints",
+    "",
+    BX_PATHNAME_LEN);
   // unlock disk images
   new bx_param_bool_c(menu,
       "unlock_images",
@@ -660,12 +672,26 @@ void bx_init_options()
       "Emulated instructions per second, used to calibrate bochs emulated time with wall clock time.",
       BX_MIN_IPS, BX_MAX_BIT32U,
       4000000);
+  new bx_param_num_c(cpu_param,
+      "trace_length", "Maximum trace length",
+      "Maximum amount of instructions in a trace cache entry",
+      1, BX_MAX_TRACE_LENGTH,
+      BX_DEFAULT_TRACE_LENGTH);
+  new bx_param_num_c(cpu_param,
+      "decode_ahead", "Traces decoded ahead on trace cache miss",
+      "Maximum amount of traces on the same page decoded ahead of execution on trace cache miss",
+      0, 64,
+      8);
 #if BX_SUPPORT_SMP
   new bx_param_num_c(cpu_param,
       "quantum", "Quantum ticks in SMP simulation",
       "Maximum amount of instructions allowed to execute before returning control to another CPU.",
       BX_SMP_QUANTUM_MIN, BX_SMP_QUANTUM_MAX,
       16);
+  new bx_param_bool_c(cpu_param,
+      "smp_threads", "Simulate each processor in its own host thread",
+      "Run the processors in parallel host threads in SMP simulation",
+      0);
 #endif
   new bx_param_bool_c(cpu_param,
       "reset_on_triple_fault", "Enable CPU reset on triple fault",
@@ -687,6 +713,38 @@ void bx_init_options()
       "Don't put CPU to sleep state by MWAIT",
       0);
 #endif
+#if BX_SUPPORT_JIT
+  new bx_param_bool_c(cpu_param,
+      "jit", "Compile hot traces to host code",
+      "Translate frequently executed traces to native host code",
+      0);
+  new bx_param_bool_c(cpu_param,
+      "jit_verify", "Check compiled traces against the interpreter",
+      "Replay every run of the native code through the instruction handlers and report differences",
+      0);
+#endif
+  new bx_param_filename_c(cpu_param,
+      "trace_cache_file",
+      "Trace cache file",
+      "Set path to the file keeping the decoded traces between runs (keep empty to disable)",
+      "", BX_PATHNAME_LEN);
+  new bx_param_filename_c(cpu_param,
+      "profile",
+      "Sampling profiler output file",
+      "Set path to the file receiving the samples of the guest RIP and the executed opcodes in collapsed stack format (keep empty to disable)",
+      "", BX_PATHNAME_LEN);
+  new bx_param_num_c(cpu_param,
+      "profile_interval", "Sampling profiler interval",
+      "Amount of emulated ticks between two samples of the sampling profiler",
+      100, BX_MAX_BIT32U,
+      10007);
+#if BX_ENABLE_STATISTICS
+  new bx_param_string_c(cpu_param,
+      "stats",
+      "CPU statistics groups",
+      "Set the CPU statistics collected at runtime, a colon separated list of icache, tlb, tlbflush, stack, smc, opcodes, traces, events, exceptions or 'all' (keep empty to disable)",
+      "", 128);
+#endif
 #if BX_CONFIGURE_MSRS
   new bx_param_filename_c(cpu_param,
       "msrs",
@@ -738,6 +796,49 @@ void bx_init_options()
       4, 8192,
       128);
   mem_block_size->set_ask_format("Enter memory block size (KB): [%d] ");
+  static const char *mem_backing_names[] = { "heap", "mmap", "file", NULL };
+  bx_param_enum_c *mem_backing = new bx_param_enum_c(ram,
+      "backing", "Guest RAM backing",
+      "Allocate guest RAM on the heap or map it from the host kernel (anonymous or file backed)",
+      mem_backing_names,
+      BX_MEM_BACKING_HEAP,
+      BX_MEM_BACKING_HEAP);
+  path = new bx_param_filename_c(ram,
+      "file",
+      "Guest RAM file",
+      "Pathname of the file guest RAM is mapped from",
+      "", BX_PATHNAME_LEN);
+  path->set_format("Name of guest RAM file: %s");
+  bx_param_bool_c *overwrite = new bx_param_bool_c(ram,
+      "overwrite", "Overwrite guest RAM file",
+      "Clear the guest RAM file even if it is not empty",
+      0);
+  bx_param_bool_c *hugepages = new bx_param_bool_c(ram,
+      "hugepages", "Use huge pages",
+      "Back mapped guest RAM with transparent huge pages",
+      0);
+  bx_param_bool_c *snapshots = new bx_param_bool_c(ram,
+      "snapshots", "Enable in-memory snapshots",
+      "Let the guest take in-memory snapshots, revert to them and fork clones",
+      0);
+  bx_param_num_c *clones = new bx_param_num_c(ram,
+      "clones",
+      "Maximum number of clones",
+      "Maximum number of forked clones running at the same time",
+      0, 256,
+      4);
+  clones->set_ask_format("Enter maximum number of clones: [%d] ");
+  deplist = new bx_list_c(NULL);
+  deplist->add(path);
+  deplist->add(hugepages);
+  deplist->add(snapshots);
+  deplist->add(overwrite);
+  mem_backing->set_dependent_list(deplist, 0);
+  mem_backing->set_dependent_bitmap(BX_MEM_BACKING_MMAP, 0x6);
+  mem_backing->set_dependent_bitmap(BX_MEM_BACKING_FILE, 0xf);
+  deplist = new bx_list_c(NULL);
+  deplist->add(clones);
+  snapshots->set_dependent_list(deplist);
   ram->set_options(ram->SERIES_ASK);
 
   path = new bx_param_filename_c(rom,
@@ -895,6 +996,10 @@ void bx_init_options()
   clock_sync->set_dependent_list(deplist, 0);
   clock_sync->set_dependent_bitmap(BX_CLOCK_SYNC_REALTIME, 1);
   clock_sync->set_dependent_bitmap(BX_CLOCK_SYNC_BOTH, 1);
+  new bx_param_bool_c(clock_cmos,
+      "idle_skip", "Skip idle time",
+      "If enabled, the time is advanced to the next timer event when all processors are halted",
+      0);
 
   bx_list_c *cmosimage = new bx_list_c(clock_cmos, "cmosimage", "CMOS Image Options");
   bx_param_bool_c *use_cmosimage = new bx_param_bool_c(cmosimage,
@@ -3051,6 +3156,9 @@ static int parse_line_formatted(const char *context, int num_params, char *param
       else if (!strncmp(params[i], "rtc_sync=", 9)) {
         SIM->get_param_bool(BXPN_CLOCK_RTC_SYNC)->set(atol(&params[i][9]));
       }
+      else if (!strncmp(params[i], "idle_skip=", 10)) {
+        SIM->get_param_bool(BXPN_CLOCK_IDLE_SKIP)->set(atol(&params[i][10]));
+      }
       else if (!strcmp(params[i], "time0=local")) {
         SIM->get_param_num(BXPN_CLOCK_TIME0)->set(BX_CLOCK_TIME0_LOCAL);
       }
@@ -3396,7 +3504,8 @@ int bx_write_clock_cmos_options(FILE *fp)
       fprintf(fp, ", time0=" FMT_LL "d", SIM->get_param_num(BXPN_CLOCK_TIME0)->get64());
   }
 
-  fprintf(fp, ", rtc_sync=%d\n", SIM->get_param_bool(BXPN_CLOCK_RTC_SYNC)->get());
+  fprintf(fp, ", rtc_sync=%d", SIM->get_param_bool(BXPN_CLOCK_RTC_SYNC)->get());
+  fprintf(fp, ", idle_skip=%d\n", SIM->get_param_bool(BXPN_CLOCK_IDLE_SKIP)->get());
 
   if (strlen(SIM->get_param_string(BXPN_CMOSIMAGE_PATH)->getptr()) > 0) {
     fprintf(fp, "cmosimage: file=%s, ", SIM->get_param_string(BXPN_CMOSIMAGE_PATH)->getptr());
@@ -3555,10 +3664,10 @@ int bx_write_configuration(const char *rc, int overwrite)
   }
   fprintf(fp, ", vbe_memsize=%s\n", SIM->get_param_enum(BXPN_VBE_MEMSIZE)->get_selected());
 #if BX_SUPPORT_SMP
-  fprintf(fp, "cpu: count=%u:%u:%u, ips=%u, quantum=%d, ",
+  fprintf(fp, "cpu: count=%u:%u:%u, ips=%u, quantum=%d, smp_threads=%d, ",
     SIM->get_param_num(BXPN_CPU_NPROCESSORS)->get(), SIM->get_param_num(BXPN_CPU_NCORES)->get(),
     SIM->get_param_num(BXPN_CPU_NTHREADS)->get(), SIM->get_param_num(BXPN_IPS)->get(),
-    SIM->get_param_num(BXPN_SMP_QUANTUM)->get());
+    SIM->get_param_num(BXPN_SMP_QUANTUM)->get(), SIM->get_param_bool(BXPN_SMP_THREADS)->get());
 #else
   fprintf(fp, "cpu: count=1, ips=%u, ", SIM->get_param_num(BXPN_IPS)->get());
 #endif
@@ -3566,12 +3675,31 @@ int bx_write_configuration(const char *rc, int overwrite)
     SIM->get_param_enum(BXPN_CPU_MODEL)->get_selected(),
     SIM->get_param_bool(BXPN_RESET_ON_TRIPLE_FAULT)->get(),
     SIM->get_param_bool(BXPN_CPUID_LIMIT_WINNT)->get());
+  fprintf(fp, ", trace_length=%d, decode_ahead=%d",
+    SIM->get_param_num(BXPN_CPU_TRACE_LENGTH)->get(),
+    SIM->get_param_num(BXPN_CPU_DECODE_AHEAD)->get());
 #if BX_CPU_LEVEL >= 5
   fprintf(fp, ", ignore_bad_msrs=%d", SIM->get_param_bool(BXPN_IGNORE_BAD_MSRS)->get());
 #endif
 #if BX_SUPPORT_MONITOR_MWAIT
   fprintf(fp, ", mwait_is_nop=%d", SIM->get_param_bool(BXPN_MWAIT_IS_NOP)->get());
 #endif
+#if BX_SUPPORT_JIT
+  fprintf(fp, ", jit=%d, jit_verify=%d", SIM->get_param_bool(BXPN_CPU_JIT)->get(),
+    SIM->get_param_bool(BXPN_CPU_JIT_VERIFY)->get());
+#endif
+  sparam = SIM->get_param_string(BXPN_CPU_TRACE_CACHE_FILE);
+  if (!sparam->isempty())
+    fprintf(fp, ", trace_cache_file=\"%s\"", sparam->getptr());
+  sparam = SIM->get_param_string(BXPN_CPU_PROFILE);
+  if (!sparam->isempty())
+    fprintf(fp, ", profile=\"%s\", profile_interval=%u", sparam->getptr(),
+      SIM->get_param_num(BXPN_CPU_PROFILE_INTERVAL)->get());
+#if BX_ENABLE_STATISTICS
+  sparam = SIM->get_param_string(BXPN_CPU_STATS);
+  if (!sparam->isempty())
+    fprintf(fp, ", stats=%s", sparam->getptr());
+#endif
 #if BX_CONFIGURE_MSRS
   sparam = SIM->get_param_string(BXPN_CONFIGURABLE_MSRS_PATH);
   if (!sparam->isempty())
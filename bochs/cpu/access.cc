@@ -353,7 +353,7 @@ int BX_CPU_C::access_read_linear(bx_address laddr, unsigned len, unsigned curr_p
   }
 #endif
 
-  bx_TLB_entry *tlbEntry = BX_DTLB_ENTRY_OF(laddr, 0);
+  bx_TLB_entry *tlbEntry = BX_DTLB_FILL_ENTRY_OF(laddr, 0);
 
   /* check for reference across multiple pages */
   if ((pageOffset + len) <= 4096) {
@@ -386,7 +386,7 @@ int BX_CPU_C::access_read_linear(bx_address laddr, unsigned len, unsigned curr_p
     }
 #endif
 
-    bx_TLB_entry *tlbEntry2 = BX_DTLB_ENTRY_OF(laddr2, 0);
+    bx_TLB_entry *tlbEntry2 = BX_DTLB_FILL_ENTRY_OF(laddr2, 0);
 
     BX_CPU_THIS_PTR address_xlation.paddress1 = translate_linear(tlbEntry, laddr, user, xlate_rw);
     BX_CPU_THIS_PTR address_xlation.paddress2 = translate_linear(tlbEntry2, laddr2, user, xlate_rw);
@@ -458,7 +458,7 @@ int BX_CPU_C::access_write_linear(bx_address laddr, unsigned len, unsigned curr_
   }
 #endif
 
-  bx_TLB_entry *tlbEntry = BX_DTLB_ENTRY_OF(laddr, 0);
+  bx_TLB_entry *tlbEntry = BX_DTLB_FILL_ENTRY_OF(laddr, 0);
 
   /* check for reference across multiple pages */
   if ((pageOffset + len) <= 4096) {
@@ -494,7 +494,7 @@ int BX_CPU_C::access_write_linear(bx_address laddr, unsigned len, unsigned curr_
     }
 #endif
 
-    bx_TLB_entry *tlbEntry2 = BX_DTLB_ENTRY_OF(laddr2, 0);
+    bx_TLB_entry *tlbEntry2 = BX_DTLB_FILL_ENTRY_OF(laddr2, 0);
 
     BX_CPU_THIS_PTR address_xlation.paddress1 = translate_linear(tlbEntry, laddr, user, xlate_rw);
     BX_CPU_THIS_PTR address_xlation.paddress2 = translate_linear(tlbEntry2, laddr2, user, xlate_rw);
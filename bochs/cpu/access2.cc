@@ -322,6 +322,7 @@ BX_CPU_C::tickle_read_linear(unsigned s, bx_address laddr)
 #endif
 
   // Access within single page
+  tlbEntry = BX_DTLB_FILL_ENTRY_OF(laddr, 0);
   BX_CPU_THIS_PTR address_xlation.paddress1 = translate_linear(tlbEntry, laddr, USER_PL, BX_READ);
   BX_CPU_THIS_PTR address_xlation.pages     = 1;
 #if BX_SUPPORT_MEMTYPE
@@ -600,6 +601,24 @@ BX_CPU_C::read_linear_zmmword_aligned(unsigned s, bx_address laddr, BxPackedZmmR
 
 #endif
 
+#if BX_SUPPORT_SMP
+  // host thread SMP simulation makes read-modify-write instructions atomic,
+  // see smpthreads.h
+  #define BX_SMP_BEGIN_RMW(data) \
+    if (bx_smp_threads_running) smp_begin_RMW(data)
+  #define BX_SMP_LOCK_RMW() \
+    if (bx_smp_threads_running) smp_lock_RMW()
+  #define BX_SMP_LOCKED_RMW_READ(data, len) \
+    if (bx_smp_threads_running) smp_locked_RMW_read(data, len)
+  #define BX_SMP_UNLOCK_RMW() \
+    if (BX_CPU_THIS_PTR smp_rmw.bus_locked) smp_unlock_RMW()
+#else
+  #define BX_SMP_BEGIN_RMW(data)
+  #define BX_SMP_LOCK_RMW()
+  #define BX_SMP_LOCKED_RMW_READ(data, len)
+  #define BX_SMP_UNLOCK_RMW()
+#endif
+
 //////////////////////////////////////////////////////////////
 // special Read-Modify-Write operations                     //
 // address translation info is kept across read/write calls //
@@ -620,6 +639,7 @@ BX_CPU_C::read_RMW_linear_byte(unsigned s, bx_address laddr)
       Bit8u *hostAddr = (Bit8u*) (hostPageAddr | pageOffset);
       pageWriteStampTable.decWriteStamp(pAddr, 1);
       data = *hostAddr;
+      BX_SMP_BEGIN_RMW(data);
       BX_CPU_THIS_PTR address_xlation.pages = (bx_ptr_equiv_t) hostAddr;
       BX_CPU_THIS_PTR address_xlation.paddress1 = pAddr;
 #if BX_SUPPORT_MEMTYPE
@@ -630,8 +650,10 @@ BX_CPU_C::read_RMW_linear_byte(unsigned s, bx_address laddr)
     }
   }
 
+  BX_SMP_LOCK_RMW();
   if (access_read_linear(laddr, 1, CPL, BX_RW, 0x0, (void *) &data) < 0)
     exception(int_number(s), 0);
+  BX_SMP_LOCKED_RMW_READ(data, 1);
 
   return data;
 }
@@ -655,6 +677,7 @@ BX_CPU_C::read_RMW_linear_word(unsigned s, bx_address laddr)
       Bit16u *hostAddr = (Bit16u*) (hostPageAddr | pageOffset);
       pageWriteStampTable.decWriteStamp(pAddr, 2);
       data = ReadHostWordFromLittleEndian(hostAddr);
+      BX_SMP_BEGIN_RMW(data);
       BX_CPU_THIS_PTR address_xlation.pages = (bx_ptr_equiv_t) hostAddr;
       BX_CPU_THIS_PTR address_xlation.paddress1 = pAddr;
 #if BX_SUPPORT_MEMTYPE
@@ -665,8 +688,10 @@ BX_CPU_C::read_RMW_linear_word(unsigned s, bx_address laddr)
     }
   }
 
+  BX_SMP_LOCK_RMW();
   if (access_read_linear(laddr, 2, CPL, BX_RW, 0x1, (void *) &data) < 0)
     exception(int_number(s), 0);
+  BX_SMP_LOCKED_RMW_READ(data, 2);
 
   return data;
 }
@@ -690,6 +715,7 @@ BX_CPU_C::read_RMW_linear_dword(unsigned s, bx_address laddr)
       Bit32u *hostAddr = (Bit32u*) (hostPageAddr | pageOffset);
       pageWriteStampTable.decWriteStamp(pAddr, 4);
       data = ReadHostDWordFromLittleEndian(hostAddr);
+      BX_SMP_BEGIN_RMW(data);
       BX_CPU_THIS_PTR address_xlation.pages = (bx_ptr_equiv_t) hostAddr;
       BX_CPU_THIS_PTR address_xlation.paddress1 = pAddr;
 #if BX_SUPPORT_MEMTYPE
@@ -700,8 +726,10 @@ BX_CPU_C::read_RMW_linear_dword(unsigned s, bx_address laddr)
     }
   }
 
+  BX_SMP_LOCK_RMW();
   if (access_read_linear(laddr, 4, CPL, BX_RW, 0x3, (void *) &data) < 0)
     exception(int_number(s), 0);
+  BX_SMP_LOCKED_RMW_READ(data, 4);
 
   return data;
 }
@@ -725,6 +753,7 @@ BX_CPU_C::read_RMW_linear_qword(unsigned s, bx_address laddr)
       Bit64u *hostAddr = (Bit64u*) (hostPageAddr | pageOffset);
       pageWriteStampTable.decWriteStamp(pAddr, 8);
       data = ReadHostQWordFromLittleEndian(hostAddr);
+      BX_SMP_BEGIN_RMW(data);
       BX_CPU_THIS_PTR address_xlation.pages = (bx_ptr_equiv_t) hostAddr;
       BX_CPU_THIS_PTR address_xlation.paddress1 = pAddr;
 #if BX_SUPPORT_MEMTYPE
@@ -735,8 +764,10 @@ BX_CPU_C::read_RMW_linear_qword(unsigned s, bx_address laddr)
     }
   }
 
+  BX_SMP_LOCK_RMW();
   if (access_read_linear(laddr, 8, CPL, BX_RW, 0x7, (void *) &data) < 0)
     exception(int_number(s), 0);
+  BX_SMP_LOCKED_RMW_READ(data, 8);
 
   return data;
 }
@@ -750,12 +781,19 @@ BX_CPU_C::write_RMW_linear_byte(Bit8u val8)
   if (BX_CPU_THIS_PTR address_xlation.pages > 2) {
     // Pages > 2 means it stores a host address for direct access.
     Bit8u *hostAddr = (Bit8u *) BX_CPU_THIS_PTR address_xlation.pages;
+#if BX_SUPPORT_SMP
+    if (BX_CPU_THIS_PTR smp_rmw.atomic)
+      smp_commit_RMW(hostAddr, val8, 1);
+    else
+#endif
     *hostAddr = val8;
   }
   else {
     // address_xlation.pages must be 1
     access_write_physical(BX_CPU_THIS_PTR address_xlation.paddress1, 1, &val8);
   }
+
+  BX_SMP_UNLOCK_RMW();
 }
 
   void BX_CPP_AttrRegparmN(1)
@@ -764,6 +802,11 @@ BX_CPU_C::write_RMW_linear_word(Bit16u val16)
   if (BX_CPU_THIS_PTR address_xlation.pages > 2) {
     // Pages > 2 means it stores a host address for direct access.
     Bit16u *hostAddr = (Bit16u *) BX_CPU_THIS_PTR address_xlation.pages;
+#if BX_SUPPORT_SMP
+    if (BX_CPU_THIS_PTR smp_rmw.atomic)
+      smp_commit_RMW(hostAddr, val16, 2);
+    else
+#endif
     WriteHostWordToLittleEndian(hostAddr, val16);
     BX_DBG_PHY_MEMORY_ACCESS(BX_CPU_ID,
         BX_CPU_THIS_PTR address_xlation.paddress1, 2, MEMTYPE(BX_CPU_THIS_PTR address_xlation.memtype1),
@@ -796,6 +839,8 @@ BX_CPU_C::write_RMW_linear_word(Bit16u val16)
         BX_WRITE, 0,  (Bit8u*) &val16);
 #endif
   }
+
+  BX_SMP_UNLOCK_RMW();
 }
 
   void BX_CPP_AttrRegparmN(1)
@@ -804,6 +849,11 @@ BX_CPU_C::write_RMW_linear_dword(Bit32u val32)
   if (BX_CPU_THIS_PTR address_xlation.pages > 2) {
     // Pages > 2 means it stores a host address for direct access.
     Bit32u *hostAddr = (Bit32u *) BX_CPU_THIS_PTR address_xlation.pages;
+#if BX_SUPPORT_SMP
+    if (BX_CPU_THIS_PTR smp_rmw.atomic)
+      smp_commit_RMW(hostAddr, val32, 4);
+    else
+#endif
     WriteHostDWordToLittleEndian(hostAddr, val32);
     BX_DBG_PHY_MEMORY_ACCESS(BX_CPU_ID,
         BX_CPU_THIS_PTR address_xlation.paddress1, 4, MEMTYPE(BX_CPU_THIS_PTR address_xlation.memtype1),
@@ -846,6 +896,8 @@ BX_CPU_C::write_RMW_linear_dword(Bit32u val32)
         BX_WRITE, 0, (Bit8u*) &val32);
 #endif
   }
+
+  BX_SMP_UNLOCK_RMW();
 }
 
   void BX_CPP_AttrRegparmN(1)
@@ -854,6 +906,11 @@ BX_CPU_C::write_RMW_linear_qword(Bit64u val64)
   if (BX_CPU_THIS_PTR address_xlation.pages > 2) {
     // Pages > 2 means it stores a host address for direct access.
     Bit64u *hostAddr = (Bit64u *) BX_CPU_THIS_PTR address_xlation.pages;
+#if BX_SUPPORT_SMP
+    if (BX_CPU_THIS_PTR smp_rmw.atomic)
+      smp_commit_RMW(hostAddr, val64, 8);
+    else
+#endif
     WriteHostQWordToLittleEndian(hostAddr, val64);
     BX_DBG_PHY_MEMORY_ACCESS(BX_CPU_ID,
         BX_CPU_THIS_PTR address_xlation.paddress1, 8, MEMTYPE(BX_CPU_THIS_PTR address_xlation.memtype1),
@@ -896,6 +953,8 @@ BX_CPU_C::write_RMW_linear_qword(Bit64u val64)
         BX_WRITE, 0, (Bit8u*) &val64);
 #endif
   }
+
+  BX_SMP_UNLOCK_RMW();
 }
 
 #if BX_SUPPORT_X86_64
@@ -912,6 +971,8 @@ void BX_CPU_C::read_RMW_linear_dqword_aligned_64(unsigned s, bx_address laddr, B
       bx_phy_address pAddr = tlbEntry->ppf | pageOffset;
       Bit64u *hostAddr = (Bit64u*) (hostPageAddr | pageOffset);
       pageWriteStampTable.decWriteStamp(pAddr, 16);
+      // no host compare-and-swap for 16 byte operands, lock the bus
+      BX_SMP_LOCK_RMW();
       *lo = ReadHostQWordFromLittleEndian(hostAddr);
       *hi = ReadHostQWordFromLittleEndian(hostAddr + 1);
       BX_CPU_THIS_PTR address_xlation.pages = (bx_ptr_equiv_t) hostAddr;
@@ -931,6 +992,7 @@ void BX_CPU_C::read_RMW_linear_dqword_aligned_64(unsigned s, bx_address laddr, B
   }
 
   BxPackedXmmRegister data;
+  BX_SMP_LOCK_RMW();
   if (access_read_linear(laddr, 16, CPL, BX_RW, 0x0, (void *) &data) < 0)
     exception(int_number(s), 0);
 
@@ -940,7 +1002,15 @@ void BX_CPU_C::read_RMW_linear_dqword_aligned_64(unsigned s, bx_address laddr, B
 
 void BX_CPU_C::write_RMW_linear_dqword(Bit64u hi, Bit64u lo)
 {
+#if BX_SUPPORT_SMP
+  // keep the bus locked until both halves are written
+  bool bus_locked = BX_CPU_THIS_PTR smp_rmw.bus_locked;
+  BX_CPU_THIS_PTR smp_rmw.bus_locked = false;
   write_RMW_linear_qword(lo);
+  BX_CPU_THIS_PTR smp_rmw.bus_locked = bus_locked;
+#else
+  write_RMW_linear_qword(lo);
+#endif
 
   BX_CPU_THIS_PTR address_xlation.paddress1 += 8;
   if (BX_CPU_THIS_PTR address_xlation.pages > 2) {
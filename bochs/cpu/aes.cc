@@ -29,6 +29,7 @@
 #if BX_CPU_LEVEL >= 6
 
 #include "simd_int.h"
+#include "host_crypto.h"
 
 //
 // XMM - Byte Representation of a 128-bit AES State
@@ -289,12 +290,88 @@ BX_CPP_INLINE Bit32u AES_RotWord(Bit32u x)
   return (x >> 8) | (x << 24);
 }
 
+// AES round transformations, on the host AES-NI when available
+
+BX_CPP_INLINE void xmm_aesenc(BxPackedXmmRegister *state, const BxPackedXmmRegister *round_key)
+{
+#if BX_HOST_CRYPTO
+  if (bx_host_crypto.aes) {
+    host_aesenc(state, round_key);
+    return;
+  }
+#endif
+
+  AES_ShiftRows(*state);
+  AES_SubstituteBytes(*state);
+  AES_MixColumns(*state);
+
+  xmm_xorps(state, round_key);
+}
+
+BX_CPP_INLINE void xmm_aesenclast(BxPackedXmmRegister *state, const BxPackedXmmRegister *round_key)
+{
+#if BX_HOST_CRYPTO
+  if (bx_host_crypto.aes) {
+    host_aesenclast(state, round_key);
+    return;
+  }
+#endif
+
+  AES_ShiftRows(*state);
+  AES_SubstituteBytes(*state);
+
+  xmm_xorps(state, round_key);
+}
+
+BX_CPP_INLINE void xmm_aesdec(BxPackedXmmRegister *state, const BxPackedXmmRegister *round_key)
+{
+#if BX_HOST_CRYPTO
+  if (bx_host_crypto.aes) {
+    host_aesdec(state, round_key);
+    return;
+  }
+#endif
+
+  AES_InverseShiftRows(*state);
+  AES_InverseSubstituteBytes(*state);
+  AES_InverseMixColumns(*state);
+
+  xmm_xorps(state, round_key);
+}
+
+BX_CPP_INLINE void xmm_aesdeclast(BxPackedXmmRegister *state, const BxPackedXmmRegister *round_key)
+{
+#if BX_HOST_CRYPTO
+  if (bx_host_crypto.aes) {
+    host_aesdeclast(state, round_key);
+    return;
+  }
+#endif
+
+  AES_InverseShiftRows(*state);
+  AES_InverseSubstituteBytes(*state);
+
+  xmm_xorps(state, round_key);
+}
+
+BX_CPP_INLINE void xmm_aesimc(BxPackedXmmRegister *state)
+{
+#if BX_HOST_CRYPTO
+  if (bx_host_crypto.aes) {
+    host_aesimc(state);
+    return;
+  }
+#endif
+
+  AES_InverseMixColumns(*state);
+}
+
 /* 66 0F 38 DB */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::AESIMC_VdqWdqR(bxInstruction_c *i)
 {
   BxPackedXmmRegister op = BX_READ_XMM_REG(i->src());
 
-  AES_InverseMixColumns(op);
+  xmm_aesimc(&op);
 
   BX_WRITE_XMM_REGZ(i->dst(), op, i->getVL());
 
@@ -306,11 +383,7 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::AESENC_VdqWdqR(bxInstruction_c *i)
 {
   BxPackedXmmRegister op1 = BX_READ_XMM_REG(i->dst()), op2 = BX_READ_XMM_REG(i->src());
 
-  AES_ShiftRows(op1);
-  AES_SubstituteBytes(op1);
-  AES_MixColumns(op1);
-
-  xmm_xorps(&op1, &op2);
+  xmm_aesenc(&op1, &op2);
 
   BX_WRITE_XMM_REG(i->dst(), op1);
 
@@ -324,11 +397,7 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VAESENC_VdqHdqWdqR(bxInstruction_c *i)
   unsigned len = i->getVL();
 
   for (unsigned n=0; n < len; n++) {
-    AES_ShiftRows(op1.vmm128(n));
-    AES_SubstituteBytes(op1.vmm128(n));
-    AES_MixColumns(op1.vmm128(n));
-
-    xmm_xorps(&op1.vmm128(n), &op2.vmm128(n));
+    xmm_aesenc(&op1.vmm128(n), &op2.vmm128(n));
   }
 
   BX_WRITE_AVX_REGZ(i->dst(), op1, len);
@@ -342,10 +411,7 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::AESENCLAST_VdqWdqR(bxInstruction_c *i)
 {
   BxPackedXmmRegister op1 = BX_READ_XMM_REG(i->dst()), op2 = BX_READ_XMM_REG(i->src());
 
-  AES_ShiftRows(op1);
-  AES_SubstituteBytes(op1);
-
-  xmm_xorps(&op1, &op2);
+  xmm_aesenclast(&op1, &op2);
 
   BX_WRITE_XMM_REG(i->dst(), op1);
 
@@ -359,10 +425,7 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VAESENCLAST_VdqHdqWdqR(bxInstruction_c *i)
   unsigned len = i->getVL();
 
   for (unsigned n=0; n < len; n++) {
-    AES_ShiftRows(op1.vmm128(n));
-    AES_SubstituteBytes(op1.vmm128(n));
-
-    xmm_xorps(&op1.vmm128(n), &op2.vmm128(n));
+    xmm_aesenclast(&op1.vmm128(n), &op2.vmm128(n));
   }
 
   BX_WRITE_AVX_REGZ(i->dst(), op1, len);
@@ -376,11 +439,7 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::AESDEC_VdqWdqR(bxInstruction_c *i)
 {
   BxPackedXmmRegister op1 = BX_READ_XMM_REG(i->dst()), op2 = BX_READ_XMM_REG(i->src());
 
-  AES_InverseShiftRows(op1);
-  AES_InverseSubstituteBytes(op1);
-  AES_InverseMixColumns(op1);
-
-  xmm_xorps(&op1, &op2);
+  xmm_aesdec(&op1, &op2);
 
   BX_WRITE_XMM_REG(i->dst(), op1);
 
@@ -394,11 +453,7 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VAESDEC_VdqHdqWdqR(bxInstruction_c *i)
   unsigned len = i->getVL();
 
   for (unsigned n=0; n < len; n++) {
-    AES_InverseShiftRows(op1.vmm128(n));
-    AES_InverseSubstituteBytes(op1.vmm128(n));
-    AES_InverseMixColumns(op1.vmm128(n));
-
-    xmm_xorps(&op1.vmm128(n), &op2.vmm128(n));
+    xmm_aesdec(&op1.vmm128(n), &op2.vmm128(n));
   }
 
   BX_WRITE_AVX_REGZ(i->dst(), op1, len);
@@ -412,10 +467,7 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::AESDECLAST_VdqWdqR(bxInstruction_c *i)
 {
   BxPackedXmmRegister op1 = BX_READ_XMM_REG(i->dst()), op2 = BX_READ_XMM_REG(i->src());
 
-  AES_InverseShiftRows(op1);
-  AES_InverseSubstituteBytes(op1);
-
-  xmm_xorps(&op1, &op2);
+  xmm_aesdeclast(&op1, &op2);
 
   BX_WRITE_XMM_REG(i->dst(), op1);
 
@@ -429,10 +481,7 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VAESDECLAST_VdqHdqWdqR(bxInstruction_c *i)
   unsigned len = i->getVL();
 
   for (unsigned n=0; n < len; n++) {
-    AES_InverseShiftRows(op1.vmm128(n));
-    AES_InverseSubstituteBytes(op1.vmm128(n));
-
-    xmm_xorps(&op1.vmm128(n), &op2.vmm128(n));
+    xmm_aesdeclast(&op1.vmm128(n), &op2.vmm128(n));
   }
 
   BX_WRITE_AVX_REGZ(i->dst(), op1, len);
@@ -460,6 +509,13 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::AESKEYGENASSIST_VdqWdqIbR(bxInstruction_c
 
 BX_CPP_INLINE void xmm_pclmulqdq(BxPackedXmmRegister *r, Bit64u a, Bit64u b)
 {
+#if BX_HOST_CRYPTO
+  if (bx_host_crypto.pclmul) {
+    host_pclmulqdq(r, a, b);
+    return;
+  }
+#endif
+
   BxPackedXmmRegister tmp;
 
   tmp.xmm64u(0) = a;
@@ -519,4 +575,50 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VPCLMULQDQ_VdqHdqWdqIbR(bxInstruction_c *i
 }
 #endif
 
+#if BX_HOST_CRYPTO
+
+static void aesenc_test(BxPackedXmmRegister *dst, const BxPackedXmmRegister *src, const BxPackedXmmRegister *xmm0, Bit8u imm8)
+{
+  xmm_aesenc(dst, src);
+}
+
+static void aesenclast_test(BxPackedXmmRegister *dst, const BxPackedXmmRegister *src, const BxPackedXmmRegister *xmm0, Bit8u imm8)
+{
+  xmm_aesenclast(dst, src);
+}
+
+static void aesdec_test(BxPackedXmmRegister *dst, const BxPackedXmmRegister *src, const BxPackedXmmRegister *xmm0, Bit8u imm8)
+{
+  xmm_aesdec(dst, src);
+}
+
+static void aesdeclast_test(BxPackedXmmRegister *dst, const BxPackedXmmRegister *src, const BxPackedXmmRegister *xmm0, Bit8u imm8)
+{
+  xmm_aesdeclast(dst, src);
+}
+
+static void aesimc_test(BxPackedXmmRegister *dst, const BxPackedXmmRegister *src, const BxPackedXmmRegister *xmm0, Bit8u imm8)
+{
+  *dst = *src;
+  xmm_aesimc(dst);
+}
+
+static void pclmulqdq_test(BxPackedXmmRegister *dst, const BxPackedXmmRegister *src, const BxPackedXmmRegister *xmm0, Bit8u imm8)
+{
+  Bit64u a = dst->xmm64u(imm8 & 1), b = src->xmm64u((imm8 >> 4) & 1);
+  xmm_pclmulqdq(dst, a, b);
+}
+
+const bxHostCryptoTest_t bx_aes_host_crypto_tests[] = {
+  { "AESENC",     aesenc_test,     &bx_host_crypto.aes },
+  { "AESENCLAST", aesenclast_test, &bx_host_crypto.aes },
+  { "AESDEC",     aesdec_test,     &bx_host_crypto.aes },
+  { "AESDECLAST", aesdeclast_test, &bx_host_crypto.aes },
+  { "AESIMC",     aesimc_test,     &bx_host_crypto.aes },
+  { "PCLMULQDQ",  pclmulqdq_test,  &bx_host_crypto.pclmul },
+  { NULL, NULL, NULL }
+};
+
+#endif
+
 #endif
@@ -148,6 +148,7 @@ bool apic_bus_broadcast_interrupt(Bit8u vector, Bit8u delivery_mode, bool trig_m
 
 static void apic_bus_broadcast_eoi(Bit8u vector)
 {
+  BX_SMP_DEVICE_LOCK();
   DEV_ioapic_receive_eoi(vector);
 }
 
@@ -828,6 +829,26 @@ void bx_local_apic_c::service_local_apic(void)
 
 bool bx_local_apic_c::deliver(Bit8u vector, Bit8u delivery_mode, Bit8u trig_mode)
 {
+#if BX_SUPPORT_SMP
+  // the processor is simulated by another host thread, let it accept the
+  // interrupt on its own
+  if (bx_smp_is_remote_cpu(cpu->bx_cpuid)) {
+    switch(delivery_mode) {
+    case APIC_DM_FIXED:
+    case APIC_DM_LOWPRI:
+    case APIC_DM_SMI:
+    case APIC_DM_NMI:
+    case APIC_DM_INIT:
+    case APIC_DM_SIPI:
+    case APIC_DM_EXTINT:
+      cpu->smp_post_request(BX_SMP_REQ_APIC_DELIVER, vector | (delivery_mode << 8) | (trig_mode << 16));
+      return true;
+    default:
+      return false;
+    }
+  }
+#endif
+
   switch(delivery_mode) {
   case APIC_DM_FIXED:
   case APIC_DM_LOWPRI:
@@ -24,22 +24,32 @@
 #include "cpu.h"
 #define LOG_THIS BX_CPU_THIS_PTR
 
-void BX_CPP_AttrRegparmN(1) BX_CPU_C::INC_EdR(bxInstruction_c *i)
+template <bool deadFlags>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::INC_EdR_DF(bxInstruction_c *i)
 {
   Bit32u erx = ++BX_READ_32BIT_REG(i->dst());
-  SET_FLAGS_OSZAP_ADD_32(erx - 1, 0, erx);
   BX_CLEAR_64BIT_HIGH(i->dst());
 
-  BX_NEXT_INSTR(i);
+  BX_NEXT_INSTR_FLAGS(i, deadFlags, SET_FLAGS_OSZAP_ADD_32(erx - 1, 0, erx));
 }
 
-void BX_CPP_AttrRegparmN(1) BX_CPU_C::DEC_EdR(bxInstruction_c *i)
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::INC_EdR(bxInstruction_c *i)
+{
+  INC_EdR_DF<false>(i);
+}
+
+template <bool deadFlags>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::DEC_EdR_DF(bxInstruction_c *i)
 {
   Bit32u erx = --BX_READ_32BIT_REG(i->dst());
-  SET_FLAGS_OSZAP_SUB_32(erx + 1, 0, erx);
   BX_CLEAR_64BIT_HIGH(i->dst());
 
-  BX_NEXT_INSTR(i);
+  BX_NEXT_INSTR_FLAGS(i, deadFlags, SET_FLAGS_OSZAP_SUB_32(erx + 1, 0, erx));
+}
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::DEC_EdR(bxInstruction_c *i)
+{
+  DEC_EdR_DF<false>(i);
 }
 
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_EdGdM(bxInstruction_c *i)
@@ -58,7 +68,8 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_EdGdM(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
-void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_GdEdR(bxInstruction_c *i)
+template <bool deadFlags>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_GdEdR_DF(bxInstruction_c *i)
 {
   Bit32u op1_32, op2_32, sum_32;
 
@@ -68,9 +79,12 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_GdEdR(bxInstruction_c *i)
 
   BX_WRITE_32BIT_REGZ(i->dst(), sum_32);
 
-  SET_FLAGS_OSZAPC_ADD_32(op1_32, op2_32, sum_32);
+  BX_NEXT_INSTR_FLAGS(i, deadFlags, SET_FLAGS_OSZAPC_ADD_32(op1_32, op2_32, sum_32));
+}
 
-  BX_NEXT_INSTR(i);
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_GdEdR(bxInstruction_c *i)
+{
+  ADD_GdEdR_DF<false>(i);
 }
 
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_GdEdM(bxInstruction_c *i)
@@ -226,7 +240,8 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_EdGdM(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
-void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_GdEdR(bxInstruction_c *i)
+template <bool deadFlags>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_GdEdR_DF(bxInstruction_c *i)
 {
   Bit32u op1_32, op2_32, diff_32;
 
@@ -235,9 +250,12 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_GdEdR(bxInstruction_c *i)
   diff_32 = op1_32 - op2_32;
   BX_WRITE_32BIT_REGZ(i->dst(), diff_32);
 
-  SET_FLAGS_OSZAPC_SUB_32(op1_32, op2_32, diff_32);
+  BX_NEXT_INSTR_FLAGS(i, deadFlags, SET_FLAGS_OSZAPC_SUB_32(op1_32, op2_32, diff_32));
+}
 
-  BX_NEXT_INSTR(i);
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_GdEdR(bxInstruction_c *i)
+{
+  SUB_GdEdR_DF<false>(i);
 }
 
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_GdEdM(bxInstruction_c *i)
@@ -388,7 +406,8 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_EdIdM(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
-void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_EdIdR(bxInstruction_c *i)
+template <bool deadFlags>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_EdIdR_DF(bxInstruction_c *i)
 {
   Bit32u op1_32, op2_32, sum_32;
 
@@ -398,9 +417,12 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_EdIdR(bxInstruction_c *i)
 
   BX_WRITE_32BIT_REGZ(i->dst(), sum_32);
 
-  SET_FLAGS_OSZAPC_ADD_32(op1_32, op2_32, sum_32);
+  BX_NEXT_INSTR_FLAGS(i, deadFlags, SET_FLAGS_OSZAPC_ADD_32(op1_32, op2_32, sum_32));
+}
 
-  BX_NEXT_INSTR(i);
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_EdIdR(bxInstruction_c *i)
+{
+  ADD_EdIdR_DF<false>(i);
 }
 
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADC_EdIdM(bxInstruction_c *i)
@@ -446,7 +468,8 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_EdIdM(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
-void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_EdIdR(bxInstruction_c *i)
+template <bool deadFlags>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_EdIdR_DF(bxInstruction_c *i)
 {
   Bit32u op1_32, op2_32 = i->Id(), diff_32;
 
@@ -454,9 +477,12 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_EdIdR(bxInstruction_c *i)
   diff_32 = op1_32 - op2_32;
   BX_WRITE_32BIT_REGZ(i->dst(), diff_32);
 
-  SET_FLAGS_OSZAPC_SUB_32(op1_32, op2_32, diff_32);
+  BX_NEXT_INSTR_FLAGS(i, deadFlags, SET_FLAGS_OSZAPC_SUB_32(op1_32, op2_32, diff_32));
+}
 
-  BX_NEXT_INSTR(i);
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_EdIdR(bxInstruction_c *i)
+{
+  SUB_EdIdR_DF<false>(i);
 }
 
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMP_EdIdM(bxInstruction_c *i)
@@ -600,3 +626,13 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMPXCHG8B(bxInstruction_c *i)
 
   BX_NEXT_INSTR(i);
 }
+
+#if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS
+// no flags variants used for dead flags elimination (fusion.cc)
+template void BX_CPU_C::INC_EdR_DF<true>(bxInstruction_c *);
+template void BX_CPU_C::DEC_EdR_DF<true>(bxInstruction_c *);
+template void BX_CPU_C::ADD_GdEdR_DF<true>(bxInstruction_c *);
+template void BX_CPU_C::ADD_EdIdR_DF<true>(bxInstruction_c *);
+template void BX_CPU_C::SUB_GdEdR_DF<true>(bxInstruction_c *);
+template void BX_CPU_C::SUB_EdIdR_DF<true>(bxInstruction_c *);
+#endif
@@ -43,7 +43,8 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_EqGqM(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
-void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_GqEqR(bxInstruction_c *i)
+template <bool deadFlags>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_GqEqR_DF(bxInstruction_c *i)
 {
   Bit64u op1_64, op2_64, sum_64;
 
@@ -52,9 +53,12 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_GqEqR(bxInstruction_c *i)
   sum_64 = op1_64 + op2_64;
   BX_WRITE_64BIT_REG(i->dst(), sum_64);
 
-  SET_FLAGS_OSZAPC_ADD_64(op1_64, op2_64, sum_64);
+  BX_NEXT_INSTR_FLAGS(i, deadFlags, SET_FLAGS_OSZAPC_ADD_64(op1_64, op2_64, sum_64));
+}
 
-  BX_NEXT_INSTR(i);
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_GqEqR(bxInstruction_c *i)
+{
+  ADD_GqEqR_DF<false>(i);
 }
 
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_GqEqM(bxInstruction_c *i)
@@ -219,7 +223,8 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_EqGqM(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
-void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_GqEqR(bxInstruction_c *i)
+template <bool deadFlags>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_GqEqR_DF(bxInstruction_c *i)
 {
   Bit64u op1_64, op2_64, diff_64;
 
@@ -229,9 +234,12 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_GqEqR(bxInstruction_c *i)
 
   BX_WRITE_64BIT_REG(i->dst(), diff_64);
 
-  SET_FLAGS_OSZAPC_SUB_64(op1_64, op2_64, diff_64);
+  BX_NEXT_INSTR_FLAGS(i, deadFlags, SET_FLAGS_OSZAPC_SUB_64(op1_64, op2_64, diff_64));
+}
 
-  BX_NEXT_INSTR(i);
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_GqEqR(bxInstruction_c *i)
+{
+  SUB_GqEqR_DF<false>(i);
 }
 
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_GqEqM(bxInstruction_c *i)
@@ -383,7 +391,8 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_EqIdM(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
-void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_EqIdR(bxInstruction_c *i)
+template <bool deadFlags>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_EqIdR_DF(bxInstruction_c *i)
 {
   Bit64u op1_64, op2_64, sum_64;
 
@@ -392,9 +401,12 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_EqIdR(bxInstruction_c *i)
   sum_64 = op1_64 + op2_64;
   BX_WRITE_64BIT_REG(i->dst(), sum_64);
 
-  SET_FLAGS_OSZAPC_ADD_64(op1_64, op2_64, sum_64);
+  BX_NEXT_INSTR_FLAGS(i, deadFlags, SET_FLAGS_OSZAPC_ADD_64(op1_64, op2_64, sum_64));
+}
 
-  BX_NEXT_INSTR(i);
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_EqIdR(bxInstruction_c *i)
+{
+  ADD_EqIdR_DF<false>(i);
 }
 
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADC_EqIdM(bxInstruction_c *i)
@@ -445,7 +457,8 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_EqIdM(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
-void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_EqIdR(bxInstruction_c *i)
+template <bool deadFlags>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_EqIdR_DF(bxInstruction_c *i)
 {
   Bit64u op1_64, op2_64, diff_64;
 
@@ -454,9 +467,12 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_EqIdR(bxInstruction_c *i)
   diff_64 = op1_64 - op2_64;
   BX_WRITE_64BIT_REG(i->dst(), diff_64);
 
-  SET_FLAGS_OSZAPC_SUB_64(op1_64, op2_64, diff_64);
+  BX_NEXT_INSTR_FLAGS(i, deadFlags, SET_FLAGS_OSZAPC_SUB_64(op1_64, op2_64, diff_64));
+}
 
-  BX_NEXT_INSTR(i);
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_EqIdR(bxInstruction_c *i)
+{
+  SUB_EqIdR_DF<false>(i);
 }
 
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMP_EqIdM(bxInstruction_c *i)
@@ -524,12 +540,17 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::INC_EqM(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
-void BX_CPP_AttrRegparmN(1) BX_CPU_C::INC_EqR(bxInstruction_c *i)
+template <bool deadFlags>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::INC_EqR_DF(bxInstruction_c *i)
 {
   Bit64u rrx = ++BX_READ_64BIT_REG(i->dst());
-  SET_FLAGS_OSZAP_ADD_64(rrx - 1, 0, rrx);
 
-  BX_NEXT_INSTR(i);
+  BX_NEXT_INSTR_FLAGS(i, deadFlags, SET_FLAGS_OSZAP_ADD_64(rrx - 1, 0, rrx));
+}
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::INC_EqR(bxInstruction_c *i)
+{
+  INC_EqR_DF<false>(i);
 }
 
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::DEC_EqM(bxInstruction_c *i)
@@ -545,12 +566,17 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::DEC_EqM(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
-void BX_CPP_AttrRegparmN(1) BX_CPU_C::DEC_EqR(bxInstruction_c *i)
+template <bool deadFlags>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::DEC_EqR_DF(bxInstruction_c *i)
 {
   Bit64u rrx = --BX_READ_64BIT_REG(i->dst());
-  SET_FLAGS_OSZAP_SUB_64(rrx + 1, 0, rrx);
 
-  BX_NEXT_INSTR(i);
+  BX_NEXT_INSTR_FLAGS(i, deadFlags, SET_FLAGS_OSZAP_SUB_64(rrx + 1, 0, rrx));
+}
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::DEC_EqR(bxInstruction_c *i)
+{
+  DEC_EqR_DF<false>(i);
 }
 
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMPXCHG_EqGqM(bxInstruction_c *i)
@@ -619,4 +645,14 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMPXCHG16B(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+#if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS
+// no flags variants used for dead flags elimination (fusion.cc)
+template void BX_CPU_C::INC_EqR_DF<true>(bxInstruction_c *);
+template void BX_CPU_C::DEC_EqR_DF<true>(bxInstruction_c *);
+template void BX_CPU_C::ADD_GqEqR_DF<true>(bxInstruction_c *);
+template void BX_CPU_C::ADD_EqIdR_DF<true>(bxInstruction_c *);
+template void BX_CPU_C::SUB_GqEqR_DF<true>(bxInstruction_c *);
+template void BX_CPU_C::SUB_EqIdR_DF<true>(bxInstruction_c *);
+#endif
+
 #endif /* if BX_SUPPORT_X86_64 */
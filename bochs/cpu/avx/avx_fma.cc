@@ -47,7 +47,10 @@ extern softfloat_status_t mxcsr_to_softfloat_status_word(bx_mxcsr_t mxcsr);
                                                                               \
     softfloat_status_t status = mxcsr_to_softfloat_status_word(MXCSR);        \
     softfloat_status_word_rc_override(status, i);                             \
-    op1 = (func)(op1, op2, op3, &status);                                     \
+    if (host_fpu_ok(status, MXCSR))                                           \
+      op1 = host_f32_3op<func>(op1, op2, op3, &status);                       \
+    else                                                                      \
+      op1 = (func)(op1, op2, op3, &status);                                   \
     check_exceptionsSSE(softfloat_getExceptionFlags(&status));                \
                                                                               \
     BX_WRITE_XMM_REG_LO_DWORD(i->dst(), op1);                                 \
@@ -70,7 +73,10 @@ AVX2_FMA_SCALAR_SINGLE(VFNMSUBSS_VpsHssWssR, f32_fnmsub)
                                                                               \
     softfloat_status_t status = mxcsr_to_softfloat_status_word(MXCSR);        \
     softfloat_status_word_rc_override(status, i);                             \
-    op1 = (func)(op1, op2, op3, &status);                                     \
+    if (host_fpu_ok(status, MXCSR))                                           \
+      op1 = host_f64_3op<func>(op1, op2, op3, &status);                       \
+    else                                                                      \
+      op1 = (func)(op1, op2, op3, &status);                                   \
     check_exceptionsSSE(softfloat_getExceptionFlags(&status));                \
                                                                               \
     BX_WRITE_XMM_REG_LO_QWORD(i->dst(), op1);                                 \
@@ -176,7 +176,10 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VSQRTSS_VssHpsWssR(bxInstruction_c *i)
 
   softfloat_status_t status = mxcsr_to_softfloat_status_word(MXCSR);
   softfloat_status_word_rc_override(status, i);
-  op1.xmm32u(0) = f32_sqrt(op2, &status);
+  if (host_fpu_ok(status, MXCSR))
+    op1.xmm32u(0) = host_f32_1op<f32_sqrt>(op2, &status);
+  else
+    op1.xmm32u(0) = f32_sqrt(op2, &status);
   check_exceptionsSSE(softfloat_getExceptionFlags(&status));
 
   BX_WRITE_XMM_REG_CLEAR_HIGH(i->dst(), op1);
@@ -191,7 +194,10 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VSQRTSD_VsdHpdWsdR(bxInstruction_c *i)
 
   softfloat_status_t status = mxcsr_to_softfloat_status_word(MXCSR);
   softfloat_status_word_rc_override(status, i);
-  op1.xmm64u(0) = f64_sqrt(op2, &status);
+  if (host_fpu_ok(status, MXCSR))
+    op1.xmm64u(0) = host_f64_1op<f64_sqrt>(op2, &status);
+  else
+    op1.xmm64u(0) = f64_sqrt(op2, &status);
   check_exceptionsSSE(softfloat_getExceptionFlags(&status));
 
   BX_WRITE_XMM_REG_CLEAR_HIGH(i->dst(), op1);
@@ -259,7 +265,10 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VRCPSS_VssHpsWssR(bxInstruction_c *i)
     softfloat_status_t status = mxcsr_to_softfloat_status_word(MXCSR);                      \
     softfloat_status_word_rc_override(status, i);                                           \
                                                                                             \
-    op1.xmm32u(0) = (func)(op1.xmm32u(0), op2, &status);                                    \
+    if (host_fpu_ok(status, MXCSR))                                                         \
+      op1.xmm32u(0) = host_f32_2op<func>(op1.xmm32u(0), op2, &status);                      \
+    else                                                                                    \
+      op1.xmm32u(0) = (func)(op1.xmm32u(0), op2, &status);                                  \
                                                                                             \
     check_exceptionsSSE(softfloat_getExceptionFlags(&status));                              \
     BX_WRITE_XMM_REG_CLEAR_HIGH(i->dst(), op1);                                             \
@@ -286,7 +295,10 @@ AVX_SCALAR_SINGLE_FP(VSCALEFSS_VssHpsWssR, f32_scalef);
     softfloat_status_t status = mxcsr_to_softfloat_status_word(MXCSR);                      \
     softfloat_status_word_rc_override(status, i);                                           \
                                                                                             \
-    op1.xmm64u(0) = (func)(op1.xmm64u(0), op2, &status);                                    \
+    if (host_fpu_ok(status, MXCSR))                                                         \
+      op1.xmm64u(0) = host_f64_2op<func>(op1.xmm64u(0), op2, &status);                      \
+    else                                                                                    \
+      op1.xmm64u(0) = (func)(op1.xmm64u(0), op2, &status);                                  \
                                                                                             \
     check_exceptionsSSE(softfloat_getExceptionFlags(&status));                              \
     BX_WRITE_XMM_REG_CLEAR_HIGH(i->dst(), op1);                                             \
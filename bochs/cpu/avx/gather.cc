@@ -48,6 +48,118 @@ bx_address BX_CPP_AttrRegparmN(2) BX_CPU_C::BxResolveGatherQ(bxInstruction_c *i,
     return (Bit32u) (BX_READ_32BIT_REG(i->sibBase()) + (index << i->sibScale()) + i->displ32s());
 }
 
+// Gather and scatter elements are accessed one by one in element order, so
+// that a fault is reported for the first faulting element with all the
+// elements before it completed. Before that gatherTranslate looks up the
+// pages of all the active elements, consecutive elements in the same page
+// share the lookup: when all of them can be accessed directly in host memory
+// the elements are copied without going through the segment checks and the
+// TLB again one by one.
+struct bxGatherAccess {
+  bx_address laddr[16];
+  bx_TLB_entry *tlbEntry[16];
+};
+
+// Returns false when one of the elements selected by the mask needs the
+// regular memory access path (segment limit checks, TLB miss, access rights,
+// element crossing the page boundary), no memory has been accessed then.
+bool BX_CPU_C::gatherTranslate(bxInstruction_c *i, bool qwordIndex, unsigned len, Bit32u mask, unsigned num_elements, unsigned rw, bxGatherAccess *access)
+{
+  unsigned s = i->seg();
+  bool long64 = long64_mode();
+
+  if (! long64) {
+    // only flat segments do not need the limit checks
+    Bit32u flat = (rw == BX_READ) ? SegAccessROK4G : SegAccessWOK4G;
+    if (! (BX_CPU_THIS_PTR sregs[s].cache.valid & flat)) return false;
+  }
+
+  bx_address lastLpf = BX_INVALID_TLB_ENTRY;
+  bx_TLB_entry *tlbEntry = NULL;
+
+  for (unsigned n=0; n < num_elements; n++) {
+    if (! (mask & (1 << n))) continue;
+
+    bx_address laddr = qwordIndex ? BxResolveGatherQ(i, n) : BxResolveGatherD(i, n);
+#if BX_SUPPORT_X86_64
+    if (long64) laddr = get_laddr64(s, laddr);
+#endif
+
+    // elements crossing the page boundary take the regular path
+    if (PAGE_OFFSET(laddr) > (0x1000 - len)) return false;
+
+    // the following element is often in the same page
+    bx_address lpf = LPFOf(laddr);
+    if (lpf != lastLpf) {
+      // the lookup does not reorder the TLB set, so the entries found for
+      // the previous elements stay in place; non canonical addresses never
+      // match a TLB entry
+      tlbEntry = BX_CPU_THIS_PTR DTLB.find_entry_of(lpf);
+      if (! tlbEntry) return false;
+
+      if (rw == BX_READ) {
+        if (! isReadOK(tlbEntry, USER_PL)) return false;
+      }
+      else {
+        if (! isWriteOK(tlbEntry, USER_PL)) return false;
+      }
+
+      lastLpf = lpf;
+    }
+
+    access->laddr[n] = laddr;
+    access->tlbEntry[n] = tlbEntry;
+  }
+
+  return true;
+}
+
+BX_CPP_INLINE Bit32u BX_CPU_C::gather_host_read_dword(const bxGatherAccess *access, unsigned n)
+{
+  bx_address laddr = access->laddr[n];
+  bx_TLB_entry *tlbEntry = access->tlbEntry[n];
+  Bit32u pageOffset = PAGE_OFFSET(laddr);
+  Bit32u data = ReadHostDWordFromLittleEndian((Bit32u*) (tlbEntry->hostPageAddr | pageOffset));
+  BX_NOTIFY_LIN_MEMORY_ACCESS(laddr, (tlbEntry->ppf | pageOffset), 4, tlbEntry->get_memtype(), BX_READ, (Bit8u*) &data);
+  return data;
+}
+
+BX_CPP_INLINE Bit64u BX_CPU_C::gather_host_read_qword(const bxGatherAccess *access, unsigned n)
+{
+  bx_address laddr = access->laddr[n];
+  bx_TLB_entry *tlbEntry = access->tlbEntry[n];
+  Bit32u pageOffset = PAGE_OFFSET(laddr);
+  Bit64u data = ReadHostQWordFromLittleEndian((Bit64u*) (tlbEntry->hostPageAddr | pageOffset));
+  BX_NOTIFY_LIN_MEMORY_ACCESS(laddr, (tlbEntry->ppf | pageOffset), 8, tlbEntry->get_memtype(), BX_READ, (Bit8u*) &data);
+  return data;
+}
+
+#if BX_SUPPORT_EVEX
+
+BX_CPP_INLINE void BX_CPU_C::scatter_host_write_dword(const bxGatherAccess *access, unsigned n, Bit32u data)
+{
+  bx_address laddr = access->laddr[n];
+  bx_TLB_entry *tlbEntry = access->tlbEntry[n];
+  Bit32u pageOffset = PAGE_OFFSET(laddr);
+  bx_phy_address pAddr = tlbEntry->ppf | pageOffset;
+  BX_NOTIFY_LIN_MEMORY_ACCESS(laddr, pAddr, 4, tlbEntry->get_memtype(), BX_WRITE, (Bit8u*) &data);
+  pageWriteStampTable.decWriteStamp(pAddr, 4);
+  WriteHostDWordToLittleEndian((Bit32u*) (tlbEntry->hostPageAddr | pageOffset), data);
+}
+
+BX_CPP_INLINE void BX_CPU_C::scatter_host_write_qword(const bxGatherAccess *access, unsigned n, Bit64u data)
+{
+  bx_address laddr = access->laddr[n];
+  bx_TLB_entry *tlbEntry = access->tlbEntry[n];
+  Bit32u pageOffset = PAGE_OFFSET(laddr);
+  bx_phy_address pAddr = tlbEntry->ppf | pageOffset;
+  BX_NOTIFY_LIN_MEMORY_ACCESS(laddr, pAddr, 8, tlbEntry->get_memtype(), BX_WRITE, (Bit8u*) &data);
+  pageWriteStampTable.decWriteStamp(pAddr, 8);
+  WriteHostQWordToLittleEndian((Bit64u*) (tlbEntry->hostPageAddr | pageOffset), data);
+}
+
+#endif
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::VGATHERDPS_VpsHps(bxInstruction_c *i)
 {
   if (i->sibIndex() == i->src2() || i->sibIndex() == i->dst() || i->src2() == i->dst()) {
@@ -64,13 +176,20 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VGATHERDPS_VpsHps(bxInstruction_c *i)
 
   unsigned n, num_elements = DWORD_ELEMENTS(i->getVL());
 
+  Bit32u active = 0;
+
   for (n=0; n < num_elements; n++) {
-    if (mask->ymm32s(n) < 0)
+    if (mask->ymm32s(n) < 0) {
       mask->ymm32u(n) = 0xffffffff;
+      active |= (1 << n);
+    }
     else
       mask->ymm32u(n) = 0;
   }
 
+  bxGatherAccess access;
+  bool direct = gatherTranslate(i, false, 4, active, num_elements, BX_READ, &access);
+
 #if BX_SUPPORT_ALIGNMENT_CHECK
   unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
   BX_CPU_THIS_PTR alignment_check_mask = 0;
@@ -85,7 +204,8 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VGATHERDPS_VpsHps(bxInstruction_c *i)
     }
 
     if (mask->ymm32u(n)) {
-        dest->ymm32u(n) = read_virtual_dword(i->seg(), BxResolveGatherD(i, n));
+        dest->ymm32u(n) = direct ? gather_host_read_dword(&access, n) :
+            read_virtual_dword(i->seg(), BxResolveGatherD(i, n));
     }
     mask->ymm32u(n) = 0;
   }
@@ -115,13 +235,20 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VGATHERQPS_VpsHps(bxInstruction_c *i)
   BxPackedYmmRegister *mask = &BX_YMM_REG(i->src2()), *dest = &BX_YMM_REG(i->dst());
   unsigned n, num_elements = QWORD_ELEMENTS(i->getVL());
 
+  Bit32u active = 0;
+
   for (n=0; n < num_elements; n++) {
-    if (mask->ymm32s(n) < 0)
+    if (mask->ymm32s(n) < 0) {
       mask->ymm32u(n) = 0xffffffff;
+      active |= (1 << n);
+    }
     else
       mask->ymm32u(n) = 0;
   }
 
+  bxGatherAccess access;
+  bool direct = gatherTranslate(i, true, 4, active, num_elements, BX_READ, &access);
+
 #if BX_SUPPORT_ALIGNMENT_CHECK
   unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
   BX_CPU_THIS_PTR alignment_check_mask = 0;
@@ -136,7 +263,8 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VGATHERQPS_VpsHps(bxInstruction_c *i)
     }
 
     if (mask->ymm32u(n)) {
-        dest->ymm32u(n) = read_virtual_dword(i->seg(), BxResolveGatherQ(i, n));
+        dest->ymm32u(n) = direct ? gather_host_read_dword(&access, n) :
+            read_virtual_dword(i->seg(), BxResolveGatherQ(i, n));
     }
     mask->ymm32u(n) = 0;
   }
@@ -166,13 +294,20 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VGATHERDPD_VpdHpd(bxInstruction_c *i)
   BxPackedYmmRegister *mask = &BX_YMM_REG(i->src2()), *dest = &BX_YMM_REG(i->dst());
   unsigned n, num_elements = QWORD_ELEMENTS(i->getVL());
 
+  Bit32u active = 0;
+
   for (n=0; n < num_elements; n++) {
-    if (mask->ymm64s(n) < 0)
+    if (mask->ymm64s(n) < 0) {
       mask->ymm64u(n) = BX_CONST64(0xffffffffffffffff);
+      active |= (1 << n);
+    }
     else
       mask->ymm64u(n) = 0;
   }
 
+  bxGatherAccess access;
+  bool direct = gatherTranslate(i, false, 8, active, num_elements, BX_READ, &access);
+
 #if BX_SUPPORT_ALIGNMENT_CHECK
   unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
   BX_CPU_THIS_PTR alignment_check_mask = 0;
@@ -187,7 +322,8 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VGATHERDPD_VpdHpd(bxInstruction_c *i)
     }
 
     if (mask->ymm64u(n)) {
-        dest->ymm64u(n) = read_virtual_qword(i->seg(), BxResolveGatherD(i, n));
+        dest->ymm64u(n) = direct ? gather_host_read_qword(&access, n) :
+            read_virtual_qword(i->seg(), BxResolveGatherD(i, n));
     }
     mask->ymm64u(n) = 0;
   }
@@ -217,13 +353,20 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VGATHERQPD_VpdHpd(bxInstruction_c *i)
   BxPackedYmmRegister *mask = &BX_YMM_REG(i->src2()), *dest = &BX_YMM_REG(i->dst());
   unsigned n, num_elements = QWORD_ELEMENTS(i->getVL());
 
+  Bit32u active = 0;
+
   for (n=0; n < num_elements; n++) {
-    if (mask->ymm64s(n) < 0)
+    if (mask->ymm64s(n) < 0) {
       mask->ymm64u(n) = BX_CONST64(0xffffffffffffffff);
+      active |= (1 << n);
+    }
     else
       mask->ymm64u(n) = 0;
   }
 
+  bxGatherAccess access;
+  bool direct = gatherTranslate(i, true, 8, active, num_elements, BX_READ, &access);
+
 #if BX_SUPPORT_ALIGNMENT_CHECK
   unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
   BX_CPU_THIS_PTR alignment_check_mask = 0;
@@ -238,7 +381,8 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VGATHERQPD_VpdHpd(bxInstruction_c *i)
     }
 
     if (mask->ymm64u(n)) {
-        dest->ymm64u(n) = read_virtual_qword(i->seg(), BxResolveGatherQ(i, n));
+        dest->ymm64u(n) = direct ? gather_host_read_qword(&access, n) :
+            read_virtual_qword(i->seg(), BxResolveGatherQ(i, n));
     }
     mask->ymm64u(n) = 0;
   }
@@ -273,6 +417,9 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VGATHERDPS_MASK_VpsVSib(bxInstruction_c *i
 
   unsigned n, len = i->getVL(), num_elements = DWORD_ELEMENTS(len);
 
+  bxGatherAccess access;
+  bool direct = gatherTranslate(i, false, 4, (Bit32u) opmask, num_elements, BX_READ, &access);
+
 #if BX_SUPPORT_ALIGNMENT_CHECK
   unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
   BX_CPU_THIS_PTR alignment_check_mask = 0;
@@ -281,7 +428,8 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VGATHERDPS_MASK_VpsVSib(bxInstruction_c *i
   for (n=0, mask = 0x1; n < num_elements; n++, mask <<= 1)
   {
     if (opmask & mask) {
-      dest->vmm32u(n) = read_virtual_dword(i->seg(), BxResolveGatherD(i, n));
+      dest->vmm32u(n) = direct ? gather_host_read_dword(&access, n) :
+          read_virtual_dword(i->seg(), BxResolveGatherD(i, n));
       opmask &= ~mask;
       BX_WRITE_OPMASK(i->opmask(), opmask);
     }
@@ -314,6 +462,9 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VGATHERQPS_MASK_VpsVSib(bxInstruction_c *i
 
   unsigned n, len = i->getVL(), num_elements = QWORD_ELEMENTS(len);
 
+  bxGatherAccess access;
+  bool direct = gatherTranslate(i, true, 4, (Bit32u) opmask, num_elements, BX_READ, &access);
+
 #if BX_SUPPORT_ALIGNMENT_CHECK
   unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
   BX_CPU_THIS_PTR alignment_check_mask = 0;
@@ -322,7 +473,8 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VGATHERQPS_MASK_VpsVSib(bxInstruction_c *i
   for (n=0, mask = 0x1; n < num_elements; n++, mask <<= 1)
   {
     if (opmask & mask) {
-      dest->vmm32u(n) = read_virtual_dword(i->seg(), BxResolveGatherQ(i, n));
+      dest->vmm32u(n) = direct ? gather_host_read_dword(&access, n) :
+          read_virtual_dword(i->seg(), BxResolveGatherQ(i, n));
       opmask &= ~mask;
       BX_WRITE_OPMASK(i->opmask(), opmask);
     }
@@ -359,6 +511,9 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VGATHERDPD_MASK_VpdVSib(bxInstruction_c *i
 
   unsigned n, len = i->getVL(), num_elements = QWORD_ELEMENTS(len);
 
+  bxGatherAccess access;
+  bool direct = gatherTranslate(i, false, 8, (Bit32u) opmask, num_elements, BX_READ, &access);
+
 #if BX_SUPPORT_ALIGNMENT_CHECK
   unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
   BX_CPU_THIS_PTR alignment_check_mask = 0;
@@ -367,7 +522,8 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VGATHERDPD_MASK_VpdVSib(bxInstruction_c *i
   for (n=0, mask = 0x1; n < num_elements; n++, mask <<= 1)
   {
     if (opmask & mask) {
-      dest->vmm64u(n) = read_virtual_qword(i->seg(), BxResolveGatherD(i, n));
+      dest->vmm64u(n) = direct ? gather_host_read_qword(&access, n) :
+          read_virtual_qword(i->seg(), BxResolveGatherD(i, n));
       opmask &= ~mask;
       BX_WRITE_OPMASK(i->opmask(), opmask);
     }
@@ -400,6 +556,9 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VGATHERQPD_MASK_VpdVSib(bxInstruction_c *i
 
   unsigned n, len = i->getVL(), num_elements = QWORD_ELEMENTS(len);
 
+  bxGatherAccess access;
+  bool direct = gatherTranslate(i, true, 8, (Bit32u) opmask, num_elements, BX_READ, &access);
+
 #if BX_SUPPORT_ALIGNMENT_CHECK
   unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
   BX_CPU_THIS_PTR alignment_check_mask = 0;
@@ -408,7 +567,8 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VGATHERQPD_MASK_VpdVSib(bxInstruction_c *i
   for (n=0, mask = 0x1; n < num_elements; n++, mask <<= 1)
   {
     if (opmask & mask) {
-      dest->vmm64u(n) = read_virtual_qword(i->seg(), BxResolveGatherQ(i, n));
+      dest->vmm64u(n) = direct ? gather_host_read_qword(&access, n) :
+          read_virtual_qword(i->seg(), BxResolveGatherQ(i, n));
       opmask &= ~mask;
       BX_WRITE_OPMASK(i->opmask(), opmask);
     }
@@ -436,6 +596,9 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VSCATTERDPS_MASK_VSibVps(bxInstruction_c *
 
   unsigned n, num_elements = DWORD_ELEMENTS(i->getVL());
 
+  bxGatherAccess access;
+  bool direct = gatherTranslate(i, false, 4, (Bit32u) opmask, num_elements, BX_WRITE, &access);
+
 #if BX_SUPPORT_ALIGNMENT_CHECK
   unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
   BX_CPU_THIS_PTR alignment_check_mask = 0;
@@ -444,7 +607,10 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VSCATTERDPS_MASK_VSibVps(bxInstruction_c *
   for (n=0, mask = 0x1; n < num_elements; n++, mask <<= 1)
   {
     if (opmask & mask) {
-      write_virtual_dword(i->seg(), BxResolveGatherD(i, n), src->vmm32u(n));
+      if (direct)
+        scatter_host_write_dword(&access, n, src->vmm32u(n));
+      else
+        write_virtual_dword(i->seg(), BxResolveGatherD(i, n), src->vmm32u(n));
       opmask &= ~mask;
       BX_WRITE_OPMASK(i->opmask(), opmask);
     }
@@ -471,6 +637,9 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VSCATTERQPS_MASK_VSibVps(bxInstruction_c *
 
   unsigned n, num_elements = QWORD_ELEMENTS(i->getVL());
 
+  bxGatherAccess access;
+  bool direct = gatherTranslate(i, true, 4, (Bit32u) opmask, num_elements, BX_WRITE, &access);
+
 #if BX_SUPPORT_ALIGNMENT_CHECK
   unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
   BX_CPU_THIS_PTR alignment_check_mask = 0;
@@ -479,7 +648,10 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VSCATTERQPS_MASK_VSibVps(bxInstruction_c *
   for (n=0, mask = 0x1; n < num_elements; n++, mask <<= 1)
   {
     if (opmask & mask) {
-      write_virtual_dword(i->seg(), BxResolveGatherQ(i, n), src->vmm32u(n));
+      if (direct)
+        scatter_host_write_dword(&access, n, src->vmm32u(n));
+      else
+        write_virtual_dword(i->seg(), BxResolveGatherQ(i, n), src->vmm32u(n));
       opmask &= ~mask;
       BX_WRITE_OPMASK(i->opmask(), opmask);
     }
@@ -506,6 +678,9 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VSCATTERDPD_MASK_VSibVpd(bxInstruction_c *
 
   unsigned n, num_elements = QWORD_ELEMENTS(i->getVL());
 
+  bxGatherAccess access;
+  bool direct = gatherTranslate(i, false, 8, (Bit32u) opmask, num_elements, BX_WRITE, &access);
+
 #if BX_SUPPORT_ALIGNMENT_CHECK
   unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
   BX_CPU_THIS_PTR alignment_check_mask = 0;
@@ -514,7 +689,10 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VSCATTERDPD_MASK_VSibVpd(bxInstruction_c *
   for (n=0, mask = 0x1; n < num_elements; n++, mask <<= 1)
   {
     if (opmask & mask) {
-      write_virtual_qword(i->seg(), BxResolveGatherD(i, n), src->vmm64u(n));
+      if (direct)
+        scatter_host_write_qword(&access, n, src->vmm64u(n));
+      else
+        write_virtual_qword(i->seg(), BxResolveGatherD(i, n), src->vmm64u(n));
       opmask &= ~mask;
       BX_WRITE_OPMASK(i->opmask(), opmask);
     }
@@ -541,6 +719,9 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VSCATTERQPD_MASK_VSibVpd(bxInstruction_c *
 
   unsigned n, num_elements = QWORD_ELEMENTS(i->getVL());
 
+  bxGatherAccess access;
+  bool direct = gatherTranslate(i, true, 8, (Bit32u) opmask, num_elements, BX_WRITE, &access);
+
 #if BX_SUPPORT_ALIGNMENT_CHECK
   unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
   BX_CPU_THIS_PTR alignment_check_mask = 0;
@@ -549,7 +730,10 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VSCATTERQPD_MASK_VSibVpd(bxInstruction_c *
   for (n=0, mask = 0x1; n < num_elements; n++, mask <<= 1)
   {
     if (opmask & mask) {
-      write_virtual_qword(i->seg(), BxResolveGatherQ(i, n), src->vmm64u(n));
+      if (direct)
+        scatter_host_write_qword(&access, n, src->vmm64u(n));
+      else
+        write_virtual_qword(i->seg(), BxResolveGatherQ(i, n), src->vmm64u(n));
       opmask &= ~mask;
       BX_WRITE_OPMASK(i->opmask(), opmask);
     }
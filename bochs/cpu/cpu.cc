@@ -49,7 +49,11 @@
 
 #endif
 
+#if BX_SUPPORT_SMP
+thread_local jmp_buf BX_CPU_C::jmp_buf_env;
+#else
 jmp_buf BX_CPU_C::jmp_buf_env;
+#endif
 
 #if BX_DEBUGGER
 void BX_CPU_C::cpu_loop_debugger(void)
@@ -175,10 +179,13 @@ void BX_CPU_C::cpu_loop(void)
     }
 
     bxICacheEntry_c *entry = getICacheEntry();
-    bxInstruction_c *i = entry->i;
 
 #if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS
+    bxInstruction_c *i = entry->i;
+
     for(;;) {
+      BX_JIT_PROFILE_TRACE(i);
+
       // want to allow changing of the instruction inside instrumentation callback
       BX_INSTR_BEFORE_EXECUTION(BX_CPU_ID, i);
       RIP += i->ilen();
@@ -191,8 +198,12 @@ void BX_CPU_C::cpu_loop(void)
 
       i = getICacheEntry()->i;
     }
+#elif BX_SUPPORT_THREADED_DISPATCH
+    // returns when an asynchronous event is pending, see dispatch.cc
+    threadedDispatch(entry, false);
 #else // BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS == 0
 
+    bxInstruction_c *i = entry->i;
     bxInstruction_c *last = i + (entry->tlen);
 
     for(;;) {
@@ -232,6 +243,12 @@ void BX_CPU_C::cpu_loop(void)
 
 void BX_CPU_C::cpu_run_trace(void)
 {
+#if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS
+  volatile Bit8u stack_anchor = 0;
+
+  BX_CPU_THIS_PTR cpuloop_stack_anchor = &stack_anchor;
+#endif
+
   // check on events which occurred for previous instructions (traps)
   // and ones which are asynchronous to the CPU (hardware interrupts)
   if (BX_CPU_THIS_PTR async_event) {
@@ -242,20 +259,31 @@ void BX_CPU_C::cpu_run_trace(void)
   }
 
   bxICacheEntry_c *entry = getICacheEntry();
-  bxInstruction_c *i = entry->i;
 
 #if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS
+  bxInstruction_c *i = entry->i;
+
+  BX_JIT_PROFILE_TRACE(i);
+
   // want to allow changing of the instruction inside instrumentation callback
   BX_INSTR_BEFORE_EXECUTION(BX_CPU_ID, i);
   RIP += i->ilen();
   // when handlers chaining is enabled this single call will execute entire trace
   BX_CPU_CALL_METHOD(i->execute1, (i)); // might iterate repeat instruction
 
+  if (BX_CPU_THIS_PTR async_event) {
+    // clear stop trace magic indication that probably was set by repeat or branch32/64
+    BX_CPU_THIS_PTR async_event &= ~BX_ASYNC_EVENT_STOP_TRACE;
+  }
+#elif BX_SUPPORT_THREADED_DISPATCH
+  threadedDispatch(entry, true);
+
   if (BX_CPU_THIS_PTR async_event) {
     // clear stop trace magic indication that probably was set by repeat or branch32/64
     BX_CPU_THIS_PTR async_event &= ~BX_ASYNC_EVENT_STOP_TRACE;
   }
 #else
+  bxInstruction_c *i = entry->i;
   bxInstruction_c *last = i + (entry->tlen);
 
   for(;;) {
@@ -317,53 +345,95 @@ bxICacheEntry_c* BX_CPU_C::getICacheEntry(void)
 
   BX_ASSERT(entry->i->ilen() != 0);
 
+  BX_CPU_STATS_TRACE(entry->i, entry->tlen);
+
   return entry;
 }
 
+#if InstrumentCPU
+
+void BX_CPU_C::traceStatistics(const bxInstruction_c *i, unsigned len)
+{
+  // stop at the inserted end of trace opcode
+  unsigned n = 0;
+  for (; n < len && i[n].ilen() != 0; n++) {
+    if (BX_CPU_THIS_PTR statsMask & BX_CPU_STATS_OPCODES)
+      INC_CPU_STAT(opcodeClass[get_bx_opcode_stats_class(i[n].getIaOpcode())]);
+  }
+
+  if (BX_CPU_THIS_PTR statsMask & BX_CPU_STATS_TRACES) {
+    unsigned bucket = 0;
+    while ((1U << bucket) < n && bucket < BX_STATS_TRACE_LENGTH_BUCKETS-1) bucket++;
+    INC_CPU_STAT(traceLength[bucket]);
+  }
+}
+
+#endif
+
 #if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS && BX_ENABLE_TRACE_LINKING
 
-// The function is called after taken branch instructions and tries to link the branch to the next trace
-void BX_CPP_AttrRegparmN(1) BX_CPU_C::linkTrace(bxInstruction_c *i)
+// Returns false if the trace has to return to the main loop instead of
+// continuing directly with the next trace
+bool BX_CPU_C::traceLinkAllowed(void)
 {
   volatile Bit8u stack_anchor = 0;
 
   if (bx_dbg.debugger_active)
-    return;
-
-#if BX_SUPPORT_SMP
-  if (BX_SMP_PROCESSORS > 1)
-    return;
-#endif
+    return false;
 
 #define BX_HANDLERS_CHAINING_MAX_LINK_DEPTH 1000
 
   // do not allow extreme trace link depth / avoid host stack overflow
   // (could happen with badly compiled instruction handlers)
-  static Bit32u linkDepth = 0;
-
-  if (BX_CPU_THIS_PTR async_event || ++linkDepth > BX_HANDLERS_CHAINING_MAX_LINK_DEPTH) {
-    linkDepth = 0;
-    return;
+  if (BX_CPU_THIS_PTR async_event || ++BX_CPU_THIS_PTR linkDepth > BX_HANDLERS_CHAINING_MAX_LINK_DEPTH) {
+    BX_CPU_THIS_PTR linkDepth = 0;
+    return false;
   }
 
 #define BX_HANDLERS_CHAINING_MAX_STACK_DEPTH 0x10000
 
   size_t stack_depth = BX_CPU_THIS_PTR cpuloop_stack_anchor - &stack_anchor;
   if (stack_depth > BX_HANDLERS_CHAINING_MAX_STACK_DEPTH) {
-    linkDepth = 0;
-    return;
+    BX_CPU_THIS_PTR linkDepth = 0;
+    return false;
   }
 
   Bit32u delta = (Bit32u) (BX_CPU_THIS_PTR icount - BX_CPU_THIS_PTR icount_last_sync);
   if(delta >= bx_pc_system.getNumCpuTicksLeftNextEvent()) {
-    linkDepth = 0;
-    return;
+    BX_CPU_THIS_PTR linkDepth = 0;
+    return false;
   }
 
+#if BX_SUPPORT_SMP
+  // In SMP mode the processor has to return to the main loop once it has
+  // executed its quantum, so other processors could make progress. The time
+  // is advanced by the main loop according to the executed instructions.
+  // Trace links are private to the processor and broken whenever any of
+  // the processors modifies code (handleSMC walks all the processors).
+  // Requests posted by other processor threads end the trace at once.
+  if (BX_SMP_PROCESSORS > 1) {
+    if (delta >= BX_CPU_THIS_PTR smpQuantum || BX_CPU_THIS_PTR smp_requests.pending()) {
+      BX_CPU_THIS_PTR linkDepth = 0;
+      return false;
+    }
+  }
+#endif
+
   BX_SYNC_TIME_IF_SINGLE_PROCESSOR(0);
 
+  return true;
+}
+
+// The function is called after taken branch instructions and tries to link the branch to the next trace
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::linkTrace(bxInstruction_c *i)
+{
+  if (! traceLinkAllowed())
+    return;
+
   bxInstruction_c *next = i->getNextTrace(BX_CPU_THIS_PTR iCache.traceLinkTimeStamp);
   if (next) {
+    BX_JIT_PROFILE_TRACE(next);
+    BX_CPU_STATS_TRACE(next, BX_MAX_TRACE_LENGTH+1);
     BX_EXECUTE_INSTRUCTION(next);
     return;
   }
@@ -383,13 +453,61 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::linkTrace(bxInstruction_c *i)
   {
     i->setNextTrace(entry->i, BX_CPU_THIS_PTR iCache.traceLinkTimeStamp);
     i = entry->i;
+    BX_JIT_PROFILE_TRACE(i);
+    BX_CPU_STATS_TRACE(i, BX_MAX_TRACE_LENGTH+1);
+    BX_EXECUTE_INSTRUCTION(i);
+  }
+}
+
+// The function is called after near RET instructions. A return to the address
+// pushed by the matching CALL continues with the trace remembered for the call
+// site, the trace is looked up and remembered otherwise.
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::linkReturnTrace(bxInstruction_c *i)
+{
+  bxICache_c::retStackEntry *ret = BX_CPU_THIS_PTR iCache.popReturn();
+
+  if (! traceLinkAllowed())
+    return;
+
+  bool predicted = (ret->laddr == get_laddr(BX_SEG_REG_CS, RIP) &&
+     ret->fetchModeMask == (BX_CPU_THIS_PTR fetchModeMask | (Bit32u(BX_CPU_THIS_PTR user_pl) << 31)));
+
+  if (predicted && ret->trace && ret->traceLinkTimeStamp == BX_CPU_THIS_PTR iCache.traceLinkTimeStamp) {
+    INC_ICACHE_STAT(iCacheReturnHits);
+    i = ret->trace;
+    BX_JIT_PROFILE_TRACE(i);
+    BX_CPU_STATS_TRACE(i, BX_MAX_TRACE_LENGTH+1);
+    BX_EXECUTE_INSTRUCTION(i);
+    return;
+  }
+
+  bx_address eipBiased = RIP + BX_CPU_THIS_PTR eipPageBias;
+  if (eipBiased >= BX_CPU_THIS_PTR eipPageWindowSize) {
+    prefetch();
+    eipBiased = RIP + BX_CPU_THIS_PTR eipPageBias;
+  }
+
+  INC_ICACHE_STAT(iCacheLookups);
+
+  bx_phy_address pAddr = BX_CPU_THIS_PTR pAddrFetchPage + eipBiased;
+  bxICacheEntry_c *entry = BX_CPU_THIS_PTR iCache.find_entry(pAddr, BX_CPU_THIS_PTR fetchModeMask);
+
+  if (entry != NULL) // link traces - handle only hit cases
+  {
+    if (predicted) {
+      ret->trace = entry->i;
+      ret->traceLinkTimeStamp = BX_CPU_THIS_PTR iCache.traceLinkTimeStamp;
+    }
+    i = entry->i;
+    BX_JIT_PROFILE_TRACE(i);
+    BX_CPU_STATS_TRACE(i, BX_MAX_TRACE_LENGTH+1);
     BX_EXECUTE_INSTRUCTION(i);
   }
 }
 
 #endif
 
-#define BX_REPEAT_TIME_UPDATE_INTERVAL (BX_MAX_TRACE_LENGTH-1)
+#define BX_REPEAT_TIME_UPDATE_INTERVAL (BX_DEFAULT_TRACE_LENGTH-1)
 
 void BX_CPP_AttrRegparmN(2) BX_CPU_C::repeat(bxInstruction_c *i, BxRepIterationPtr_tR execute)
 {
@@ -205,6 +205,14 @@ const Bit64u BX_PHY_ADDRESS_RESERVED_BITS = (~BX_PHY_ADDRESS_MASK);
 #define BX_CPU_ID (0)
 #endif
 
+// advance the system time on behalf of a repeated string instruction, it is
+// advanced by the main thread when the processors run in host threads
+#if BX_SUPPORT_SMP
+#define BX_CPU_TICKN(n) { if (! bx_smp_threads_running) BX_TICKN(n); }
+#else
+#define BX_CPU_TICKN(n) BX_TICKN(n)
+#endif
+
 #if BX_SUPPORT_AVX
 
 #define BX_READ_8BIT_OPMASK(index)  (BX_CPU_THIS_PTR opmask[index].word.byte.rl)
@@ -698,7 +706,9 @@ typedef struct
 #include "decoder/instr.h"
 #include "lazy_flags.h"
 #include "tlb.h"
+#include "smpthreads.h"
 #include "icache.h"
+#include "jit.h"
 
 // general purpose register
 #if BX_SUPPORT_X86_64
@@ -887,6 +897,7 @@ typedef enum dbg_show_flags_t {
 
 struct BX_SMM_State;
 struct BxOpcodeInfo_t;
+struct bxGatherAccess;
 struct bx_cpu_statistics;
 class bx_cpuid_t;
 
@@ -1253,11 +1264,18 @@ public: // for now...
   BX_SMF bool get_amx_ok();
 
   // for exceptions
+#if BX_SUPPORT_SMP
+  static thread_local jmp_buf jmp_buf_env; // one per host thread running CPUs
+#else
   static jmp_buf jmp_buf_env;
+#endif
   unsigned last_exception_type;
 
 #if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS
   const volatile Bit8u *cpuloop_stack_anchor = NULL;
+#if BX_ENABLE_TRACE_LINKING
+  Bit32u linkDepth = 0; // amount of traces executed through trace links
+#endif
 #endif
 
   // Boundaries of current code page, based on EIP
@@ -1284,6 +1302,7 @@ public: // for now...
 
   // statistics
   bx_cpu_statistics *stats;
+  Bit32u statsMask; // statistics groups collected at runtime, see cpustats.h
 
 #if BX_DEBUGGER
   bx_phy_address watchpoint;
@@ -1323,10 +1342,19 @@ public: // for now...
 #define BX_INSTR_FAR_BRANCH_ORIGIN()
 #endif
 
-#define BX_DTLB_SIZE 2048
-#define BX_ITLB_SIZE 1024
-  TLB<BX_DTLB_SIZE> DTLB BX_CPP_AlignN(32);
-  TLB<BX_ITLB_SIZE> ITLB BX_CPP_AlignN(32);
+#define BX_DTLB_SIZE 4096 /* must be power of two */
+#define BX_DTLB_WAYS 4
+#define BX_ITLB_SIZE 2048 /* must be power of two */
+#define BX_ITLB_WAYS 4
+  TLB<BX_DTLB_SIZE, BX_DTLB_WAYS> DTLB BX_CPP_AlignN(32);
+  TLB<BX_ITLB_SIZE, BX_ITLB_WAYS> ITLB BX_CPP_AlignN(32);
+
+#if BX_SUPPORT_X86_64
+  bx_PWC PWC;
+#endif
+#if BX_SUPPORT_VMX >= 2 || BX_SUPPORT_SVM
+  bx_nested_PWC nestedPWC;
+#endif
 
 #if BX_CPU_LEVEL >= 6
   struct {
@@ -1340,6 +1368,17 @@ public: // for now...
   bxICache_c iCache BX_CPP_AlignN(32);
   Bit32u fetchModeMask;
 
+  unsigned maxTraceLength;    // longest trace, including merged traces
+  unsigned traceQuantum;      // longest trace decoded on a miss
+  unsigned decodeAheadTraces; // traces decoded ahead on a miss
+#if BX_SUPPORT_SMP
+  Bit32u smpQuantum;          // ticks executed before returning to the main loop
+#endif
+
+#if BX_SUPPORT_JIT
+  bxJitCache_c *jit; // NULL if the trace compiler is disabled
+#endif
+
   struct {
     bx_address rm_addr;       // The address offset after resolution
     bx_phy_address paddress1; // physical address after translation of 1st len1 bytes of data
@@ -1360,6 +1399,22 @@ public: // for now...
 #endif
   } address_xlation;
 
+#if BX_SUPPORT_SMP
+  // requests posted by other host threads in multi-threaded SMP simulation
+  bx_smp_request_queue_c smp_requests;
+
+  // read-modify-write in progress in multi-threaded SMP simulation
+  struct {
+    bool atomic;              // operand is in host memory, commit with compare-and-swap
+    bool bus_locked;          // operand is not in host memory, big emulator lock is held
+    Bit64u value;             // operand value as it was read
+    // state to roll back the instruction if the compare-and-swap fails
+    Bit32u eflags;
+    bx_lazyflags_entry oszapc;
+    bx_gen_reg_t gen_reg[BX_GENERAL_REGISTERS+4];
+  } smp_rmw;
+#endif
+
   BX_SMF void setEFlags(Bit32u val) BX_CPP_AttrRegparmN(1);
 
   BX_SMF BX_CPP_INLINE void setEFlagsOSZAPC(Bit32u flags32) {
@@ -4014,6 +4069,7 @@ public: // for now...
 
   BX_SMF void NOP(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
   BX_SMF void PAUSE(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void MFENCE(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
   BX_SMF void MOV_EbIbR(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
   BX_SMF void MOV_EwIwR(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
   BX_SMF void MOV_EdIdR(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
@@ -4417,6 +4473,57 @@ public: // for now...
   BX_SMF void BxError(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
 #if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS
   BX_SMF void BxEndTrace(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+
+  // fused instruction pairs, the template argument is the handler of the
+  // second instruction (fusion.cc)
+  template <BxExecutePtr_tR second> BX_SMF void CMP_GdEdR_FUSED(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <BxExecutePtr_tR second> BX_SMF void CMP_EdIdR_FUSED(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <BxExecutePtr_tR second> BX_SMF void TEST_EdGdR_FUSED(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <BxExecutePtr_tR second> BX_SMF void TEST_EdIdR_FUSED(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <BxExecutePtr_tR second> BX_SMF void DEC_EdR_FUSED(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <BxExecutePtr_tR second> BX_SMF void MOV32_GdEdM_FUSED(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <BxExecutePtr_tR second> BX_SMF void PUSH_EdR_FUSED(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <BxExecutePtr_tR second> BX_SMF void POP_EdR_FUSED(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+#if BX_SUPPORT_X86_64
+  template <BxExecutePtr_tR second> BX_SMF void CMP_GqEqR_FUSED(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <BxExecutePtr_tR second> BX_SMF void CMP_EqIdR_FUSED(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <BxExecutePtr_tR second> BX_SMF void TEST_EqGqR_FUSED(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <BxExecutePtr_tR second> BX_SMF void TEST_EqIdR_FUSED(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <BxExecutePtr_tR second> BX_SMF void DEC_EqR_FUSED(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <BxExecutePtr_tR second> BX_SMF void MOV64_GdEdM_FUSED(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <BxExecutePtr_tR second> BX_SMF void MOV_GqEqM_FUSED(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <BxExecutePtr_tR second> BX_SMF void PUSH_EqR_FUSED(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <BxExecutePtr_tR second> BX_SMF void POP_EqR_FUSED(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+#endif
+#endif
+
+  // register ALU instructions, with deadFlags set the flags are computed only
+  // when needed (dead flags elimination in fusion.cc)
+  template <bool deadFlags> BX_SMF void ADD_GdEdR_DF(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <bool deadFlags> BX_SMF void ADD_EdIdR_DF(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <bool deadFlags> BX_SMF void SUB_GdEdR_DF(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <bool deadFlags> BX_SMF void SUB_EdIdR_DF(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <bool deadFlags> BX_SMF void AND_GdEdR_DF(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <bool deadFlags> BX_SMF void AND_EdIdR_DF(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <bool deadFlags> BX_SMF void OR_GdEdR_DF(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <bool deadFlags> BX_SMF void OR_EdIdR_DF(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <bool deadFlags> BX_SMF void XOR_GdEdR_DF(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <bool deadFlags> BX_SMF void XOR_EdIdR_DF(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <bool deadFlags> BX_SMF void INC_EdR_DF(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <bool deadFlags> BX_SMF void DEC_EdR_DF(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+#if BX_SUPPORT_X86_64
+  template <bool deadFlags> BX_SMF void ADD_GqEqR_DF(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <bool deadFlags> BX_SMF void ADD_EqIdR_DF(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <bool deadFlags> BX_SMF void SUB_GqEqR_DF(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <bool deadFlags> BX_SMF void SUB_EqIdR_DF(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <bool deadFlags> BX_SMF void AND_GqEqR_DF(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <bool deadFlags> BX_SMF void AND_EqIdR_DF(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <bool deadFlags> BX_SMF void OR_GqEqR_DF(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <bool deadFlags> BX_SMF void OR_EqIdR_DF(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <bool deadFlags> BX_SMF void XOR_GqEqR_DF(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <bool deadFlags> BX_SMF void XOR_EqIdR_DF(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <bool deadFlags> BX_SMF void INC_EqR_DF(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  template <bool deadFlags> BX_SMF void DEC_EqR_DF(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
 #endif
 
   BX_SMF void BxNoFPU(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
@@ -4442,6 +4549,13 @@ public: // for now...
 #if BX_SUPPORT_AVX
   BX_SMF bx_address BxResolveGatherD(bxInstruction_c *, unsigned) BX_CPP_AttrRegparmN(2);
   BX_SMF bx_address BxResolveGatherQ(bxInstruction_c *, unsigned) BX_CPP_AttrRegparmN(2);
+  BX_SMF bool gatherTranslate(bxInstruction_c *i, bool qwordIndex, unsigned len, Bit32u mask, unsigned num_elements, unsigned rw, bxGatherAccess *access);
+  BX_CPP_INLINE BX_SMF Bit32u gather_host_read_dword(const bxGatherAccess *access, unsigned n);
+  BX_CPP_INLINE BX_SMF Bit64u gather_host_read_qword(const bxGatherAccess *access, unsigned n);
+#if BX_SUPPORT_EVEX
+  BX_CPP_INLINE BX_SMF void scatter_host_write_dword(const bxGatherAccess *access, unsigned n, Bit32u data);
+  BX_CPP_INLINE BX_SMF void scatter_host_write_qword(const bxGatherAccess *access, unsigned n, Bit64u data);
+#endif
 #endif
 // <TAG-CLASS-CPU-END>
 
@@ -4483,9 +4597,14 @@ public: // for now...
 #endif
 #if BX_SUPPORT_SMP
   BX_SMF void cpu_run_trace(void);
+#endif
+#if BX_SUPPORT_THREADED_DISPATCH
+  BX_SMF void threadedDispatch(bxICacheEntry_c *entry, bool oneTrace);
 #endif
   BX_SMF bool handleAsyncEvent(void);
   BX_SMF bool handleWaitForEvent(void);
+  BX_SMF bool wakeupEventPending(void);
+  BX_SMF bool isWaitingForEvent(void);
   BX_SMF void HandleExtInterrupt(void);
   BX_SMF Bit8u interrupt_acknowledge(void);
 
@@ -4494,8 +4613,30 @@ public: // for now...
   BX_SMF bxICacheEntry_c *serveICacheMiss(Bit32u eipBiased, bx_phy_address pAddr);
   BX_SMF bxICacheEntry_c* getICacheEntry(void);
   BX_SMF bool mergeTraces(bxICacheEntry_c *entry, bxInstruction_c *i, bx_phy_address pAddr);
+  BX_SMF void decodeAhead(bxICacheEntry_c *missed, unsigned len, Bit32u eipBiased);
+  BX_SMF unsigned decodeAheadSuccessors(const bxInstruction_c *i, unsigned len, Bit32u eipBiased, Bit32u *queue, unsigned num);
+  BX_SMF bxICacheEntry_c* loadTraceFilePage(bx_phy_address pAddr);
+  BX_SMF unsigned loadTraceFileTrace(bxICacheEntry_c *entry, const struct bxTraceFileView_t *view, unsigned trace);
+  BX_SMF Bit64u traceFileSignature(void);
+  BX_SMF void traceStatistics(const bxInstruction_c *i, unsigned len);
+  BX_SMF void profileSample(void);
+#if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS
+  BX_SMF void optimizeTrace(bxInstruction_c *i, unsigned len);
+  BX_SMF void fuseTrace(bxInstruction_c *i, unsigned len);
+  BX_SMF void eliminateDeadFlags(bxInstruction_c *i, unsigned len);
+#endif
 #if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS && BX_ENABLE_TRACE_LINKING
+  BX_SMF bool traceLinkAllowed(void);
   BX_SMF void linkTrace(bxInstruction_c *i) BX_CPP_AttrRegparmN(1);
+  BX_SMF void linkReturnTrace(bxInstruction_c *i) BX_CPP_AttrRegparmN(1);
+#endif
+  BX_SMF BX_CPP_INLINE void pushReturnTrace(bx_address return_RIP);
+#if BX_SUPPORT_JIT
+  BX_SMF void JitTraceEntry(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void jitProfileTrace(bxInstruction_c *i);
+  BX_SMF void jitCompileTrace(bxInstruction_c *i);
+  BX_SMF void jitFlushCodeBuffer(void);
+  BX_SMF void jitVerifyTrace(bxInstruction_c *i);
 #endif
   BX_SMF void prefetch(void);
   BX_SMF void updateFetchModeMask(void);
@@ -4645,6 +4786,23 @@ public: // for now...
   BX_SMF Bit32u stack_read_dword(bx_address offset) BX_CPP_AttrRegparmN(1);
   BX_SMF Bit64u stack_read_qword(bx_address offset) BX_CPP_AttrRegparmN(1);
 
+  // inline push/pop accesses through the stack page window, see stack.h
+  BX_SMF BX_CPP_INLINE bool stackWindowHit(bx_address offset);
+  BX_SMF BX_CPP_INLINE void stack_window_write_word(bx_address offset, Bit16u data);
+  BX_SMF BX_CPP_INLINE void stack_window_write_dword(bx_address offset, Bit32u data);
+  BX_SMF BX_CPP_INLINE void stack_window_write_qword(bx_address offset, Bit64u data);
+  BX_SMF BX_CPP_INLINE Bit16u stack_window_read_word(bx_address offset);
+  BX_SMF BX_CPP_INLINE Bit32u stack_window_read_dword(bx_address offset);
+  BX_SMF BX_CPP_INLINE Bit64u stack_window_read_qword(bx_address offset);
+  BX_SMF BX_CPP_INLINE void stack_push_word(bx_address offset, Bit16u data);
+  BX_SMF BX_CPP_INLINE void stack_push_dword(bx_address offset, Bit32u data);
+  BX_SMF BX_CPP_INLINE Bit16u stack_pop_word(bx_address offset);
+  BX_SMF BX_CPP_INLINE Bit32u stack_pop_dword(bx_address offset);
+#if BX_SUPPORT_X86_64
+  BX_SMF BX_CPP_INLINE void stack_push_qword(bx_address offset, Bit64u data);
+  BX_SMF BX_CPP_INLINE Bit64u stack_pop_qword(bx_address offset);
+#endif
+
 #if BX_SUPPORT_CET
   BX_SMF void shadow_stack_write_dword(bx_address offset, unsigned curr_pl, Bit32u data) BX_CPP_AttrRegparmN(3);
   BX_SMF void shadow_stack_write_qword(bx_address offset, unsigned curr_pl, Bit64u data) BX_CPP_AttrRegparmN(3);
@@ -4682,16 +4840,15 @@ public: // for now...
        bx_descriptor_t *descriptor, bx_address rip, unsigned cpl);
 
 #if BX_SUPPORT_REPEAT_SPEEDUPS
-  BX_SMF Bit32u FastRepMOVSB(unsigned srcSeg, Bit32u srcOff, unsigned dstSeg, Bit32u dstOff, Bit32u byteCount, Bit32u granularity);
-  BX_SMF Bit32u FastRepMOVSB(bx_address laddrSrc, bx_address laddrDst, Bit64u byteCount, Bit32u granularity);
-
-  BX_SMF Bit32u FastRepSTOSB(unsigned dstSeg, Bit32u dstOff, Bit8u  val, Bit32u  byteCount);
-  BX_SMF Bit32u FastRepSTOSW(unsigned dstSeg, Bit32u dstOff, Bit16u val, Bit32u  wordCount);
-  BX_SMF Bit32u FastRepSTOSD(unsigned dstSeg, Bit32u dstOff, Bit32u val, Bit32u dwordCount);
+  BX_SMF Bit64u FastRepMOVS(bxInstruction_c *i, unsigned len);
+  BX_SMF Bit64u FastRepSTOS(bxInstruction_c *i, unsigned len, Bit64u val);
+  BX_SMF Bit64u FastRepCMPS(bxInstruction_c *i, unsigned len);
+  BX_SMF Bit64u FastRepSCAS(bxInstruction_c *i, unsigned len, Bit64u val);
 
-  BX_SMF Bit32u FastRepSTOSB(bx_address laddrDst, Bit8u  val, Bit32u  byteCount);
-  BX_SMF Bit32u FastRepSTOSW(bx_address laddrDst, Bit16u val, Bit32u  wordCount);
-  BX_SMF Bit32u FastRepSTOSD(bx_address laddrDst, Bit32u val, Bit32u dwordCount);
+  BX_SMF Bit64u FastRepCount(bxInstruction_c *i);
+  BX_SMF Bit64u FastRepRun(bxInstruction_c *i, unsigned seg, unsigned reg, unsigned len, unsigned rw, bx_address *laddr);
+  BX_SMF void FastRepAdvance(bxInstruction_c *i, Bit64u count, unsigned len, bool src, bool dst);
+  BX_SMF bool FastRepMisaligned(bx_address laddr, unsigned len);
 
   BX_SMF Bit32u FastRepINSW(Bit32u dstOff, Bit16u port, Bit32u wordCount);
   BX_SMF Bit32u FastRepOUTSW(unsigned srcSeg, Bit32u srcOff, Bit16u port, Bit32u wordCount);
@@ -4721,8 +4878,11 @@ public: // for now...
 
   // linear address for translate_linear expected to be canonical !
   BX_SMF bx_phy_address translate_linear(bx_TLB_entry *entry, bx_address laddr, unsigned user, unsigned rw);
+  BX_SMF void set_tlb_entry_host_page_addr(bx_TLB_entry *entry, bx_address laddr, unsigned rw, Bit32u combined_access);
   BX_SMF bx_phy_address translate_linear_legacy(bx_address laddr, Bit32u &lpf_mask, unsigned user, unsigned rw);
   BX_SMF void update_access_dirty(bx_phy_address *entry_addr, Bit32u *entry, BxMemtype *entry_memtype, unsigned leaf, unsigned write);
+  BX_SMF void update_paging_entry_dword(bx_phy_address entry_addr, Bit32u old_entry, Bit32u new_entry, BxMemtype memtype, AccessReason reason);
+  BX_SMF void update_paging_entry_qword(bx_phy_address entry_addr, Bit64u old_entry, Bit64u new_entry, BxMemtype memtype, AccessReason reason);
   BX_SMF Bit32u check_leaf_entry_faults(bx_address laddr, Bit64u leaf_entry, Bit32u combined_access, unsigned user, unsigned rw, bool nx_page = false);
 #if BX_CPU_LEVEL >= 6
   BX_SMF bx_phy_address translate_linear_load_PDPTR(bx_address laddr, unsigned user, unsigned rw);
@@ -4758,6 +4918,10 @@ public: // for now...
 
 #if BX_CPU_LEVEL >= 6
   BX_SMF void TLB_flushNonGlobal(void);
+#endif
+#if BX_SUPPORT_X86_64
+  BX_SMF void TLB_flushPCID(Bit32u pcid);
+  BX_SMF void TLB_switchPCID(bool flush);
 #endif
   BX_SMF void TLB_flush(void);
   BX_SMF void TLB_invlpg(bx_address laddr);
@@ -4779,7 +4943,7 @@ public: // for now...
 
   BX_SMF bool SetCR0(bxInstruction_c *i, bx_address val);
   BX_SMF bool check_CR0(bx_address val, bool vmenter = false) BX_CPP_AttrRegparmN(1);
-  BX_SMF bool SetCR3(bx_address val) BX_CPP_AttrRegparmN(1);
+  BX_SMF bool SetCR3(bx_address val, bool noflush = false) BX_CPP_AttrRegparmN(2);
 #if BX_CPU_LEVEL >= 5
   BX_SMF bool SetCR4(bxInstruction_c *i, bx_address val);
   BX_SMF bool check_CR4(bx_address val) BX_CPP_AttrRegparmN(1);
@@ -4968,6 +5132,17 @@ public: // for now...
   BX_SMF void    deliver_NMI(void);
   BX_SMF void    deliver_SMI(void);
   BX_SMF void    deliver_SIPI(unsigned vector);
+#if BX_SUPPORT_SMP
+  BX_SMF void    smp_post_request(unsigned type, Bit32u data = 0, Bit64u addr = 0);
+  BX_SMF void    smp_process_requests(void);
+  BX_SMF void    smp_begin_RMW(Bit64u value);
+  BX_SMF void    smp_lock_RMW(void);
+  BX_SMF void    smp_locked_RMW_read(Bit64u value, unsigned len);
+  BX_SMF void    smp_unlock_RMW(void);
+  BX_SMF void    smp_commit_RMW(void *hostAddr, Bit64u val, unsigned len);
+  BX_SMF void    smp_restart_RMW(void) BX_CPP_AttrNoReturn();
+  BX_SMF bool    smp_update_paging_entry(bx_phy_address entry_addr, Bit64u old_entry, Bit64u new_entry, unsigned len);
+#endif
 #if BX_SUPPORT_UINTR
   BX_SMF void    deliver_UINTR();
   BX_SMF void    Process_UINTR_Notification();
@@ -5550,6 +5725,15 @@ BX_CPP_INLINE bx_address BX_CPU_C::get_laddr(unsigned seg, bx_address offset)
   return get_laddr32(seg, (Bit32u) offset);
 }
 
+// remember the return address of a near CALL for the matching near RET
+BX_CPP_INLINE void BX_CPU_C::pushReturnTrace(bx_address return_RIP)
+{
+#if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS && BX_ENABLE_TRACE_LINKING
+  BX_CPU_THIS_PTR iCache.pushReturn(get_laddr(BX_SEG_REG_CS, return_RIP),
+      BX_CPU_THIS_PTR fetchModeMask | (Bit32u(BX_CPU_THIS_PTR user_pl) << 31));
+#endif
+}
+
 // same as agen_read32 but also allow access to execute only segments
 BX_CPP_INLINE Bit32u BX_CPU_C::agen_read_execute32(unsigned s, Bit32u offset, unsigned len)
 {
@@ -5899,6 +6083,7 @@ class bxInstruction_c;
 
 #if BX_ENABLE_TRACE_LINKING == 0
 #define linkTrace(i)
+#define linkReturnTrace(i)
 #endif
 
 #define BX_LINK_TRACE(i) {                             \
@@ -5906,6 +6091,11 @@ class bxInstruction_c;
   return linkTrace(i);                                 \
 }
 
+#define BX_LINK_RETURN(i) {                            \
+  BX_COMMIT_INSTRUCTION(i);                            \
+  return linkReturnTrace(i);                           \
+}
+
 #define BX_NEXT_INSTR(i) {                             \
   BX_COMMIT_INSTRUCTION(i);                            \
   if (BX_CPU_THIS_PTR async_event) return;             \
@@ -5913,11 +6103,26 @@ class bxInstruction_c;
   BX_EXECUTE_INSTRUCTION(i);                           \
 }
 
+// The flags of an instruction are dead when the next instruction in the trace
+// overwrites all of them, they are computed anyway if the trace is left after
+// the instruction because of an async event. The async event is sampled once
+// so it is never seen with the flags not computed.
+#define BX_NEXT_INSTR_FLAGS(i, dead_flags, set_flags) {   \
+  Bit32u async_event_sample = BX_CPU_THIS_PTR async_event; \
+  if (! (dead_flags) || async_event_sample) { set_flags; } \
+  BX_COMMIT_INSTRUCTION(i);                            \
+  if (async_event_sample) return;                      \
+  ++i;                                                 \
+  BX_EXECUTE_INSTRUCTION(i);                           \
+}
+
 #else // BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS
 
 #define BX_NEXT_TRACE(i) { return; }
 #define BX_NEXT_INSTR(i) { return; }
+#define BX_NEXT_INSTR_FLAGS(i, dead_flags, set_flags) { set_flags; return; }
 #define BX_LINK_TRACE(i) { return; }
+#define BX_LINK_RETURN(i) { return; }
 
 #endif
 
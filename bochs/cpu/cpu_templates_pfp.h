@@ -23,6 +23,7 @@
 #define BX_CPU_PFP_TEMPLATES_H
 
 #include "cpu/softfloat3e/include/softfloat.h"
+#include "simd_pfp.h"
 
 extern softfloat_status_t mxcsr_to_softfloat_status_word(bx_mxcsr_t mxcsr);
 
@@ -38,7 +39,10 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::HANDLE_SSE_PFP_1OP(bxInstruction_c *i)
 #if BX_CPU_LEVEL >= 6
   BxPackedXmmRegister op = BX_READ_XMM_REG(i->src());
   softfloat_status_t status = mxcsr_to_softfloat_status_word(MXCSR);
-  (func)(&op, status);
+  if (host_fpu_ok(status, MXCSR))
+    host_xmm_pfp_1op<func>(&op, status);
+  else
+    (func)(&op, status);
   check_exceptionsSSE(softfloat_getExceptionFlags(&status));
   BX_WRITE_XMM_REG(i->dst(), op);
 #endif
@@ -52,7 +56,10 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::HANDLE_SSE_PFP_2OP(bxInstruction_c *i)
   BxPackedXmmRegister op1 = BX_READ_XMM_REG(i->dst()), op2 = BX_READ_XMM_REG(i->src());
 
   softfloat_status_t status = mxcsr_to_softfloat_status_word(MXCSR);
-  (func)(&op1, &op2, status);
+  if (host_fpu_ok(status, MXCSR))
+    host_xmm_pfp_2op<func>(&op1, &op2, status);
+  else
+    (func)(&op1, &op2, status);
   check_exceptionsSSE(softfloat_getExceptionFlags(&status));
 
   BX_WRITE_XMM_REG(i->dst(), op1);
@@ -71,8 +78,13 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::HANDLE_AVX_PFP_1OP(bxInstruction_c *i)
   softfloat_status_t status = mxcsr_to_softfloat_status_word(MXCSR);
   softfloat_status_word_rc_override(status, i);
 
-  for (unsigned n=0; n < len; n++) {
-    (func)(&op.vmm128(n), status);
+  if (host_fpu_ok(status, MXCSR)) {
+    for (unsigned n=0; n < len; n++)
+      host_xmm_pfp_1op<func>(&op.vmm128(n), status);
+  }
+  else {
+    for (unsigned n=0; n < len; n++)
+      (func)(&op.vmm128(n), status);
   }
 
   check_exceptionsSSE(softfloat_getExceptionFlags(&status));
@@ -89,8 +101,13 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::HANDLE_AVX_PFP_2OP(bxInstruction_c *i)
   softfloat_status_t status = mxcsr_to_softfloat_status_word(MXCSR);
   softfloat_status_word_rc_override(status, i);
 
-  for (unsigned n=0; n < len; n++) {
-    (func)(&op1.vmm128(n), &op2.vmm128(n), status);
+  if (host_fpu_ok(status, MXCSR)) {
+    for (unsigned n=0; n < len; n++)
+      host_xmm_pfp_2op<func>(&op1.vmm128(n), &op2.vmm128(n), status);
+  }
+  else {
+    for (unsigned n=0; n < len; n++)
+      (func)(&op1.vmm128(n), &op2.vmm128(n), status);
   }
 
   check_exceptionsSSE(softfloat_getExceptionFlags(&status));
@@ -109,8 +126,14 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::HANDLE_AVX_PFP_3OP(bxInstruction_c *i)
   softfloat_status_t status = mxcsr_to_softfloat_status_word(MXCSR);
   softfloat_status_word_rc_override(status, i);
 
-  for (unsigned n=0; n < len; n++)
-    (func)(&op1.vmm128(n), &op2.vmm128(n), &op3.vmm128(n), status);
+  if (host_fpu_ok(status, MXCSR)) {
+    for (unsigned n=0; n < len; n++)
+      host_xmm_pfp_3op<func>(&op1.vmm128(n), &op2.vmm128(n), &op3.vmm128(n), status);
+  }
+  else {
+    for (unsigned n=0; n < len; n++)
+      (func)(&op1.vmm128(n), &op2.vmm128(n), &op3.vmm128(n), status);
+  }
 
   check_exceptionsSSE(softfloat_getExceptionFlags(&status));
   BX_WRITE_AVX_REGZ(i->dst(), op1, len);
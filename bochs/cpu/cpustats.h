@@ -24,14 +24,45 @@
 #ifndef BX_CPUSTATS_H
 #define BX_CPUSTATS_H
 
-#define InstrumentICACHE 0
-#define InstrumentTLB 0
-#define InstrumentTLBFlush 0
-#define InstrumentStackPrefetch 0
-#define InstrumentSMC 0
+// The CPU statistics are compiled in together with the other Bochs statistics
+// and collected only for the groups selected at runtime with the cpu option
+// stats=..., so a disabled group costs a single test of the statistics mask.
+#define InstrumentCPU BX_ENABLE_STATISTICS
+
+// runtime selectable statistics groups
+#define BX_CPU_STATS_ICACHE           (1 << 0)
+#define BX_CPU_STATS_TLB              (1 << 1)
+#define BX_CPU_STATS_TLBFLUSH         (1 << 2)
+#define BX_CPU_STATS_STACK_PREFETCH   (1 << 3)
+#define BX_CPU_STATS_SMC              (1 << 4)
+#define BX_CPU_STATS_OPCODES          (1 << 5)
+#define BX_CPU_STATS_TRACES           (1 << 6)
+#define BX_CPU_STATS_EVENTS           (1 << 7)
+#define BX_CPU_STATS_EXCEPTIONS       (1 << 8)
+#define BX_CPU_STATS_TIMERS           (1 << 9)  // host time of the timer callbacks
+
+#define BX_CPU_STATS_ALL              ((1 << 10) - 1)
+
+// instruction classes counted by the opcodes statistics group
+enum {
+  BX_STATS_OPCODE_INTEGER = 0,
+  BX_STATS_OPCODE_X87,
+  BX_STATS_OPCODE_MMX,       // MMX and 3DNow!
+  BX_STATS_OPCODE_SSE,
+  BX_STATS_OPCODE_AVX,       // AVX/AVX2 and the other VEX encoded vector extensions
+  BX_STATS_OPCODE_AVX512,    // AVX-512 and AVX10
+  BX_STATS_OPCODE_AMX,
+  BX_STATS_OPCODE_SYSTEM,    // VMX/SVM/SMX, XSAVE, MONITOR/MWAIT, SYSCALL/SYSENTER, MSR access extensions
+  BX_STATS_OPCODE_CLASSES
+};
+
+#if InstrumentCPU
+// returns the instruction class of the opcode, see fetchdecode32.cc
+unsigned get_bx_opcode_stats_class(Bit16u ia_opcode);
+#endif
 
-// indicate if any of the CPU statistics was compiled in
-#define InstrumentCPU (InstrumentICACHE + InstrumentTLB + InstrumentTLBFlush + InstrumentStackPrefetch + InstrumentSMC)
+// trace length histogram buckets: 1, 2, 3-4, 5-8, 9-16, 17-32, 33-64
+#define BX_STATS_TRACE_LENGTH_BUCKETS 7
 
 struct bx_cpu_statistics
 {
@@ -39,6 +70,11 @@ struct bx_cpu_statistics
   Bit64u iCacheLookups;
   Bit64u iCachePrefetch;
   Bit64u iCacheMisses;
+  Bit64u iCacheEvictions;
+  Bit64u iCacheReclaims;
+  Bit64u iCacheDecodeAhead;
+  Bit64u iCacheTraceFileLoads; // traces loaded from the trace cache file
+  Bit64u iCacheReturnHits;     // near returns linked from the return address stack
 
   // tlb lookup statistics
   Bit64u tlbLookups;
@@ -47,10 +83,15 @@ struct bx_cpu_statistics
   Bit64u tlbMisses;
   Bit64u tlbExecuteMisses;
   Bit64u tlbWriteMisses;
+  Bit64u tlbLargePageHits;   // misses refilled from the large page TLB
+  Bit64u pwcHits;            // page walks started from the paging structure cache
+  Bit64u nestedPwcHits;      // guest paging structure accesses translated from the cache
 
   // tlb flush statistics
   Bit64u tlbGlobalFlushes;
   Bit64u tlbNonGlobalFlushes;
+  Bit64u tlbPCIDFlushes;     // invalidations of a single PCID
+  Bit64u tlbPCIDSwitches;    // CR3 writes keeping the TLB entries
 
   // stack prefetch statistics
   Bit64u stackPrefetch;
@@ -58,45 +99,82 @@ struct bx_cpu_statistics
   // self modifying code statistics
   Bit64u smc;
 
+  // instructions executed per instruction class, counted when a trace is entered
+  Bit64u opcodeClass[BX_STATS_OPCODE_CLASSES];
+
+  // traces entered by their length
+  Bit64u traceLength[BX_STATS_TRACE_LENGTH_BUCKETS];
+
+  // asynchronous event statistics
+  Bit64u asyncEvents;
+  Bit64u asyncWaitForEvent;   // events handled while the CPU is not active (HLT, MWAIT, wait for SIPI)
+  Bit64u asyncSMI;
+  Bit64u asyncINIT;
+  Bit64u asyncDebugTraps;
+  Bit64u asyncNMI;
+  Bit64u asyncInterrupts;
+  Bit64u asyncUserInterrupts;
+  Bit64u asyncVmEvents;       // VMX/SVM exits and virtual interrupts raised at instruction boundary
+  Bit64u asyncDMA;
+
+  // exceptions per vector
+  Bit64u exceptions[BX_CPU_HANDLED_EXCEPTIONS];
+
   bx_cpu_statistics():
       iCacheLookups(0), iCachePrefetch(0), iCacheMisses(0),
+      iCacheEvictions(0), iCacheReclaims(0), iCacheDecodeAhead(0), iCacheTraceFileLoads(0), iCacheReturnHits(0),
       tlbLookups(0), tlbExecuteLookups(0), tlbWriteLookups(0),
-      tlbMisses(0), tlbExecuteMisses(0), tlbWriteMisses(0),
-      tlbGlobalFlushes(0), tlbNonGlobalFlushes(0),
-      stackPrefetch(0), smc(0) {}
+      tlbMisses(0), tlbExecuteMisses(0), tlbWriteMisses(0), tlbLargePageHits(0),
+      pwcHits(0), nestedPwcHits(0),
+      tlbGlobalFlushes(0), tlbNonGlobalFlushes(0), tlbPCIDFlushes(0), tlbPCIDSwitches(0),
+      stackPrefetch(0), smc(0),
+      asyncEvents(0), asyncWaitForEvent(0), asyncSMI(0), asyncINIT(0), asyncDebugTraps(0),
+      asyncNMI(0), asyncInterrupts(0), asyncUserInterrupts(0), asyncVmEvents(0), asyncDMA(0)
+  {
+    memset(opcodeClass, 0, sizeof(opcodeClass));
+    memset(traceLength, 0, sizeof(traceLength));
+    memset(exceptions, 0, sizeof(exceptions));
+  }
 
 };
 
+#if InstrumentCPU
+
+#define INC_CPU_STAT_GROUP(cpu, group, stat) {                                \
+  if ((cpu)->statsMask & (group)) INC_STAT((cpu)->stats -> stat);             \
+}
+
 #define INC_CPU_STAT(stat) INC_STAT(BX_CPU_THIS_PTR stats -> stat)
 
-#if InstrumentICACHE
-  #define INC_ICACHE_STAT(stat) INC_CPU_STAT(stat)
-#else
-  #define INC_ICACHE_STAT(stat)
-#endif
+#define INC_ICACHE_STAT(stat) INC_CPU_STAT_GROUP(BX_CPU_THIS, BX_CPU_STATS_ICACHE, stat)
+#define INC_TLBFLUSH_STAT(stat) INC_CPU_STAT_GROUP(BX_CPU_THIS, BX_CPU_STATS_TLBFLUSH, stat)
+#define INC_TLB_STAT(stat) INC_CPU_STAT_GROUP(BX_CPU_THIS, BX_CPU_STATS_TLB, stat)
+#define INC_STACK_PREFETCH_STAT(stat) INC_CPU_STAT_GROUP(BX_CPU_THIS, BX_CPU_STATS_STACK_PREFETCH, stat)
+#define INC_SMC_STAT(cpu, stat) INC_CPU_STAT_GROUP(cpu, BX_CPU_STATS_SMC, stat)
+#define INC_EVENT_STAT(stat) INC_CPU_STAT_GROUP(BX_CPU_THIS, BX_CPU_STATS_EVENTS, stat)
+#define INC_EXCEPTION_STAT(vector) INC_CPU_STAT_GROUP(BX_CPU_THIS, BX_CPU_STATS_EXCEPTIONS, exceptions[vector])
+
+// the traces are accounted when entered, the linked traces are passed with
+// the maximal length and end with the inserted end of trace opcode
+#define BX_CPU_STATS_TRACE(i, len) {                                          \
+  if (BX_CPU_THIS_PTR statsMask & (BX_CPU_STATS_OPCODES | BX_CPU_STATS_TRACES)) \
+    traceStatistics(i, len);                                                  \
+}
 
-#if InstrumentTLBFlush
-  #define INC_TLBFLUSH_STAT(stat) INC_CPU_STAT(stat)
 #else
-  #define INC_TLBFLUSH_STAT(stat)
-#endif
 
-#if InstrumentTLB
-  #define INC_TLB_STAT(stat) INC_CPU_STAT(stat)
-#else
-  #define INC_TLB_STAT(stat)
-#endif
+#define INC_CPU_STAT(stat)
 
-#if InstrumentStackPrefetch
-  #define INC_STACK_PREFETCH_STAT(stat) INC_CPU_STAT(stat)
-#else
-  #define INC_STACK_PREFETCH_STAT(stat)
-#endif
+#define INC_ICACHE_STAT(stat)
+#define INC_TLBFLUSH_STAT(stat)
+#define INC_TLB_STAT(stat)
+#define INC_STACK_PREFETCH_STAT(stat)
+#define INC_SMC_STAT(cpu, stat)
+#define INC_EVENT_STAT(stat)
+#define INC_EXCEPTION_STAT(vector)
+
+#define BX_CPU_STATS_TRACE(i, len)
 
-#if InstrumentSMC
-  #define INC_SMC_STAT(stat) INC_CPU_STAT(stat)
-#else
-  #define INC_SMC_STAT(stat)
 #endif
 
 #endif
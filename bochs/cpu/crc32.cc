@@ -28,6 +28,8 @@
 
 #if BX_CPU_LEVEL >= 6
 
+#include "host_crypto.h"
+
 // 3-byte opcodes
 
 const Bit64u CRC32_POLYNOMIAL = BX_CONST64(0x11edc6f41);
@@ -72,19 +74,78 @@ static Bit32u mod2_64bit(Bit64u divisor, Bit64u dividend)
   return (Bit32u) remainder;
 }
 
-void BX_CPP_AttrRegparmN(1) BX_CPU_C::CRC32_GdEbR(bxInstruction_c *i)
+// CRC32 (polynomial 11EDC6F41H) of the value appended to crc, on the host CRC32 when available
+
+static Bit32u crc32_8(Bit32u crc, Bit8u val)
 {
-  Bit8u op1 = BX_READ_8BIT_REGx(i->src(), i->extend8bitL());
+#if BX_HOST_CRYPTO
+  if (bx_host_crypto.crc32)
+    return host_crc32_8(crc, val);
+#endif
 
-  Bit32u op2 = BX_READ_32BIT_REG(i->dst());
-  op2 = BitReflect32(op2);
+  crc = BitReflect32(crc);
+
+  Bit64u tmp1 = ((Bit64u) BitReflect8 (val)) << 32;
+  Bit64u tmp2 = ((Bit64u) crc) <<  8;
+  Bit64u tmp3 = tmp1 ^ tmp2;
+  crc = mod2_64bit(CRC32_POLYNOMIAL, tmp3);
 
-  Bit64u tmp1 = ((Bit64u) BitReflect8 (op1)) << 32;
-  Bit64u tmp2 = ((Bit64u) op2) <<  8;
+  return BitReflect32(crc);
+}
+
+static Bit32u crc32_16(Bit32u crc, Bit16u val)
+{
+#if BX_HOST_CRYPTO
+  if (bx_host_crypto.crc32)
+    return host_crc32_16(crc, val);
+#endif
+
+  crc = BitReflect32(crc);
+
+  Bit64u tmp1 = ((Bit64u) BitReflect16(val)) << 32;
+  Bit64u tmp2 = ((Bit64u) crc) << 16;
   Bit64u tmp3 = tmp1 ^ tmp2;
-  op2 = mod2_64bit(CRC32_POLYNOMIAL, tmp3);
+  crc = mod2_64bit(CRC32_POLYNOMIAL, tmp3);
+
+  return BitReflect32(crc);
+}
+
+static Bit32u crc32_32(Bit32u crc, Bit32u val)
+{
+#if BX_HOST_CRYPTO
+  if (bx_host_crypto.crc32)
+    return host_crc32_32(crc, val);
+#endif
+
+  crc = BitReflect32(crc);
+
+  Bit64u tmp1 = ((Bit64u) BitReflect32(val)) << 32;
+  Bit64u tmp2 = ((Bit64u) crc) << 32;
+  Bit64u tmp3 = tmp1 ^ tmp2;
+  crc = mod2_64bit(CRC32_POLYNOMIAL, tmp3);
+
+  return BitReflect32(crc);
+}
+
+#if BX_SUPPORT_X86_64
+static Bit32u crc32_64(Bit32u crc, Bit64u val)
+{
+#if BX_HOST_CRYPTO
+  if (bx_host_crypto.crc32)
+    return host_crc32_64(crc, val);
+#endif
+
+  crc = crc32_32(crc, (Bit32u) val);
+  return crc32_32(crc, (Bit32u)(val >> 32));
+}
+#endif
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::CRC32_GdEbR(bxInstruction_c *i)
+{
+  Bit8u op1 = BX_READ_8BIT_REGx(i->src(), i->extend8bitL());
+  Bit32u op2 = BX_READ_32BIT_REG(i->dst());
 
-  BX_WRITE_32BIT_REGZ(i->dst(), BitReflect32(op2));
+  BX_WRITE_32BIT_REGZ(i->dst(), crc32_8(op2, op1));
 
   BX_NEXT_INSTR(i);
 }
@@ -92,15 +153,9 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::CRC32_GdEbR(bxInstruction_c *i)
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::CRC32_GdEwR(bxInstruction_c *i)
 {
   Bit32u op2 = BX_READ_32BIT_REG(i->dst());
-  op2 = BitReflect32(op2);
   Bit16u op1 = BX_READ_16BIT_REG(i->src());
 
-  Bit64u tmp1 = ((Bit64u) BitReflect16(op1)) << 32;
-  Bit64u tmp2 = ((Bit64u) op2) << 16;
-  Bit64u tmp3 = tmp1 ^ tmp2;
-  op2 = mod2_64bit(CRC32_POLYNOMIAL, tmp3);
-
-  BX_WRITE_32BIT_REGZ(i->dst(), BitReflect32(op2));
+  BX_WRITE_32BIT_REGZ(i->dst(), crc32_16(op2, op1));
 
   BX_NEXT_INSTR(i);
 }
@@ -108,15 +163,9 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::CRC32_GdEwR(bxInstruction_c *i)
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::CRC32_GdEdR(bxInstruction_c *i)
 {
   Bit32u op2 = BX_READ_32BIT_REG(i->dst());
-  op2 = BitReflect32(op2);
   Bit32u op1 = BX_READ_32BIT_REG(i->src());
 
-  Bit64u tmp1 = ((Bit64u) BitReflect32(op1)) << 32;
-  Bit64u tmp2 = ((Bit64u) op2) << 32;
-  Bit64u tmp3 = tmp1 ^ tmp2;
-  op2 = mod2_64bit(CRC32_POLYNOMIAL, tmp3);
-
-  BX_WRITE_32BIT_REGZ(i->dst(), BitReflect32(op2));
+  BX_WRITE_32BIT_REGZ(i->dst(), crc32_32(op2, op1));
 
   BX_NEXT_INSTR(i);
 }
@@ -126,23 +175,49 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::CRC32_GdEdR(bxInstruction_c *i)
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::CRC32_GdEqR(bxInstruction_c *i)
 {
   Bit32u op2 = BX_READ_32BIT_REG(i->dst());
-  op2 = BitReflect32(op2);
   Bit64u op1 = BX_READ_64BIT_REG(i->src());
 
-  Bit64u tmp1 = ((Bit64u) BitReflect32(op1 & 0xffffffff)) << 32;
-  Bit64u tmp2 = ((Bit64u) op2) << 32;
-  Bit64u tmp3 = tmp1 ^ tmp2;
-  op2  = mod2_64bit(CRC32_POLYNOMIAL, tmp3);
-  tmp1 = ((Bit64u) BitReflect32(op1 >> 32)) << 32;
-  tmp2 = ((Bit64u) op2) << 32;
-  tmp3 = tmp1 ^ tmp2;
-  op2  = mod2_64bit(CRC32_POLYNOMIAL, tmp3);
-
-  BX_WRITE_32BIT_REGZ(i->dst(), BitReflect32(op2));
+  BX_WRITE_32BIT_REGZ(i->dst(), crc32_64(op2, op1));
 
   BX_NEXT_INSTR(i);
 }
 
 #endif // BX_SUPPORT_X86_64
 
+#if BX_HOST_CRYPTO
+
+static void crc32_8_test(BxPackedXmmRegister *dst, const BxPackedXmmRegister *src, const BxPackedXmmRegister *xmm0, Bit8u imm8)
+{
+  dst->xmm32u(0) = crc32_8(dst->xmm32u(0), src->xmmubyte(0));
+}
+
+static void crc32_16_test(BxPackedXmmRegister *dst, const BxPackedXmmRegister *src, const BxPackedXmmRegister *xmm0, Bit8u imm8)
+{
+  dst->xmm32u(0) = crc32_16(dst->xmm32u(0), src->xmm16u(0));
+}
+
+static void crc32_32_test(BxPackedXmmRegister *dst, const BxPackedXmmRegister *src, const BxPackedXmmRegister *xmm0, Bit8u imm8)
+{
+  dst->xmm32u(0) = crc32_32(dst->xmm32u(0), src->xmm32u(0));
+}
+
+#if BX_SUPPORT_X86_64
+static void crc32_64_test(BxPackedXmmRegister *dst, const BxPackedXmmRegister *src, const BxPackedXmmRegister *xmm0, Bit8u imm8)
+{
+  dst->xmm32u(0) = crc32_64(dst->xmm32u(0), src->xmm64u(0));
+}
+#endif
+
+const bxHostCryptoTest_t bx_crc32_host_crypto_tests[] = {
+  { "CRC32 Gd,Eb", crc32_8_test,  &bx_host_crypto.crc32 },
+  { "CRC32 Gd,Ew", crc32_16_test, &bx_host_crypto.crc32 },
+  { "CRC32 Gd,Ed", crc32_32_test, &bx_host_crypto.crc32 },
+#if BX_SUPPORT_X86_64
+  { "CRC32 Gd,Eq", crc32_64_test, &bx_host_crypto.crc32 },
+#endif
+  { NULL, NULL, NULL }
+};
+
+#endif
+
 #endif // BX_CPU_LEVEL >= 6
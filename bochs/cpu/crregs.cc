@@ -717,12 +717,14 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::MOV_CR3Rq(bxInstruction_c *i)
 #endif
 
   // allow bit 63 (hint that TLB doesn't need to be cleared) to be set when
-  // PCIDE is set, but ignore the hint if given
+  // PCIDE is set, the TLB entries of the new PCID are kept if given
+  bool noflush = false;
   if (BX_CPU_THIS_PTR cr4.get_PCIDE()) {
+    noflush = (val_64 >> 63) != 0;
     val_64 &= ~(BX_CONST64(1)<<63);
   }
 
-  if (! SetCR3(val_64))
+  if (! SetCR3(val_64, noflush))
     exception(BX_GP_EXCEPTION, 0);
 
   BX_INSTR_TLB_CNTRL(BX_CPU_ID, BX_INSTR_MOV_CR3, val_64);
@@ -1421,7 +1423,7 @@ bool BX_CPU_C::SetCR4(bxInstruction_c *i, bx_address val)
 }
 #endif // BX_CPU_LEVEL >= 5
 
-bool BX_CPP_AttrRegparmN(1) BX_CPU_C::SetCR3(bx_address val)
+bool BX_CPP_AttrRegparmN(2) BX_CPU_C::SetCR3(bx_address val, bool noflush)
 {
 #if BX_SUPPORT_X86_64
   if (long_mode()) {
@@ -1434,6 +1436,14 @@ bool BX_CPP_AttrRegparmN(1) BX_CPU_C::SetCR3(bx_address val)
 
   BX_CPU_THIS_PTR cr3 = val;
 
+#if BX_SUPPORT_X86_64
+  // TLB entries are tagged with the PCID, the entries of other PCIDs are kept
+  if (BX_CPU_THIS_PTR cr4.get_PCIDE()) {
+    TLB_switchPCID(! noflush);
+    return true;
+  }
+#endif
+
   // flush TLB even if value does not change
 #if BX_CPU_LEVEL >= 6
   if (BX_CPU_THIS_PTR cr4.get_PGE())
@@ -1472,6 +1482,12 @@ bool BX_CPP_AttrRegparmN(1) BX_CPU_C::SetEFER(bx_address val_64)
   }
 #endif
 
+#if BX_SUPPORT_X86_64
+  // the paging structure cache entries were checked for reserved NX bit
+  if (BX_CPU_THIS_PTR efer.get_NXE() != ((val32 & BX_EFER_NXE_MASK) != 0))
+    BX_CPU_THIS_PTR PWC.flush();
+#endif
+
   BX_CPU_THIS_PTR efer.set32((val32 & BX_CPU_THIS_PTR efer_suppmask & ~BX_EFER_LMA_MASK)
         | (BX_CPU_THIS_PTR efer.get32() & BX_EFER_LMA_MASK)); // keep LMA untouched
 
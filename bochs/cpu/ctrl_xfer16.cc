@@ -143,7 +143,7 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::RETnear16_Iw(bxInstruction_c *i)
 
   BX_INSTR_UCNEAR_BRANCH(BX_CPU_ID, BX_INSTR_IS_RET, PREV_RIP, EIP);
 
-  BX_NEXT_TRACE(i);
+  BX_LINK_RETURN(i);
 }
 
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::RETfar16_Iw(bxInstruction_c *i)
@@ -201,6 +201,7 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::CALL_Jw(bxInstruction_c *i)
 
   /* push 16 bit EA of next instruction */
   push_16(IP);
+  pushReturnTrace(IP);
 #if BX_SUPPORT_CET
   if (ShadowStackEnabled(CPL) && i->Iw())
     shadow_stack_push_32(IP);
@@ -240,6 +241,7 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::CALL_EwR(bxInstruction_c *i)
 
   /* push 16 bit EA of next instruction */
   push_16(IP);
+  pushReturnTrace(IP);
 #if BX_SUPPORT_CET
   if (ShadowStackEnabled(CPL))
     shadow_stack_push_32(IP);
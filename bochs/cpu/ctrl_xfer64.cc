@@ -72,7 +72,7 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::RETnear64_Iw(bxInstruction_c *i)
 
   BX_INSTR_UCNEAR_BRANCH(BX_CPU_ID, BX_INSTR_IS_RET, PREV_RIP, RIP);
 
-  BX_NEXT_TRACE(i);
+  BX_LINK_RETURN(i);
 }
 
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::RETfar64_Iw(bxInstruction_c *i)
@@ -113,6 +113,7 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::CALL_Jq(bxInstruction_c *i)
 
   /* push 64 bit EA of next instruction */
   push_64(RIP);
+  pushReturnTrace(RIP);
 #if BX_SUPPORT_CET
   if (ShadowStackEnabled(CPL) && i->Id())
     shadow_stack_push_64(RIP);
@@ -144,6 +145,7 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::CALL_EqR(bxInstruction_c *i)
 
   /* push 64 bit EA of next instruction */
   push_64(RIP);
+  pushReturnTrace(RIP);
 #if BX_SUPPORT_CET
   if (ShadowStackEnabled(CPL))
     shadow_stack_push_64(RIP);
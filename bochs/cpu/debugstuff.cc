@@ -28,6 +28,9 @@
 #include "memory/memory-bochs.h"
 #include "pc_system.h"
 
+#include "tracefile.h"
+#include "profiler.h"
+
 const char *stringify_EFLAGS(Bit32u eflags, char *s)
 {
   /* 31|30|29|28| 27|26|25|24| 23|22|21|20| 19|18|17|16
@@ -496,4 +499,20 @@ void BX_CPU_C::dbg_get_guard_state(bx_dbg_guard_state_t *guard_state)
 void BX_CPU_C::atexit(void)
 {
   debug(BX_CPU_THIS_PTR prev_rip);
+
+#if BX_SUPPORT_JIT
+  if (BX_CPU_THIS_PTR jit) {
+    BX_INFO(("trace compiler: " FMT_LL "u traces compiled, code buffer flushed " FMT_LL "u times",
+      BX_CPU_THIS_PTR jit->compiledTraces, BX_CPU_THIS_PTR jit->bufferFlushes));
+    if (BX_CPU_THIS_PTR jit->verify) {
+      BX_INFO(("trace compiler: " FMT_LL "u native code runs verified, " FMT_LL "u mismatches",
+        BX_CPU_THIS_PTR jit->verifiedRuns, BX_CPU_THIS_PTR jit->verifyMismatches));
+    }
+  }
+#endif
+
+  if (BX_CPU_ID == 0) {
+    traceFile.save();
+    profiler.save();
+  }
 }
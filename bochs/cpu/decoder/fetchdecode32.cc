@@ -26,6 +26,7 @@
 #define NEED_CPU_TEMPLATE_METHODS 1
 #include "../cpu.h"
 #include "../cpuid.h"
+#include "../cpustats.h"
 #endif
 
 #include "decoder.h"
@@ -2259,6 +2260,112 @@ const char *get_bx_opcode_name(Bit16u ia_opcode)
   return (ia_opcode < BX_IA_LAST) ? BxOpcodeNamesTable[ia_opcode] : 0;
 }
 
+#if BX_ENABLE_STATISTICS && !defined(BX_STANDALONE_DECODER)
+unsigned get_bx_opcode_stats_class(Bit16u ia_opcode)
+{
+  static const Bit8u BxOpcodeFeatures[BX_IA_LAST] =
+  {
+#define bx_define_opcode(a, b, c, d, e, f, s1, s2, s3, s4, g) f,
+#include "ia_opcodes.def"
+  };
+#undef  bx_define_opcode
+
+  if (ia_opcode >= BX_IA_LAST)
+    return BX_STATS_OPCODE_INTEGER;
+
+  switch(BxOpcodeFeatures[ia_opcode]) {
+    case BX_ISA_X87:
+      return BX_STATS_OPCODE_X87;
+
+    case BX_ISA_MMX:
+    case BX_ISA_3DNOW:
+    case BX_ISA_3DNOW_EXT:
+      return BX_STATS_OPCODE_MMX;
+
+    case BX_ISA_SSE:
+    case BX_ISA_SSE2:
+    case BX_ISA_SSE3:
+    case BX_ISA_SSSE3:
+    case BX_ISA_SSE4_1:
+    case BX_ISA_SSE4_2:
+    case BX_ISA_SSE4A:
+    case BX_ISA_AES_PCLMULQDQ:
+    case BX_ISA_SHA:
+    case BX_ISA_GFNI:
+      return BX_STATS_OPCODE_SSE;
+
+    case BX_ISA_AVX:
+    case BX_ISA_AVX2:
+    case BX_ISA_AVX_F16C:
+    case BX_ISA_AVX_FMA:
+    case BX_ISA_FMA4:
+    case BX_ISA_XOP:
+    case BX_ISA_VAES_VPCLMULQDQ:
+    case BX_ISA_SHA512:
+    case BX_ISA_SM3:
+    case BX_ISA_SM4:
+    case BX_ISA_AVX_IFMA:
+    case BX_ISA_AVX_VNNI:
+    case BX_ISA_AVX_VNNI_INT8:
+    case BX_ISA_AVX_VNNI_INT16:
+    case BX_ISA_AVX_NE_CONVERT:
+      return BX_STATS_OPCODE_AVX;
+
+    case BX_ISA_AVX512:
+    case BX_ISA_AVX512_DQ:
+    case BX_ISA_AVX512_BW:
+    case BX_ISA_AVX512_CD:
+    case BX_ISA_AVX512_VBMI:
+    case BX_ISA_AVX512_VBMI2:
+    case BX_ISA_AVX512_IFMA52:
+    case BX_ISA_AVX512_VPOPCNTDQ:
+    case BX_ISA_AVX512_VNNI:
+    case BX_ISA_AVX512_BITALG:
+    case BX_ISA_AVX512_VP2INTERSECT:
+    case BX_ISA_AVX512_BF16:
+    case BX_ISA_AVX512_FP16:
+    case BX_ISA_AVX10_1:
+    case BX_ISA_AVX10_2:
+    case BX_ISA_AVX10_2_MOVRS:
+      return BX_STATS_OPCODE_AVX512;
+
+    case BX_ISA_AMX:
+    case BX_ISA_AMX_INT8:
+    case BX_ISA_AMX_BF16:
+    case BX_ISA_AMX_FP16:
+    case BX_ISA_AMX_TF32:
+    case BX_ISA_AMX_COMPLEX:
+    case BX_ISA_AMX_MOVRS:
+    case BX_ISA_AMX_AVX512:
+      return BX_STATS_OPCODE_AMX;
+
+    case BX_ISA_VMX:
+    case BX_ISA_SVM:
+    case BX_ISA_SMX:
+    case BX_ISA_XSAVE:
+    case BX_ISA_XSAVEOPT:
+    case BX_ISA_XSAVEC:
+    case BX_ISA_XSAVES:
+    case BX_ISA_MONITOR_MWAIT:
+    case BX_ISA_MONITORX_MWAITX:
+    case BX_ISA_WAITPKG:
+    case BX_ISA_SYSCALL_SYSRET_LEGACY:
+    case BX_ISA_SYSENTER_SYSEXIT:
+    case BX_ISA_FSGSBASE:
+    case BX_ISA_INVPCID:
+    case BX_ISA_UINTR:
+    case BX_ISA_SERIALIZE:
+    case BX_ISA_MSRLIST:
+    case BX_ISA_WRMSRNS:
+    case BX_ISA_MSR_IMM:
+      return BX_STATS_OPCODE_SYSTEM;
+
+    default:
+      return BX_STATS_OPCODE_INTEGER;
+  }
+}
+#endif
+
 const char *get_intel_disasm_opcode_name(Bit16u ia_opcode)
 {
   static const char* BxOpcodeNamesTable[BX_IA_LAST] =
@@ -59,6 +59,9 @@ public:
   union {
     BxExecutePtr_tR execute2;
     bxInstruction_c *next;
+#if BX_SUPPORT_JIT
+    void *jitCode; // native code of the compiled trace (jit.h)
+#endif
   } handlers;
 #endif
 
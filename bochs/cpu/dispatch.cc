@@ -0,0 +1,146 @@
+/////////////////////////////////////////////////////////////////////////
+// $Id$
+/////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (C) 2026  The Bochs Project
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA B 02110-1301 USA
+//
+/////////////////////////////////////////////////////////////////////////
+
+#define NEED_CPU_REG_SHORTCUTS 1
+#include "bochs.h"
+#include "cpu.h"
+#define LOG_THIS BX_CPU_THIS_PTR
+
+#if BX_SUPPORT_THREADED_DISPATCH
+
+#include "pc_system.h"
+#include "decoder/ia_opcodes.h"
+#include "decoder/fetchdecode.h"
+
+extern struct bxIAOpcodeTable BxOpcodesTable[];
+
+// Threaded dispatch (--enable-threaded-dispatch)
+//
+// Without handlers chaining cpu_loop calls every handler through the
+// execute1 pointer from a single call site, the host predicts that indirect
+// call poorly. The threaded dispatch loop jumps to a label of its own for
+// each of the most common handlers (hot_handlers.def), the label calls the
+// handler directly and ends with its own copy of the dispatch jump, so the
+// host branch predictor learns which handler usually follows which.
+//
+// The label is selected from the opcode and the mod==c0 form. The handler
+// assigned to the instruction could still be a different one (for example
+// BxNoSSE, or the SS segment variants of MOV), the label checks execute1
+// and falls back to the indirect call.
+
+enum {
+  BX_HOT_HANDLER_NONE = 0,
+#define bx_hot_handler(h) BX_HOT_HANDLER_##h,
+#include "hot_handlers.def"
+#undef bx_hot_handler
+  BX_HOT_HANDLER_LAST
+};
+
+static const BxExecutePtr_tR hotHandlers[BX_HOT_HANDLER_LAST] = {
+  NULL,
+#define bx_hot_handler(h) &BX_CPU_C::h,
+#include "hot_handlers.def"
+#undef bx_hot_handler
+};
+
+// hot handler executed by every opcode in the memory and in the register form
+static Bit16u *buildDispatchSlots(void)
+{
+  Bit16u *slots = new Bit16u[BX_IA_LAST * 2];
+
+  for (unsigned n=0; n < BX_IA_LAST; n++) {
+    for (unsigned modC0 = 0; modC0 < 2; modC0++) {
+      BxExecutePtr_tR handler = modC0 ? BxOpcodesTable[n].execute2 : BxOpcodesTable[n].execute1;
+      Bit16u slot = BX_HOT_HANDLER_NONE;
+      if (handler) {
+        for (unsigned k=1; k < BX_HOT_HANDLER_LAST; k++) {
+          if (hotHandlers[k] == handler) {
+            slot = k;
+            break;
+          }
+        }
+      }
+      slots[n*2 + modC0] = slot;
+    }
+  }
+
+  return slots;
+}
+
+// Executes the instructions from the trace cache entry until an asynchronous
+// event is pending, with oneTrace set only until the end of the trace.
+void BX_CPU_C::threadedDispatch(bxICacheEntry_c *entry, bool oneTrace)
+{
+  static const void * const labels[BX_HOT_HANDLER_LAST] = {
+    &&generic,
+#define bx_hot_handler(h) &&hot_##h,
+#include "hot_handlers.def"
+#undef bx_hot_handler
+  };
+  static const Bit16u * const slots = buildDispatchSlots();
+
+  bxInstruction_c *i = entry->i;
+  bxInstruction_c *last = i + entry->tlen;
+
+#define BX_DISPATCH() {                                                   \
+    /* want to allow changing of the instruction inside instrumentation callback */ \
+    BX_INSTR_BEFORE_EXECUTION(BX_CPU_ID, i);                              \
+    RIP += i->ilen();                                                     \
+    goto *labels[slots[i->getIaOpcode() * 2 + (i->modC0() != 0)]];       \
+  }
+
+#define BX_DISPATCH_NEXT() {                                              \
+    BX_CPU_THIS_PTR prev_rip = RIP; /* commit new RIP */                  \
+    BX_INSTR_AFTER_EXECUTION(BX_CPU_ID, i);                               \
+    BX_CPU_THIS_PTR icount++;                                             \
+    if (BX_SMP_PROCESSORS == 1) BX_TICK1();                               \
+    if (BX_CPU_THIS_PTR async_event) return;                              \
+    if (++i == last) goto trace_end;                                      \
+    BX_DISPATCH();                                                        \
+  }
+
+  BX_DISPATCH();
+
+trace_end:
+  if (oneTrace) return;
+  entry = getICacheEntry();
+  i = entry->i;
+  last = i + entry->tlen;
+  BX_DISPATCH();
+
+generic:
+  BX_CPU_CALL_METHOD(i->execute1, (i)); // might iterate repeat instruction
+  BX_DISPATCH_NEXT();
+
+#define bx_hot_handler(h)                                                 \
+hot_##h:                                                                  \
+  if (i->execute1 != &BX_CPU_C::h) goto generic;                          \
+  BX_CPU_THIS_PTR h(i);                                                   \
+  BX_DISPATCH_NEXT();
+#include "hot_handlers.def"
+#undef bx_hot_handler
+
+#undef BX_DISPATCH
+#undef BX_DISPATCH_NEXT
+}
+
+#endif // BX_SUPPORT_THREADED_DISPATCH
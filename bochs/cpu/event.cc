@@ -25,6 +25,8 @@
 #include "cpu.h"
 #define LOG_THIS BX_CPU_THIS_PTR
 
+#include "cpustats.h"
+
 #if BX_SUPPORT_APIC
 #include "apic.h"
 #endif
@@ -37,6 +39,32 @@
 
 #include "bx_debug/debug.h"
 
+// an event which ends the HLT or MWAIT condition is pending
+bool BX_CPU_C::wakeupEventPending(void)
+{
+  return (is_pending(BX_EVENT_PENDING_INTR | BX_EVENT_PENDING_LAPIC_INTR | BX_EVENT_PENDING_UINTR) && (BX_CPU_THIS_PTR get_IF() || BX_CPU_THIS_PTR activity_state == BX_ACTIVITY_STATE_MWAIT_IF)) ||
+         is_unmasked_event_pending(BX_EVENT_NMI | BX_EVENT_SMI | BX_EVENT_INIT |
+            BX_EVENT_VMX_VTPR_UPDATE |
+            BX_EVENT_VMX_VEOI_UPDATE |
+            BX_EVENT_VMX_VIRTUAL_APIC_WRITE |
+            BX_EVENT_VMX_MONITOR_TRAP_FLAG |
+            BX_EVENT_VMX_VIRTUAL_NMI);
+}
+
+// The processor waits for an event which is not pending yet, it does not
+// execute anything until a timer or another processor wakes it up.
+bool BX_CPU_C::isWaitingForEvent(void)
+{
+  if (BX_CPU_THIS_PTR activity_state == BX_ACTIVITY_STATE_ACTIVE)
+    return false;
+
+  if (BX_CPU_THIS_PTR activity_state == BX_ACTIVITY_STATE_WAIT_FOR_SIPI)
+    return true;
+
+  return ! wakeupEventPending() &&
+         ! is_unmasked_event_pending(BX_EVENT_VMX_PREEMPTION_TIMER_EXPIRED);
+}
+
 bool BX_CPU_C::handleWaitForEvent(void)
 {
   if (BX_CPU_THIS_PTR activity_state == BX_ACTIVITY_STATE_WAIT_FOR_SIPI) {
@@ -51,13 +79,7 @@ bool BX_CPU_C::handleWaitForEvent(void)
   // an interrupt wakes up the CPU.
   while (1)
   {
-    if ((is_pending(BX_EVENT_PENDING_INTR | BX_EVENT_PENDING_LAPIC_INTR | BX_EVENT_PENDING_UINTR) && (BX_CPU_THIS_PTR get_IF() || BX_CPU_THIS_PTR activity_state == BX_ACTIVITY_STATE_MWAIT_IF)) ||
-         is_unmasked_event_pending(BX_EVENT_NMI | BX_EVENT_SMI | BX_EVENT_INIT |
-            BX_EVENT_VMX_VTPR_UPDATE |
-            BX_EVENT_VMX_VEOI_UPDATE |
-            BX_EVENT_VMX_VIRTUAL_APIC_WRITE |
-            BX_EVENT_VMX_MONITOR_TRAP_FLAG |
-            BX_EVENT_VMX_VIRTUAL_NMI))
+    if (wakeupEventPending())
     {
       // interrupt ends the HALT condition
 #if BX_SUPPORT_MONITOR_MWAIT
@@ -82,6 +104,7 @@ bool BX_CPU_C::handleWaitForEvent(void)
 
     if (BX_HRQ && BX_DBG_ASYNC_DMA) {
       // handle DMA also when CPU is halted
+      BX_SMP_DEVICE_LOCK();
       DEV_dma_raise_hlda();
     }
 
@@ -109,7 +132,12 @@ bool BX_CPU_C::handleWaitForEvent(void)
       return 1; // Return to caller of cpu_loop.
     }
 
-    BX_TICKN(10); // when in HLT run time faster for single CPU
+    if (bx_pc_system.snapshot_request)
+      return 1; // Return to caller of cpu_loop.
+
+    // skip to the next timer event if enabled
+    if (! bx_pc_system.idle_skip())
+      BX_TICKN(10); // when in HLT run time faster for single CPU
   }
 
   return 0;
@@ -124,8 +152,11 @@ Bit8u BX_CPU_C::interrupt_acknowledge(void)
     vector = BX_CPU_THIS_PTR lapic->acknowledge_int();
   else
 #endif
+  {
     // if no local APIC, always acknowledge the PIC.
+    BX_SMP_DEVICE_LOCK();
     vector = DEV_pic_iac(); // may set INTR with next interrupt
+  }
 
   return vector;
 }
@@ -207,7 +238,10 @@ bool BX_CPU_C::handleAsyncEvent(void)
   //
   // This area is where we process special conditions and events.
   //
+  INC_EVENT_STAT(asyncEvents);
+
   if (BX_CPU_THIS_PTR activity_state != BX_ACTIVITY_STATE_ACTIVE) {
+    INC_EVENT_STAT(asyncWaitForEvent);
     // For one processor, pass the time as quickly as possible until
     // an interrupt wakes up the CPU.
     if (handleWaitForEvent()) return 1;
@@ -218,6 +252,9 @@ bool BX_CPU_C::handleAsyncEvent(void)
     return 1; // Return to caller of cpu_loop.
   }
 
+  if (bx_pc_system.snapshot_request)
+    return 1; // Return to caller of cpu_loop.
+
   // Priority 1: Hardware Reset and Machine Checks
   //   RESET
   //   Machine Check
@@ -237,6 +274,7 @@ bool BX_CPU_C::handleAsyncEvent(void)
   if (is_unmasked_event_pending(BX_EVENT_VMX_VTPR_UPDATE |
                                 BX_EVENT_VMX_VEOI_UPDATE | BX_EVENT_VMX_VIRTUAL_APIC_WRITE))
   {
+    INC_EVENT_STAT(asyncVmEvents);
     VMX_Virtual_Apic_Access_Trap();
   }
 #endif
@@ -244,6 +282,7 @@ bool BX_CPU_C::handleAsyncEvent(void)
   // Priority 2: Trap on Task Switch
   //   T flag in TSS is set
   if (BX_CPU_THIS_PTR debug_trap & BX_DEBUG_TRAP_TASK_SWITCH_BIT) {
+    INC_EVENT_STAT(asyncDebugTraps);
     exception(BX_DB_EXCEPTION, 0); // no error, not interrupt
   }
 
@@ -254,6 +293,7 @@ bool BX_CPU_C::handleAsyncEvent(void)
   //   INIT
   if (is_unmasked_event_pending(BX_EVENT_SMI) && SVM_GIF)
   {
+    INC_EVENT_STAT(asyncSMI);
 #if BX_SUPPORT_SVM
     if (BX_CPU_THIS_PTR in_svm_guest) {
       if (SVM_INTERCEPT(SVM_INTERCEPT0_SMI)) Svm_Vmexit(SVM_VMEXIT_SMI);
@@ -264,6 +304,7 @@ bool BX_CPU_C::handleAsyncEvent(void)
   }
 
   if (is_unmasked_event_pending(BX_EVENT_INIT) && SVM_GIF) {
+    INC_EVENT_STAT(asyncINIT);
 #if BX_SUPPORT_SVM
     if (BX_CPU_THIS_PTR in_svm_guest) {
       if (SVM_INTERCEPT(SVM_INTERCEPT0_INIT)) Svm_Vmexit(SVM_VMEXIT_INIT); // INIT is still pending
@@ -298,6 +339,7 @@ bool BX_CPU_C::handleAsyncEvent(void)
 #if BX_SUPPORT_VMX
   if (is_pending(BX_EVENT_VMX_MONITOR_TRAP_FLAG)) {
     if (is_unmasked_event_pending(BX_EVENT_VMX_MONITOR_TRAP_FLAG)) {
+      INC_EVENT_STAT(asyncVmEvents);
       VMexit(VMX_VMEXIT_MONITOR_TRAP_FLAG, 0);
     }
     else {
@@ -316,6 +358,7 @@ bool BX_CPU_C::handleAsyncEvent(void)
     BX_CPU_THIS_PTR debug_trap |= code_breakpoint_match(get_laddr(BX_SEG_REG_CS, BX_CPU_THIS_PTR prev_rip));
 #endif
     if (BX_CPU_THIS_PTR debug_trap & 0xf000) {
+      INC_EVENT_STAT(asyncDebugTraps);
       exception(BX_DB_EXCEPTION, 0); // no error, not interrupt
     }
     else {
@@ -334,6 +377,7 @@ bool BX_CPU_C::handleAsyncEvent(void)
     // execution of STI doesn't block User interrupts delivery, only MOV_SS does
     if (! interrupts_inhibited(BX_INHIBIT_INTERRUPTS_BY_MOVSS)) {
       if (is_unmasked_event_pending(BX_EVENT_PENDING_UINTR)) {
+        INC_EVENT_STAT(asyncUserInterrupts);
         deliver_UINTR();
       }
     }
@@ -341,15 +385,18 @@ bool BX_CPU_C::handleAsyncEvent(void)
   }
 #if BX_SUPPORT_VMX >= 2
   else if (is_unmasked_event_pending(BX_EVENT_VMX_PREEMPTION_TIMER_EXPIRED)) {
+    INC_EVENT_STAT(asyncVmEvents);
     VMexit(VMX_VMEXIT_VMX_PREEMPTION_TIMER_EXPIRED, 0);
   }
 #endif
 #if BX_SUPPORT_VMX
   else if (is_unmasked_event_pending(BX_EVENT_VMX_VIRTUAL_NMI)) {
+    INC_EVENT_STAT(asyncVmEvents);
     VMexit(VMX_VMEXIT_NMI_WINDOW, 0);
   }
 #endif
   else if (is_unmasked_event_pending(BX_EVENT_NMI)) {
+    INC_EVENT_STAT(asyncNMI);
 #if BX_SUPPORT_SVM
     if (BX_CPU_THIS_PTR in_svm_guest) {
       if (SVM_INTERCEPT(SVM_INTERCEPT0_NMI)) Svm_Vmexit(SVM_VMEXIT_NMI);
@@ -366,6 +413,7 @@ bool BX_CPU_C::handleAsyncEvent(void)
   }
 #if BX_SUPPORT_VMX
   else if (is_pending(BX_EVENT_VMX_INTERRUPT_WINDOW_EXITING) && BX_CPU_THIS_PTR get_IF()) {
+    INC_EVENT_STAT(asyncVmEvents);
     // interrupt-window exiting
     VMexit(VMX_VMEXIT_INTERRUPT_WINDOW, 0);
   }
@@ -373,23 +421,28 @@ bool BX_CPU_C::handleAsyncEvent(void)
   else if (is_unmasked_event_pending(BX_EVENT_PENDING_INTR | BX_EVENT_PENDING_LAPIC_INTR |
                                      BX_EVENT_PENDING_VMX_VIRTUAL_INTR))
   {
+    INC_EVENT_STAT(asyncInterrupts);
     HandleExtInterrupt();
   }
 #if BX_SUPPORT_UINTR
   else if (is_unmasked_event_pending(BX_EVENT_PENDING_UINTR))
   {
+    INC_EVENT_STAT(asyncUserInterrupts);
     deliver_UINTR();
   }
 #endif
 #if BX_SUPPORT_SVM
   else if (is_unmasked_event_pending(BX_EVENT_SVM_VIRQ_PENDING))
   {
+    INC_EVENT_STAT(asyncVmEvents);
     SvmVirtualInterruptAcknowledge();
   }
 #endif
   else if (BX_HRQ && BX_DBG_ASYNC_DMA) {
     // NOTE: similar code in ::take_dma()
     // assert Hold Acknowledge (HLDA) and go into a bus hold state
+    INC_EVENT_STAT(asyncDMA);
+    BX_SMP_DEVICE_LOCK();
     DEV_dma_raise_hlda();
   }
 
@@ -472,6 +525,13 @@ void BX_CPU_C::deliver_SIPI(unsigned vector)
 
 void BX_CPU_C::deliver_INIT(void)
 {
+#if BX_SUPPORT_SMP
+  if (bx_smp_is_remote_cpu(BX_CPU_ID)) {
+    smp_post_request(BX_SMP_REQ_DELIVER_INIT);
+    return;
+  }
+#endif
+
   if (! is_masked_event(BX_EVENT_INIT)) {
     signal_event(BX_EVENT_INIT);
   }
@@ -479,21 +539,49 @@ void BX_CPU_C::deliver_INIT(void)
 
 void BX_CPU_C::deliver_NMI(void)
 {
+#if BX_SUPPORT_SMP
+  if (bx_smp_is_remote_cpu(BX_CPU_ID)) {
+    smp_post_request(BX_SMP_REQ_DELIVER_NMI);
+    return;
+  }
+#endif
+
   signal_event(BX_EVENT_NMI);
 }
 
 void BX_CPU_C::deliver_SMI(void)
 {
+#if BX_SUPPORT_SMP
+  if (bx_smp_is_remote_cpu(BX_CPU_ID)) {
+    smp_post_request(BX_SMP_REQ_DELIVER_SMI);
+    return;
+  }
+#endif
+
   signal_event(BX_EVENT_SMI);
 }
 
 void BX_CPU_C::raise_INTR(void)
 {
+#if BX_SUPPORT_SMP
+  if (bx_smp_is_remote_cpu(BX_CPU_ID)) {
+    smp_post_request(BX_SMP_REQ_RAISE_INTR);
+    return;
+  }
+#endif
+
   signal_event(BX_EVENT_PENDING_INTR);
 }
 
 void BX_CPU_C::clear_INTR(void)
 {
+#if BX_SUPPORT_SMP
+  if (bx_smp_is_remote_cpu(BX_CPU_ID)) {
+    smp_post_request(BX_SMP_REQ_CLEAR_INTR);
+    return;
+  }
+#endif
+
   clear_event(BX_EVENT_PENDING_INTR);
 }
 
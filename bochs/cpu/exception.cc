@@ -25,6 +25,8 @@
 #include "cpu.h"
 #define LOG_THIS BX_CPU_THIS_PTR
 
+#include "cpustats.h"
+
 #if BX_SUPPORT_SVM
 #include "svm.h"
 #endif
@@ -941,6 +943,7 @@ void BX_CPU_C::exception(unsigned vector, Bit16u error_code)
   bool push_error = false;
 
   if (vector < BX_CPU_HANDLED_EXCEPTIONS) {
+     INC_EXCEPTION_STAT(vector);
      push_error = exception_push_error(vector);
      exception_class = get_exception_class(vector);
      exception_type = get_exception_type(vector);
@@ -26,239 +26,435 @@
 
 #include "pc_system.h"
 
+#include "bx_debug/debug.h"
+
 //
 // Repeat Speedups methods
 //
+// The MOVS/STOS/CMPS/SCAS iteration handlers call the bulk string engine
+// below when executed with a REP prefix. The engine processes the run of
+// elements ahead of the current one directly in host memory and advances
+// the index registers and the counter past them; the regular handler then
+// executes the last element of the run which updates the flags and lets
+// repeat() check for pending events.
+//
+// The run walks page by page through the data TLB and stops at the first
+// page not cached in the TLB with a host pointer, so the regular handler
+// is called for pages which need a page walk, MMIO pages, pages with a
+// hardware data breakpoint and write monitored pages. Host write access is
+// requested for every written page which invalidates the traces decoded
+// from it (self modifying code). The run is also stopped at the end of the
+// segment, before the index register wraps and before the next timer
+// event; it is not used at all when memory watchpoints are set in the
+// debugger or when a misaligned element would cause an #AC exception.
+//
 
 #if BX_SUPPORT_REPEAT_SPEEDUPS
-Bit32u BX_CPU_C::FastRepMOVSB(unsigned srcSeg, Bit32u srcOff, unsigned dstSeg, Bit32u dstOff, Bit32u byteCount, Bit32u granularity)
-{
-  BX_ASSERT(BX_CPU_THIS_PTR cpu_mode != BX_MODE_LONG_64);
-
-  bx_address laddrSrc, laddrDst;
 
-  bx_segment_reg_t *srcSegPtr = &BX_CPU_THIS_PTR sregs[srcSeg];
-  if (srcSegPtr->cache.valid & SegAccessROK4G) {
-    laddrSrc = srcOff;
+BX_CPP_INLINE Bit64u read_host_string_element(const Bit8u *hostAddr, unsigned len)
+{
+  switch(len) {
+  case 1:
+    return *hostAddr;
+  case 2:
+    return ReadHostWordFromLittleEndian((Bit16u*) hostAddr);
+  case 4:
+    return ReadHostDWordFromLittleEndian((Bit32u*) hostAddr);
+  default:
+    return ReadHostQWordFromLittleEndian((Bit64u*) hostAddr);
   }
-  else {
-    if (!(srcSegPtr->cache.valid & SegAccessROK))
-      return 0;
-    if ((srcOff | 0xfff) > srcSegPtr->cache.u.segment.limit_scaled)
-      return 0;
+}
 
-    laddrSrc = get_laddr32(srcSeg, srcOff);
+BX_CPP_INLINE void write_host_string_element(Bit8u *hostAddr, unsigned len, Bit64u val)
+{
+  switch(len) {
+  case 1:
+    *hostAddr = (Bit8u) val;
+    break;
+  case 2:
+    WriteHostWordToLittleEndian((Bit16u*) hostAddr, (Bit16u) val);
+    break;
+  case 4:
+    WriteHostDWordToLittleEndian((Bit32u*) hostAddr, (Bit32u) val);
+    break;
+  default:
+    WriteHostQWordToLittleEndian((Bit64u*) hostAddr, val);
+    break;
   }
+}
 
-  bx_segment_reg_t *dstSegPtr = &BX_CPU_THIS_PTR sregs[dstSeg];
-  if (dstSegPtr->cache.valid & SegAccessWOK4G) {
-    laddrDst = dstOff;
-  }
-  else {
-    if (!(dstSegPtr->cache.valid & SegAccessWOK))
-      return 0;
-    if ((dstOff | 0xfff) > dstSegPtr->cache.u.segment.limit_scaled)
-      return 0;
+// number of elements from laddr to the end of its page in the string
+// direction, zero if the element at laddr is split between two pages
+BX_CPP_INLINE Bit32u string_elements_in_page(bx_address laddr, unsigned len, bool df)
+{
+  Bit32u pageOffset = PAGE_OFFSET(laddr);
+  if (pageOffset + len > 0x1000) return 0;
 
-    laddrDst = get_laddr32(dstSeg, dstOff);
-  }
+  return df ? (pageOffset / len + 1) : ((0x1000 - pageOffset) / len);
+}
 
-  return FastRepMOVSB(laddrSrc, laddrDst, byteCount, granularity);
+// Number of elements the engine may process ahead of the current one: all
+// but the last remaining iteration, and not more than the CPU ticks left
+// before the next timer event.
+Bit64u BX_CPU_C::FastRepCount(bxInstruction_c *i)
+{
+#if BX_DEBUGGER
+  // memory watchpoints are only checked by the regular memory accessors
+  if (num_write_watchpoints || num_read_watchpoints)
+    return 0;
+#endif
+
+  Bit64u count;
+#if BX_SUPPORT_X86_64
+  if (i->as64L())
+    count = RCX;
+  else
+#endif
+  if (i->as32L())
+    count = ECX;
+  else
+    count = CX;
+
+  Bit32u ticksLeft = bx_pc_system.getNumCpuTicksLeftNextEvent();
+  if (count > ticksLeft)
+    count = ticksLeft;
+
+  return count ? count-1 : 0;
 }
 
-Bit32u BX_CPU_C::FastRepMOVSB(bx_address laddrSrc, bx_address laddrDst, Bit64u byteCount, Bit32u granularity)
+// Returns the number of consecutive elements, starting with the one at the
+// index register reg, which can be accessed in the string direction without
+// segment limit violation or index register wrap, and the linear address of
+// the first element. Zero if the segment does not allow the direct access.
+Bit64u BX_CPU_C::FastRepRun(bxInstruction_c *i, unsigned s, unsigned reg, unsigned len, unsigned rw, bx_address *laddr)
 {
-  Bit8u *hostAddrSrc = v2h_read_byte(laddrSrc, USER_PL);
-  // Check that native host access was not vetoed for that page
-  if (!hostAddrSrc) return 0;
-
-  Bit8u *hostAddrDst = v2h_write_byte(laddrDst, USER_PL);
-  // Check that native host access was not vetoed for that page
-  if (!hostAddrDst) return 0;
-
-  assert(! BX_CPU_THIS_PTR get_DF());
-
-  // See how many bytes can fit in the rest of this page.
-  Bit32u bytesFitSrc = 0x1000 - PAGE_OFFSET(laddrSrc);
-  Bit32u bytesFitDst = 0x1000 - PAGE_OFFSET(laddrDst);
-
-  // Restrict word count to the number that will fit in either
-  // source or dest pages.
-  if (byteCount > bytesFitSrc)
-    byteCount = bytesFitSrc;
-  if (byteCount > bytesFitDst)
-    byteCount = bytesFitDst;
-  if (byteCount > bx_pc_system.getNumCpuTicksLeftNextEvent())
-    byteCount = bx_pc_system.getNumCpuTicksLeftNextEvent();
-
-  byteCount &= ~(granularity-1);
-
-  // If after all the restrictions, there is anything left to do...
-  if (byteCount) {
-    // Transfer data directly using host addresses
-    for (unsigned j=0; j<byteCount; j++) {
-      * (Bit8u *) hostAddrDst = * (Bit8u *) hostAddrSrc;
-      hostAddrDst++;
-      hostAddrSrc++;
+  bool df = BX_CPU_THIS_PTR get_DF();
+
+#if BX_SUPPORT_X86_64
+  if (i->as64L()) {
+    *laddr = get_laddr64(s, BX_READ_64BIT_REG(reg));
+    return BX_CONST64(0xffffffffffffffff);
+  }
+#endif
+
+  Bit32u offset = i->as32L() ? BX_READ_32BIT_REG(reg) : BX_READ_16BIT_REG(reg);
+  Bit64u last = i->as32L() ? 0xffffffff : 0xffff;
+
+  if (Bit64u(offset) + len - 1 > last) return 0;
+
+#if BX_SUPPORT_X86_64
+  if (BX_CPU_THIS_PTR cpu_mode == BX_MODE_LONG_64) {
+    *laddr = get_laddr64(s, offset);
+  }
+  else
+#endif
+  {
+    bx_segment_reg_t *seg = &BX_CPU_THIS_PTR sregs[s];
+    if (! (seg->cache.valid & (rw == BX_READ ? SegAccessROK4G : SegAccessWOK4G))) {
+      if (! (seg->cache.valid & (rw == BX_READ ? SegAccessROK : SegAccessWOK)))
+        return 0;
+      // only expand up segments have the access flags set
+      if (seg->cache.u.segment.limit_scaled < last)
+        last = seg->cache.u.segment.limit_scaled;
+      if (Bit64u(offset) + len - 1 > last)
+        return 0;
     }
+
+    *laddr = get_laddr32(s, offset);
   }
 
-  return byteCount;
+  return df ? (offset / len + 1) : ((last - offset + 1) / len);
 }
 
-Bit32u BX_CPU_C::FastRepSTOSB(unsigned dstSeg, Bit32u dstOff, Bit8u val, Bit32u count)
+// Advance the index registers and the counter past count elements
+void BX_CPU_C::FastRepAdvance(bxInstruction_c *i, Bit64u count, unsigned len, bool src, bool dst)
 {
-  bx_address laddrDst;
+  if (! count) return;
 
-  BX_ASSERT(BX_CPU_THIS_PTR cpu_mode != BX_MODE_LONG_64);
+  bx_address delta = (bx_address) count * len;
+  if (BX_CPU_THIS_PTR get_DF())
+    delta = -delta;
 
-  bx_segment_reg_t *dstSegPtr = &BX_CPU_THIS_PTR sregs[dstSeg];
-  if (dstSegPtr->cache.valid & SegAccessWOK4G) {
-    laddrDst = dstOff;
+#if BX_SUPPORT_X86_64
+  if (i->as64L()) {
+    if (src) RSI += delta;
+    if (dst) RDI += delta;
+    RCX -= count;
+  }
+  else
+#endif
+  if (i->as32L()) {
+    // zero extension of RSI/RDI/RCX
+    if (src) RSI = (Bit32u) (ESI + delta);
+    if (dst) RDI = (Bit32u) (EDI + delta);
+    RCX = (Bit32u) (ECX - count);
   }
   else {
-    if (!(dstSegPtr->cache.valid & SegAccessWOK))
-      return 0;
-    if ((dstOff | 0xfff) > dstSegPtr->cache.u.segment.limit_scaled)
-      return 0;
-
-    laddrDst = get_laddr32(dstSeg, dstOff);
+    if (src) SI += (Bit16u) delta;
+    if (dst) DI += (Bit16u) delta;
+    CX -= (Bit16u) count;
   }
 
-  return FastRepSTOSB(laddrDst, val, count);
+  // the regular handler and the main cpu loop account the last element
+  BX_CPU_TICKN((Bit32u) count);
 }
 
-Bit32u BX_CPU_C::FastRepSTOSB(bx_address laddrDst, Bit8u val, Bit32u count)
+bool BX_CPU_C::FastRepMisaligned(bx_address laddr, unsigned len)
 {
-  Bit8u *hostAddrDst = v2h_write_byte(laddrDst, USER_PL);
-  // Check that native host access was not vetoed for that page
-  if (!hostAddrDst) return 0;
-
-  assert(! BX_CPU_THIS_PTR get_DF());
-
-  // See how many bytes can fit in the rest of this page.
-  Bit32u bytesFitDst = 0x1000 - PAGE_OFFSET(laddrDst);
-
-  // Restrict word count to the number that will fit in either
-  // source or dest pages.
-  if (count > bytesFitDst)
-    count = bytesFitDst;
-  if (count > bx_pc_system.getNumCpuTicksLeftNextEvent())
-    count = bx_pc_system.getNumCpuTicksLeftNextEvent();
-
-  // If after all the restrictions, there is anything left to do...
-  if (count) {
-    // Transfer data directly using host addresses
-    for (unsigned j=0; j<count; j++) {
-      * (Bit8u *) hostAddrDst = val;
-      hostAddrDst++;
+#if BX_CPU_LEVEL >= 4 && BX_SUPPORT_ALIGNMENT_CHECK
+  if (BX_CPU_THIS_PTR alignment_check() && USER_PL)
+    return (laddr & (len-1)) != 0;
+#endif
+
+  return false;
+}
+
+Bit64u BX_CPU_C::FastRepMOVS(bxInstruction_c *i, unsigned len)
+{
+  bx_address laddrSrc, laddrDst;
+
+  Bit64u count = FastRepCount(i);
+  if (! count) return 0;
+
+  Bit64u run = FastRepRun(i, i->seg(), BX_32BIT_REG_ESI, len, BX_READ, &laddrSrc);
+  if (count > run) count = run;
+  run = FastRepRun(i, BX_SEG_REG_ES, BX_32BIT_REG_EDI, len, BX_WRITE, &laddrDst);
+  if (count > run) count = run;
+  if (! count) return 0;
+
+  if (FastRepMisaligned(laddrSrc | laddrDst, len)) return 0;
+
+  bool df = BX_CPU_THIS_PTR get_DF();
+  bx_address laddrMask = long64_mode() ? (bx_address) -1 : 0xffffffff;
+
+  Bit64u done = 0;
+  while (done < count) {
+    bx_address offset = (bx_address) done * len;
+    bx_address src = (df ? laddrSrc - offset : laddrSrc + offset) & laddrMask;
+    bx_address dst = (df ? laddrDst - offset : laddrDst + offset) & laddrMask;
+
+    Bit64u n = string_elements_in_page(src, len, df);
+    Bit32u fitDst = string_elements_in_page(dst, len, df);
+    if (n > fitDst) n = fitDst;
+    if (n > count - done) n = count - done;
+    if (! n) break;
+
+    Bit32u bytes = (Bit32u) n * len;
+    if (df) {
+      // the run in the page ends with the element at src
+      src -= bytes - len;
+      dst -= bytes - len;
+    }
+
+    Bit8u *hostAddrSrc = v2h_read_byte(src, USER_PL);
+    // Check that native host access was not vetoed for that page
+    if (! hostAddrSrc) break;
+    Bit8u *hostAddrDst = v2h_write_byte(dst, USER_PL);
+    if (! hostAddrDst) break;
+
+    // A block copy is equivalent to the element by element copy unless
+    // the destination overlaps the part of the source not yet copied
+    bool replicate = df ? (hostAddrDst < hostAddrSrc && hostAddrDst + bytes > hostAddrSrc) :
+                          (hostAddrDst > hostAddrSrc && hostAddrDst < hostAddrSrc + bytes);
+    if (replicate) {
+      for (unsigned j=0; j<n; j++) {
+        unsigned elem = df ? (unsigned)(n-1-j) : j;
+        Bit64u val = read_host_string_element(hostAddrSrc + elem*len, len);
+        write_host_string_element(hostAddrDst + elem*len, len, val);
+      }
     }
+    else {
+      memmove(hostAddrDst, hostAddrSrc, bytes);
+    }
+
+    done += n;
   }
 
-  return count;
+  FastRepAdvance(i, done, len, true, true);
+  return done;
 }
 
-Bit32u BX_CPU_C::FastRepSTOSW(unsigned dstSeg, Bit32u dstOff, Bit16u val, Bit32u count)
+Bit64u BX_CPU_C::FastRepSTOS(bxInstruction_c *i, unsigned len, Bit64u val)
 {
   bx_address laddrDst;
 
-  BX_ASSERT(BX_CPU_THIS_PTR cpu_mode != BX_MODE_LONG_64);
+  Bit64u count = FastRepCount(i);
+  if (! count) return 0;
 
-  bx_segment_reg_t *dstSegPtr = &BX_CPU_THIS_PTR sregs[dstSeg];
-  if (dstSegPtr->cache.valid & SegAccessWOK4G) {
-    laddrDst = dstOff;
-  }
-  else {
-    if (!(dstSegPtr->cache.valid & SegAccessWOK))
-      return 0;
-    if ((dstOff | 0xfff) > dstSegPtr->cache.u.segment.limit_scaled)
-      return 0;
+  Bit64u run = FastRepRun(i, BX_SEG_REG_ES, BX_32BIT_REG_EDI, len, BX_WRITE, &laddrDst);
+  if (count > run) count = run;
+  if (! count) return 0;
+
+  if (FastRepMisaligned(laddrDst, len)) return 0;
+
+  bool df = BX_CPU_THIS_PTR get_DF();
+  bx_address laddrMask = long64_mode() ? (bx_address) -1 : 0xffffffff;
+
+  // the element is a repeated byte (e.g. zero fill), use memset
+  Bit64u pattern = Bit64u(Bit8u(val)) * BX_CONST64(0x0101010101010101);
+  if (len < 8) pattern &= (BX_CONST64(1) << (len*8)) - 1;
+  bool fill = (val == pattern);
+
+  Bit64u done = 0;
+  while (done < count) {
+    bx_address offset = (bx_address) done * len;
+    bx_address dst = (df ? laddrDst - offset : laddrDst + offset) & laddrMask;
+
+    Bit64u n = string_elements_in_page(dst, len, df);
+    if (n > count - done) n = count - done;
+    if (! n) break;
+
+    Bit32u bytes = (Bit32u) n * len;
+    if (df) dst -= bytes - len;
+
+    Bit8u *hostAddrDst = v2h_write_byte(dst, USER_PL);
+    // Check that native host access was not vetoed for that page
+    if (! hostAddrDst) break;
+
+    if (fill) {
+      memset(hostAddrDst, (Bit8u) val, bytes);
+    }
+    else {
+      for (unsigned j=0; j<n; j++) {
+        write_host_string_element(hostAddrDst, len, val);
+        hostAddrDst += len;
+      }
+    }
 
-    laddrDst = get_laddr32(dstSeg, dstOff);
+    done += n;
   }
 
-  return FastRepSTOSW(laddrDst, val, count);
+  FastRepAdvance(i, done, len, false, true);
+  return done;
 }
 
-Bit32u BX_CPU_C::FastRepSTOSW(bx_address laddrDst, Bit16u val, Bit32u count)
+// REPE CMPS skips the equal elements, REPNE CMPS the different ones, the
+// first element terminating the repeat is left to the regular handler
+Bit64u BX_CPU_C::FastRepCMPS(bxInstruction_c *i, unsigned len)
 {
-  Bit8u *hostAddrDst = v2h_write_byte(laddrDst, USER_PL);
-  // Check that native host access was not vetoed for that page
-  if (!hostAddrDst) return 0;
-
-  assert(! BX_CPU_THIS_PTR get_DF());
-
-  // See how many words can fit in the rest of this page.
-  Bit32u wordsFitDst = (0x1000 - PAGE_OFFSET(laddrDst)) >> 1;
-
-  // Restrict word count to the number that will fit in either
-  // source or dest pages.
-  if (count > wordsFitDst)
-    count = wordsFitDst;
-  if (count > bx_pc_system.getNumCpuTicksLeftNextEvent())
-    count = bx_pc_system.getNumCpuTicksLeftNextEvent();
-
-  // If after all the restrictions, there is anything left to do...
-  if (count) {
-    // Transfer data directly using host addresses
-    for (unsigned j=0; j<count; j++) {
-      WriteHostWordToLittleEndian((Bit16u*)hostAddrDst, val);
-      hostAddrDst += 2;
+  bx_address laddrSrc, laddrDst;
+
+  Bit64u count = FastRepCount(i);
+  if (! count) return 0;
+
+  Bit64u run = FastRepRun(i, i->seg(), BX_32BIT_REG_ESI, len, BX_READ, &laddrSrc);
+  if (count > run) count = run;
+  run = FastRepRun(i, BX_SEG_REG_ES, BX_32BIT_REG_EDI, len, BX_READ, &laddrDst);
+  if (count > run) count = run;
+  if (! count) return 0;
+
+  if (FastRepMisaligned(laddrSrc | laddrDst, len)) return 0;
+
+  bool df = BX_CPU_THIS_PTR get_DF();
+  bool repe = (i->lockRepUsedValue() == 3);
+  bx_address laddrMask = long64_mode() ? (bx_address) -1 : 0xffffffff;
+
+  Bit64u done = 0;
+  while (done < count) {
+    bx_address offset = (bx_address) done * len;
+    bx_address src = (df ? laddrSrc - offset : laddrSrc + offset) & laddrMask;
+    bx_address dst = (df ? laddrDst - offset : laddrDst + offset) & laddrMask;
+
+    Bit64u n = string_elements_in_page(src, len, df);
+    Bit32u fitDst = string_elements_in_page(dst, len, df);
+    if (n > fitDst) n = fitDst;
+    if (n > count - done) n = count - done;
+    if (! n) break;
+
+    Bit32u bytes = (Bit32u) n * len;
+    if (df) {
+      src -= bytes - len;
+      dst -= bytes - len;
+    }
+
+    Bit8u *hostAddrSrc = v2h_read_byte(src, USER_PL);
+    // Check that native host access was not vetoed for that page
+    if (! hostAddrSrc) break;
+    Bit8u *hostAddrDst = v2h_read_byte(dst, USER_PL);
+    if (! hostAddrDst) break;
+
+    unsigned match = (unsigned) n;
+    if (repe && !df && !memcmp(hostAddrSrc, hostAddrDst, bytes)) {
+      // all elements are equal
     }
+    else {
+      for (unsigned j=0; j<n; j++) {
+        unsigned elem = df ? (unsigned)(n-1-j) : j;
+        bool equal = !memcmp(hostAddrSrc + elem*len, hostAddrDst + elem*len, len);
+        if (equal != repe) {
+          match = j;
+          break;
+        }
+      }
+    }
+
+    done += match;
+    if (match < n) break;
   }
 
-  return count;
+  FastRepAdvance(i, done, len, true, true);
+  return done;
 }
 
-Bit32u BX_CPU_C::FastRepSTOSD(unsigned dstSeg, Bit32u dstOff, Bit32u val, Bit32u count)
+// REPE SCAS skips the elements equal to the accumulator, REPNE SCAS the
+// different ones, the first element terminating the repeat is left to the
+// regular handler
+Bit64u BX_CPU_C::FastRepSCAS(bxInstruction_c *i, unsigned len, Bit64u val)
 {
   bx_address laddrDst;
 
-  BX_ASSERT(BX_CPU_THIS_PTR cpu_mode != BX_MODE_LONG_64);
+  Bit64u count = FastRepCount(i);
+  if (! count) return 0;
 
-  bx_segment_reg_t *dstSegPtr = &BX_CPU_THIS_PTR sregs[dstSeg];
-  if (dstSegPtr->cache.valid & SegAccessWOK4G) {
-    laddrDst = dstOff;
-  }
-  else {
-    if (!(dstSegPtr->cache.valid & SegAccessWOK))
-      return 0;
-    if ((dstOff | 0xfff) > dstSegPtr->cache.u.segment.limit_scaled)
-      return 0;
+  Bit64u run = FastRepRun(i, BX_SEG_REG_ES, BX_32BIT_REG_EDI, len, BX_READ, &laddrDst);
+  if (count > run) count = run;
+  if (! count) return 0;
 
-    laddrDst = get_laddr32(dstSeg, dstOff);
-  }
+  if (FastRepMisaligned(laddrDst, len)) return 0;
 
-  return FastRepSTOSD(laddrDst, val, count);
-}
+  bool df = BX_CPU_THIS_PTR get_DF();
+  bool repe = (i->lockRepUsedValue() == 3);
+  bx_address laddrMask = long64_mode() ? (bx_address) -1 : 0xffffffff;
 
-Bit32u BX_CPU_C::FastRepSTOSD(bx_address laddrDst, Bit32u val, Bit32u count)
-{
-  Bit8u *hostAddrDst = v2h_write_byte(laddrDst, USER_PL);
-  // Check that native host access was not vetoed for that page
-  if (!hostAddrDst) return 0;
-
-  assert(! BX_CPU_THIS_PTR get_DF());
-
-  // See how many dwords can fit in the rest of this page.
-  Bit32u dwordsFitDst = (0x1000 - PAGE_OFFSET(laddrDst)) >> 2;
-
-  // Restrict dword count to the number that will fit in either
-  // source or dest pages.
-  if (count > dwordsFitDst)
-    count = dwordsFitDst;
-  if (count > bx_pc_system.getNumCpuTicksLeftNextEvent())
-    count = bx_pc_system.getNumCpuTicksLeftNextEvent();
-
-  // If after all the restrictions, there is anything left to do...
-  if (count) {
-    // Transfer data directly using host addresses
-    for (unsigned j=0; j<count; j++) {
-      WriteHostDWordToLittleEndian((Bit32u*)hostAddrDst, val);
-      hostAddrDst += 4;
+  Bit64u done = 0;
+  while (done < count) {
+    bx_address offset = (bx_address) done * len;
+    bx_address dst = (df ? laddrDst - offset : laddrDst + offset) & laddrMask;
+
+    Bit64u n = string_elements_in_page(dst, len, df);
+    if (n > count - done) n = count - done;
+    if (! n) break;
+
+    Bit32u bytes = (Bit32u) n * len;
+    if (df) dst -= bytes - len;
+
+    Bit8u *hostAddrDst = v2h_read_byte(dst, USER_PL);
+    // Check that native host access was not vetoed for that page
+    if (! hostAddrDst) break;
+
+    unsigned match = (unsigned) n;
+    if (len == 1 && !repe && !df) {
+      // REPNE SCASB, search for the accumulator byte
+      const Bit8u *found = (const Bit8u *) memchr(hostAddrDst, (Bit8u) val, bytes);
+      if (found) match = (unsigned)(found - hostAddrDst);
+    }
+    else {
+      for (unsigned j=0; j<n; j++) {
+        unsigned elem = df ? (unsigned)(n-1-j) : j;
+        bool equal = (read_host_string_element(hostAddrDst + elem*len, len) == val);
+        if (equal != repe) {
+          match = j;
+          break;
+        }
+      }
     }
+
+    done += match;
+    if (match < n) break;
   }
 
-  return count;
+  FastRepAdvance(i, done, len, false, true);
+  return done;
 }
+
 #endif
@@ -0,0 +1,476 @@
+/////////////////////////////////////////////////////////////////////////
+// $Id$
+/////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (C) 2026  The Bochs Project
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA B 02110-1301 USA
+//
+/////////////////////////////////////////////////////////////////////////
+
+#define NEED_CPU_REG_SHORTCUTS 1
+#include "bochs.h"
+#include "cpu.h"
+#define LOG_THIS BX_CPU_THIS_PTR
+
+#if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS
+
+// Superinstructions
+//
+// After a trace is decoded frequent pairs of adjacent instructions are fused:
+// the handler of the first instruction in the pair is replaced by a fused
+// handler which executes the first instruction inline and continues with the
+// second one through a direct call of its handler instead of an indirect
+// call through execute1. The compiler is free to inline the second handler,
+// for compare and branch pairs the condition is evaluated right after the
+// flags were computed.
+//
+// Both instructions are committed separately (RIP, prev_rip, icount and
+// instrumentation callbacks) and async events are checked between them, so
+// exceptions, single stepping and SMC are handled exactly as with regular
+// handlers chaining. The decoded instructions themselves (ia opcode, operands)
+// are not changed, only the execute1 pointer of the first instruction.
+//
+// The pairs were selected from the opcode pair histograms collected with
+// instrument/example3.
+//
+// Dead flags elimination
+//
+// A backward liveness pass over the trace finds register ALU instructions
+// whose flags are overwritten by the next instruction before anything could
+// read them. Their handler is replaced by the deadFlags instance of the same
+// handler template which skips the lazy flags update unless the trace is left
+// right after the instruction because of an async event (BX_NEXT_INSTR_FLAGS).
+// Only register forms which cannot fault are considered as flags writers, so
+// no exception can be taken between the two instructions. Not done when
+// instrumentation is compiled in, the instrumentation callbacks may inspect
+// EFLAGS after every instruction.
+
+// commit the first instruction of the pair and continue with the second one
+#define BX_NEXT_FUSED_INSTR(i, second) {               \
+  BX_COMMIT_INSTRUCTION(i);                            \
+  if (BX_CPU_THIS_PTR async_event) return;             \
+  ++i;                                                 \
+  BX_INSTR_BEFORE_EXECUTION(BX_CPU_ID, (i));           \
+  RIP += (i)->ilen();                                  \
+  return BX_CPU_CALL_METHOD(second, (i));              \
+}
+
+template <BxExecutePtr_tR second>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMP_GdEdR_FUSED(bxInstruction_c *i)
+{
+  Bit32u op1_32 = BX_READ_32BIT_REG(i->dst());
+  Bit32u op2_32 = BX_READ_32BIT_REG(i->src());
+  Bit32u diff_32 = op1_32 - op2_32;
+
+  SET_FLAGS_OSZAPC_SUB_32(op1_32, op2_32, diff_32);
+
+  BX_NEXT_FUSED_INSTR(i, second);
+}
+
+template <BxExecutePtr_tR second>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMP_EdIdR_FUSED(bxInstruction_c *i)
+{
+  Bit32u op1_32 = BX_READ_32BIT_REG(i->dst());
+  Bit32u op2_32 = i->Id();
+  Bit32u diff_32 = op1_32 - op2_32;
+
+  SET_FLAGS_OSZAPC_SUB_32(op1_32, op2_32, diff_32);
+
+  BX_NEXT_FUSED_INSTR(i, second);
+}
+
+template <BxExecutePtr_tR second>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::TEST_EdGdR_FUSED(bxInstruction_c *i)
+{
+  Bit32u op1_32 = BX_READ_32BIT_REG(i->dst());
+  op1_32 &= BX_READ_32BIT_REG(i->src());
+
+  SET_FLAGS_OSZAPC_LOGIC_32(op1_32);
+
+  BX_NEXT_FUSED_INSTR(i, second);
+}
+
+template <BxExecutePtr_tR second>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::TEST_EdIdR_FUSED(bxInstruction_c *i)
+{
+  Bit32u op1_32 = BX_READ_32BIT_REG(i->dst());
+  op1_32 &= i->Id();
+
+  SET_FLAGS_OSZAPC_LOGIC_32(op1_32);
+
+  BX_NEXT_FUSED_INSTR(i, second);
+}
+
+template <BxExecutePtr_tR second>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::DEC_EdR_FUSED(bxInstruction_c *i)
+{
+  Bit32u erx = --BX_READ_32BIT_REG(i->dst());
+  SET_FLAGS_OSZAP_SUB_32(erx + 1, 0, erx);
+  BX_CLEAR_64BIT_HIGH(i->dst());
+
+  BX_NEXT_FUSED_INSTR(i, second);
+}
+
+template <BxExecutePtr_tR second>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::MOV32_GdEdM_FUSED(bxInstruction_c *i)
+{
+  Bit32u eaddr = (Bit32u) BX_CPU_RESOLVE_ADDR_32(i);
+  Bit32u val32 = read_virtual_dword_32(i->seg(), eaddr);
+
+  BX_WRITE_32BIT_REGZ(i->dst(), val32);
+
+  BX_NEXT_FUSED_INSTR(i, second);
+}
+
+template <BxExecutePtr_tR second>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::PUSH_EdR_FUSED(bxInstruction_c *i)
+{
+  push_32(BX_READ_32BIT_REG(i->dst()));
+
+  BX_NEXT_FUSED_INSTR(i, second);
+}
+
+template <BxExecutePtr_tR second>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::POP_EdR_FUSED(bxInstruction_c *i)
+{
+  BX_WRITE_32BIT_REGZ(i->dst(), pop_32());
+
+  BX_NEXT_FUSED_INSTR(i, second);
+}
+
+#if BX_SUPPORT_X86_64
+
+template <BxExecutePtr_tR second>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMP_GqEqR_FUSED(bxInstruction_c *i)
+{
+  Bit64u op1_64 = BX_READ_64BIT_REG(i->dst());
+  Bit64u op2_64 = BX_READ_64BIT_REG(i->src());
+  Bit64u diff_64 = op1_64 - op2_64;
+
+  SET_FLAGS_OSZAPC_SUB_64(op1_64, op2_64, diff_64);
+
+  BX_NEXT_FUSED_INSTR(i, second);
+}
+
+template <BxExecutePtr_tR second>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMP_EqIdR_FUSED(bxInstruction_c *i)
+{
+  Bit64u op1_64 = BX_READ_64BIT_REG(i->dst());
+  Bit64u op2_64 = (Bit32s) i->Id();
+  Bit64u diff_64 = op1_64 - op2_64;
+
+  SET_FLAGS_OSZAPC_SUB_64(op1_64, op2_64, diff_64);
+
+  BX_NEXT_FUSED_INSTR(i, second);
+}
+
+template <BxExecutePtr_tR second>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::TEST_EqGqR_FUSED(bxInstruction_c *i)
+{
+  Bit64u op1_64 = BX_READ_64BIT_REG(i->dst());
+  op1_64 &= BX_READ_64BIT_REG(i->src());
+
+  SET_FLAGS_OSZAPC_LOGIC_64(op1_64);
+
+  BX_NEXT_FUSED_INSTR(i, second);
+}
+
+template <BxExecutePtr_tR second>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::TEST_EqIdR_FUSED(bxInstruction_c *i)
+{
+  Bit64u op1_64 = BX_READ_64BIT_REG(i->dst());
+  op1_64 &= (Bit64u) (Bit32s) i->Id();
+
+  SET_FLAGS_OSZAPC_LOGIC_64(op1_64);
+
+  BX_NEXT_FUSED_INSTR(i, second);
+}
+
+template <BxExecutePtr_tR second>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::DEC_EqR_FUSED(bxInstruction_c *i)
+{
+  Bit64u rrx = --BX_READ_64BIT_REG(i->dst());
+  SET_FLAGS_OSZAP_SUB_64(rrx + 1, 0, rrx);
+
+  BX_NEXT_FUSED_INSTR(i, second);
+}
+
+template <BxExecutePtr_tR second>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::MOV64_GdEdM_FUSED(bxInstruction_c *i)
+{
+  Bit64u eaddr = BX_CPU_RESOLVE_ADDR_64(i);
+  Bit32u val32 = read_linear_dword(i->seg(), get_laddr64(i->seg(), eaddr));
+
+  BX_WRITE_32BIT_REGZ(i->dst(), val32);
+
+  BX_NEXT_FUSED_INSTR(i, second);
+}
+
+template <BxExecutePtr_tR second>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::MOV_GqEqM_FUSED(bxInstruction_c *i)
+{
+  bx_address eaddr = BX_CPU_RESOLVE_ADDR_64(i);
+  Bit64u val64 = read_linear_qword(i->seg(), get_laddr64(i->seg(), eaddr));
+
+  BX_WRITE_64BIT_REG(i->dst(), val64);
+
+  BX_NEXT_FUSED_INSTR(i, second);
+}
+
+template <BxExecutePtr_tR second>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::PUSH_EqR_FUSED(bxInstruction_c *i)
+{
+  push_64(BX_READ_64BIT_REG(i->dst()));
+
+  BX_NEXT_FUSED_INSTR(i, second);
+}
+
+template <BxExecutePtr_tR second>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::POP_EqR_FUSED(bxInstruction_c *i)
+{
+  BX_WRITE_64BIT_REG(i->dst(), pop_64());
+
+  BX_NEXT_FUSED_INSTR(i, second);
+}
+
+#endif // BX_SUPPORT_X86_64
+
+struct bxFusedPair_t {
+  BxExecutePtr_tR second;
+  BxExecutePtr_tR fused;
+};
+
+struct bxFusionRule_t {
+  BxExecutePtr_tR first;
+  const bxFusedPair_t *pairs;
+  unsigned num_pairs;
+};
+
+#define BX_FUSED_PAIR(first, second) \
+  { &BX_CPU_C::second, &BX_CPU_C::first##_FUSED<&BX_CPU_C::second> }
+
+// flags producer followed by a conditional branch
+#define BX_FUSED_JCC_PAIRS(first, form)                                      \
+  BX_FUSED_PAIR(first, JZ_##form),   BX_FUSED_PAIR(first, JNZ_##form),      \
+  BX_FUSED_PAIR(first, JB_##form),   BX_FUSED_PAIR(first, JNB_##form),      \
+  BX_FUSED_PAIR(first, JBE_##form),  BX_FUSED_PAIR(first, JNBE_##form),     \
+  BX_FUSED_PAIR(first, JS_##form),   BX_FUSED_PAIR(first, JNS_##form),      \
+  BX_FUSED_PAIR(first, JL_##form),   BX_FUSED_PAIR(first, JNL_##form),      \
+  BX_FUSED_PAIR(first, JLE_##form),  BX_FUSED_PAIR(first, JNLE_##form)
+
+#if BX_SUPPORT_X86_64
+#define BX_FUSED_JCC32_PAIRS(first) \
+  BX_FUSED_JCC_PAIRS(first, Jd), BX_FUSED_JCC_PAIRS(first, Jq)
+#else
+#define BX_FUSED_JCC32_PAIRS(first) \
+  BX_FUSED_JCC_PAIRS(first, Jd)
+#endif
+
+// load followed by a register ALU operation
+#define BX_FUSED_ALU32_PAIRS(first)                                          \
+  BX_FUSED_PAIR(first, ADD_GdEdR),   BX_FUSED_PAIR(first, SUB_GdEdR),       \
+  BX_FUSED_PAIR(first, AND_GdEdR),   BX_FUSED_PAIR(first, OR_GdEdR),        \
+  BX_FUSED_PAIR(first, XOR_GdEdR),   BX_FUSED_PAIR(first, CMP_GdEdR),       \
+  BX_FUSED_PAIR(first, TEST_EdGdR)
+
+#define BX_FUSED_ALU64_PAIRS(first)                                          \
+  BX_FUSED_PAIR(first, ADD_GqEqR),   BX_FUSED_PAIR(first, SUB_GqEqR),       \
+  BX_FUSED_PAIR(first, AND_GqEqR),   BX_FUSED_PAIR(first, OR_GqEqR),        \
+  BX_FUSED_PAIR(first, XOR_GqEqR),   BX_FUSED_PAIR(first, CMP_GqEqR),       \
+  BX_FUSED_PAIR(first, TEST_EqGqR)
+
+static const bxFusedPair_t fused_CMP_GdEdR[] = { BX_FUSED_JCC32_PAIRS(CMP_GdEdR) };
+static const bxFusedPair_t fused_CMP_EdIdR[] = { BX_FUSED_JCC32_PAIRS(CMP_EdIdR) };
+static const bxFusedPair_t fused_TEST_EdGdR[] = { BX_FUSED_JCC32_PAIRS(TEST_EdGdR) };
+static const bxFusedPair_t fused_TEST_EdIdR[] = { BX_FUSED_JCC32_PAIRS(TEST_EdIdR) };
+static const bxFusedPair_t fused_DEC_EdR[] = { BX_FUSED_JCC32_PAIRS(DEC_EdR) };
+static const bxFusedPair_t fused_MOV32_GdEdM[] = { BX_FUSED_ALU32_PAIRS(MOV32_GdEdM) };
+static const bxFusedPair_t fused_PUSH_EdR[] = { BX_FUSED_PAIR(PUSH_EdR, PUSH_EdR) };
+static const bxFusedPair_t fused_POP_EdR[] = { BX_FUSED_PAIR(POP_EdR, POP_EdR) };
+
+#if BX_SUPPORT_X86_64
+static const bxFusedPair_t fused_CMP_GqEqR[] = { BX_FUSED_JCC_PAIRS(CMP_GqEqR, Jq) };
+static const bxFusedPair_t fused_CMP_EqIdR[] = { BX_FUSED_JCC_PAIRS(CMP_EqIdR, Jq) };
+static const bxFusedPair_t fused_TEST_EqGqR[] = { BX_FUSED_JCC_PAIRS(TEST_EqGqR, Jq) };
+static const bxFusedPair_t fused_TEST_EqIdR[] = { BX_FUSED_JCC_PAIRS(TEST_EqIdR, Jq) };
+static const bxFusedPair_t fused_DEC_EqR[] = { BX_FUSED_JCC_PAIRS(DEC_EqR, Jq) };
+static const bxFusedPair_t fused_MOV64_GdEdM[] = { BX_FUSED_ALU32_PAIRS(MOV64_GdEdM) };
+static const bxFusedPair_t fused_MOV_GqEqM[] = { BX_FUSED_ALU64_PAIRS(MOV_GqEqM) };
+static const bxFusedPair_t fused_PUSH_EqR[] = { BX_FUSED_PAIR(PUSH_EqR, PUSH_EqR) };
+static const bxFusedPair_t fused_POP_EqR[] = { BX_FUSED_PAIR(POP_EqR, POP_EqR) };
+#endif
+
+#define BX_FUSION_RULE(first) \
+  { &BX_CPU_C::first, fused_##first, sizeof(fused_##first) / sizeof(fused_##first[0]) }
+
+static const bxFusionRule_t fusionRules[] = {
+  BX_FUSION_RULE(CMP_GdEdR),
+  BX_FUSION_RULE(CMP_EdIdR),
+  BX_FUSION_RULE(TEST_EdGdR),
+  BX_FUSION_RULE(TEST_EdIdR),
+  BX_FUSION_RULE(DEC_EdR),
+  BX_FUSION_RULE(MOV32_GdEdM),
+  BX_FUSION_RULE(PUSH_EdR),
+  BX_FUSION_RULE(POP_EdR),
+#if BX_SUPPORT_X86_64
+  BX_FUSION_RULE(CMP_GqEqR),
+  BX_FUSION_RULE(CMP_EqIdR),
+  BX_FUSION_RULE(TEST_EqGqR),
+  BX_FUSION_RULE(TEST_EqIdR),
+  BX_FUSION_RULE(DEC_EqR),
+  BX_FUSION_RULE(MOV64_GdEdM),
+  BX_FUSION_RULE(MOV_GqEqM),
+  BX_FUSION_RULE(PUSH_EqR),
+  BX_FUSION_RULE(POP_EqR),
+#endif
+};
+
+#define BX_FUSION_RULES (sizeof(fusionRules) / sizeof(fusionRules[0]))
+
+void BX_CPU_C::optimizeTrace(bxInstruction_c *i, unsigned len)
+{
+  fuseTrace(i, len);
+#if BX_INSTRUMENTATION == 0
+  eliminateDeadFlags(i, len);
+#endif
+}
+
+void BX_CPU_C::fuseTrace(bxInstruction_c *i, unsigned len)
+{
+  for (unsigned n=0; n+1 < len; n++) {
+    for (unsigned r=0; r < BX_FUSION_RULES; r++) {
+      if (i[n].execute1 != fusionRules[r].first) continue;
+
+      const bxFusedPair_t *pair = fusionRules[r].pairs;
+      for (unsigned k=0; k < fusionRules[r].num_pairs; k++, pair++) {
+        if (i[n+1].execute1 == pair->second) {
+          i[n].execute1 = pair->fused;
+          n++; // the second instruction is not fused with the next one
+          break;
+        }
+      }
+      break;
+    }
+  }
+}
+
+struct bxFlagsRule_t {
+  BxExecutePtr_tR handler;
+  BxExecutePtr_tR deadFlags; // variant without flags update, NULL if none
+  bool writesAllFlags;       // overwrites all six flags without reading them
+};
+
+#define BX_FLAGS_RULE(handler) \
+  { &BX_CPU_C::handler, &BX_CPU_C::handler##_DF<true>, true }
+
+// INC and DEC keep CF, their flags could be dead but they don't kill flags
+#define BX_FLAGS_RULE_INCDEC(handler) \
+  { &BX_CPU_C::handler, &BX_CPU_C::handler##_DF<true>, false }
+
+#define BX_FLAGS_KILL(handler) \
+  { &BX_CPU_C::handler, NULL, true }
+
+static const bxFlagsRule_t flagsRules[] = {
+  BX_FLAGS_RULE(ADD_GdEdR),
+  BX_FLAGS_RULE(ADD_EdIdR),
+  BX_FLAGS_RULE(SUB_GdEdR),
+  BX_FLAGS_RULE(SUB_EdIdR),
+  BX_FLAGS_RULE(AND_GdEdR),
+  BX_FLAGS_RULE(AND_EdIdR),
+  BX_FLAGS_RULE(OR_GdEdR),
+  BX_FLAGS_RULE(OR_EdIdR),
+  BX_FLAGS_RULE(XOR_GdEdR),
+  BX_FLAGS_RULE(XOR_EdIdR),
+  BX_FLAGS_RULE_INCDEC(INC_EdR),
+  BX_FLAGS_RULE_INCDEC(DEC_EdR),
+  BX_FLAGS_KILL(CMP_GdEdR),
+  BX_FLAGS_KILL(CMP_EdIdR),
+  BX_FLAGS_KILL(TEST_EdGdR),
+  BX_FLAGS_KILL(TEST_EdIdR),
+  BX_FLAGS_KILL(ZERO_IDIOM_GdR),
+#if BX_SUPPORT_X86_64
+  BX_FLAGS_RULE(ADD_GqEqR),
+  BX_FLAGS_RULE(ADD_EqIdR),
+  BX_FLAGS_RULE(SUB_GqEqR),
+  BX_FLAGS_RULE(SUB_EqIdR),
+  BX_FLAGS_RULE(AND_GqEqR),
+  BX_FLAGS_RULE(AND_EqIdR),
+  BX_FLAGS_RULE(OR_GqEqR),
+  BX_FLAGS_RULE(OR_EqIdR),
+  BX_FLAGS_RULE(XOR_GqEqR),
+  BX_FLAGS_RULE(XOR_EqIdR),
+  BX_FLAGS_RULE_INCDEC(INC_EqR),
+  BX_FLAGS_RULE_INCDEC(DEC_EqR),
+  BX_FLAGS_KILL(CMP_GqEqR),
+  BX_FLAGS_KILL(CMP_EqIdR),
+  BX_FLAGS_KILL(TEST_EqGqR),
+  BX_FLAGS_KILL(TEST_EqIdR),
+#endif
+};
+
+#define BX_FLAGS_RULES (sizeof(flagsRules) / sizeof(flagsRules[0]))
+
+// returns the handler of the instruction as it was before fusion and dead
+// flags elimination
+BxExecutePtr_tR getOriginalHandler(const bxInstruction_c *i)
+{
+  for (unsigned r=0; r < BX_FUSION_RULES; r++) {
+    const bxFusedPair_t *pair = fusionRules[r].pairs;
+    for (unsigned k=0; k < fusionRules[r].num_pairs; k++, pair++) {
+      if (i->execute1 == pair->fused) return fusionRules[r].first;
+    }
+  }
+
+  for (unsigned r=0; r < BX_FLAGS_RULES; r++) {
+    if (i->execute1 == flagsRules[r].deadFlags) return flagsRules[r].handler;
+  }
+
+  return i->execute1;
+}
+
+static const bxFlagsRule_t *findFlagsRule(const bxInstruction_c *i)
+{
+  BxExecutePtr_tR handler = getOriginalHandler(i);
+
+  for (unsigned r=0; r < BX_FLAGS_RULES; r++) {
+    if (handler == flagsRules[r].handler) return &flagsRules[r];
+  }
+  return NULL;
+}
+
+void BX_CPU_C::eliminateDeadFlags(bxInstruction_c *i, unsigned len)
+{
+  // flags are live at the end of the trace (the last entry is the end of
+  // trace opcode) and before any instruction not known to overwrite them
+  bool live = true;
+
+  for (int n = len-1; n >= 0; n--) {
+    const bxFlagsRule_t *rule = findFlagsRule(&i[n]);
+    if (! rule) {
+      live = true;
+      continue;
+    }
+
+    // fused handlers and instructions already optimized (copied by trace
+    // merging) are left as is
+    if (! live && rule->deadFlags && i[n].execute1 == rule->handler)
+      i[n].execute1 = rule->deadFlags;
+
+    live = ! rule->writesAllFlags;
+  }
+}
+
+#endif // BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS
@@ -64,6 +64,7 @@ static const Bit8u GF256_Inv[256] = {
 };
 
 #include "scalar_arith.h"
+#include "host_crypto.h"
 
 BX_CPP_INLINE Bit8u affine_byte(Bit64u src2, Bit8u src1byte, Bit8u imm8)
 {
@@ -80,6 +81,13 @@ BX_CPP_INLINE Bit8u affine_byte(Bit64u src2, Bit8u src1byte, Bit8u imm8)
 
 BX_CPP_INLINE void xmm_gf2p8affineqb(BxPackedXmmRegister *dst, const BxPackedXmmRegister *src, Bit8u imm8)
 {
+#if BX_HOST_CRYPTO
+  if (bx_host_crypto.gfni) {
+    host_gf2p8affineqb(dst, src, imm8);
+    return;
+  }
+#endif
+
   for (unsigned i=0; i < 16; i++) {
     dst->xmmubyte(i) = affine_byte(src->xmm64u(i/8), dst->xmmubyte(i), imm8);
   }
@@ -92,6 +100,13 @@ BX_CPP_INLINE Bit8u affine_inverse_byte(Bit64u src2qw, Bit8u src1byte, Bit8u imm
 
 BX_CPP_INLINE void xmm_gf2p8affineinvqb(BxPackedXmmRegister *dst, const BxPackedXmmRegister *src, Bit8u imm8)
 {
+#if BX_HOST_CRYPTO
+  if (bx_host_crypto.gfni) {
+    host_gf2p8affineinvqb(dst, src, imm8);
+    return;
+  }
+#endif
+
   for (unsigned i=0; i < 16; i++) {
     dst->xmmubyte(i) = affine_inverse_byte(src->xmm64u(i/8), dst->xmmubyte(i), imm8);
   }
@@ -269,12 +284,24 @@ BX_CPP_INLINE Bit8u gf2p8mul(Bit8u a, Bit8u b)
   return GF256_Exp[tmp];
 }
 
+BX_CPP_INLINE void xmm_gf2p8mulb(BxPackedXmmRegister *dst, const BxPackedXmmRegister *src)
+{
+#if BX_HOST_CRYPTO
+  if (bx_host_crypto.gfni) {
+    host_gf2p8mulb(dst, src);
+    return;
+  }
+#endif
+
+  for (unsigned n=0; n < 16; n++)
+    dst->xmmubyte(n) = gf2p8mul(dst->xmmubyte(n), src->xmmubyte(n));
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::GF2P8MULB_VdqWdqR(bxInstruction_c *i)
 {
   BxPackedXmmRegister dst = BX_READ_XMM_REG(i->dst()), src = BX_READ_XMM_REG(i->src());
 
-  for (unsigned n=0; n < 16; n++)
-    dst.xmmubyte(n) = gf2p8mul(dst.xmmubyte(n), src.xmmubyte(n));
+  xmm_gf2p8mulb(&dst, &src);
 
   BX_WRITE_XMM_REG(i->dst(), dst);
 
@@ -287,8 +314,8 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VGF2P8MULB_VdqHdqWdqR(bxInstruction_c *i)
   BxPackedAvxRegister dst = BX_READ_AVX_REG(i->src1()), src = BX_READ_AVX_REG(i->src2());
   unsigned len = i->getVL();
 
-  for (unsigned n=0; n < BYTE_ELEMENTS(len); n++) {
-    dst.vmmubyte(n) = gf2p8mul(dst.vmmubyte(n), src.vmmubyte(n));
+  for (unsigned n=0; n < len; n++) {
+    xmm_gf2p8mulb(&dst.vmm128(n), &src.vmm128(n));
   }
 
 #if BX_SUPPORT_EVEX
@@ -302,4 +329,30 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VGF2P8MULB_VdqHdqWdqR(bxInstruction_c *i)
 }
 #endif
 
+#if BX_HOST_CRYPTO
+
+static void gf2p8mulb_test(BxPackedXmmRegister *dst, const BxPackedXmmRegister *src, const BxPackedXmmRegister *xmm0, Bit8u imm8)
+{
+  xmm_gf2p8mulb(dst, src);
+}
+
+static void gf2p8affineqb_test(BxPackedXmmRegister *dst, const BxPackedXmmRegister *src, const BxPackedXmmRegister *xmm0, Bit8u imm8)
+{
+  xmm_gf2p8affineqb(dst, src, imm8);
+}
+
+static void gf2p8affineinvqb_test(BxPackedXmmRegister *dst, const BxPackedXmmRegister *src, const BxPackedXmmRegister *xmm0, Bit8u imm8)
+{
+  xmm_gf2p8affineinvqb(dst, src, imm8);
+}
+
+const bxHostCryptoTest_t bx_gf2_host_crypto_tests[] = {
+  { "GF2P8MULB",        gf2p8mulb_test,        &bx_host_crypto.gfni },
+  { "GF2P8AFFINEQB",    gf2p8affineqb_test,    &bx_host_crypto.gfni },
+  { "GF2P8AFFINEINVQB", gf2p8affineinvqb_test, &bx_host_crypto.gfni },
+  { NULL, NULL, NULL }
+};
+
+#endif
+
 #endif
@@ -0,0 +1,299 @@
+/////////////////////////////////////////////////////////////////////////
+// $Id$
+/////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (C) 2026  The Bochs Project
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA B 02110-1301 USA
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include "bochs.h"
+#include "cpu.h"
+#define LOG_THIS genlog->
+
+#if BX_CPU_LEVEL >= 6
+
+#include "host_crypto.h"
+
+#if BX_HOST_CRYPTO
+
+#if defined(_MSC_VER)
+  #include <intrin.h>
+  #define BX_HOST_TARGET(isa)
+#else
+  #include <cpuid.h>
+  #define BX_HOST_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+#include <immintrin.h>
+
+static void host_cpuid(Bit32u leaf, Bit32u subleaf, Bit32u regs[4])
+{
+#if defined(_MSC_VER)
+  __cpuidex((int *) regs, leaf, subleaf);
+#else
+  __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static bx_host_crypto_t host_crypto_features(void)
+{
+  bx_host_crypto_t features = { false, false, false, false, false };
+  Bit32u regs[4];
+
+  host_cpuid(0, 0, regs);
+  Bit32u max_leaf = regs[0];
+
+  host_cpuid(1, 0, regs);
+  features.pclmul = (regs[2] >> 1) & 1;
+  features.crc32  = (regs[2] >> 20) & 1; // SSE4.2
+  features.aes    = (regs[2] >> 25) & 1;
+
+  if (max_leaf >= 7) {
+    host_cpuid(7, 0, regs);
+    features.sha  = (regs[1] >> 29) & 1;
+    features.gfni = (regs[2] >> 8) & 1;
+  }
+
+  return features;
+}
+
+bx_host_crypto_t bx_host_crypto = host_crypto_features();
+
+/////////////////////////////////////////////////////////////////////////
+// AES-NI
+/////////////////////////////////////////////////////////////////////////
+
+BX_HOST_TARGET("aes") void host_aesenc(BxPackedXmmRegister *state, const BxPackedXmmRegister *round_key)
+{
+  xmm_store(state, _mm_aesenc_si128(xmm_load(state), xmm_load(round_key)));
+}
+
+BX_HOST_TARGET("aes") void host_aesenclast(BxPackedXmmRegister *state, const BxPackedXmmRegister *round_key)
+{
+  xmm_store(state, _mm_aesenclast_si128(xmm_load(state), xmm_load(round_key)));
+}
+
+BX_HOST_TARGET("aes") void host_aesdec(BxPackedXmmRegister *state, const BxPackedXmmRegister *round_key)
+{
+  xmm_store(state, _mm_aesdec_si128(xmm_load(state), xmm_load(round_key)));
+}
+
+BX_HOST_TARGET("aes") void host_aesdeclast(BxPackedXmmRegister *state, const BxPackedXmmRegister *round_key)
+{
+  xmm_store(state, _mm_aesdeclast_si128(xmm_load(state), xmm_load(round_key)));
+}
+
+BX_HOST_TARGET("aes") void host_aesimc(BxPackedXmmRegister *state)
+{
+  xmm_store(state, _mm_aesimc_si128(xmm_load(state)));
+}
+
+/////////////////////////////////////////////////////////////////////////
+// PCLMULQDQ
+/////////////////////////////////////////////////////////////////////////
+
+BX_HOST_TARGET("pclmul") void host_pclmulqdq(BxPackedXmmRegister *r, Bit64u a, Bit64u b)
+{
+  __m128i op1 = _mm_loadl_epi64((const __m128i *) &a);
+  __m128i op2 = _mm_loadl_epi64((const __m128i *) &b);
+
+  xmm_store(r, _mm_clmulepi64_si128(op1, op2, 0x00));
+}
+
+/////////////////////////////////////////////////////////////////////////
+// SHA1 / SHA256
+/////////////////////////////////////////////////////////////////////////
+
+BX_HOST_TARGET("sha") void host_sha1rnds4(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, unsigned imm)
+{
+  __m128i abcd = xmm_load(op1), w = xmm_load(op2);
+
+  // the round function is an immediate of the host instruction
+  switch(imm & 0x3) {
+    case 0:
+      abcd = _mm_sha1rnds4_epu32(abcd, w, 0);
+      break;
+    case 1:
+      abcd = _mm_sha1rnds4_epu32(abcd, w, 1);
+      break;
+    case 2:
+      abcd = _mm_sha1rnds4_epu32(abcd, w, 2);
+      break;
+    case 3:
+      abcd = _mm_sha1rnds4_epu32(abcd, w, 3);
+      break;
+  }
+
+  xmm_store(op1, abcd);
+}
+
+BX_HOST_TARGET("sha") void host_sha1nexte(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
+{
+  xmm_store(op1, _mm_sha1nexte_epu32(xmm_load(op1), xmm_load(op2)));
+}
+
+BX_HOST_TARGET("sha") void host_sha1msg1(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
+{
+  xmm_store(op1, _mm_sha1msg1_epu32(xmm_load(op1), xmm_load(op2)));
+}
+
+BX_HOST_TARGET("sha") void host_sha1msg2(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
+{
+  xmm_store(op1, _mm_sha1msg2_epu32(xmm_load(op1), xmm_load(op2)));
+}
+
+BX_HOST_TARGET("sha") void host_sha256rnds2(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, const BxPackedXmmRegister *wk)
+{
+  xmm_store(op1, _mm_sha256rnds2_epu32(xmm_load(op1), xmm_load(op2), xmm_load(wk)));
+}
+
+BX_HOST_TARGET("sha") void host_sha256msg1(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
+{
+  xmm_store(op1, _mm_sha256msg1_epu32(xmm_load(op1), xmm_load(op2)));
+}
+
+BX_HOST_TARGET("sha") void host_sha256msg2(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
+{
+  xmm_store(op1, _mm_sha256msg2_epu32(xmm_load(op1), xmm_load(op2)));
+}
+
+/////////////////////////////////////////////////////////////////////////
+// CRC32 (SSE4.2)
+/////////////////////////////////////////////////////////////////////////
+
+BX_HOST_TARGET("sse4.2") Bit32u host_crc32_8(Bit32u crc, Bit8u val)
+{
+  return _mm_crc32_u8(crc, val);
+}
+
+BX_HOST_TARGET("sse4.2") Bit32u host_crc32_16(Bit32u crc, Bit16u val)
+{
+  return _mm_crc32_u16(crc, val);
+}
+
+BX_HOST_TARGET("sse4.2") Bit32u host_crc32_32(Bit32u crc, Bit32u val)
+{
+  return _mm_crc32_u32(crc, val);
+}
+
+#if BX_SUPPORT_X86_64
+BX_HOST_TARGET("sse4.2") Bit32u host_crc32_64(Bit32u crc, Bit64u val)
+{
+#if defined(__x86_64__) || defined(_M_X64)
+  return (Bit32u) _mm_crc32_u64(crc, val);
+#else
+  crc = _mm_crc32_u32(crc, (Bit32u) val);
+  return _mm_crc32_u32(crc, (Bit32u)(val >> 32));
+#endif
+}
+#endif
+
+/////////////////////////////////////////////////////////////////////////
+// GFNI
+/////////////////////////////////////////////////////////////////////////
+
+BX_HOST_TARGET("gfni") void host_gf2p8mulb(BxPackedXmmRegister *dst, const BxPackedXmmRegister *src)
+{
+  xmm_store(dst, _mm_gf2p8mul_epi8(xmm_load(dst), xmm_load(src)));
+}
+
+// the constant added by the affine transformation is an immediate of the
+// host instruction, apply it separately
+
+BX_HOST_TARGET("gfni") void host_gf2p8affineqb(BxPackedXmmRegister *dst, const BxPackedXmmRegister *src, Bit8u imm8)
+{
+  __m128i r = _mm_gf2p8affine_epi64_epi8(xmm_load(dst), xmm_load(src), 0);
+  xmm_store(dst, _mm_xor_si128(r, _mm_set1_epi8((char) imm8)));
+}
+
+BX_HOST_TARGET("gfni") void host_gf2p8affineinvqb(BxPackedXmmRegister *dst, const BxPackedXmmRegister *src, Bit8u imm8)
+{
+  __m128i r = _mm_gf2p8affineinv_epi64_epi8(xmm_load(dst), xmm_load(src), 0);
+  xmm_store(dst, _mm_xor_si128(r, _mm_set1_epi8((char) imm8)));
+}
+
+/////////////////////////////////////////////////////////////////////////
+// Differential test against the portable code
+/////////////////////////////////////////////////////////////////////////
+
+#define BX_HOST_CRYPTO_TEST_VECTORS 64
+
+// xorshift64, the vectors are the same on every run
+static Bit64u host_crypto_random(Bit64u *state)
+{
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return *state;
+}
+
+// Runs the operations on random operands, once with the host extension and
+// once with the portable code, and compares the results. A host extension
+// which gives a different result is reported and not used.
+void bx_check_host_crypto(void)
+{
+  static const bxHostCryptoTest_t *lists[] = {
+    bx_aes_host_crypto_tests,
+    bx_sha_host_crypto_tests,
+    bx_crc32_host_crypto_tests,
+    bx_gf2_host_crypto_tests
+  };
+
+  Bit64u seed = BX_CONST64(0x9e3779b97f4a7c15);
+
+  for (unsigned l=0; l < sizeof(lists) / sizeof(lists[0]); l++) {
+    for (const bxHostCryptoTest_t *test = lists[l]; test->name; test++) {
+      if (! *test->feature) continue;
+
+      unsigned mismatches = 0;
+
+      for (unsigned n=0; n < BX_HOST_CRYPTO_TEST_VECTORS; n++) {
+        BxPackedXmmRegister xmm[3];
+        for (unsigned r=0; r < 3; r++) {
+          xmm[r].xmm64u(0) = host_crypto_random(&seed);
+          xmm[r].xmm64u(1) = host_crypto_random(&seed);
+        }
+        Bit8u imm8 = (Bit8u) host_crypto_random(&seed);
+
+        BxPackedXmmRegister result[2];
+        for (unsigned run=0; run < 2; run++) {
+          result[run] = xmm[1];
+          *test->feature = (run == 0);
+          test->op(&result[run], &xmm[2], &xmm[0], imm8);
+        }
+        *test->feature = true;
+
+        if (result[0].xmm64u(0) != result[1].xmm64u(0) || result[0].xmm64u(1) != result[1].xmm64u(1))
+          mismatches++;
+      }
+
+      if (mismatches) {
+        BX_ERROR(("host %s differs from the portable code on %u of %u random inputs, the host extension is not used",
+          test->name, mismatches, BX_HOST_CRYPTO_TEST_VECTORS));
+        *test->feature = false;
+      }
+    }
+  }
+}
+
+#else
+
+void bx_check_host_crypto(void) {}
+
+#endif // BX_HOST_CRYPTO
+
+#endif // BX_CPU_LEVEL >= 6
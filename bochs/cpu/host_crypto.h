@@ -0,0 +1,111 @@
+/////////////////////////////////////////////////////////////////////////
+// $Id$
+/////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (C) 2026  The Bochs Project
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA B 02110-1301 USA
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef BX_HOST_CRYPTO_H
+#define BX_HOST_CRYPTO_H
+
+// Host AES-NI, PCLMULQDQ, SHA, CRC32 and GFNI implementation of the guest
+// crypto instructions (--enable-host-simd)
+//
+// Unlike the packed integer helpers of simd_host.h these instructions are
+// not part of the x86-64 baseline, so they are compiled for their own host
+// instruction set extension and selected at runtime by the host CPUID. The
+// table driven emulation stays as the fallback when the host lacks them.
+// bx_check_host_crypto() compares both on random inputs at startup and
+// falls back to the portable code for any host extension that differs.
+
+#include "simd_host.h"
+
+#if BX_HOST_SSE2 && (defined(__GNUC__) || defined(_MSC_VER))
+  #define BX_HOST_CRYPTO 1
+#else
+  #define BX_HOST_CRYPTO 0
+#endif
+
+#if BX_HOST_CRYPTO
+
+struct bx_host_crypto_t {
+  bool aes;
+  bool pclmul;
+  bool sha;
+  bool crc32;
+  bool gfni;
+};
+
+// host features, detected once at startup
+extern bx_host_crypto_t bx_host_crypto;
+
+// AES round on a single 128-bit state
+extern void host_aesenc(BxPackedXmmRegister *state, const BxPackedXmmRegister *round_key);
+extern void host_aesenclast(BxPackedXmmRegister *state, const BxPackedXmmRegister *round_key);
+extern void host_aesdec(BxPackedXmmRegister *state, const BxPackedXmmRegister *round_key);
+extern void host_aesdeclast(BxPackedXmmRegister *state, const BxPackedXmmRegister *round_key);
+extern void host_aesimc(BxPackedXmmRegister *state);
+
+extern void host_pclmulqdq(BxPackedXmmRegister *r, Bit64u a, Bit64u b);
+
+// SHA1/SHA256, same operands as the guest instructions (op1 is the destination)
+extern void host_sha1rnds4(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, unsigned imm);
+extern void host_sha1nexte(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2);
+extern void host_sha1msg1(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2);
+extern void host_sha1msg2(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2);
+extern void host_sha256rnds2(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, const BxPackedXmmRegister *wk);
+extern void host_sha256msg1(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2);
+extern void host_sha256msg2(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2);
+
+// CRC32C accumulation of 1, 2, 4 or 8 bytes
+extern Bit32u host_crc32_8(Bit32u crc, Bit8u val);
+extern Bit32u host_crc32_16(Bit32u crc, Bit16u val);
+extern Bit32u host_crc32_32(Bit32u crc, Bit32u val);
+#if BX_SUPPORT_X86_64
+extern Bit32u host_crc32_64(Bit32u crc, Bit64u val);
+#endif
+
+extern void host_gf2p8mulb(BxPackedXmmRegister *dst, const BxPackedXmmRegister *src);
+extern void host_gf2p8affineqb(BxPackedXmmRegister *dst, const BxPackedXmmRegister *src, Bit8u imm8);
+extern void host_gf2p8affineinvqb(BxPackedXmmRegister *dst, const BxPackedXmmRegister *src, Bit8u imm8);
+
+// Operation checked by bx_check_host_crypto(), defined next to the portable
+// code of the instruction. It updates dst from dst and src like the register
+// form of the instruction, xmm0 is the implicit operand of SHA256RNDS2 and
+// the CRC32 forms accumulate into the low dword of dst.
+typedef void (*bxHostCryptoTestOp_t)(BxPackedXmmRegister *dst, const BxPackedXmmRegister *src,
+  const BxPackedXmmRegister *xmm0, Bit8u imm8);
+
+struct bxHostCryptoTest_t {
+  const char *name;
+  bxHostCryptoTestOp_t op;
+  bool *feature;
+};
+
+// terminated by an entry with a NULL name
+extern const bxHostCryptoTest_t bx_aes_host_crypto_tests[];
+extern const bxHostCryptoTest_t bx_sha_host_crypto_tests[];
+extern const bxHostCryptoTest_t bx_crc32_host_crypto_tests[];
+extern const bxHostCryptoTest_t bx_gf2_host_crypto_tests[];
+
+#endif
+
+// called once at startup, does not touch any processor state
+extern void bx_check_host_crypto(void);
+
+#endif
@@ -31,6 +31,9 @@
 #include "cpustats.h"
 
 #include "decoder/ia_opcodes.h"
+#include "decoder/fetchdecode.h"
+
+#include "tracefile.h"
 
 bxPageWriteStampTable pageWriteStampTable;
 
@@ -39,9 +42,18 @@ extern int fetchDecode32(const Bit8u *fetchPtr, bool is_32, bxInstruction_c *i,
 extern int fetchDecode64(const Bit8u *fetchPtr, bxInstruction_c *i, unsigned remainingInPage);
 #endif
 
+extern struct bxIAOpcodeTable BxOpcodesTable[];
+
 void flushICaches(void)
 {
   for (unsigned i=0; i<BX_SMP_PROCESSORS; i++) {
+#if BX_SUPPORT_SMP
+    if (bx_smp_is_remote_cpu(i)) {
+      BX_CPU(i)->smp_post_request(BX_SMP_REQ_ICACHE_FLUSH);
+      bx_smp_stop_remote_trace(i);
+      continue;
+    }
+#endif
     BX_CPU(i)->iCache.flushICacheEntries();
     BX_CPU(i)->async_event |= BX_ASYNC_EVENT_STOP_TRACE;
   }
@@ -51,9 +63,15 @@ void flushICaches(void)
 
 void handleSMC(bx_phy_address pAddr, Bit32u mask)
 {
-  INC_SMC_STAT(smc);
-
   for (unsigned i=0; i<BX_SMP_PROCESSORS; i++) {
+#if BX_SUPPORT_SMP
+    if (bx_smp_is_remote_cpu(i)) {
+      BX_CPU(i)->smp_post_request(BX_SMP_REQ_ICACHE_SMC, mask, pAddr);
+      bx_smp_stop_remote_trace(i);
+      continue;
+    }
+#endif
+    INC_SMC_STAT(BX_CPU(i), smc);
     BX_CPU(i)->async_event |= BX_ASYNC_EVENT_STOP_TRACE;
     BX_CPU(i)->iCache.handleSMC(pAddr, mask);
   }
@@ -92,17 +110,90 @@ void genDummyICacheEntry(bxInstruction_c *i)
 
 #endif
 
+static int compareTraceLocation(const void *a, const void *b)
+{
+  const bxInstruction_c *ia = (*(bxICacheEntry_c* const *) a)->i;
+  const bxInstruction_c *ib = (*(bxICacheEntry_c* const *) b)->i;
+
+  return (ia < ib) ? -1 : (ia > ib);
+}
+
+void bxICache_c::reclaimMemPoolSegment(void)
+{
+  mpsegment = (mpsegment + 1) % BxICacheMemPoolSegments;
+
+  unsigned segStart = mpsegment * BxICacheMemPoolSegmentSize;
+  bxInstruction_c *segStartPtr = &mpool[segStart];
+  bxInstruction_c *segEndPtr = segStartPtr + BxICacheMemPoolSegmentSize;
+  unsigned hot = 0;
+
+  // evict all traces living in the oldest mpool segment except the ones
+  // which were looked up since the previous reclaim
+  bxICacheEntry_c *e = entry;
+  for (unsigned n=0; n < BxICacheEntries; n++, e++) {
+    if (e->pAddr == BX_ICACHE_INVALID_PHY_ADDRESS || e->i < segStartPtr || e->i >= segEndPtr)
+      continue;
+
+    if ((Bit32s)(e->lastUse - lastReclaimClock) > 0)
+      reclaimList[hot++] = e;
+    else
+      e->pAddr = BX_ICACHE_INVALID_PHY_ADDRESS;
+  }
+
+  // compact the hot traces to the beginning of the segment, no more than
+  // half of the segment is kept so the reclaim always frees enough space
+  qsort(reclaimList, hot, sizeof(bxICacheEntry_c*), compareTraceLocation);
+
+  mpindex = segStart;
+  for (unsigned n=0; n < hot; n++) {
+    e = reclaimList[n];
+    if ((mpindex + e->tlen) > (segStart + BxICacheMemPoolSegmentSize/2)) {
+      e->pAddr = BX_ICACHE_INVALID_PHY_ADDRESS;
+      continue;
+    }
+    if (e->i != &mpool[mpindex])
+      memmove(&mpool[mpindex], e->i, sizeof(bxInstruction_c) * e->tlen);
+    e->i = &mpool[mpindex];
+    mpindex += e->tlen;
+  }
+
+  for (unsigned n=0; n < BX_ICACHE_PAGE_SPLIT_ENTRIES; n++) {
+    if (pageSplitIndex[n].ppf != BX_ICACHE_INVALID_PHY_ADDRESS) {
+      if (pageSplitIndex[n].e->pAddr == BX_ICACHE_INVALID_PHY_ADDRESS)
+        pageSplitIndex[n].ppf = BX_ICACHE_INVALID_PHY_ADDRESS;
+    }
+  }
+
+  lastReclaimClock = lruClock;
+
+  // traces were moved or dropped, links into the segment are not valid anymore
+  bumpTraceLinkTimeStamp();
+}
+
 bxICacheEntry_c* BX_CPU_C::serveICacheMiss(Bit32u eipBiased, bx_phy_address pAddr)
 {
+  if (traceFile.enabled() && ! bx_dbg.debugger_active) {
+    bxICacheEntry_c *entry = loadTraceFilePage(pAddr);
+    if (entry) return entry;
+  }
+
   bxICacheEntry_c *entry = BX_CPU_THIS_PTR iCache.get_entry(pAddr, BX_CPU_THIS_PTR fetchModeMask);
 
-  BX_CPU_THIS_PTR iCache.alloc_trace(entry);
+  if (entry->pAddr != pAddr && entry->pAddr != BX_ICACHE_INVALID_PHY_ADDRESS) {
+    INC_ICACHE_STAT(iCacheEvictions);
+  }
+
+  if (BX_CPU_THIS_PTR iCache.alloc_trace(entry)) {
+    INC_ICACHE_STAT(iCacheReclaims);
+  }
 
   // Cache miss. We weren't so lucky, but let's be optimistic - try to build
   // trace from incoming instruction bytes stream !
   entry->pAddr = pAddr;
   entry->traceMask = 0;
 
+  BX_CPU_THIS_PTR iCache.linkToPage(entry);
+
   unsigned remainingInPage = BX_CPU_THIS_PTR eipPageWindowSize - eipBiased;
   const Bit8u *fetchPtr = BX_CPU_THIS_PTR eipFetchPtr + eipBiased;
   int ret;
@@ -118,13 +209,7 @@ bxICacheEntry_c* BX_CPU_C::serveICacheMiss(Bit32u eipBiased, bx_phy_address pAdd
 #endif
 
   // Don't allow traces longer than cpu_loop can execute
-  static unsigned quantum =
-#if BX_SUPPORT_SMP
-    (BX_SMP_PROCESSORS > 1) ? SIM->get_param_num(BXPN_SMP_QUANTUM)->get() :
-#endif
-    BX_MAX_TRACE_LENGTH;
-  if (bx_dbg.debugger_active)
-    quantum = 1;
+  unsigned quantum = bx_dbg.debugger_active ? 1 : BX_CPU_THIS_PTR traceQuantum;
 
   for (unsigned n=0;n < quantum;n++)
   {
@@ -193,9 +278,16 @@ bxICacheEntry_c* BX_CPU_C::serveICacheMiss(Bit32u eipBiased, bx_phy_address pAdd
     // try to find a trace starting from current pAddr and merge
     if (!bx_dbg.debugger_active) {
       if (remainingInPage >= 15) { // avoid merging with page split trace
+        unsigned decoded = entry->tlen;
         if (mergeTraces(entry, i, pAddr)) {
+          if (traceFile.enabled())
+            traceFile.record(BX_CPU_THIS_PTR pAddrFetchPage, BX_CPU_THIS_PTR fetchModeMask & BX_TRACE_FILE_MODE_MASK,
+                BX_CPU_THIS_PTR eipFetchPtr, eipBiased, entry->i, decoded);
           entry->traceMask |= traceMask;
           pageWriteStampTable.markICacheMask(pAddr, entry->traceMask);
+#if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS
+          optimizeTrace(entry->i, entry->tlen);
+#endif
           BX_CPU_THIS_PTR iCache.commit_trace(entry->tlen);
           return entry;
         }
@@ -207,18 +299,342 @@ bxICacheEntry_c* BX_CPU_C::serveICacheMiss(Bit32u eipBiased, bx_phy_address pAdd
 
   pageWriteStampTable.markICacheMask(pAddr, entry->traceMask);
 
+  unsigned decoded = entry->tlen;
+
   if (! bx_dbg.debugger_active) {
+    if (traceFile.enabled())
+      traceFile.record(BX_CPU_THIS_PTR pAddrFetchPage, BX_CPU_THIS_PTR fetchModeMask & BX_TRACE_FILE_MODE_MASK,
+          BX_CPU_THIS_PTR eipFetchPtr, eipBiased, entry->i, decoded);
 #if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS
     entry->tlen++; /* Add the inserted end of trace opcode */
     genDummyICacheEntry(i);
+    optimizeTrace(entry->i, entry->tlen);
 #endif
   }
 
   BX_CPU_THIS_PTR iCache.commit_trace(entry->tlen);
 
+  if (BX_CPU_THIS_PTR decodeAheadTraces && ! bx_dbg.debugger_active)
+    decodeAhead(entry, decoded, eipBiased);
+
   return entry;
 }
 
+// Cold code misses the trace cache once for every trace executed. When a trace
+// is built on a miss, the traces it could continue with (targets of the direct
+// branches and the fall-through successor) are decoded right away as long as
+// they are on the same page, up to the decode_ahead budget. Candidates are
+// kept as offsets into the current fetch window.
+#define BX_DECODE_AHEAD_QUEUE_SIZE 16
+
+static unsigned queueDecodeAhead(Bit32u *queue, unsigned num, Bit32u offset)
+{
+  if (num == BX_DECODE_AHEAD_QUEUE_SIZE) return num;
+
+  for (unsigned n=0; n < num; n++)
+    if (queue[n] == offset) return num;
+
+  queue[num] = offset;
+  return num+1;
+}
+
+unsigned BX_CPU_C::decodeAheadSuccessors(const bxInstruction_c *i, unsigned len, Bit32u eipBiased, Bit32u *queue, unsigned num)
+{
+  bool fallThrough = true;
+
+  for (unsigned n=0; n < len; n++, i++) {
+    unsigned ia_opcode = i->getIaOpcode();
+    eipBiased += i->ilen();
+    fallThrough = (BxOpcodesTable[ia_opcode].opflags & BX_TRACE_END) == 0;
+
+    unsigned src = BxOpcodesTable[ia_opcode].src[0];
+    if (BX_DISASM_SRC_ORIGIN(src) != BX_SRC_BRANCH_OFFSET) continue;
+
+    bx_address target = eipBiased - BX_CPU_THIS_PTR eipPageBias;
+    switch (BX_DISASM_SRC_TYPE(src)) {
+    case BX_IMMW:
+    case BX_IMMBW_SE:
+      target = (target + (Bit16s) i->Iw()) & 0xffff;
+      break;
+    default:
+      target += (Bit32s) i->Id();
+      if (! long64_mode()) target &= 0xffffffff;
+      break;
+    }
+
+    // the fetch window is already limited by the CS segment limit
+    target += BX_CPU_THIS_PTR eipPageBias;
+    if (target < BX_CPU_THIS_PTR eipPageWindowSize)
+      num = queueDecodeAhead(queue, num, (Bit32u) target);
+
+    // only an unconditional jump has no fall-through successor
+    switch (ia_opcode) {
+    case BX_IA_JMP_Jw:
+    case BX_IA_JMP_Jbw:
+    case BX_IA_JMP_Jd:
+    case BX_IA_JMP_Jbd:
+#if BX_SUPPORT_X86_64
+    case BX_IA_JMP_Jq:
+    case BX_IA_JMP_Jbq:
+#endif
+      fallThrough = false;
+      break;
+    default:
+      fallThrough = true;
+      break;
+    }
+  }
+
+  if (fallThrough && eipBiased < BX_CPU_THIS_PTR eipPageWindowSize)
+    num = queueDecodeAhead(queue, num, eipBiased);
+
+  return num;
+}
+
+void BX_CPU_C::decodeAhead(bxICacheEntry_c *missed, unsigned len, Bit32u eipBiased)
+{
+  Bit32u queue[BX_DECODE_AHEAD_QUEUE_SIZE];
+  unsigned head = 1, tail = 1;
+
+  queue[0] = eipBiased;
+  tail = decodeAheadSuccessors(missed->i, len, eipBiased, queue, tail);
+
+  for (unsigned budget = BX_CPU_THIS_PTR decodeAheadTraces; budget > 0 && head < tail; head++)
+  {
+    // never reclaim an mpool segment, the missed trace could be moved
+    if (! BX_CPU_THIS_PTR iCache.can_alloc_trace()) break;
+
+    Bit32u offset = queue[head];
+    bx_phy_address pAddr = BX_CPU_THIS_PTR pAddrFetchPage + offset;
+    bxICacheEntry_c *entry = BX_CPU_THIS_PTR iCache.get_decode_ahead_entry(pAddr, BX_CPU_THIS_PTR fetchModeMask);
+    if (entry == NULL || entry == missed) continue;
+
+    budget--;
+
+    BX_CPU_THIS_PTR iCache.alloc_trace(entry);
+
+    unsigned remainingInPage = BX_CPU_THIS_PTR eipPageWindowSize - offset;
+    const Bit8u *fetchPtr = BX_CPU_THIS_PTR eipFetchPtr + offset;
+    Bit32u pageOffset = PAGE_OFFSET((Bit32u) pAddr);
+    Bit32u traceMask = 0;
+    bxInstruction_c *i = entry->i;
+    int ret;
+
+    for (unsigned n=0; n < BX_CPU_THIS_PTR traceQuantum; n++)
+    {
+#if BX_SUPPORT_X86_64
+      if (BX_CPU_THIS_PTR cpu_mode == BX_MODE_LONG_64)
+        ret = fetchDecode64(fetchPtr, i, remainingInPage);
+      else
+#endif
+        ret = fetchDecode32(fetchPtr, BX_CPU_THIS_PTR sregs[BX_SEG_REG_CS].cache.u.segment.d_b, i, remainingInPage);
+
+      // the page split instruction is left for the demand fetch
+      if (ret < 0) break;
+
+      ret = assignHandler(i, BX_CPU_THIS_PTR fetchModeMask);
+
+      unsigned iLen = i->ilen();
+      entry->tlen++;
+
+#ifdef BX_INSTR_STORE_OPCODE_BYTES
+      i->set_opcode_bytes(fetchPtr);
+#endif
+      BX_INSTR_OPCODE(BX_CPU_ID, i, fetchPtr, iLen,
+         BX_CPU_THIS_PTR sregs[BX_SEG_REG_CS].cache.u.segment.d_b, long64_mode());
+
+      i++;
+
+      traceMask |= 1 <<  (pageOffset >> 7);
+      traceMask |= 1 << ((pageOffset + iLen - 1) >> 7);
+
+      remainingInPage -= iLen;
+      if (ret != 0 || remainingInPage == 0) break;
+      pageOffset += iLen;
+      fetchPtr += iLen;
+    }
+
+    if (entry->tlen == 0) {
+      entry->pAddr = BX_ICACHE_INVALID_PHY_ADDRESS;
+      continue;
+    }
+
+    // the trace was not executed yet, it is the first to go if it never will
+    entry->pAddr = pAddr;
+    entry->traceMask = traceMask;
+    entry->lastUse = BX_CPU_THIS_PTR iCache.lastReclaimClock;
+
+    BX_CPU_THIS_PTR iCache.linkToPage(entry);
+    pageWriteStampTable.markICacheMask(pAddr, traceMask);
+
+    tail = decodeAheadSuccessors(entry->i, entry->tlen, offset, queue, tail);
+
+#if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS
+    entry->tlen++; /* Add the inserted end of trace opcode */
+    genDummyICacheEntry(i);
+    optimizeTrace(entry->i, entry->tlen);
+#endif
+
+    BX_CPU_THIS_PTR iCache.commit_trace(entry->tlen);
+
+    INC_ICACHE_STAT(iCacheDecodeAhead);
+  }
+}
+
+// Builds the trace from the instructions recorded in the trace cache file,
+// returns the number of instructions added to the entry.
+unsigned BX_CPU_C::loadTraceFileTrace(bxICacheEntry_c *entry, const bxTraceFileView_t *view, unsigned trace)
+{
+  unsigned offset = view->traces[trace].offset;
+  bx_phy_address pAddr = BX_CPU_THIS_PTR pAddrFetchPage + offset;
+  const Bit8u *src = view->instr;
+  for (unsigned n=0; n < trace; n++) src += view->traces[n].len * sizeof(bxInstruction_c);
+
+  unsigned len = view->traces[trace].len;
+  if (len > BX_CPU_THIS_PTR traceQuantum) len = BX_CPU_THIS_PTR traceQuantum;
+
+  Bit32u traceMask = 0;
+  bxInstruction_c *i = entry->i;
+
+  for (unsigned n=0; n < len; n++, src += sizeof(bxInstruction_c)) {
+    memcpy((void *) i, src, sizeof(bxInstruction_c));
+
+    // the fetch window could be shorter because of the CS segment limit
+    unsigned iLen = i->ilen();
+    if (offset + iLen > BX_CPU_THIS_PTR eipPageWindowSize) break;
+
+    int ret = assignHandler(i, BX_CPU_THIS_PTR fetchModeMask);
+    entry->tlen++;
+
+#ifdef BX_INSTR_STORE_OPCODE_BYTES
+    i->set_opcode_bytes(BX_CPU_THIS_PTR eipFetchPtr + offset);
+#endif
+    BX_INSTR_OPCODE(BX_CPU_ID, i, BX_CPU_THIS_PTR eipFetchPtr + offset, iLen,
+       BX_CPU_THIS_PTR sregs[BX_SEG_REG_CS].cache.u.segment.d_b, long64_mode());
+
+    i++;
+
+    traceMask |= 1 <<  (offset >> 7);
+    traceMask |= 1 << ((offset + iLen - 1) >> 7);
+
+    offset += iLen;
+    if (ret != 0) break;
+  }
+
+  if (entry->tlen == 0) {
+    entry->pAddr = BX_ICACHE_INVALID_PHY_ADDRESS;
+    return 0;
+  }
+
+  entry->pAddr = pAddr;
+  entry->traceMask = traceMask;
+
+  BX_CPU_THIS_PTR iCache.linkToPage(entry);
+  pageWriteStampTable.markICacheMask(pAddr, traceMask);
+
+  unsigned loaded = entry->tlen;
+
+#if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS
+  entry->tlen++; /* Add the inserted end of trace opcode */
+  genDummyICacheEntry(i);
+  optimizeTrace(entry->i, entry->tlen);
+#endif
+
+  BX_CPU_THIS_PTR iCache.commit_trace(entry->tlen);
+
+  return loaded;
+}
+
+// On the first miss in a page whose content was recorded in the trace cache
+// file all the traces recorded for the page are loaded, the trace which
+// missed is returned (NULL if it was not recorded and has to be decoded).
+bxICacheEntry_c* BX_CPU_C::loadTraceFilePage(bx_phy_address pAddr)
+{
+  unsigned mode = BX_CPU_THIS_PTR fetchModeMask & BX_TRACE_FILE_MODE_MASK;
+
+  if (! BX_CPU_THIS_PTR iCache.probeTraceFile(BX_CPU_THIS_PTR pAddrFetchPage, mode))
+    return NULL;
+
+  bxTraceFileView_t view;
+  if (! traceFile.lookup(BX_CPU_THIS_PTR eipFetchPtr, mode, &view))
+    return NULL;
+
+#if BX_SUPPORT_SMP == 0
+  if (BX_CPU_THIS_PTR pAddrFetchPage == BX_CPU_THIS_PTR pAddrStackPage)
+    invalidate_stack_cache();
+#endif
+
+  Bit32u missedOffset = PAGE_OFFSET((Bit32u) pAddr);
+  bxICacheEntry_c *missed = NULL;
+
+  // the trace which missed first, this allocation could reclaim an mpool segment
+  for (unsigned n=0; n < view.ntraces; n++) {
+    if (view.traces[n].offset != missedOffset) continue;
+
+    missed = BX_CPU_THIS_PTR iCache.get_entry(pAddr, BX_CPU_THIS_PTR fetchModeMask);
+    if (missed->pAddr != pAddr && missed->pAddr != BX_ICACHE_INVALID_PHY_ADDRESS) {
+      INC_ICACHE_STAT(iCacheEvictions);
+    }
+    if (BX_CPU_THIS_PTR iCache.alloc_trace(missed)) {
+      INC_ICACHE_STAT(iCacheReclaims);
+    }
+    if (! loadTraceFileTrace(missed, &view, n)) missed = NULL;
+    break;
+  }
+
+  // the others were not executed yet in this run, they go first if they never will
+  for (unsigned n=0; n < view.ntraces; n++) {
+    if (view.traces[n].offset == missedOffset) continue;
+
+    if (! BX_CPU_THIS_PTR iCache.can_alloc_trace()) break;
+
+    bx_phy_address traceAddr = BX_CPU_THIS_PTR pAddrFetchPage + view.traces[n].offset;
+    bxICacheEntry_c *entry = BX_CPU_THIS_PTR iCache.get_decode_ahead_entry(traceAddr, BX_CPU_THIS_PTR fetchModeMask);
+    if (entry == NULL || entry == missed) continue;
+
+    BX_CPU_THIS_PTR iCache.alloc_trace(entry);
+    if (loadTraceFileTrace(entry, &view, n)) {
+      entry->lastUse = BX_CPU_THIS_PTR iCache.lastReclaimClock;
+      INC_ICACHE_STAT(iCacheTraceFileLoads);
+    }
+  }
+
+  if (missed) {
+    INC_ICACHE_STAT(iCacheTraceFileLoads);
+  }
+
+  return missed;
+}
+
+// The trace cache file can be used only by the binary which wrote it with
+// the same CPU configuration, the signature covers the decoder tables and
+// the supported instruction set extensions.
+Bit64u BX_CPU_C::traceFileSignature(void)
+{
+  Bit64u hash = BX_CONST64(0xcbf29ce484222325);
+
+#define BX_TRACE_FILE_HASH(val) \
+  hash = (hash ^ (Bit64u)(val)) * BX_CONST64(0x100000001b3)
+
+  BX_TRACE_FILE_HASH(BX_IA_LAST);
+  BX_TRACE_FILE_HASH(sizeof(bxInstruction_c));
+
+  for (unsigned n=0; n < BX_IA_LAST; n++) {
+    for (const char *name = get_bx_opcode_name(n); *name; name++)
+      BX_TRACE_FILE_HASH(*name);
+    for (unsigned k=0; k < 4; k++)
+      BX_TRACE_FILE_HASH(BxOpcodesTable[n].src[k]);
+    BX_TRACE_FILE_HASH(BxOpcodesTable[n].opflags);
+  }
+
+  for (unsigned n=0; n < BX_ISA_EXTENSIONS_ARRAY_SIZE; n++)
+    BX_TRACE_FILE_HASH(BX_CPU_THIS_PTR ia_extensions_bitmask[n]);
+
+#undef BX_TRACE_FILE_HASH
+
+  return hash;
+}
+
 bool BX_CPU_C::mergeTraces(bxICacheEntry_c *entry, bxInstruction_c *i, bx_phy_address pAddr)
 {
   BX_ASSERT(!bx_dbg.debugger_active);
@@ -231,17 +647,17 @@ bool BX_CPU_C::mergeTraces(bxICacheEntry_c *entry, bxInstruction_c *i, bx_phy_ad
     unsigned max_length = e->tlen;
 
 #if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS
-    if (max_length + entry->tlen > BX_MAX_TRACE_LENGTH)
+    if (max_length + entry->tlen > BX_CPU_THIS_PTR maxTraceLength)
         return false;
 #else
-    if (max_length + entry->tlen > BX_MAX_TRACE_LENGTH)
-        max_length = BX_MAX_TRACE_LENGTH - entry->tlen;
+    if (max_length + entry->tlen > BX_CPU_THIS_PTR maxTraceLength)
+        max_length = BX_CPU_THIS_PTR maxTraceLength - entry->tlen;
     if(max_length == 0) return false;
 #endif
 
     memcpy(i, e->i, sizeof(bxInstruction_c)*max_length);
     entry->tlen += max_length;
-    BX_ASSERT(entry->tlen <= BX_MAX_TRACE_LENGTH);
+    BX_ASSERT(entry->tlen <= BX_CPU_THIS_PTR maxTraceLength);
 
     entry->traceMask |= e->traceMask;
 
@@ -26,26 +26,92 @@
 
 extern void handleSMC(bx_phy_address pAddr, Bit32u mask);
 
+// Every 4K physical page has a 32-bit mask of 128-byte lines which have
+// instructions decoded into the trace cache. The table is sparse: one array
+// of masks per 4G of physical address space, the arrays above 4G are only
+// allocated when code is executed from there, so pages above 4G never alias.
+#define BX_PHY_MEM_PAGES_IN_4G_SPACE (1024*1024)
+
+// The table also keeps the optional dirty page log used by the incremental
+// checkpoints: one bit per 4K page of guest RAM written since the log was
+// last cleared. All the writes to guest RAM already pass through
+// decWriteStamp(), so the log is maintained there.
+#if BX_PHY_ADDRESS_WIDTH > 32
+  #define BX_PAGE_WRITE_STAMP_REGIONS (1 << (BX_PHY_ADDRESS_WIDTH - 32))
+#else
+  #define BX_PAGE_WRITE_STAMP_REGIONS 1
+#endif
+
 class bxPageWriteStampTable
 {
-  const Bit32u PHY_MEM_PAGES_IN_4G_SPACE;
-  Bit32u *fineGranularityMapping;
+  Bit32u *fineGranularityMapping[BX_PAGE_WRITE_STAMP_REGIONS];
+
+  Bit32u *dirtyLog;     // NULL if the dirty page log is disabled
+  Bit64u dirtyLogPages;
 
 public:
-  bxPageWriteStampTable(): PHY_MEM_PAGES_IN_4G_SPACE(1024*1024) {
-    fineGranularityMapping = new Bit32u[PHY_MEM_PAGES_IN_4G_SPACE];
+  bxPageWriteStampTable() {
+    fineGranularityMapping[0] = new Bit32u[BX_PHY_MEM_PAGES_IN_4G_SPACE];
+    for (unsigned n=1; n < BX_PAGE_WRITE_STAMP_REGIONS; n++)
+      fineGranularityMapping[n] = NULL;
     resetWriteStamps();
+    dirtyLog = NULL;
+    dirtyLogPages = 0;
+  }
+ ~bxPageWriteStampTable() {
+    for (unsigned n=0; n < BX_PAGE_WRITE_STAMP_REGIONS; n++)
+      delete [] fineGranularityMapping[n];
+    delete [] dirtyLog;
   }
- ~bxPageWriteStampTable() { delete [] fineGranularityMapping; }
 
   BX_CPP_INLINE static Bit32u hash(bx_phy_address pAddr) {
-    // can share writeStamps between multiple pages if >32 bit phy address
     return ((Bit32u) pAddr) >> 12;
   }
 
+  BX_CPP_INLINE static unsigned region(bx_phy_address pAddr) {
+#if BX_PAGE_WRITE_STAMP_REGIONS > 1
+    return (unsigned)(pAddr >> 32) & (BX_PAGE_WRITE_STAMP_REGIONS-1);
+#else
+    return 0;
+#endif
+  }
+
+  // returns NULL if nothing was ever marked in the 4G region of the pAddr
+  BX_CPP_INLINE Bit32u* getMapping(bx_phy_address pAddr) const
+  {
+#if BX_SUPPORT_SMP
+    // the table pointer is published by allocMapping with a full barrier,
+    // always reload it instead of reusing a stale NULL
+    return *(Bit32u* volatile *) &fineGranularityMapping[region(pAddr)];
+#else
+    return fineGranularityMapping[region(pAddr)];
+#endif
+  }
+
+  BX_CPP_INLINE Bit32u* allocMapping(bx_phy_address pAddr)
+  {
+    Bit32u *mapping = getMapping(pAddr);
+    if (! mapping) {
+      mapping = new Bit32u[BX_PHY_MEM_PAGES_IN_4G_SPACE];
+      memset(mapping, 0, sizeof(Bit32u) * BX_PHY_MEM_PAGES_IN_4G_SPACE);
+#if BX_SUPPORT_SMP
+      // another processor thread could allocate the same region, only the
+      // first table is published and the loser frees its own copy
+      if (! BX_ATOMIC_CASPTR(&fineGranularityMapping[region(pAddr)], (Bit32u*) NULL, mapping)) {
+        delete [] mapping;
+        mapping = getMapping(pAddr);
+      }
+#else
+      fineGranularityMapping[region(pAddr)] = mapping;
+#endif
+    }
+    return mapping;
+  }
+
   BX_CPP_INLINE Bit32u getFineGranularityMapping(bx_phy_address pAddr) const
   {
-    return fineGranularityMapping[hash(pAddr)];
+    Bit32u *mapping = getMapping(pAddr);
+    return mapping ? mapping[hash(pAddr)] : 0;
   }
 
   BX_CPP_INLINE void markICache(bx_phy_address pAddr, unsigned len)
@@ -53,38 +119,119 @@ public:
     Bit32u mask  = 1 << (PAGE_OFFSET((Bit32u) pAddr) >> 7);
            mask |= 1 << (PAGE_OFFSET((Bit32u) pAddr + len - 1) >> 7);
 
-    fineGranularityMapping[hash(pAddr)] |= mask;
+#if BX_SUPPORT_SMP
+    BX_ATOMIC_OR32(&allocMapping(pAddr)[hash(pAddr)], mask);
+#else
+    allocMapping(pAddr)[hash(pAddr)] |= mask;
+#endif
   }
 
   BX_CPP_INLINE void markICacheMask(bx_phy_address pAddr, Bit32u mask)
   {
-    fineGranularityMapping[hash(pAddr)] |= mask;
+#if BX_SUPPORT_SMP
+    BX_ATOMIC_OR32(&allocMapping(pAddr)[hash(pAddr)], mask);
+#else
+    allocMapping(pAddr)[hash(pAddr)] |= mask;
+#endif
+  }
+
+  // starts logging the writes to the first <bytes> of the physical memory
+  void enableDirtyLog(Bit64u bytes)
+  {
+    delete [] dirtyLog;
+    dirtyLogPages = (bytes + 0xfff) >> 12;
+    dirtyLog = new Bit32u[(dirtyLogPages + 31) / 32];
+    clearDirtyLog();
+  }
+
+  void disableDirtyLog(void)
+  {
+    delete [] dirtyLog;
+    dirtyLog = NULL;
+    dirtyLogPages = 0;
+  }
+
+  BX_CPP_INLINE bool dirtyLogEnabled(void) const { return dirtyLog != NULL; }
+
+  void clearDirtyLog(void)
+  {
+    if (dirtyLog)
+      memset(dirtyLog, 0, sizeof(Bit32u) * ((dirtyLogPages + 31) / 32));
+  }
+
+  Bit64u countDirtyPages(void) const
+  {
+    Bit64u count = 0;
+    for (Bit64u n = 0; dirtyLog && n < (dirtyLogPages + 31) / 32; n++) {
+      for (Bit32u word = dirtyLog[n]; word; word &= word - 1) count++;
+    }
+    return count;
+  }
+
+  BX_CPP_INLINE bool isPageDirty(Bit64u page) const
+  {
+    return page < dirtyLogPages && (dirtyLog[page >> 5] & (1 << (page & 31))) != 0;
+  }
+
+  BX_CPP_INLINE void markDirty(bx_phy_address pAddr)
+  {
+    Bit64u page = pAddr >> 12;
+    if (page >= dirtyLogPages) return;
+
+    Bit32u *word = &dirtyLog[page >> 5];
+    Bit32u bit = 1 << (page & 31);
+    // most of the writes go to pages which are dirty already
+    if (! (*word & bit)) {
+#if BX_SUPPORT_SMP
+      BX_ATOMIC_OR32(word, bit);
+#else
+      *word |= bit;
+#endif
+    }
   }
 
   // whole page is being altered
   BX_CPP_INLINE void decWriteStamp(bx_phy_address pAddr)
   {
+    markDirty(pAddr);
+
+    Bit32u *mapping = getMapping(pAddr);
+    if (! mapping) return;
+
     Bit32u index = hash(pAddr);
 
-    if (fineGranularityMapping[index]) {
+    if (mapping[index]) {
       handleSMC(pAddr, 0xffffffff); // one of the CPUs might be running trace from this page
-      fineGranularityMapping[index] = 0;
+#if BX_SUPPORT_SMP
+      BX_ATOMIC_AND32(&mapping[index], 0);
+#else
+      mapping[index] = 0;
+#endif
     }
   }
 
   // assumption: write does not split 4K page
   BX_CPP_INLINE void decWriteStamp(bx_phy_address pAddr, unsigned len)
   {
+    markDirty(pAddr);
+
+    Bit32u *mapping = getMapping(pAddr);
+    if (! mapping) return;
+
     Bit32u index = hash(pAddr);
 
-    if (fineGranularityMapping[index]) {
+    if (mapping[index]) {
        Bit32u mask  = 1 << (PAGE_OFFSET((Bit32u) pAddr) >> 7);
               mask |= 1 << (PAGE_OFFSET((Bit32u) pAddr + len - 1) >> 7);
 
-       if (fineGranularityMapping[index] & mask) {
+       if (mapping[index] & mask) {
           // one of the CPUs might be running trace from this page
           handleSMC(pAddr, mask);
-          fineGranularityMapping[index] &= ~mask;
+#if BX_SUPPORT_SMP
+          BX_ATOMIC_AND32(&mapping[index], ~mask);
+#else
+          mapping[index] &= ~mask;
+#endif
        }
     }
   }
@@ -94,16 +241,29 @@ public:
 
 BX_CPP_INLINE void bxPageWriteStampTable::resetWriteStamps(void)
 {
-  for (Bit32u i=0; i<PHY_MEM_PAGES_IN_4G_SPACE; i++) {
-    fineGranularityMapping[i] = 0;
+  for (unsigned n=0; n < BX_PAGE_WRITE_STAMP_REGIONS; n++) {
+    if (fineGranularityMapping[n])
+      memset(fineGranularityMapping[n], 0, sizeof(Bit32u) * BX_PHY_MEM_PAGES_IN_4G_SPACE);
   }
 }
 
 extern bxPageWriteStampTable pageWriteStampTable;
 
 #define BxICacheEntries (64  * 1024)  // Must be a power of 2.
+#define BxICacheWays    (4)           // Must be a power of 2, 1 means direct mapped
+#define BxICacheSets    (BxICacheEntries / BxICacheWays)
 #define BxICacheMemPool (576 * 1024)
 
+// The mpool is recycled one segment at a time: when the allocation pointer
+// reaches the oldest segment only traces living there are evicted, traces
+// which were used since the previous reclaim are compacted and kept.
+#define BxICacheMemPoolSegments (8)
+#define BxICacheMemPoolSegmentSize (BxICacheMemPool / BxICacheMemPoolSegments)
+
+// Reverse index from physical page to the trace cache entries decoded from
+// it, used to find the traces to invalidate on self modifying code.
+#define BxICachePageBuckets (8 * 1024) // Must be a power of 2.
+
 struct bxICacheEntry_c
 {
   bx_phy_address pAddr; // Physical address of the instruction
@@ -111,9 +271,9 @@ struct bxICacheEntry_c
 
   Bit32u tlen;          // Trace length in instructions
   bxInstruction_c *i;
-};
 
-#define BX_MAX_TRACE_LENGTH 32
+  Bit32u lastUse;       // LRU stamp of the last lookup hit
+};
 
 static const bx_phy_address BX_ICACHE_INVALID_PHY_ADDRESS = bx_phy_address(-1);
 
@@ -124,9 +284,13 @@ public:
   bxICacheEntry_c entry[BxICacheEntries];
   bxInstruction_c mpool[BxICacheMemPool];
   unsigned mpindex;
+  unsigned mpsegment; // mpool segment currently used for allocation
 
   Bit32u traceLinkTimeStamp;
 
+  Bit32u lruClock;
+  Bit32u lastReclaimClock;
+
 #define BX_ICACHE_PAGE_SPLIT_ENTRIES 8 /* must be power of two */
   struct pageSplitEntryIndex {
     bx_phy_address ppf; // Physical address of 2nd page of the trace
@@ -134,27 +298,128 @@ public:
   } pageSplitIndex[BX_ICACHE_PAGE_SPLIT_ENTRIES];
   int nextPageSplitIndex;
 
+  // scratch list used for mpool segment compaction
+  bxICacheEntry_c *reclaimList[BxICacheEntries];
+
+  // pages already looked up in the trace cache file (page | fetch mode)
+#define BX_ICACHE_TRACE_FILE_PROBES 1024 /* must be power of two */
+  bx_phy_address traceFileProbe[BX_ICACHE_TRACE_FILE_PROBES];
+
+  // Circular doubly linked lists of entries per page bucket, the list heads
+  // are the nodes BxICacheEntries...BxICacheEntries+BxICachePageBuckets-1.
+  // An entry is (re)linked into the bucket of its page when a trace is
+  // built into it, stale nodes are skipped during the walk.
+  Bit32u pageLinkNext[BxICacheEntries + BxICachePageBuckets];
+  Bit32u pageLinkPrev[BxICacheEntries + BxICachePageBuckets];
+
+#if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS && BX_ENABLE_TRACE_LINKING
+  // Return address stack: near CALLs push the linear return address, the
+  // matching near RET links to the trace remembered in the entry without
+  // translating and looking up the return address. The entry keeps its trace
+  // when the same call site pushes it again at the same call depth.
+#define BX_ICACHE_RET_STACK_ENTRIES 16 /* must be power of two */
+  struct retStackEntry {
+    bx_address laddr;          // linear return address
+    Bit32u fetchModeMask;      // fetch mode and CPL == 3 at the CALL
+    Bit32u traceLinkTimeStamp; // trace is valid while the links are valid
+    bxInstruction_c *trace;    // trace at the return address or NULL
+  } retStack[BX_ICACHE_RET_STACK_ENTRIES];
+  unsigned retStackTop;
+#endif
+
 public:
-  bxICache_c() { flushICacheEntries(); }
+  bxICache_c(): lruClock(0) { flushICacheEntries(); }
 
   BX_CPP_INLINE static unsigned hash(bx_phy_address pAddr, unsigned fetchModeMask)
   {
-//  return ((pAddr + (pAddr << 2) + (pAddr>>6)) & (BxICacheEntries-1)) ^ fetchModeMask;
-    return ((pAddr) & (BxICacheEntries-1)) ^ fetchModeMask;
+//  return ((pAddr + (pAddr << 2) + (pAddr>>6)) & (BxICacheSets-1)) ^ fetchModeMask;
+    return ((pAddr) & (BxICacheSets-1)) ^ fetchModeMask;
   }
 
-  BX_CPP_INLINE void alloc_trace(bxICacheEntry_c *e)
+  // returns true if an mpool segment had to be reclaimed to fit the trace
+  BX_CPP_INLINE bool alloc_trace(bxICacheEntry_c *e)
   {
+    bool reclaimed = false;
+
     // took +1 garbend for instruction chaining speedup (end-of-trace opcode)
-    if ((mpindex + BX_MAX_TRACE_LENGTH + 1) > BxICacheMemPool) {
-      flushICacheEntries();
+    if ((mpindex + BX_MAX_TRACE_LENGTH + 1) > (mpsegment + 1) * BxICacheMemPoolSegmentSize) {
+      // the entry is going to be rebuilt, do not let the reclaim keep its old trace
+      e->pAddr = BX_ICACHE_INVALID_PHY_ADDRESS;
+      reclaimMemPoolSegment();
+      reclaimed = true;
     }
     e->i = &mpool[mpindex];
     e->tlen = 0;
+    return reclaimed;
+  }
+
+  void reclaimMemPoolSegment(void);
+
+  BX_CPP_INLINE static unsigned pageBucket(bx_phy_address pAddr)
+  {
+    return (unsigned)(pAddr >> 12) & (BxICachePageBuckets-1);
+  }
+
+  BX_CPP_INLINE void resetPageIndex(void)
+  {
+    for (unsigned n=0; n < BxICacheEntries + BxICachePageBuckets; n++)
+      pageLinkNext[n] = pageLinkPrev[n] = n;
+  }
+
+  // register the entry in the reverse index of the page it was built from
+  BX_CPP_INLINE void linkToPage(bxICacheEntry_c *e)
+  {
+    Bit32u node = (Bit32u)(e - entry);
+    Bit32u head = BxICacheEntries + pageBucket(e->pAddr);
+
+    // unlink from the bucket of the trace previously held by the entry
+    pageLinkNext[pageLinkPrev[node]] = pageLinkNext[node];
+    pageLinkPrev[pageLinkNext[node]] = pageLinkPrev[node];
+
+    pageLinkNext[node] = pageLinkNext[head];
+    pageLinkPrev[node] = head;
+    pageLinkPrev[pageLinkNext[head]] = node;
+    pageLinkNext[head] = node;
   }
 
   BX_CPP_INLINE void commit_trace(unsigned len) { mpindex += len; }
 
+#if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS && BX_ENABLE_TRACE_LINKING
+  BX_CPP_INLINE void pushReturn(bx_address laddr, Bit32u mode)
+  {
+    retStackEntry *e = &retStack[retStackTop++ & (BX_ICACHE_RET_STACK_ENTRIES-1)];
+    if (e->laddr != laddr || e->fetchModeMask != mode) {
+      e->laddr = laddr;
+      e->fetchModeMask = mode;
+      e->trace = NULL;
+    }
+  }
+
+  BX_CPP_INLINE retStackEntry* popReturn(void)
+  {
+    return &retStack[--retStackTop & (BX_ICACHE_RET_STACK_ENTRIES-1)];
+  }
+
+  BX_CPP_INLINE void flushReturnStack(void)
+  {
+    for (unsigned n=0; n < BX_ICACHE_RET_STACK_ENTRIES; n++) {
+      retStack[n].laddr = 0;
+      retStack[n].fetchModeMask = 0xffffffff; // never matches a fetch mode
+      retStack[n].trace = NULL;
+    }
+    retStackTop = 0;
+  }
+#endif
+
+  // returns false if the page was already looked up in the trace cache file
+  BX_CPP_INLINE bool probeTraceFile(bx_phy_address ppf, unsigned mode)
+  {
+    bx_phy_address *probe = &traceFileProbe[pageBucket(ppf) & (BX_ICACHE_TRACE_FILE_PROBES-1)];
+    if (*probe == (ppf | mode)) return false;
+    *probe = ppf | mode;
+    return true;
+  }
+
   BX_CPP_INLINE void commit_page_split_trace(bx_phy_address paddr, bxICacheEntry_c *e)
   {
     mpindex += e->tlen;
@@ -174,24 +439,84 @@ public:
   BX_CPP_INLINE void flushICacheEntries(void);
   BX_CPP_INLINE void invalidatePageSplitICacheEntries(void);
 
+  BX_CPP_INLINE bxICacheEntry_c* get_set(bx_phy_address pAddr, unsigned fetchModeMask)
+  {
+    return &(entry[hash(pAddr, fetchModeMask) * BxICacheWays]);
+  }
+
+  // returns the entry to (re)fill with the trace at pAddr: the one already
+  // holding pAddr, else an invalid one, else the least recently used way
   BX_CPP_INLINE bxICacheEntry_c* get_entry(bx_phy_address pAddr, unsigned fetchModeMask)
   {
-    return &(entry[hash(pAddr, fetchModeMask)]);
+    bxICacheEntry_c* e = get_set(pAddr, fetchModeMask);
+    bxICacheEntry_c* victim = e;
+    unsigned way;
+
+    for (way=0; way < BxICacheWays; way++) {
+      if (e[way].pAddr == pAddr) {
+        victim = &e[way];
+        break;
+      }
+    }
+
+    if (way == BxICacheWays) {
+      for (way=0; way < BxICacheWays; way++) {
+        if (e[way].pAddr == BX_ICACHE_INVALID_PHY_ADDRESS) {
+          victim = &e[way];
+          break;
+        }
+        if ((lruClock - e[way].lastUse) > (lruClock - victim->lastUse))
+          victim = &e[way];
+      }
+    }
+
+    victim->lastUse = lruClock;
+    return victim;
   }
 
-  BX_CPP_INLINE bxICacheEntry_c* find_entry(bx_phy_address pAddr, unsigned fetchModeMask)
+  // returns the entry to be filled with a trace decoded ahead of execution or
+  // NULL if pAddr is already cached or only entries used since the previous
+  // mpool reclaim could be replaced
+  BX_CPP_INLINE bxICacheEntry_c* get_decode_ahead_entry(bx_phy_address pAddr, unsigned fetchModeMask)
   {
-    bxICacheEntry_c* e = get_entry(pAddr, fetchModeMask);
-    if (e->pAddr != pAddr)
-       return NULL;
+    bxICacheEntry_c* e = get_set(pAddr, fetchModeMask);
+    bxICacheEntry_c* victim = NULL;
+
+    for (unsigned way=0; way < BxICacheWays; way++) {
+      if (e[way].pAddr == pAddr) return NULL;
+      if (e[way].pAddr == BX_ICACHE_INVALID_PHY_ADDRESS) {
+        if (! victim || victim->pAddr != BX_ICACHE_INVALID_PHY_ADDRESS) victim = &e[way];
+      }
+      else if (! victim && (Bit32s)(e[way].lastUse - lastReclaimClock) <= 0) {
+        victim = &e[way];
+      }
+    }
 
-    return e;
+    return victim;
   }
 
-  BX_CPP_INLINE bool breakLinks()
+  // true if a trace could be allocated without reclaiming an mpool segment
+  BX_CPP_INLINE bool can_alloc_trace() const
   {
-    invalidatePageSplitICacheEntries();
+    return (mpindex + BX_MAX_TRACE_LENGTH + 1) <= (mpsegment + 1) * BxICacheMemPoolSegmentSize;
+  }
+
+  BX_CPP_INLINE bxICacheEntry_c* find_entry(bx_phy_address pAddr, unsigned fetchModeMask)
+  {
+    bxICacheEntry_c* e = get_set(pAddr, fetchModeMask);
+
+    for (unsigned way=0; way < BxICacheWays; way++, e++) {
+      if (e->pAddr == pAddr) {
+        e->lastUse = ++lruClock;
+        return e;
+      }
+    }
+
+    return NULL;
+  }
 
+  BX_CPP_INLINE bool bumpTraceLinkTimeStamp()
+  {
     // break all links between traces
     if (++traceLinkTimeStamp == 0xffffffff) {
       flushICacheEntries();
@@ -199,6 +524,13 @@ public:
     }
     return false;
   }
+
+  BX_CPP_INLINE bool breakLinks()
+  {
+    invalidatePageSplitICacheEntries();
+
+    return bumpTraceLinkTimeStamp();
+  }
 };
 
 BX_CPP_INLINE void bxICache_c::flushICacheEntries(void)
@@ -215,14 +547,31 @@ BX_CPP_INLINE void bxICache_c::flushICacheEntries(void)
   for (unsigned i=0;i<BX_ICACHE_PAGE_SPLIT_ENTRIES;i++)
     pageSplitIndex[i].ppf = BX_ICACHE_INVALID_PHY_ADDRESS;
 
+  resetPageIndex();
+
+  for (unsigned i=0;i<BX_ICACHE_TRACE_FILE_PROBES;i++)
+    traceFileProbe[i] = BX_ICACHE_INVALID_PHY_ADDRESS;
+
   mpindex = 0;
+  mpsegment = 0;
+  lastReclaimClock = lruClock;
 
   traceLinkTimeStamp = 0;
+
+#if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS && BX_ENABLE_TRACE_LINKING
+  // the link time stamp starts over, the remembered traces are gone
+  flushReturnStack();
+#endif
 }
 
 BX_CPP_INLINE void bxICache_c::handleSMC(bx_phy_address pAddr, Bit32u mask)
 {
-  Bit32u pAddrIndex = bxPageWriteStampTable::hash(pAddr);
+  bx_phy_address pAddrPage = LPFOf(pAddr);
+
+  // the page content changed, look it up in the trace cache file again
+  bx_phy_address *probe = &traceFileProbe[pageBucket(pAddrPage) & (BX_ICACHE_TRACE_FILE_PROBES-1)];
+  if (LPFOf(*probe) == pAddrPage)
+    *probe = BX_ICACHE_INVALID_PHY_ADDRESS;
 
   // break all links between traces
   if (breakLinks()) return;
@@ -233,16 +582,12 @@ BX_CPP_INLINE void bxICache_c::handleSMC(bx_phy_address pAddr, Bit32u mask)
   // be invalidated. In order to solve this issue  replace all instructions
   // from the invalidated trace with dummy EndOfTrace opcodes.
 
-  // Another corner case that has to be handled - pageWriteStampTable wrap.
-  // Multiple physical addresses could be mapped into single pageWriteStampTable
-  // entry and all of them have to be invalidated here now.
-
   if (mask & 0x1) {
     // the store touched 1st cache line in the page, check for
     // page split traces to invalidate.
     for (unsigned i=0;i<BX_ICACHE_PAGE_SPLIT_ENTRIES;i++) {
       if (pageSplitIndex[i].ppf != BX_ICACHE_INVALID_PHY_ADDRESS) {
-        if (pAddrIndex == bxPageWriteStampTable::hash(pageSplitIndex[i].ppf)) {
+        if (pAddrPage == LPFOf(pageSplitIndex[i].ppf)) {
           pageSplitIndex[i].ppf = BX_ICACHE_INVALID_PHY_ADDRESS;
           flushSMC(pageSplitIndex[i].e);
         }
@@ -250,16 +595,13 @@ BX_CPP_INLINE void bxICache_c::handleSMC(bx_phy_address pAddr, Bit32u mask)
     }
   }
 
-  bxICacheEntry_c *e = get_entry(LPFOf(pAddr), 0);
+  // walk only the traces registered for the page
+  Bit32u head = BxICacheEntries + pageBucket(pAddrPage);
 
-  // go over 32 "cache lines" of 128 byte each
-  for (unsigned n=0; n < 32; n++) {
-    Bit32u line_mask = (1 << n);
-    if (line_mask > mask) break;
-    for (unsigned index=0; index < 128; index++, e++) {
-      if (pAddrIndex == bxPageWriteStampTable::hash(e->pAddr) && (e->traceMask & mask) != 0) {
-        flushSMC(e);
-      }
+  for (Bit32u node = pageLinkNext[head]; node != head; node = pageLinkNext[node]) {
+    bxICacheEntry_c *e = &entry[node];
+    if (LPFOf(e->pAddr) == pAddrPage && (e->traceMask & mask) != 0) {
+      flushSMC(e);
     }
   }
 }
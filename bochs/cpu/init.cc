@@ -28,6 +28,9 @@
 #include "gui/siminterface.h"
 #include "param_names.h"
 #include "cpustats.h"
+#include "pc_system.h"
+#include "tracefile.h"
+#include "profiler.h"
 
 #if BX_SUPPORT_APIC
 #include "apic.h"
@@ -41,6 +44,10 @@
 #include "svm.h"
 #endif
 
+#if BX_CPU_LEVEL >= 6
+#include "host_crypto.h"
+#endif
+
 #include <stdlib.h>
 
 BX_CPU_C::BX_CPU_C(unsigned id): bx_cpuid(id)
@@ -75,6 +82,16 @@ BX_CPU_C::BX_CPU_C(unsigned id): bx_cpuid(id)
 #endif
 
   stats = NULL;
+  statsMask = 0;
+
+#if BX_SUPPORT_JIT
+  jit = NULL;
+#endif
+
+#if BX_SUPPORT_SMP
+  smp_rmw.atomic = false;
+  smp_rmw.bus_locked = false;
+#endif
 
   srand(time(NULL)); // initialize random generator for RDRAND/RDSEED
 }
@@ -246,45 +263,183 @@ void BX_CPU_C::initialize(void)
   init_VMCS();
 #endif
 
+#if BX_SUPPORT_JIT
+  if (SIM->get_param_bool(BXPN_CPU_JIT)->get()) {
+    BX_CPU_THIS_PTR jit = new bxJitCache_c(SIM->get_param_bool(BXPN_CPU_JIT_VERIFY)->get());
+    if (! BX_CPU_THIS_PTR jit->ready()) {
+      BX_ERROR(("failed to allocate executable memory, trace compiler disabled"));
+      delete BX_CPU_THIS_PTR jit;
+      BX_CPU_THIS_PTR jit = NULL;
+    }
+  }
+#endif
+
+  BX_CPU_THIS_PTR maxTraceLength = SIM->get_param_num(BXPN_CPU_TRACE_LENGTH)->get();
+  BX_CPU_THIS_PTR traceQuantum = BX_CPU_THIS_PTR maxTraceLength;
+#if BX_SUPPORT_SMP
+  BX_CPU_THIS_PTR smpQuantum = SIM->get_param_num(BXPN_SMP_QUANTUM)->get();
+  // Don't allow traces longer than cpu_loop can execute
+  if (BX_SMP_PROCESSORS > 1) {
+    if (BX_CPU_THIS_PTR traceQuantum > BX_CPU_THIS_PTR smpQuantum)
+      BX_CPU_THIS_PTR traceQuantum = BX_CPU_THIS_PTR smpQuantum;
+  }
+#endif
+  BX_CPU_THIS_PTR decodeAheadTraces = SIM->get_param_num(BXPN_CPU_DECODE_AHEAD)->get();
+
+  // the trace cache file is shared by all the processors
+  const char *trace_cache_file = SIM->get_param_string(BXPN_CPU_TRACE_CACHE_FILE)->getptr();
+  if (BX_CPU_ID == 0 && *trace_cache_file)
+    traceFile.open(trace_cache_file, traceFileSignature());
+
+#if BX_CPU_LEVEL >= 6
+  // the host crypto extensions are detected once for all the processors
+  if (BX_CPU_ID == 0)
+    bx_check_host_crypto();
+#endif
+
+  // the profiler samples all the processors
+  const char *profile_file = SIM->get_param_string(BXPN_CPU_PROFILE)->getptr();
+  if (BX_CPU_ID == 0 && *profile_file)
+    profiler.open(profile_file, SIM->get_param_num(BXPN_CPU_PROFILE_INTERVAL)->get());
+
   init_statistics();
 }
 
+#if InstrumentCPU
+
+// names of the statistics groups in the order of their BX_CPU_STATS_xxx bits
+static const char *cpu_stats_group_names[] = {
+  "icache", "tlb", "tlbflush", "stack", "smc", "opcodes", "traces", "events", "exceptions", "timers", NULL
+};
+
+// parse the value of the cpu option stats, a list of the statistics groups
+// separated by colons or 'all'
+static bool parse_cpu_stats_groups(const char *val, Bit32u *mask)
+{
+  *mask = 0;
+
+  while (*val) {
+    const char *end = strchr(val, ':');
+    size_t len = end ? (size_t)(end - val) : strlen(val);
+
+    if (len == 3 && !strncmp(val, "all", 3)) {
+      *mask |= BX_CPU_STATS_ALL;
+    }
+    else if (len > 0) {
+      unsigned n = 0;
+      while (cpu_stats_group_names[n] != NULL) {
+        if (strlen(cpu_stats_group_names[n]) == len && !strncmp(val, cpu_stats_group_names[n], len)) break;
+        n++;
+      }
+      if (cpu_stats_group_names[n] == NULL) return false;
+      *mask |= (1 << n);
+    }
+
+    val += len;
+    if (*val) val++;
+  }
+
+  return true;
+}
+
+// the statistics groups could be changed while the simulation is running
+static const char *cpu_stats_param_handler(bx_param_string_c *param, bool set,
+                     const char *oldval, const char *val, int maxlen)
+{
+  if (set) {
+    Bit32u mask;
+    if (! parse_cpu_stats_groups(val, &mask)) {
+      BX_CPU(0)->error("unknown CPU statistics group in '%s'", val);
+      return oldval;
+    }
+    for (unsigned n=0; n < BX_SMP_PROCESSORS; n++)
+      BX_CPU(n)->statsMask = mask;
+    bx_pc_system.timerStats = (mask & BX_CPU_STATS_TIMERS) != 0;
+  }
+  return val;
+}
+
+#endif
+
 // statistics
 void BX_CPU_C::init_statistics(void)
 {
 #if InstrumentCPU
   stats = new bx_cpu_statistics;
 
+  bx_param_string_c *stats_param = SIM->get_param_string(BXPN_CPU_STATS);
+  if (! parse_cpu_stats_groups(stats_param->getptr(), &BX_CPU_THIS_PTR statsMask))
+    BX_PANIC(("cpu: unknown statistics group in stats=%s", stats_param->getptr()));
+
+  if (BX_CPU_ID == 0) {
+    stats_param->set_handler(cpu_stats_param_handler);
+    stats_param->set_runtime_param(1);
+    bx_pc_system.timerStats = (BX_CPU_THIS_PTR statsMask & BX_CPU_STATS_TIMERS) != 0;
+  }
+
   bx_list_c *cpu = new bx_list_c(SIM->get_statistics_root(), get_name(), get_name());
 
-#if InstrumentICACHE
   new bx_shadow_num_c(cpu, "iCacheLookups", &stats->iCacheLookups);
   new bx_shadow_num_c(cpu, "iCachePrefetch", &stats->iCachePrefetch);
   new bx_shadow_num_c(cpu, "iCacheMisses", &stats->iCacheMisses);
-#endif
+  new bx_shadow_num_c(cpu, "iCacheEvictions", &stats->iCacheEvictions);
+  new bx_shadow_num_c(cpu, "iCacheReclaims", &stats->iCacheReclaims);
+  new bx_shadow_num_c(cpu, "iCacheDecodeAhead", &stats->iCacheDecodeAhead);
+  new bx_shadow_num_c(cpu, "iCacheTraceFileLoads", &stats->iCacheTraceFileLoads);
+  new bx_shadow_num_c(cpu, "iCacheReturnHits", &stats->iCacheReturnHits);
 
-#if InstrumentTLB
   new bx_shadow_num_c(cpu, "tlbLookups", &stats->tlbLookups);
   new bx_shadow_num_c(cpu, "tlbExecuteLookups", &stats->tlbExecuteLookups);
   new bx_shadow_num_c(cpu, "tlbWriteLookups", &stats->tlbWriteLookups);
   new bx_shadow_num_c(cpu, "tlbMisses", &stats->tlbMisses);
   new bx_shadow_num_c(cpu, "tlbExecuteMisses", &stats->tlbExecuteMisses);
   new bx_shadow_num_c(cpu, "tlbWriteMisses", &stats->tlbWriteMisses);
-#endif
+  new bx_shadow_num_c(cpu, "tlbLargePageHits", &stats->tlbLargePageHits);
+  new bx_shadow_num_c(cpu, "pwcHits", &stats->pwcHits);
+  new bx_shadow_num_c(cpu, "nestedPwcHits", &stats->nestedPwcHits);
 
-#if InstrumentTLBFlush
   new bx_shadow_num_c(cpu, "tlbGlobalFlushes", &stats->tlbGlobalFlushes);
   new bx_shadow_num_c(cpu, "tlbNonGlobalFlushes", &stats->tlbNonGlobalFlushes);
-#endif
+  new bx_shadow_num_c(cpu, "tlbPCIDFlushes", &stats->tlbPCIDFlushes);
+  new bx_shadow_num_c(cpu, "tlbPCIDSwitches", &stats->tlbPCIDSwitches);
 
-#if InstrumentStackPrefetch
   new bx_shadow_num_c(cpu, "stackPrefetch", &stats->stackPrefetch);
-#endif
 
-#if InstrumentSMC
   new bx_shadow_num_c(cpu, "smc", &stats->smc);
-#endif
 
+  static const char *opcode_class_names[BX_STATS_OPCODE_CLASSES] = {
+    "integer", "x87", "mmx", "sse", "avx", "avx512", "amx", "system"
+  };
+  bx_list_c *opcodes = new bx_list_c(cpu, "opcodes");
+  for (unsigned n=0; n < BX_STATS_OPCODE_CLASSES; n++)
+    new bx_shadow_num_c(opcodes, opcode_class_names[n], &stats->opcodeClass[n]);
+
+  static const char *trace_length_names[BX_STATS_TRACE_LENGTH_BUCKETS] = {
+    "len1", "len2", "len3_4", "len5_8", "len9_16", "len17_32", "len33_64"
+  };
+  bx_list_c *traces = new bx_list_c(cpu, "traceLength");
+  for (unsigned n=0; n < BX_STATS_TRACE_LENGTH_BUCKETS; n++)
+    new bx_shadow_num_c(traces, trace_length_names[n], &stats->traceLength[n]);
+
+  bx_list_c *events = new bx_list_c(cpu, "asyncEvents");
+  new bx_shadow_num_c(events, "total", &stats->asyncEvents);
+  new bx_shadow_num_c(events, "waitForEvent", &stats->asyncWaitForEvent);
+  new bx_shadow_num_c(events, "SMI", &stats->asyncSMI);
+  new bx_shadow_num_c(events, "INIT", &stats->asyncINIT);
+  new bx_shadow_num_c(events, "debugTraps", &stats->asyncDebugTraps);
+  new bx_shadow_num_c(events, "NMI", &stats->asyncNMI);
+  new bx_shadow_num_c(events, "interrupts", &stats->asyncInterrupts);
+  new bx_shadow_num_c(events, "userInterrupts", &stats->asyncUserInterrupts);
+  new bx_shadow_num_c(events, "vmEvents", &stats->asyncVmEvents);
+  new bx_shadow_num_c(events, "DMA", &stats->asyncDMA);
+
+  static const char *exception_names[BX_CPU_HANDLED_EXCEPTIONS] = {
+    "DE", "DB", "02", "BP", "OF", "BR", "UD", "NM", "DF", "09", "TS", "NP", "SS", "GP", "PF", "15",
+    "MF", "AC", "MC", "XM", "VE", "CP", "22", "23", "24", "25", "26", "27", "28", "29", "SX", "31"
+  };
+  bx_list_c *exceptions = new bx_list_c(cpu, "exceptions");
+  for (unsigned n=0; n < BX_CPU_HANDLED_EXCEPTIONS; n++)
+    new bx_shadow_num_c(exceptions, exception_names[n], &stats->exceptions[n]);
 #endif
 }
 
@@ -667,6 +822,7 @@ void BX_CPU_C::register_state(void)
     BXRS_HEX_PARAM_FIELD(tlb_entry, lpf_mask, DTLB.entry[n].lpf_mask);
     BXRS_HEX_PARAM_FIELD(tlb_entry, ppf, DTLB.entry[n].ppf);
     BXRS_HEX_PARAM_FIELD(tlb_entry, accessBits, DTLB.entry[n].accessBits);
+    BXRS_HEX_PARAM_FIELD(tlb_entry, pcid, DTLB.entry[n].pcid);
 #if BX_SUPPORT_PKEYS
     BXRS_HEX_PARAM_FIELD(tlb_entry, pkey, DTLB.entry[n].pkey);
 #endif
@@ -686,6 +842,7 @@ void BX_CPU_C::register_state(void)
     BXRS_HEX_PARAM_FIELD(tlb_entry, lpf_mask, ITLB.entry[n].lpf_mask);
     BXRS_HEX_PARAM_FIELD(tlb_entry, ppf, ITLB.entry[n].ppf);
     BXRS_HEX_PARAM_FIELD(tlb_entry, accessBits, ITLB.entry[n].accessBits);
+    BXRS_HEX_PARAM_FIELD(tlb_entry, pcid, ITLB.entry[n].pcid);
 #if BX_SUPPORT_PKEYS
     BXRS_HEX_PARAM_FIELD(tlb_entry, pkey, ITLB.entry[n].pkey);
 #endif
@@ -845,6 +1002,10 @@ BX_CPU_C::~BX_CPU_C()
   delete stats;
 #endif
 
+#if BX_SUPPORT_JIT
+  delete jit;
+#endif
+
 #if BX_CPU_LEVEL >= 5
   destroy_MSRs();
 #endif
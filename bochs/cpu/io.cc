@@ -85,6 +85,8 @@ Bit32u BX_CPU_C::FastRepINSW(Bit32u dstOff, Bit16u port, Bit32u wordCount)
 
   // If after all the restrictions, there is anything left to do...
   if (wordCount) {
+    // bulk IO state is shared with the devices
+    BX_SMP_DEVICE_LOCK();
     for (count=0; count<wordCount; ) {
       bx_devices.bulkIOQuantumsTransferred = 0;
       if (BX_CPU_THIS_PTR get_DF()==0) { // Only do accel for DF=0
@@ -165,6 +167,8 @@ Bit32u BX_CPU_C::FastRepOUTSW(unsigned srcSeg, Bit32u srcOff, Bit16u port, Bit32
 
   // If after all the restrictions, there is anything left to do...
   if (wordCount) {
+    // bulk IO state is shared with the devices
+    BX_SMP_DEVICE_LOCK();
     for (count=0; count<wordCount; ) {
       bx_devices.bulkIOQuantumsTransferred = 0;
       if (BX_CPU_THIS_PTR get_DF()==0) { // Only do accel for DF=0
@@ -342,7 +346,7 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::INSW32_YwDX(bxInstruction_c *i)
       // one, since the main cpu loop will decrement one.  Also,
       // the count is predecremented before examined, so defintely
       // don't roll it under zero.
-      BX_TICKN(wordCount-1);
+      BX_CPU_TICKN(wordCount-1);
       RCX = ECX - (wordCount-1);
       increment = wordCount << 1; // count * 2.
     }
@@ -589,7 +593,7 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::OUTSW32_DXXw(bxInstruction_c *i)
     if (wordCount) {
       // Decrement eCX.  Note, the main loop will decrement 1 also, so
       // decrement by one less than expected, like the case above.
-      BX_TICKN(wordCount-1); // Main cpu loop also decrements one more.
+      BX_CPU_TICKN(wordCount-1); // Main cpu loop also decrements one more.
       RCX = ECX - (wordCount-1);
       increment = wordCount << 1; // count * 2.
     }
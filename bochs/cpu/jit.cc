@@ -0,0 +1,809 @@
+/////////////////////////////////////////////////////////////////////////
+// $Id$
+/////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (C) 2026  The Bochs Project
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA B 02110-1301 USA
+//
+/////////////////////////////////////////////////////////////////////////
+
+#define NEED_CPU_REG_SHORTCUTS 1
+#include "bochs.h"
+#include "cpu.h"
+#define LOG_THIS BX_CPU_THIS_PTR
+
+#if BX_SUPPORT_JIT
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+bxJitCache_c::bxJitCache_c(bool verify_mode): verify(verify_mode), storeLogSize(0),
+  compiledTraces(0), bufferFlushes(0), verifiedRuns(0), verifyMismatches(0), used(0)
+{
+  memset(profile, 0, sizeof(profile));
+
+  pageSize = (Bit32u) sysconf(_SC_PAGESIZE);
+
+  // the blocks are made writable one at a time while they are emitted
+  void *mem = mmap(NULL, BX_JIT_CODE_BUFFER_SIZE, PROT_READ | PROT_EXEC,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  buffer = (mem == MAP_FAILED) ? NULL : (Bit8u *) mem;
+}
+
+bxJitCache_c::~bxJitCache_c()
+{
+  if (buffer)
+    munmap(buffer, BX_JIT_CODE_BUFFER_SIZE);
+}
+
+bool bxJitCache_c::set_protection(Bit8u *block, bool writable)
+{
+  bx_ptr_equiv_t start = (bx_ptr_equiv_t) block & ~(bx_ptr_equiv_t)(pageSize - 1);
+  bx_ptr_equiv_t end = (bx_ptr_equiv_t) block + BX_JIT_MAX_BLOCK_SIZE;
+  end = (end + pageSize - 1) & ~(bx_ptr_equiv_t)(pageSize - 1);
+  if (end > (bx_ptr_equiv_t) buffer + BX_JIT_CODE_BUFFER_SIZE)
+    end = (bx_ptr_equiv_t) buffer + BX_JIT_CODE_BUFFER_SIZE;
+
+  // the first page could hold the end of the previous block, the native code
+  // is entered only by the owning cpu which is not running it right now
+  return mprotect((void *) start, end - start,
+                  writable ? (PROT_READ | PROT_WRITE) : (PROT_READ | PROT_EXEC)) == 0;
+}
+
+// host registers
+enum {
+  JIT_RAX, JIT_RCX, JIT_RDX, JIT_RBX, JIT_RSP, JIT_RBP, JIT_RSI, JIT_RDI,
+  JIT_R8,  JIT_R9,  JIT_R10
+};
+
+// ALU operations, as encoded in the reg field of opcodes 0x81 and 0xC1
+enum {
+  JIT_ALU_ADD = 0,
+  JIT_ALU_OR  = 1,
+  JIT_ALU_AND = 4,
+  JIT_ALU_SUB = 5,
+  JIT_ALU_XOR = 6,
+  JIT_ALU_CMP = 7,
+  JIT_SHL = 4,
+  JIT_SHR = 5
+};
+
+// Tiny x86-64 code emitter, only the forms used by the compiler.
+// The native code keeps the BX_CPU_C pointer in RBX and the pointer to the
+// hooked instruction in RBP, all the memory operands are [RBX+disp32] or
+// [RBP+disp32].
+class bxJitEmitter_c {
+public:
+  Bit8u *p;
+
+  bxJitEmitter_c(Bit8u *code): p(code) {}
+
+  void byte(unsigned b) { *p++ = (Bit8u) b; }
+  void dword(Bit32u val) { memcpy(p, &val, 4); p += 4; }
+  void qword(Bit64u val) { memcpy(p, &val, 8); p += 8; }
+
+  void rex(bool w, unsigned reg, unsigned rm) {
+    byte(0x40 | (w ? 0x8 : 0) | ((reg & 8) >> 1) | ((rm & 8) >> 3));
+  }
+  void modrm_reg(unsigned reg, unsigned rm) {
+    byte(0xC0 | ((reg & 7) << 3) | (rm & 7));
+  }
+  void modrm_mem(unsigned reg, unsigned base, Bit32u disp) {
+    byte(0x80 | ((reg & 7) << 3) | (base & 7)); dword(disp);
+  }
+
+  // <op> rm, reg (opcode 0x01 add, 0x09 or, 0x21 and, 0x29 sub, 0x31 xor, 0x89 mov)
+  void op_rr(unsigned opcode, bool w, unsigned rm, unsigned reg) {
+    rex(w, reg, rm); byte(opcode); modrm_reg(reg, rm);
+  }
+  void mov(unsigned dst, unsigned src) { op_rr(0x89, 1, dst, src); }
+  void zext32(unsigned r) { op_rr(0x89, 0, r, r); }
+  void alu(unsigned alu_op, bool w, unsigned dst, unsigned src) {
+    op_rr((alu_op << 3) | 1, w, dst, src);
+  }
+  // <alu> rm, imm32
+  void alu_imm(unsigned alu_op, bool w, unsigned rm, Bit32u imm) {
+    rex(w, 0, rm); byte(0x81); modrm_reg(alu_op, rm); dword(imm);
+  }
+  // <alu> qword [RBX+disp], imm32
+  void alu_cpu_imm(unsigned alu_op, Bit32u disp, Bit32u imm) {
+    rex(1, 0, JIT_RBX); byte(0x81); modrm_mem(alu_op, JIT_RBX, disp); dword(imm);
+  }
+  void shift(unsigned shift_op, bool w, unsigned rm, unsigned count) {
+    rex(w, 0, rm); byte(0xC1); modrm_reg(shift_op, rm); byte(count);
+  }
+  void not_(unsigned rm) { rex(1, 0, rm); byte(0xF7); modrm_reg(2, rm); }
+  void movsxd(unsigned dst, unsigned src) { rex(1, dst, src); byte(0x63); modrm_reg(dst, src); }
+
+  // mov reg, [RBX+disp] (32-bit load zero extends)
+  void load(bool w, unsigned reg, Bit32u disp) {
+    rex(w, reg, JIT_RBX); byte(0x8B); modrm_mem(reg, JIT_RBX, disp);
+  }
+  // mov qword [RBX+disp], reg
+  void store(unsigned reg, Bit32u disp) {
+    rex(1, reg, JIT_RBX); byte(0x89); modrm_mem(reg, JIT_RBX, disp);
+  }
+  // mov qword [RBX+disp], simm32
+  void store_imm(Bit32u disp, Bit32u imm) {
+    rex(1, 0, JIT_RBX); byte(0xC7); modrm_mem(0, JIT_RBX, disp); dword(imm);
+  }
+  // cmp dword [RBX+disp], 0
+  void test_cpu_dword(Bit32u disp) {
+    rex(0, 0, JIT_RBX); byte(0x83); modrm_mem(JIT_ALU_CMP, JIT_RBX, disp); byte(0);
+  }
+  // lea reg, [RBP+disp]
+  void lea_instr(unsigned reg, Bit32u disp) {
+    rex(1, reg, JIT_RBP); byte(0x8D); modrm_mem(reg, JIT_RBP, disp);
+  }
+
+  void mov_imm32(unsigned r, Bit32u imm) { rex(0, 0, r); byte(0xB8 + (r & 7)); dword(imm); }
+  void mov_simm32(unsigned r, Bit32u imm) { rex(1, 0, r); byte(0xC7); modrm_reg(0, r); dword(imm); }
+  void mov_imm64(unsigned r, Bit64u imm) { rex(1, 0, r); byte(0xB8 + (r & 7)); qword(imm); }
+
+  void call(const void *func) {
+    mov_imm64(JIT_RAX, (Bit64u)(bx_ptr_equiv_t) func);
+    byte(0xFF); modrm_reg(2, JIT_RAX);
+  }
+
+  // jnz rel32, returns the location to be patched
+  Bit8u *jnz(void) { byte(0x0F); byte(0x85); dword(0); return p; }
+  void patch(Bit8u *jump, const Bit8u *target) {
+    Bit32u rel = (Bit32u)(target - jump);
+    memcpy(jump - 4, &rel, 4);
+  }
+
+  void prologue(void) {
+    byte(0x53);                             // push rbx
+    byte(0x55);                             // push rbp
+    alu_imm(JIT_ALU_SUB, 1, JIT_RSP, 8);    // keep the stack 16-byte aligned for calls
+    mov(JIT_RBX, JIT_RDI);
+    mov(JIT_RBP, JIT_RSI);
+  }
+  void epilogue(void) {
+    alu_imm(JIT_ALU_ADD, 1, JIT_RSP, 8);
+    byte(0x5D);                             // pop rbp
+    byte(0x5B);                             // pop rbx
+    byte(0xC3);                             // ret
+  }
+};
+
+// Helpers for the memory accessing instructions, called from the native
+// code with RIP, prev_rip and icount committed as the handlers expect them.
+
+typedef void (*bxJitHelperPtr_t)(BX_CPU_C *cpu, bxInstruction_c *i);
+
+#define JIT_RESOLVE_ADDR_64(cpu, i) \
+  ((i)->as64L() ? (cpu)->BxResolve64(i) : (Bit64u)(cpu)->BxResolve32(i))
+
+// kinds of the stores logged in jit_verify mode
+enum {
+  JIT_STORE_VIRTUAL32,
+  JIT_STORE_LINEAR32,
+  JIT_STORE_LINEAR64,
+  JIT_STORE_STACK32,
+  JIT_STORE_STACK64
+};
+
+// stack offset written by push_32 (see stack.h)
+static bx_address jit_push32_offset(BX_CPU_C *cpu)
+{
+  if (cpu->long64_mode())
+    return cpu->gen_reg[BX_64BIT_REG_RSP].rrx - 4;
+  if (cpu->sregs[BX_SEG_REG_SS].cache.u.segment.d_b)
+    return (Bit32u)(cpu->gen_reg[BX_32BIT_REG_ESP].dword.erx - 4);
+  return (Bit16u)(cpu->gen_reg[BX_16BIT_REG_SP].word.rx - 4);
+}
+
+static void jit_MOV32_GdEdM(BX_CPU_C *cpu, bxInstruction_c *i)
+{
+  Bit32u eaddr = cpu->BxResolve32(i);
+  cpu->gen_reg[i->dst()].rrx = cpu->read_virtual_dword_32(i->seg(), eaddr);
+}
+
+static void jit_MOV32_EdGdM(BX_CPU_C *cpu, bxInstruction_c *i)
+{
+  Bit32u eaddr = cpu->BxResolve32(i);
+  if (cpu->jit->verify)
+    cpu->jit->log_store(JIT_STORE_VIRTUAL32, i->seg(), eaddr, cpu->read_virtual_dword_32(i->seg(), eaddr));
+  cpu->write_virtual_dword_32(i->seg(), eaddr, cpu->gen_reg[i->src()].dword.erx);
+}
+
+static void jit_MOV64_GdEdM(BX_CPU_C *cpu, bxInstruction_c *i)
+{
+  Bit64u eaddr = JIT_RESOLVE_ADDR_64(cpu, i);
+  cpu->gen_reg[i->dst()].rrx = cpu->read_linear_dword(i->seg(), cpu->get_laddr64(i->seg(), eaddr));
+}
+
+static void jit_MOV64_EdGdM(BX_CPU_C *cpu, bxInstruction_c *i)
+{
+  Bit64u eaddr = JIT_RESOLVE_ADDR_64(cpu, i);
+  bx_address laddr = cpu->get_laddr64(i->seg(), eaddr);
+  if (cpu->jit->verify)
+    cpu->jit->log_store(JIT_STORE_LINEAR32, i->seg(), laddr, cpu->read_linear_dword(i->seg(), laddr));
+  cpu->write_linear_dword(i->seg(), laddr, cpu->gen_reg[i->src()].dword.erx);
+}
+
+static void jit_MOV_GqEqM(BX_CPU_C *cpu, bxInstruction_c *i)
+{
+  Bit64u eaddr = JIT_RESOLVE_ADDR_64(cpu, i);
+  cpu->gen_reg[i->dst()].rrx = cpu->read_linear_qword(i->seg(), cpu->get_laddr64(i->seg(), eaddr));
+}
+
+static void jit_MOV_EqGqM(BX_CPU_C *cpu, bxInstruction_c *i)
+{
+  Bit64u eaddr = JIT_RESOLVE_ADDR_64(cpu, i);
+  bx_address laddr = cpu->get_laddr64(i->seg(), eaddr);
+  if (cpu->jit->verify)
+    cpu->jit->log_store(JIT_STORE_LINEAR64, i->seg(), laddr, cpu->read_linear_qword(i->seg(), laddr));
+  cpu->write_linear_qword(i->seg(), laddr, cpu->gen_reg[i->src()].rrx);
+}
+
+static void jit_PUSH_EdR(BX_CPU_C *cpu, bxInstruction_c *i)
+{
+  if (cpu->jit->verify) {
+    bx_address offset = jit_push32_offset(cpu);
+    cpu->jit->log_store(JIT_STORE_STACK32, BX_SEG_REG_SS, offset, cpu->stack_read_dword(offset));
+  }
+  cpu->push_32(cpu->gen_reg[i->dst()].dword.erx);
+}
+
+static void jit_POP_EdR(BX_CPU_C *cpu, bxInstruction_c *i)
+{
+  Bit32u val32 = cpu->pop_32();
+  cpu->gen_reg[i->dst()].rrx = val32;
+}
+
+static void jit_PUSH_EqR(BX_CPU_C *cpu, bxInstruction_c *i)
+{
+  if (cpu->jit->verify) {
+    bx_address offset = cpu->gen_reg[BX_64BIT_REG_RSP].rrx - 8;
+    cpu->jit->log_store(JIT_STORE_STACK64, BX_SEG_REG_SS, offset, cpu->stack_read_qword(offset));
+  }
+  cpu->push_64(cpu->gen_reg[i->dst()].rrx);
+}
+
+static void jit_POP_EqR(BX_CPU_C *cpu, bxInstruction_c *i)
+{
+  Bit64u val64 = cpu->pop_64();
+  cpu->gen_reg[i->dst()].rrx = val64;
+}
+
+enum {
+  JIT_OP_MOV_RR,
+  JIT_OP_MOV_RI,
+  JIT_OP_MOV_RI64,
+  JIT_OP_ALU_RR,
+  JIT_OP_ALU_RI,
+  JIT_OP_INC,
+  JIT_OP_DEC,
+  JIT_OP_LEA,
+  JIT_OP_HELPER
+};
+
+#define JIT_OS64        0x1  // 64-bit operand size
+#define JIT_WRITE_DST   0x2  // the ALU result is written to the destination
+#define JIT_LOGIC       0x4  // logical operation, carries are zero
+#define JIT_LEA32       0x8  // 32-bit LEA result
+
+struct bxJitOp_t {
+  BxExecutePtr_tR handler;
+  Bit8u kind;
+  Bit8u alu;
+  Bit8u flags;
+  bxJitHelperPtr_t helper;
+};
+
+// Handlers of the instructions which can be compiled. CMP and TEST are
+// compiled as SUB and AND which do not write the destination.
+static const bxJitOp_t jitOps[] = {
+  { &BX_CPU_C::MOV_GdEdR,   JIT_OP_MOV_RR,   0,           0,                               NULL },
+  { &BX_CPU_C::MOV_EdIdR,   JIT_OP_MOV_RI,   0,           0,                               NULL },
+  { &BX_CPU_C::ADD_GdEdR,   JIT_OP_ALU_RR,   JIT_ALU_ADD, JIT_WRITE_DST,                   NULL },
+  { &BX_CPU_C::SUB_GdEdR,   JIT_OP_ALU_RR,   JIT_ALU_SUB, JIT_WRITE_DST,                   NULL },
+  { &BX_CPU_C::CMP_GdEdR,   JIT_OP_ALU_RR,   JIT_ALU_SUB, 0,                               NULL },
+  { &BX_CPU_C::AND_GdEdR,   JIT_OP_ALU_RR,   JIT_ALU_AND, JIT_WRITE_DST | JIT_LOGIC,       NULL },
+  { &BX_CPU_C::OR_GdEdR,    JIT_OP_ALU_RR,   JIT_ALU_OR,  JIT_WRITE_DST | JIT_LOGIC,       NULL },
+  { &BX_CPU_C::XOR_GdEdR,   JIT_OP_ALU_RR,   JIT_ALU_XOR, JIT_WRITE_DST | JIT_LOGIC,       NULL },
+  { &BX_CPU_C::TEST_EdGdR,  JIT_OP_ALU_RR,   JIT_ALU_AND, JIT_LOGIC,                       NULL },
+  { &BX_CPU_C::ADD_EdIdR,   JIT_OP_ALU_RI,   JIT_ALU_ADD, JIT_WRITE_DST,                   NULL },
+  { &BX_CPU_C::SUB_EdIdR,   JIT_OP_ALU_RI,   JIT_ALU_SUB, JIT_WRITE_DST,                   NULL },
+  { &BX_CPU_C::CMP_EdIdR,   JIT_OP_ALU_RI,   JIT_ALU_SUB, 0,                               NULL },
+  { &BX_CPU_C::AND_EdIdR,   JIT_OP_ALU_RI,   JIT_ALU_AND, JIT_WRITE_DST | JIT_LOGIC,       NULL },
+  { &BX_CPU_C::OR_EdIdR,    JIT_OP_ALU_RI,   JIT_ALU_OR,  JIT_WRITE_DST | JIT_LOGIC,       NULL },
+  { &BX_CPU_C::XOR_EdIdR,   JIT_OP_ALU_RI,   JIT_ALU_XOR, JIT_WRITE_DST | JIT_LOGIC,       NULL },
+  { &BX_CPU_C::TEST_EdIdR,  JIT_OP_ALU_RI,   JIT_ALU_AND, JIT_LOGIC,                       NULL },
+  { &BX_CPU_C::INC_EdR,     JIT_OP_INC,      JIT_ALU_ADD, JIT_WRITE_DST,                   NULL },
+  { &BX_CPU_C::DEC_EdR,     JIT_OP_DEC,      JIT_ALU_SUB, JIT_WRITE_DST,                   NULL },
+  { &BX_CPU_C::LEA_GdM,     JIT_OP_LEA,      0,           JIT_LEA32,                       NULL },
+  { &BX_CPU_C::MOV32_GdEdM, JIT_OP_HELPER,   0,           0,                               jit_MOV32_GdEdM },
+  { &BX_CPU_C::MOV32_EdGdM, JIT_OP_HELPER,   0,           0,                               jit_MOV32_EdGdM },
+  { &BX_CPU_C::PUSH_EdR,    JIT_OP_HELPER,   0,           0,                               jit_PUSH_EdR },
+  { &BX_CPU_C::POP_EdR,     JIT_OP_HELPER,   0,           0,                               jit_POP_EdR },
+
+  { &BX_CPU_C::MOV_GqEqR,   JIT_OP_MOV_RR,   0,           JIT_OS64,                        NULL },
+  { &BX_CPU_C::MOV_EqIdR,   JIT_OP_MOV_RI,   0,           JIT_OS64,                        NULL },
+  { &BX_CPU_C::MOV_RRXIq,   JIT_OP_MOV_RI64, 0,           JIT_OS64,                        NULL },
+  { &BX_CPU_C::ADD_GqEqR,   JIT_OP_ALU_RR,   JIT_ALU_ADD, JIT_OS64 | JIT_WRITE_DST,        NULL },
+  { &BX_CPU_C::SUB_GqEqR,   JIT_OP_ALU_RR,   JIT_ALU_SUB, JIT_OS64 | JIT_WRITE_DST,        NULL },
+  { &BX_CPU_C::CMP_GqEqR,   JIT_OP_ALU_RR,   JIT_ALU_SUB, JIT_OS64,                        NULL },
+  { &BX_CPU_C::AND_GqEqR,   JIT_OP_ALU_RR,   JIT_ALU_AND, JIT_OS64 | JIT_WRITE_DST | JIT_LOGIC, NULL },
+  { &BX_CPU_C::OR_GqEqR,    JIT_OP_ALU_RR,   JIT_ALU_OR,  JIT_OS64 | JIT_WRITE_DST | JIT_LOGIC, NULL },
+  { &BX_CPU_C::XOR_GqEqR,   JIT_OP_ALU_RR,   JIT_ALU_XOR, JIT_OS64 | JIT_WRITE_DST | JIT_LOGIC, NULL },
+  { &BX_CPU_C::TEST_EqGqR,  JIT_OP_ALU_RR,   JIT_ALU_AND, JIT_OS64 | JIT_LOGIC,            NULL },
+  { &BX_CPU_C::ADD_EqIdR,   JIT_OP_ALU_RI,   JIT_ALU_ADD, JIT_OS64 | JIT_WRITE_DST,        NULL },
+  { &BX_CPU_C::SUB_EqIdR,   JIT_OP_ALU_RI,   JIT_ALU_SUB, JIT_OS64 | JIT_WRITE_DST,        NULL },
+  { &BX_CPU_C::CMP_EqIdR,   JIT_OP_ALU_RI,   JIT_ALU_SUB, JIT_OS64,                        NULL },
+  { &BX_CPU_C::AND_EqIdR,   JIT_OP_ALU_RI,   JIT_ALU_AND, JIT_OS64 | JIT_WRITE_DST | JIT_LOGIC, NULL },
+  { &BX_CPU_C::OR_EqIdR,    JIT_OP_ALU_RI,   JIT_ALU_OR,  JIT_OS64 | JIT_WRITE_DST | JIT_LOGIC, NULL },
+  { &BX_CPU_C::XOR_EqIdR,   JIT_OP_ALU_RI,   JIT_ALU_XOR, JIT_OS64 | JIT_WRITE_DST | JIT_LOGIC, NULL },
+  { &BX_CPU_C::TEST_EqIdR,  JIT_OP_ALU_RI,   JIT_ALU_AND, JIT_OS64 | JIT_LOGIC,            NULL },
+  { &BX_CPU_C::INC_EqR,     JIT_OP_INC,      JIT_ALU_ADD, JIT_OS64 | JIT_WRITE_DST,        NULL },
+  { &BX_CPU_C::DEC_EqR,     JIT_OP_DEC,      JIT_ALU_SUB, JIT_OS64 | JIT_WRITE_DST,        NULL },
+  { &BX_CPU_C::LEA_GqM,     JIT_OP_LEA,      0,           JIT_OS64,                        NULL },
+  { &BX_CPU_C::MOV64_GdEdM, JIT_OP_HELPER,   0,           0,                               jit_MOV64_GdEdM },
+  { &BX_CPU_C::MOV64_EdGdM, JIT_OP_HELPER,   0,           0,                               jit_MOV64_EdGdM },
+  { &BX_CPU_C::MOV_GqEqM,   JIT_OP_HELPER,   0,           0,                               jit_MOV_GqEqM },
+  { &BX_CPU_C::MOV_EqGqM,   JIT_OP_HELPER,   0,           0,                               jit_MOV_EqGqM },
+  { &BX_CPU_C::PUSH_EqR,    JIT_OP_HELPER,   0,           0,                               jit_PUSH_EqR },
+  { &BX_CPU_C::POP_EqR,     JIT_OP_HELPER,   0,           0,                               jit_POP_EqR }
+};
+
+extern BxExecutePtr_tR getOriginalHandler(const bxInstruction_c *i);
+
+static const bxJitOp_t *jitLookupOp(const bxInstruction_c *i)
+{
+  // the first instruction of a fused pair is compiled as a single one, the
+  // compiled code always computes the flags
+  BxExecutePtr_tR handler = getOriginalHandler(i);
+
+  for (unsigned n=0; n < sizeof(jitOps) / sizeof(jitOps[0]); n++) {
+    if (handler == jitOps[n].handler) return &jitOps[n];
+  }
+  return NULL;
+}
+
+#define JIT_CPU_OFFSET(field) \
+  ((Bit32u)((const Bit8u *) &(BX_CPU_THIS_PTR field) - (const Bit8u *) BX_CPU_THIS))
+
+void BX_CPU_C::jitProfileTrace(bxInstruction_c *i)
+{
+  if (BX_CPU_THIS_PTR jit->countTraceEntry(i))
+    jitCompileTrace(i);
+}
+
+void BX_CPU_C::jitCompileTrace(bxInstruction_c *i)
+{
+  const bxJitOp_t *ops[BX_MAX_TRACE_LENGTH];
+  unsigned n;
+
+  if (bx_dbg.debugger_active) return;
+
+  // the trace always ends with an instruction which cannot be compiled
+  // (branch or the inserted end of trace opcode)
+  for (n=0; n < BX_MAX_TRACE_LENGTH; n++) {
+    ops[n] = jitLookupOp(i + n);
+    if (! ops[n]) break;
+  }
+
+  // a single instruction is cheaper to run through its handler
+  if (n < 2) return;
+
+  Bit8u *block = BX_CPU_THIS_PTR jit->alloc_block();
+  if (! block) {
+    jitFlushCodeBuffer();
+    block = BX_CPU_THIS_PTR jit->alloc_block();
+    if (! block) {
+      BX_PANIC(("jitCompileTrace: failed to make the code buffer writable"));
+      return;
+    }
+  }
+
+  bxJitBlockHeader_t *header = (bxJitBlockHeader_t *) block;
+  header->execute1 = i->execute1;
+  header->execute2 = i->handlers.execute2;
+  Bit8u *code = block + BX_JIT_BLOCK_HEADER_SIZE;
+
+  const Bit32u rip_offset = JIT_CPU_OFFSET(gen_reg[BX_64BIT_REG_RIP].rrx);
+  const Bit32u prev_rip_offset = JIT_CPU_OFFSET(prev_rip);
+  const Bit32u icount_offset = JIT_CPU_OFFSET(icount);
+  const Bit32u async_event_offset = JIT_CPU_OFFSET(async_event);
+  const Bit32u result_offset = JIT_CPU_OFFSET(oszapc.result);
+  const Bit32u auxbits_offset = JIT_CPU_OFFSET(oszapc.auxbits);
+#define JIT_REG_OFFSET(reg) JIT_CPU_OFFSET(gen_reg[reg].rrx)
+
+  Bit8u *exit_jumps[BX_MAX_TRACE_LENGTH + 1];
+  unsigned num_exit_jumps = 0;
+  Bit8u *first_instr_exit = NULL;
+
+  bxJitEmitter_c e(code);
+  e.prologue();
+
+  // RIP was advanced past the hooked instruction before the native code is
+  // entered. RIP updates and instruction counts of the inline instructions
+  // are accumulated and committed only when needed.
+  Bit32u rip_pending = 0, icount_pending = 0;
+
+  for (unsigned k=0; k < n; k++) {
+    bxInstruction_c *instr = i + k;
+    const bxJitOp_t *op = ops[k];
+    bool os64 = (op->flags & JIT_OS64) != 0;
+
+    // RIP seen by the instruction is the one after it
+    if (k > 0) rip_pending += instr->ilen();
+
+    if (op->kind == JIT_OP_HELPER) {
+      e.load(1, JIT_RAX, rip_offset);
+      if (rip_pending) {
+        e.alu_imm(JIT_ALU_ADD, 1, JIT_RAX, rip_pending);
+        e.store(JIT_RAX, rip_offset);
+      }
+      e.alu_imm(JIT_ALU_SUB, 1, JIT_RAX, instr->ilen());
+      e.store(JIT_RAX, prev_rip_offset);
+      if (icount_pending)
+        e.alu_cpu_imm(JIT_ALU_ADD, icount_offset, icount_pending);
+
+      e.mov(JIT_RDI, JIT_RBX);
+      e.lea_instr(JIT_RSI, k * sizeof(bxInstruction_c));
+      e.call((const void *) op->helper);
+
+      // commit the instruction and stop if it raised an event
+      e.load(1, JIT_RAX, rip_offset);
+      e.store(JIT_RAX, prev_rip_offset);
+      e.alu_cpu_imm(JIT_ALU_ADD, icount_offset, 1);
+      e.test_cpu_dword(async_event_offset);
+      exit_jumps[num_exit_jumps++] = e.jnz();
+
+      rip_pending = 0;
+      icount_pending = 0;
+      continue;
+    }
+
+    switch(op->kind) {
+    case JIT_OP_MOV_RR:
+      e.load(os64, JIT_RAX, JIT_REG_OFFSET(instr->src()));
+      e.store(JIT_RAX, JIT_REG_OFFSET(instr->dst()));
+      break;
+
+    case JIT_OP_MOV_RI:
+      if (os64)
+        e.mov_simm32(JIT_RAX, instr->Id());
+      else
+        e.mov_imm32(JIT_RAX, instr->Id());
+      e.store(JIT_RAX, JIT_REG_OFFSET(instr->dst()));
+      break;
+
+    case JIT_OP_MOV_RI64:
+      e.mov_imm64(JIT_RAX, instr->Iq());
+      e.store(JIT_RAX, JIT_REG_OFFSET(instr->dst()));
+      break;
+
+    case JIT_OP_LEA:
+      if (instr->sibBase() == BX_64BIT_REG_RIP) {
+        e.load(1, JIT_RAX, rip_offset);
+        if (rip_pending)
+          e.alu_imm(JIT_ALU_ADD, 1, JIT_RAX, rip_pending);
+      }
+      else {
+        e.load(1, JIT_RAX, JIT_REG_OFFSET(instr->sibBase()));
+      }
+      if (instr->displ32s())
+        e.alu_imm(JIT_ALU_ADD, 1, JIT_RAX, (Bit32u) instr->displ32s());
+      if (instr->sibIndex() != 4) {
+        e.load(1, JIT_RCX, JIT_REG_OFFSET(instr->sibIndex()));
+        if (instr->sibScale())
+          e.shift(JIT_SHL, 1, JIT_RCX, instr->sibScale());
+        e.alu(JIT_ALU_ADD, 1, JIT_RAX, JIT_RCX);
+      }
+      if (! instr->as64L()) {
+        if (instr->asize_mask() == 0xffffffff)
+          e.zext32(JIT_RAX);
+        else
+          e.alu_imm(JIT_ALU_AND, 0, JIT_RAX, (Bit32u) instr->asize_mask());
+      }
+      else if (op->flags & JIT_LEA32) {
+        e.zext32(JIT_RAX);
+      }
+      e.store(JIT_RAX, JIT_REG_OFFSET(instr->dst()));
+      break;
+
+    case JIT_OP_ALU_RR:
+    case JIT_OP_ALU_RI:
+    case JIT_OP_INC:
+    case JIT_OP_DEC:
+      // RAX = op1, RCX = op2, RDX = result
+      e.load(os64, JIT_RAX, JIT_REG_OFFSET(instr->dst()));
+      if (op->kind == JIT_OP_ALU_RR)
+        e.load(os64, JIT_RCX, JIT_REG_OFFSET(instr->src()));
+      else if (op->kind == JIT_OP_ALU_RI) {
+        if (os64)
+          e.mov_simm32(JIT_RCX, instr->Id());
+        else
+          e.mov_imm32(JIT_RCX, instr->Id());
+      }
+      e.mov(JIT_RDX, JIT_RAX);
+      if (op->kind == JIT_OP_INC || op->kind == JIT_OP_DEC)
+        e.alu_imm(op->alu, os64, JIT_RDX, 1);
+      else
+        e.alu(op->alu, os64, JIT_RDX, JIT_RCX);
+      if (op->flags & JIT_WRITE_DST)
+        e.store(JIT_RDX, JIT_REG_OFFSET(instr->dst()));
+
+      // oszapc.result = (bx_address)(BitNNs) result
+      if (os64) {
+        e.store(JIT_RDX, result_offset);
+      }
+      else {
+        e.movsxd(JIT_R8, JIT_RDX);
+        e.store(JIT_R8, result_offset);
+      }
+
+      if (op->flags & JIT_LOGIC) {
+        e.store_imm(auxbits_offset, 0);
+        break;
+      }
+
+      // R8 = carries vector (ADD_COUT_VEC / SUB_COUT_VEC)
+      switch(op->kind) {
+      case JIT_OP_INC:
+        e.mov(JIT_R8, JIT_RDX);
+        e.not_(JIT_R8);
+        e.alu(JIT_ALU_AND, 1, JIT_R8, JIT_RAX);
+        break;
+      case JIT_OP_DEC:
+        e.mov(JIT_R8, JIT_RAX);
+        e.not_(JIT_R8);
+        e.alu(JIT_ALU_AND, 1, JIT_R8, JIT_RDX);
+        break;
+      default:
+        if (op->alu == JIT_ALU_ADD) {
+          e.mov(JIT_R8, JIT_RAX);
+          e.alu(JIT_ALU_AND, 1, JIT_R8, JIT_RCX);
+          e.mov(JIT_R9, JIT_RAX);
+          e.alu(JIT_ALU_OR, 1, JIT_R9, JIT_RCX);
+          e.mov(JIT_R10, JIT_RDX);
+          e.not_(JIT_R10);
+          e.alu(JIT_ALU_AND, 1, JIT_R9, JIT_R10);
+        }
+        else {
+          e.mov(JIT_R10, JIT_RAX);
+          e.not_(JIT_R10);
+          e.mov(JIT_R8, JIT_R10);
+          e.alu(JIT_ALU_AND, 1, JIT_R8, JIT_RCX);
+          e.mov(JIT_R9, JIT_R10);
+          e.alu(JIT_ALU_XOR, 1, JIT_R9, JIT_RCX);
+          e.alu(JIT_ALU_AND, 1, JIT_R9, JIT_RDX);
+        }
+        e.alu(JIT_ALU_OR, 1, JIT_R8, JIT_R9);
+        break;
+      }
+
+      // R8 = lazy auxbits, as in SET_FLAGS_OSZAPC_SIZE
+      if (os64) {
+        e.mov(JIT_R9, JIT_R8);
+        e.shift(JIT_SHR, 1, JIT_R9, 62);
+        e.shift(JIT_SHL, 1, JIT_R9, LF_BIT_PO);
+        e.alu_imm(JIT_ALU_AND, 0, JIT_R8, LF_MASK_AF);
+        e.alu(JIT_ALU_OR, 1, JIT_R8, JIT_R9);
+      }
+      else {
+        e.alu_imm(JIT_ALU_AND, 0, JIT_R8, ~(LF_MASK_PDB | LF_MASK_SD));
+      }
+
+      if (op->kind == JIT_OP_INC || op->kind == JIT_OP_DEC) {
+        // keep CF, as in SET_FLAGS_OSZAP_SIZE
+        e.load(1, JIT_R9, auxbits_offset);
+        e.alu(JIT_ALU_XOR, 1, JIT_R9, JIT_R8);
+        e.alu_imm(JIT_ALU_AND, 0, JIT_R9, LF_MASK_CF);
+        e.mov(JIT_R10, JIT_R9);
+        e.shift(JIT_SHR, 1, JIT_R10, 1);
+        e.alu(JIT_ALU_XOR, 1, JIT_R9, JIT_R10);
+        e.alu(JIT_ALU_XOR, 1, JIT_R8, JIT_R9);
+        e.zext32(JIT_R8);
+      }
+      e.store(JIT_R8, auxbits_offset);
+      break;
+
+    default:
+      BX_PANIC(("jitCompileTrace: unexpected instruction kind %d", op->kind));
+    }
+
+    icount_pending++;
+
+    // async event could be pending since before the trace was entered,
+    // the handlers would stop after the first instruction
+    if (k == 0) {
+      e.test_cpu_dword(async_event_offset);
+      first_instr_exit = e.jnz();
+    }
+  }
+
+  // commit the executed instructions and continue with the first one which
+  // was not compiled
+  e.load(1, JIT_RAX, rip_offset);
+  if (rip_pending) {
+    e.alu_imm(JIT_ALU_ADD, 1, JIT_RAX, rip_pending);
+    e.store(JIT_RAX, rip_offset);
+  }
+  e.store(JIT_RAX, prev_rip_offset);
+  if (icount_pending)
+    e.alu_cpu_imm(JIT_ALU_ADD, icount_offset, icount_pending);
+  e.test_cpu_dword(async_event_offset);
+  exit_jumps[num_exit_jumps++] = e.jnz();
+  e.lea_instr(JIT_RAX, n * sizeof(bxInstruction_c));
+  e.epilogue();
+
+  if (first_instr_exit) {
+    e.patch(first_instr_exit, e.p);
+    e.load(1, JIT_RAX, rip_offset);
+    e.store(JIT_RAX, prev_rip_offset);
+    e.alu_cpu_imm(JIT_ALU_ADD, icount_offset, 1);
+  }
+
+  for (unsigned j=0; j < num_exit_jumps; j++)
+    e.patch(exit_jumps[j], e.p);
+  e.alu(JIT_ALU_XOR, 0, JIT_RAX, JIT_RAX);
+  e.epilogue();
+
+  if ((e.p - block) > BX_JIT_MAX_BLOCK_SIZE)
+    BX_PANIC(("jitCompileTrace: native code buffer overflow"));
+
+  if (! BX_CPU_THIS_PTR jit->commit_block(e.p))
+    BX_PANIC(("jitCompileTrace: failed to make the code buffer executable"));
+  BX_CPU_THIS_PTR jit->compiledTraces++;
+
+  // hook the trace
+  i->handlers.jitCode = code;
+  i->execute1 = &BX_CPU_C::JitTraceEntry;
+}
+
+// The code buffer is full: unhook the compiled traces and start over. The
+// hooked instructions and the copies made of them by trace merging all live
+// in the trace cache mpool, the native code is not running at this point.
+void BX_CPU_C::jitFlushCodeBuffer(void)
+{
+  bxInstruction_c *i = BX_CPU_THIS_PTR iCache.mpool;
+
+  for (unsigned n=0; n < BxICacheMemPool; n++, i++) {
+    if (i->execute1 == &BX_CPU_C::JitTraceEntry) {
+      const bxJitBlockHeader_t *header = bxJitCache_c::block_header(i->handlers.jitCode);
+      i->execute1 = header->execute1;
+      i->handlers.execute2 = header->execute2;
+    }
+  }
+
+  BX_CPU_THIS_PTR jit->flush();
+  BX_CPU_THIS_PTR jit->bufferFlushes++;
+}
+
+// state the native code of a trace could modify
+struct bxJitState_t {
+  bx_gen_reg_t gen_reg[BX_GENERAL_REGISTERS+1]; // including RIP
+  bx_address prev_rip;
+  Bit64u icount;
+  bx_lazyflags_entry oszapc;
+};
+
+static void jitSaveState(BX_CPU_C *cpu, bxJitState_t *state)
+{
+  memcpy(state->gen_reg, cpu->gen_reg, sizeof(state->gen_reg));
+  state->prev_rip = cpu->prev_rip;
+  state->icount = cpu->icount;
+  state->oszapc = cpu->oszapc;
+}
+
+static void jitRestoreState(BX_CPU_C *cpu, const bxJitState_t *state)
+{
+  memcpy(cpu->gen_reg, state->gen_reg, sizeof(state->gen_reg));
+  cpu->prev_rip = state->prev_rip;
+  cpu->icount = state->icount;
+  cpu->oszapc = state->oszapc;
+}
+
+// Runs the native code of the trace, then replays the same instructions
+// through their original handlers from the same starting state and memory
+// and reports any difference. Runs stopped by an async event or an exception
+// are not replayed. The loads are executed twice, memory mapped devices are
+// not expected in the compiled traces.
+void BX_CPU_C::jitVerifyTrace(bxInstruction_c *i)
+{
+  bxJitState_t before, native;
+
+  jitSaveState(BX_CPU_THIS, &before);
+  BX_CPU_THIS_PTR jit->storeLogSize = 0;
+  bxInstruction_c *next = ((bxJitCodePtr_t) i->handlers.jitCode)(BX_CPU_THIS, i);
+  if (! next) return;
+  jitSaveState(BX_CPU_THIS, &native);
+  Bit32u native_flags = read_eflags() & EFlagsOSZAPCMask;
+
+  // undo the stores in reverse order
+  for (int n = BX_CPU_THIS_PTR jit->storeLogSize - 1; n >= 0; n--) {
+    unsigned seg = BX_CPU_THIS_PTR jit->storeLog[n].seg;
+    bx_address addr = BX_CPU_THIS_PTR jit->storeLog[n].addr;
+    Bit64u value = BX_CPU_THIS_PTR jit->storeLog[n].value;
+    switch(BX_CPU_THIS_PTR jit->storeLog[n].kind) {
+    case JIT_STORE_VIRTUAL32:
+      write_virtual_dword_32(seg, (Bit32u) addr, (Bit32u) value);
+      break;
+    case JIT_STORE_LINEAR32:
+      write_linear_dword(seg, addr, (Bit32u) value);
+      break;
+    case JIT_STORE_LINEAR64:
+      write_linear_qword(seg, addr, value);
+      break;
+    case JIT_STORE_STACK32:
+      stack_write_dword(addr, (Bit32u) value);
+      break;
+    case JIT_STORE_STACK64:
+      stack_write_qword(addr, value);
+      break;
+    }
+  }
+
+  jitRestoreState(BX_CPU_THIS, &before);
+
+  // each handler returns after committing its instruction and computes the
+  // flags even if they are dead; the trace is left after the replay
+  BX_CPU_THIS_PTR async_event |= BX_ASYNC_EVENT_STOP_TRACE;
+  for (bxInstruction_c *instr = i; instr < next; instr++) {
+    if (instr != i) RIP += instr->ilen();
+    BX_CPU_CALL_METHOD(getOriginalHandler(instr), (instr));
+  }
+  Bit32u interp_flags = read_eflags() & EFlagsOSZAPCMask;
+
+  BX_CPU_THIS_PTR jit->verifiedRuns++;
+
+  bool mismatch = false;
+  for (unsigned n=0; n <= BX_GENERAL_REGISTERS; n++) {
+    if (native.gen_reg[n].rrx != BX_CPU_THIS_PTR gen_reg[n].rrx) {
+      BX_ERROR(("jit verify: trace at " FMT_ADDRX64 ": register %u native=" FMT_ADDRX64 " interpreter=" FMT_ADDRX64,
+        before.prev_rip, n, native.gen_reg[n].rrx, BX_CPU_THIS_PTR gen_reg[n].rrx));
+      mismatch = true;
+    }
+  }
+  if (native_flags != interp_flags) {
+    BX_ERROR(("jit verify: trace at " FMT_ADDRX64 ": flags native=0x%03x interpreter=0x%03x",
+      before.prev_rip, native_flags, interp_flags));
+    mismatch = true;
+  }
+  if (native.prev_rip != BX_CPU_THIS_PTR prev_rip || native.icount != BX_CPU_THIS_PTR icount) {
+    BX_ERROR(("jit verify: trace at " FMT_ADDRX64 ": prev_rip/icount native=" FMT_ADDRX64 "/" FMT_LL "u interpreter=" FMT_ADDRX64 "/" FMT_LL "u",
+      before.prev_rip, native.prev_rip, native.icount, BX_CPU_THIS_PTR prev_rip, BX_CPU_THIS_PTR icount));
+    mismatch = true;
+  }
+
+  // the interpreter state is kept
+  if (mismatch) {
+    BX_CPU_THIS_PTR jit->verifyMismatches++;
+    BX_PANIC(("jit verify: native code of the trace at " FMT_ADDRX64 " (%u instructions, first %s) differs from the interpreter",
+      before.prev_rip, (unsigned)(next - i), i->getIaOpcodeName()));
+  }
+}
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::JitTraceEntry(bxInstruction_c *i)
+{
+  if (BX_CPU_THIS_PTR jit->verify) {
+    jitVerifyTrace(i);
+    return;
+  }
+
+  bxInstruction_c *next = ((bxJitCodePtr_t) i->handlers.jitCode)(BX_CPU_THIS, i);
+
+  if (next) {
+    BX_EXECUTE_INSTRUCTION(next);
+  }
+}
+
+#endif // BX_SUPPORT_JIT
@@ -0,0 +1,165 @@
+/////////////////////////////////////////////////////////////////////////
+// $Id$
+/////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (C) 2026  The Bochs Project
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA B 02110-1301 USA
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef BX_JIT_H
+#define BX_JIT_H
+
+#if BX_SUPPORT_JIT
+
+// Basic block compiler for hot traces (x86-64 hosts, cpu: jit=1, disabled by
+// default)
+//
+// Every time a trace is entered its first instruction is counted in a small
+// hash table. When a trace becomes hot, the longest prefix of it made of
+// supported instructions is translated to host code:
+//  - register to register and register/immediate integer ALU instructions,
+//    MOV and LEA are emitted inline, the flags are left in the oszapc lazy
+//    flags representation exactly as the instruction handlers do;
+//  - loads, stores, PUSH and POP call small helpers which go through the
+//    regular TLB fast path, exceptions longjmp out of the native code;
+//  - branches and all other instructions end the native block and are
+//    executed by their regular handlers (branches keep their trace links).
+//
+// The first instruction of the trace is hooked: its execute1 becomes
+// JitTraceEntry and the native code pointer is kept in handlers.jitCode.
+// The native code addresses the instructions of the trace relative to the
+// hooked one, so copies of it made by trace merging stay valid. Invalidation
+// of the trace (SMC, trace cache flush) overwrites the hooked instruction and
+// drops the native code together with it.
+//
+// The code buffer is never writable and executable at the same time: the
+// pages of a block are made writable while it is emitted and executable once
+// it is complete. Every block starts with the handlers the hooked instruction
+// had before, when the buffer is full the hooked instructions found in the
+// trace cache are restored from them and the buffer starts over, the decoded
+// traces are kept.
+//
+// With cpu: jit_verify=1 every run of a native block is replayed through the
+// original handlers of its instructions and the resulting registers, flags,
+// RIP and instruction count are compared. The store helpers log the memory
+// they overwrite so it can be restored before the replay.
+
+#define BX_JIT_HOT_THRESHOLD      64
+#define BX_JIT_PROFILE_ENTRIES    4096
+#define BX_JIT_CODE_BUFFER_SIZE   (4*1024*1024)
+#define BX_JIT_MAX_BLOCK_SIZE     (BX_MAX_TRACE_LENGTH * 160 + 256)
+
+// native code of a compiled trace, returns the instruction to continue with
+// or NULL if the trace has to be stopped because of an async event
+typedef bxInstruction_c* (*bxJitCodePtr_t)(BX_CPU_C *cpu, bxInstruction_c *i);
+
+// handlers of the hooked instruction, kept in front of the native code
+struct bxJitBlockHeader_t {
+  BxExecutePtr_tR execute1;
+  BxExecutePtr_tR execute2;
+};
+
+#define BX_JIT_BLOCK_HEADER_SIZE  ((sizeof(bxJitBlockHeader_t) + 15) & ~15)
+
+class bxJitCache_c {
+public:
+  bxJitCache_c(bool verify_mode);
+ ~bxJitCache_c();
+
+  // returns true when the trace starting with the instruction became hot
+  BX_CPP_INLINE bool countTraceEntry(bxInstruction_c *i)
+  {
+    unsigned index = (unsigned)(((bx_ptr_equiv_t) i >> 4) ^ ((bx_ptr_equiv_t) i >> 16)) & (BX_JIT_PROFILE_ENTRIES-1);
+    if (profile[index].i != i) {
+      profile[index].i = i;
+      profile[index].hits = 0;
+    }
+    return (++profile[index].hits == BX_JIT_HOT_THRESHOLD);
+  }
+
+  bool ready(void) const { return buffer != NULL; }
+
+  // returns the next block made writable, NULL if the buffer is full
+  Bit8u *alloc_block(void) {
+    if ((used + BX_JIT_MAX_BLOCK_SIZE) > BX_JIT_CODE_BUFFER_SIZE) return NULL;
+    if (! set_protection(buffer + used, true)) return NULL;
+    return buffer + used;
+  }
+  // makes the block executable, returns false if the protection could not
+  // be changed
+  bool commit_block(Bit8u *end) {
+    Bit8u *block = buffer + used;
+    used = (Bit32u)(end - buffer);
+    return set_protection(block, false);
+  }
+  // the unhooked traces have to become hot again to be compiled
+  void flush(void) {
+    used = 0;
+    memset(profile, 0, sizeof(profile));
+  }
+
+  static bxJitBlockHeader_t *block_header(const void *code) {
+    return (bxJitBlockHeader_t *)((Bit8u *) code - BX_JIT_BLOCK_HEADER_SIZE);
+  }
+
+  bool verify;
+
+  // memory overwritten by the native code of the trace being verified
+  struct {
+    unsigned kind;
+    unsigned seg;
+    bx_address addr;
+    Bit64u value;
+  } storeLog[BX_MAX_TRACE_LENGTH];
+  unsigned storeLogSize;
+
+  void log_store(unsigned kind, unsigned seg, bx_address addr, Bit64u value) {
+    storeLog[storeLogSize].kind = kind;
+    storeLog[storeLogSize].seg = seg;
+    storeLog[storeLogSize].addr = addr;
+    storeLog[storeLogSize].value = value;
+    storeLogSize++;
+  }
+
+  Bit64u compiledTraces, bufferFlushes;
+  Bit64u verifiedRuns, verifyMismatches;
+
+private:
+  struct {
+    bxInstruction_c *i;
+    Bit32u hits;
+  } profile[BX_JIT_PROFILE_ENTRIES];
+
+  Bit8u *buffer;
+  Bit32u used;
+  Bit32u pageSize;
+
+  bool set_protection(Bit8u *block, bool writable);
+};
+
+#define BX_JIT_PROFILE_TRACE(i) {                                             \
+  if (BX_CPU_THIS_PTR jit && (i)->execute1 != &BX_CPU_C::JitTraceEntry)       \
+    jitProfileTrace(i);                                                       \
+}
+
+#else
+
+#define BX_JIT_PROFILE_TRACE(i)
+
+#endif // BX_SUPPORT_JIT
+
+#endif
@@ -47,7 +47,8 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_EdGdM(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
-void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_GdEdR(bxInstruction_c *i)
+template <bool deadFlags>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_GdEdR_DF(bxInstruction_c *i)
 {
   Bit32u op1_32, op2_32;
 
@@ -56,9 +57,12 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_GdEdR(bxInstruction_c *i)
   op1_32 ^= op2_32;
   BX_WRITE_32BIT_REGZ(i->dst(), op1_32);
 
-  SET_FLAGS_OSZAPC_LOGIC_32(op1_32);
+  BX_NEXT_INSTR_FLAGS(i, deadFlags, SET_FLAGS_OSZAPC_LOGIC_32(op1_32));
+}
 
-  BX_NEXT_INSTR(i);
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_GdEdR(bxInstruction_c *i)
+{
+  XOR_GdEdR_DF<false>(i);
 }
 
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_GdEdM(bxInstruction_c *i)
@@ -92,15 +96,19 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_EdIdM(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
-void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_EdIdR(bxInstruction_c *i)
+template <bool deadFlags>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_EdIdR_DF(bxInstruction_c *i)
 {
   Bit32u op1_32 = BX_READ_32BIT_REG(i->dst());
   op1_32 ^= i->Id();
   BX_WRITE_32BIT_REGZ(i->dst(), op1_32);
 
-  SET_FLAGS_OSZAPC_LOGIC_32(op1_32);
+  BX_NEXT_INSTR_FLAGS(i, deadFlags, SET_FLAGS_OSZAPC_LOGIC_32(op1_32));
+}
 
-  BX_NEXT_INSTR(i);
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_EdIdR(bxInstruction_c *i)
+{
+  XOR_EdIdR_DF<false>(i);
 }
 
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_EdIdM(bxInstruction_c *i)
@@ -118,15 +126,19 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_EdIdM(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
-void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_EdIdR(bxInstruction_c *i)
+template <bool deadFlags>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_EdIdR_DF(bxInstruction_c *i)
 {
   Bit32u op1_32 = BX_READ_32BIT_REG(i->dst());
   op1_32 |= i->Id();
   BX_WRITE_32BIT_REGZ(i->dst(), op1_32);
 
-  SET_FLAGS_OSZAPC_LOGIC_32(op1_32);
+  BX_NEXT_INSTR_FLAGS(i, deadFlags, SET_FLAGS_OSZAPC_LOGIC_32(op1_32));
+}
 
-  BX_NEXT_INSTR(i);
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_EdIdR(bxInstruction_c *i)
+{
+  OR_EdIdR_DF<false>(i);
 }
 
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::NOT_EdM(bxInstruction_c *i)
@@ -165,7 +177,8 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_EdGdM(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
-void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_GdEdR(bxInstruction_c *i)
+template <bool deadFlags>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_GdEdR_DF(bxInstruction_c *i)
 {
   Bit32u op1_32, op2_32;
 
@@ -174,9 +187,12 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_GdEdR(bxInstruction_c *i)
   op1_32 |= op2_32;
   BX_WRITE_32BIT_REGZ(i->dst(), op1_32);
 
-  SET_FLAGS_OSZAPC_LOGIC_32(op1_32);
+  BX_NEXT_INSTR_FLAGS(i, deadFlags, SET_FLAGS_OSZAPC_LOGIC_32(op1_32));
+}
 
-  BX_NEXT_INSTR(i);
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_GdEdR(bxInstruction_c *i)
+{
+  OR_GdEdR_DF<false>(i);
 }
 
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_GdEdM(bxInstruction_c *i)
@@ -211,7 +227,8 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_EdGdM(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
-void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_GdEdR(bxInstruction_c *i)
+template <bool deadFlags>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_GdEdR_DF(bxInstruction_c *i)
 {
   Bit32u op1_32, op2_32;
 
@@ -220,9 +237,12 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_GdEdR(bxInstruction_c *i)
   op1_32 &= op2_32;
   BX_WRITE_32BIT_REGZ(i->dst(), op1_32);
 
-  SET_FLAGS_OSZAPC_LOGIC_32(op1_32);
+  BX_NEXT_INSTR_FLAGS(i, deadFlags, SET_FLAGS_OSZAPC_LOGIC_32(op1_32));
+}
 
-  BX_NEXT_INSTR(i);
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_GdEdR(bxInstruction_c *i)
+{
+  AND_GdEdR_DF<false>(i);
 }
 
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_GdEdM(bxInstruction_c *i)
@@ -256,15 +276,19 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_EdIdM(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
-void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_EdIdR(bxInstruction_c *i)
+template <bool deadFlags>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_EdIdR_DF(bxInstruction_c *i)
 {
   Bit32u op1_32 = BX_READ_32BIT_REG(i->dst());
   op1_32 &= i->Id();
   BX_WRITE_32BIT_REGZ(i->dst(), op1_32);
 
-  SET_FLAGS_OSZAPC_LOGIC_32(op1_32);
+  BX_NEXT_INSTR_FLAGS(i, deadFlags, SET_FLAGS_OSZAPC_LOGIC_32(op1_32));
+}
 
-  BX_NEXT_INSTR(i);
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_EdIdR(bxInstruction_c *i)
+{
+  AND_EdIdR_DF<false>(i);
 }
 
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::TEST_EdGdR(bxInstruction_c *i)
@@ -314,3 +338,13 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::TEST_EdIdM(bxInstruction_c *i)
 
   BX_NEXT_INSTR(i);
 }
+
+#if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS
+// no flags variants used for dead flags elimination (fusion.cc)
+template void BX_CPU_C::XOR_GdEdR_DF<true>(bxInstruction_c *);
+template void BX_CPU_C::XOR_EdIdR_DF<true>(bxInstruction_c *);
+template void BX_CPU_C::OR_GdEdR_DF<true>(bxInstruction_c *);
+template void BX_CPU_C::OR_EdIdR_DF<true>(bxInstruction_c *);
+template void BX_CPU_C::AND_GdEdR_DF<true>(bxInstruction_c *);
+template void BX_CPU_C::AND_EdIdR_DF<true>(bxInstruction_c *);
+#endif
@@ -42,7 +42,8 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_EqGqM(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
-void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_GqEqR(bxInstruction_c *i)
+template <bool deadFlags>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_GqEqR_DF(bxInstruction_c *i)
 {
   Bit64u op1_64, op2_64;
 
@@ -52,9 +53,12 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_GqEqR(bxInstruction_c *i)
 
   BX_WRITE_64BIT_REG(i->dst(), op1_64);
 
-  SET_FLAGS_OSZAPC_LOGIC_64(op1_64);
+  BX_NEXT_INSTR_FLAGS(i, deadFlags, SET_FLAGS_OSZAPC_LOGIC_64(op1_64));
+}
 
-  BX_NEXT_INSTR(i);
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_GqEqR(bxInstruction_c *i)
+{
+  XOR_GqEqR_DF<false>(i);
 }
 
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_GqEqM(bxInstruction_c *i)
@@ -89,7 +93,8 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_EqIdM(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
-void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_EqIdR(bxInstruction_c *i)
+template <bool deadFlags>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_EqIdR_DF(bxInstruction_c *i)
 {
   Bit64u op1_64, op2_64 = (Bit32s) i->Id();
 
@@ -97,9 +102,12 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_EqIdR(bxInstruction_c *i)
   op1_64 ^= op2_64;
   BX_WRITE_64BIT_REG(i->dst(), op1_64);
 
-  SET_FLAGS_OSZAPC_LOGIC_64(op1_64);
+  BX_NEXT_INSTR_FLAGS(i, deadFlags, SET_FLAGS_OSZAPC_LOGIC_64(op1_64));
+}
 
-  BX_NEXT_INSTR(i);
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_EqIdR(bxInstruction_c *i)
+{
+  XOR_EqIdR_DF<false>(i);
 }
 
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_EqIdM(bxInstruction_c *i)
@@ -117,7 +125,8 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_EqIdM(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
-void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_EqIdR(bxInstruction_c *i)
+template <bool deadFlags>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_EqIdR_DF(bxInstruction_c *i)
 {
   Bit64u op1_64, op2_64 = (Bit32s) i->Id();
 
@@ -125,9 +134,12 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_EqIdR(bxInstruction_c *i)
   op1_64 |= op2_64;
   BX_WRITE_64BIT_REG(i->dst(), op1_64);
 
-  SET_FLAGS_OSZAPC_LOGIC_64(op1_64);
+  BX_NEXT_INSTR_FLAGS(i, deadFlags, SET_FLAGS_OSZAPC_LOGIC_64(op1_64));
+}
 
-  BX_NEXT_INSTR(i);
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_EqIdR(bxInstruction_c *i)
+{
+  OR_EqIdR_DF<false>(i);
 }
 
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::NOT_EqM(bxInstruction_c *i)
@@ -166,7 +178,8 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_EqGqM(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
-void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_GqEqR(bxInstruction_c *i)
+template <bool deadFlags>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_GqEqR_DF(bxInstruction_c *i)
 {
   Bit64u op1_64, op2_64;
 
@@ -176,9 +189,12 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_GqEqR(bxInstruction_c *i)
 
   BX_WRITE_64BIT_REG(i->dst(), op1_64);
 
-  SET_FLAGS_OSZAPC_LOGIC_64(op1_64);
+  BX_NEXT_INSTR_FLAGS(i, deadFlags, SET_FLAGS_OSZAPC_LOGIC_64(op1_64));
+}
 
-  BX_NEXT_INSTR(i);
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_GqEqR(bxInstruction_c *i)
+{
+  OR_GqEqR_DF<false>(i);
 }
 
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_GqEqM(bxInstruction_c *i)
@@ -214,7 +230,8 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_EqGqM(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
-void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_GqEqR(bxInstruction_c *i)
+template <bool deadFlags>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_GqEqR_DF(bxInstruction_c *i)
 {
   Bit64u op1_64, op2_64;
 
@@ -224,9 +241,12 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_GqEqR(bxInstruction_c *i)
 
   BX_WRITE_64BIT_REG(i->dst(), op1_64);
 
-  SET_FLAGS_OSZAPC_LOGIC_64(op1_64);
+  BX_NEXT_INSTR_FLAGS(i, deadFlags, SET_FLAGS_OSZAPC_LOGIC_64(op1_64));
+}
 
-  BX_NEXT_INSTR(i);
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_GqEqR(bxInstruction_c *i)
+{
+  AND_GqEqR_DF<false>(i);
 }
 
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_GqEqM(bxInstruction_c *i)
@@ -261,7 +281,8 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_EqIdM(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
-void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_EqIdR(bxInstruction_c *i)
+template <bool deadFlags>
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_EqIdR_DF(bxInstruction_c *i)
 {
   Bit64u op1_64, op2_64 = (Bit32s) i->Id();
 
@@ -269,9 +290,12 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_EqIdR(bxInstruction_c *i)
   op1_64 &= op2_64;
   BX_WRITE_64BIT_REG(i->dst(), op1_64);
 
-  SET_FLAGS_OSZAPC_LOGIC_64(op1_64);
+  BX_NEXT_INSTR_FLAGS(i, deadFlags, SET_FLAGS_OSZAPC_LOGIC_64(op1_64));
+}
 
-  BX_NEXT_INSTR(i);
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_EqIdR(bxInstruction_c *i)
+{
+  AND_EqIdR_DF<false>(i);
 }
 
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::TEST_EqGqR(bxInstruction_c *i)
@@ -330,4 +354,14 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::TEST_EqIdM(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+#if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS
+// no flags variants used for dead flags elimination (fusion.cc)
+template void BX_CPU_C::XOR_GqEqR_DF<true>(bxInstruction_c *);
+template void BX_CPU_C::XOR_EqIdR_DF<true>(bxInstruction_c *);
+template void BX_CPU_C::OR_GqEqR_DF<true>(bxInstruction_c *);
+template void BX_CPU_C::OR_EqIdR_DF<true>(bxInstruction_c *);
+template void BX_CPU_C::AND_GqEqR_DF<true>(bxInstruction_c *);
+template void BX_CPU_C::AND_EqIdR_DF<true>(bxInstruction_c *);
+#endif
+
 #endif /* if BX_SUPPORT_X86_64 */
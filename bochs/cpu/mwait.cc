@@ -56,7 +56,15 @@ bool BX_CPU_C::is_monitor(bx_phy_address begin_addr, unsigned len)
 
 void BX_CPU_C::check_monitor(bx_phy_address begin_addr, unsigned len)
 {
-  if (is_monitor(begin_addr, len)) wakeup_monitor();
+  if (is_monitor(begin_addr, len)) {
+#if BX_SUPPORT_SMP
+    if (bx_smp_is_remote_cpu(BX_CPU_ID)) {
+      smp_post_request(BX_SMP_REQ_CHECK_MONITOR, len, begin_addr);
+      return;
+    }
+#endif
+    wakeup_monitor();
+  }
 }
 
 void BX_CPU_C::wakeup_monitor(void)
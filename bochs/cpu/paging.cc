@@ -402,6 +402,20 @@ void BX_CPU_C::TLB_flush(void)
   BX_CPU_THIS_PTR DTLB.flush();
   BX_CPU_THIS_PTR ITLB.flush();
 
+#if BX_SUPPORT_X86_64
+  BX_CPU_THIS_PTR PWC.flush();
+#endif
+#if BX_SUPPORT_VMX >= 2 || BX_SUPPORT_SVM
+  BX_CPU_THIS_PTR nestedPWC.flush();
+#endif
+
+#if BX_SUPPORT_X86_64
+  // CR3 or CR4.PCIDE might be changed together with the flush
+  Bit32u pcid = BX_CPU_THIS_PTR cr4.get_PCIDE() ? ((Bit32u) BX_CPU_THIS_PTR cr3 & 0xfff) : 0;
+  BX_CPU_THIS_PTR DTLB.pcid = pcid;
+  BX_CPU_THIS_PTR ITLB.pcid = pcid;
+#endif
+
 #if BX_SUPPORT_MONITOR_MWAIT
   // invalidating of the TLB might change translation for monitored page
   // and cause subsequent MWAIT instruction to wait forever
@@ -423,6 +437,37 @@ void BX_CPU_C::TLB_flushNonGlobal(void)
   BX_CPU_THIS_PTR DTLB.flushNonGlobal();
   BX_CPU_THIS_PTR ITLB.flushNonGlobal();
 
+#if BX_SUPPORT_X86_64
+  BX_CPU_THIS_PTR PWC.flush();
+#endif
+#if BX_SUPPORT_VMX >= 2 || BX_SUPPORT_SVM
+  BX_CPU_THIS_PTR nestedPWC.flush();
+#endif
+
+#if BX_SUPPORT_MONITOR_MWAIT
+  // invalidating of the TLB might change translation for monitored page
+  // and cause subsequent MWAIT instruction to wait forever
+  BX_CPU_THIS_PTR wakeup_monitor();
+#endif
+
+  // break all links bewteen traces
+  BX_CPU_THIS_PTR iCache.breakLinks();
+}
+#endif
+
+#if BX_SUPPORT_X86_64
+// invalidate the non global TLB entries tagged with the PCID
+void BX_CPU_C::TLB_flushPCID(Bit32u pcid)
+{
+  INC_TLBFLUSH_STAT(tlbPCIDFlushes);
+
+  invalidate_prefetch_q();
+  invalidate_stack_cache();
+
+  BX_CPU_THIS_PTR DTLB.flushNonGlobal(false, pcid);
+  BX_CPU_THIS_PTR ITLB.flushNonGlobal(false, pcid);
+  BX_CPU_THIS_PTR PWC.flush();
+
 #if BX_SUPPORT_MONITOR_MWAIT
   // invalidating of the TLB might change translation for monitored page
   // and cause subsequent MWAIT instruction to wait forever
@@ -432,6 +477,31 @@ void BX_CPU_C::TLB_flushNonGlobal(void)
   // break all links bewteen traces
   BX_CPU_THIS_PTR iCache.breakLinks();
 }
+
+// CR3 write with CR4.PCIDE set, the TLB lookups continue with the entries
+// tagged with the new PCID
+void BX_CPU_C::TLB_switchPCID(bool flush)
+{
+  Bit32u pcid = (Bit32u) BX_CPU_THIS_PTR cr3 & 0xfff;
+
+  if (flush) {
+    TLB_flushPCID(pcid);
+  }
+  else {
+    INC_TLBFLUSH_STAT(tlbPCIDSwitches);
+
+    invalidate_prefetch_q();
+    invalidate_stack_cache();
+    // the paging structure cache is not tagged with the PCID
+    BX_CPU_THIS_PTR PWC.flush();
+
+    // break all links bewteen traces
+    BX_CPU_THIS_PTR iCache.breakLinks();
+  }
+
+  BX_CPU_THIS_PTR DTLB.pcid = pcid;
+  BX_CPU_THIS_PTR ITLB.pcid = pcid;
+}
 #endif
 
 void BX_CPU_C::TLB_invlpg(bx_address laddr)
@@ -442,6 +512,9 @@ void BX_CPU_C::TLB_invlpg(bx_address laddr)
   BX_DEBUG(("TLB_invlpg(0x" FMT_ADDRX "): invalidate TLB entry", laddr));
   BX_CPU_THIS_PTR DTLB.invlpg(laddr);
   BX_CPU_THIS_PTR ITLB.invlpg(laddr);
+#if BX_SUPPORT_X86_64
+  BX_CPU_THIS_PTR PWC.flush(); // INVLPG invalidates all the paging structure caches
+#endif
 
 #if BX_SUPPORT_MONITOR_MWAIT
   // invalidating of the TLB entry might change translation for monitored
@@ -844,6 +917,23 @@ bx_phy_address BX_CPU_C::translate_linear_long_mode(bx_address laddr, Bit32u &lp
   bx_phy_address ppf = curr_entry & BX_CR3_PAGING_MASK;
 
   int start_leaf = BX_CPU_THIS_PTR cr4.get_LA57() ? BX_LEVEL_PML5 : BX_LEVEL_PML4, leaf = start_leaf;
+  Bit32u level_access[5];
+  bool level_nx[5];
+
+  // continue the page walk below the deepest cached paging structure entry
+  for (int level = BX_LEVEL_PDE; level <= BX_LEVEL_PML4; level++) {
+    bx_PWC_entry *pwc = BX_CPU_THIS_PTR PWC.find_entry_of(laddr, level);
+    if (pwc) {
+      INC_TLB_STAT(pwcHits);
+      curr_entry = pwc->entry;
+      combined_access = pwc->combined_access;
+      nx_page = pwc->nx_page;
+      ppf = curr_entry & BX_CONST64(0x000ffffffffff000);
+      offset_mask = (BX_CONST64(1) << (12 + 9*level)) - 1;
+      start_leaf = leaf = level - 1;
+      break;
+    }
+  }
 
   for (;; --leaf) {
     entry_addr[leaf] = ppf + ((laddr >> (9 + 9*leaf)) & 0xff8);
@@ -888,6 +978,8 @@ bx_phy_address BX_CPU_C::translate_linear_long_mode(bx_address laddr, Bit32u &lp
     }
 
     combined_access &= curr_entry; // U/S and R/W
+    level_access[leaf] = combined_access;
+    level_nx[leaf] = nx_page;
   }
 
 #if BX_SUPPORT_PKEYS
@@ -909,6 +1001,10 @@ bx_phy_address BX_CPU_C::translate_linear_long_mode(bx_address laddr, Bit32u &lp
   // Update A/D bits if needed
   update_access_dirty_PAE(entry_addr, entry, entry_memtype, start_leaf, leaf, isWrite);
 
+  // remember the non-leaf entries of the walk
+  for (int level = BX_MIN(start_leaf, BX_LEVEL_PML4); level > leaf; level--)
+    BX_CPU_THIS_PTR PWC.set_entry(laddr, level, entry[level], level_access[level], level_nx[level]);
+
   return (ppf | combined_access);
 }
 
@@ -919,8 +1015,9 @@ void BX_CPU_C::update_access_dirty_PAE(bx_phy_address *entry_addr, Bit64u *entry
   // Update A bit if needed
   for (unsigned level=max_level; level > leaf; level--) {
     if (!(entry[level] & 0x20)) {
+      Bit64u old_entry = entry[level];
       entry[level] |= 0x20;
-      write_physical_qword(entry_addr[level], entry[level], entry_memtype[level], AccessReason(BX_PTE_ACCESS + level)); // should be done with locked RMW
+      update_paging_entry_qword(entry_addr[level], old_entry, entry[level], entry_memtype[level], AccessReason(BX_PTE_ACCESS + level));
     }
   }
 
@@ -935,9 +1032,10 @@ void BX_CPU_C::update_access_dirty_PAE(bx_phy_address *entry_addr, Bit64u *entry
   }
 #endif
   if (!(entry[leaf] & 0x20) || set_dirty) {
+    Bit64u old_entry = entry[leaf];
     entry[leaf] |= 0x20; // Update A and possibly D bits
     if (set_dirty) entry[leaf] |= 0x40;
-    write_physical_qword(entry_addr[leaf], entry[leaf], entry_memtype[leaf], AccessReason(BX_PTE_ACCESS + leaf)); // should be done with locked RMW
+    update_paging_entry_qword(entry_addr[leaf], old_entry, entry[leaf], entry_memtype[leaf], AccessReason(BX_PTE_ACCESS + leaf));
   }
 }
 
@@ -1235,8 +1333,9 @@ void BX_CPU_C::update_access_dirty(bx_phy_address *entry_addr, Bit32u *entry, Bx
   if (leaf == BX_LEVEL_PTE) {
     // Update PDE A bit if needed
     if (!(entry[BX_LEVEL_PDE] & 0x20)) {
+      Bit32u old_entry = entry[BX_LEVEL_PDE];
       entry[BX_LEVEL_PDE] |= 0x20;
-      write_physical_dword(entry_addr[BX_LEVEL_PDE], entry[BX_LEVEL_PDE], entry_memtype[BX_LEVEL_PDE], BX_PDE_ACCESS); // should be done with locked RMW
+      update_paging_entry_dword(entry_addr[BX_LEVEL_PDE], old_entry, entry[BX_LEVEL_PDE], entry_memtype[BX_LEVEL_PDE], BX_PDE_ACCESS);
     }
   }
 
@@ -1251,9 +1350,10 @@ void BX_CPU_C::update_access_dirty(bx_phy_address *entry_addr, Bit32u *entry, Bx
   }
 #endif
   if (!(entry[leaf] & 0x20) || set_dirty) {
+    Bit32u old_entry = entry[leaf];
     entry[leaf] |= 0x20; // Update A and possibly D bits
     if (set_dirty) entry[leaf] |= 0x40;
-    write_physical_dword(entry_addr[leaf], entry[leaf], entry_memtype[leaf], AccessReason(BX_PTE_ACCESS + leaf)); // should be done with locked RMW
+    update_paging_entry_dword(entry_addr[leaf], old_entry, entry[leaf], entry_memtype[leaf], AccessReason(BX_PTE_ACCESS + leaf));
   }
 }
 
@@ -1311,6 +1411,55 @@ bx_phy_address BX_CPU_C::translate_linear(bx_TLB_entry *tlbEntry, bx_address lad
   if (isWrite)
     INC_TLB_STAT(tlbWriteMisses);
 
+  // with nested paging the 4K parts of a large page are translated separately
+  bool nested_paging = false;
+#if BX_SUPPORT_VMX >= 2
+  if (BX_CPU_THIS_PTR in_vmx_guest && BX_CPU_THIS_PTR vmcs.vmexec_ctrls2.EPT_ENABLE())
+    nested_paging = true;
+#endif
+#if BX_SUPPORT_SVM
+  if (BX_CPU_THIS_PTR in_svm_guest && SVM_NESTED_PAGING_ENABLED)
+    nested_paging = true;
+#endif
+
+#if BX_CPU_LEVEL >= 5
+  if (BX_CPU_THIS_PTR cr0.get_PG() && ! nested_paging) {
+    // refill the TLB entry from the large page TLB without a page walk
+    // when the cached translation allows the access
+    bx_large_TLB_entry *largeEntry = isExecute ? BX_CPU_THIS_PTR ITLB.find_large_entry_of(laddr) :
+                                                 BX_CPU_THIS_PTR DTLB.find_large_entry_of(laddr);
+    if (largeEntry) {
+      Bit32u accessBits = largeEntry->accessBits;
+#if BX_SUPPORT_PKEYS
+      if (! isExecute)
+        accessBits &= isWrite ? BX_CPU_THIS_PTR wr_pkey[largeEntry->pkey] : BX_CPU_THIS_PTR rd_pkey[largeEntry->pkey];
+#endif
+      if (accessBits & (1 << (isExecute ? user : (isShadowStack | (isWrite<<1) | user)))) {
+        INC_TLB_STAT(tlbLargePageHits);
+
+        paddress = A20ADDR(largeEntry->ppf | (laddr & largeEntry->lpf_mask));
+
+        tlbEntry->lpf = lpf | TLB_NoHostPtr;
+        tlbEntry->lpf_mask = largeEntry->lpf_mask;
+#if BX_SUPPORT_PKEYS
+        tlbEntry->pkey = largeEntry->pkey;
+#endif
+        tlbEntry->ppf = PPFOf(paddress);
+        tlbEntry->accessBits = largeEntry->accessBits;
+        tlbEntry->pcid = largeEntry->pcid;
+
+        if (isExecute)
+          BX_CPU_THIS_PTR ITLB.split_large = true;
+        else
+          BX_CPU_THIS_PTR DTLB.split_large = true;
+
+        set_tlb_entry_host_page_addr(tlbEntry, laddr, rw, largeEntry->combined_access);
+        return paddress;
+      }
+    }
+  }
+#endif
+
   Bit32u lpf_mask = 0xfff; // 4K pages
   Bit32u combined_access = BX_COMBINED_ACCESS_WRITE | BX_COMBINED_ACCESS_USER;
 #if BX_SUPPORT_X86_64
@@ -1358,6 +1507,10 @@ bx_phy_address BX_CPU_C::translate_linear(bx_TLB_entry *tlbEntry, bx_address lad
     combined_access = combine_memtype(combined_access, BX_MEMTYPE_WB); // act as PAT memory type is WB
   }
 
+  // physical frame of a large page, nested paging translations are not
+  // cached in the large page TLB
+  bx_phy_address large_ppf = paddress & ~((Bit64u) lpf_mask);
+
   // Calculate physical memory address and fill in TLB cache entry
 #if BX_SUPPORT_VMX >= 2
   bool spp_page = false;
@@ -1387,6 +1540,7 @@ bx_phy_address BX_CPU_C::translate_linear(bx_TLB_entry *tlbEntry, bx_address lad
 #endif
   tlbEntry->ppf = ppf;
   tlbEntry->accessBits = 0;
+  tlbEntry->pcid = isExecute ? BX_CPU_THIS_PTR ITLB.pcid : BX_CPU_THIS_PTR DTLB.pcid;
 
   if (isExecute) {
     tlbEntry->accessBits |= TLB_SysExecuteOK;
@@ -1487,23 +1641,44 @@ bx_phy_address BX_CPU_C::translate_linear(bx_TLB_entry *tlbEntry, bx_address lad
     tlbEntry->accessBits |= TLB_GlobalPage;
 #endif
 
+#if BX_CPU_LEVEL >= 5
+  if (lpf_mask > 0xfff && ! nested_paging) {
+    bx_large_TLB_entry *largeEntry = isExecute ? BX_CPU_THIS_PTR ITLB.get_large_entry_of(laddr) :
+                                                 BX_CPU_THIS_PTR DTLB.get_large_entry_of(laddr);
+    largeEntry->lpf = laddr & ~((bx_address) lpf_mask);
+    largeEntry->ppf = large_ppf;
+    largeEntry->lpf_mask = lpf_mask;
+    largeEntry->accessBits = tlbEntry->accessBits;
+#if BX_SUPPORT_PKEYS
+    largeEntry->pkey = pkey;
+#endif
+    largeEntry->combined_access = combined_access;
+    largeEntry->pcid = tlbEntry->pcid;
+  }
+#endif
+
+  set_tlb_entry_host_page_addr(tlbEntry, laddr, rw, combined_access);
+
+  return paddress;
+}
+
+void BX_CPU_C::set_tlb_entry_host_page_addr(bx_TLB_entry *tlbEntry, bx_address laddr, unsigned rw, Bit32u combined_access)
+{
   // Attempt to get a host pointer to this physical page. Put that
   // pointer in the TLB cache. Note if the request is vetoed, NULL
   // will be returned, and it's OK to OR zero in anyways.
-  tlbEntry->hostPageAddr = BX_CPU_THIS_PTR getHostMemAddr(ppf, rw);
+  tlbEntry->hostPageAddr = BX_CPU_THIS_PTR getHostMemAddr(tlbEntry->ppf, rw);
   if (tlbEntry->hostPageAddr) {
     // All access allowed also via direct pointer
 #if BX_X86_DEBUGGER
     if (! hwbreakpoint_check(laddr, BX_HWDebugMemW, BX_HWDebugMemRW))
 #endif
-       tlbEntry->lpf = lpf; // allow direct access with HostPtr
+       tlbEntry->lpf = LPFOf(laddr); // allow direct access with HostPtr
   }
 
 #if BX_SUPPORT_MEMTYPE
   tlbEntry->memtype = resolve_memtype(memtype_by_mtrr(tlbEntry->ppf), extract_memtype(combined_access) /* effective page tables memory type */);
 #endif
-
-  return paddress;
 }
 
 const char *get_memtype_name(BxMemtype memtype)
@@ -1848,12 +2023,28 @@ bx_phy_address BX_CPU_C::nested_walk(bx_phy_address guest_paddr, unsigned rw, bo
 
   BX_DEBUG(("Nested walk for guest paddr 0x" FMT_PHY_ADDRX, guest_paddr));
 
+  // the guest page walk reads the same few guest paging structures again and again
+  if (is_page_walk) {
+    bx_nested_PWC_entry *npwc = BX_CPU_THIS_PTR nestedPWC.find_entry_of(guest_paddr, rw);
+    if (npwc) {
+      INC_TLB_STAT(nestedPwcHits);
+      return npwc->hpf | PAGE_OFFSET(guest_paddr);
+    }
+  }
+
+  bx_phy_address host_paddr;
+
   if (host_state->efer.get_LMA())
-    return nested_walk_long_mode(guest_paddr, rw, is_page_walk);
+    host_paddr = nested_walk_long_mode(guest_paddr, rw, is_page_walk);
   else if (host_state->cr4.get_PAE())
-    return nested_walk_PAE(guest_paddr, rw, is_page_walk);
+    host_paddr = nested_walk_PAE(guest_paddr, rw, is_page_walk);
   else
-    return nested_walk_legacy(guest_paddr, rw, is_page_walk);
+    host_paddr = nested_walk_legacy(guest_paddr, rw, is_page_walk);
+
+  if (is_page_walk)
+    BX_CPU_THIS_PTR nestedPWC.set_entry(guest_paddr, host_paddr, rw);
+
+  return host_paddr;
 }
 
 #endif
@@ -1947,6 +2138,16 @@ bx_phy_address BX_CPU_C::translate_guest_physical(bx_phy_address guest_paddr, bx
   if (BX_VMX_EPT_ACCESS_DIRTY_ENABLED && is_page_walk && guest_laddr_valid)
     rw = BX_WRITE;
 
+  // the guest page walk reads the same few guest paging structures again and again
+  bool cache_walk = is_page_walk && !supervisor_shadow_stack && !vm->vmexec_ctrls2.PML_ENABLE();
+  if (cache_walk) {
+    bx_nested_PWC_entry *npwc = BX_CPU_THIS_PTR nestedPWC.find_entry_of(guest_paddr, rw);
+    if (npwc) {
+      INC_TLB_STAT(nestedPwcHits);
+      return npwc->hpf | PAGE_OFFSET(guest_paddr);
+    }
+  }
+
   if (rw == BX_EXECUTE) {
     if (vm->vmexec_ctrls2.MBE_CTRL()) {
       access_mask |= user_page ? BX_EPT_MBE_USER_EXECUTE : BX_EPT_MBE_SUPERVISOR_EXECUTE;
@@ -2125,6 +2326,9 @@ bx_phy_address BX_CPU_C::translate_guest_physical(bx_phy_address guest_paddr, bx
     update_ept_access_dirty(entry_addr, entry, MEMTYPE(eptptr_memtype), leaf, rw & 1);
   }
 
+  if (cache_walk)
+    BX_CPU_THIS_PTR nestedPWC.set_entry(guest_paddr, ppf, rw);
+
   Bit32u page_offset = PAGE_OFFSET(guest_paddr);
   return ppf | page_offset;
 }
@@ -2135,15 +2339,17 @@ void BX_CPU_C::update_ept_access_dirty(bx_phy_address *entry_addr, Bit64u *entry
   // Update A bit if needed
   for (unsigned level=BX_LEVEL_PML4; level > leaf; level--) {
     if (!(entry[level] & 0x100)) {
+      Bit64u old_entry = entry[level];
       entry[level] |= 0x100;
-      write_physical_qword(entry_addr[level], entry[level], MEMTYPE(eptptr_memtype), AccessReason(BX_EPT_PTE_ACCESS + level)); // should be done with locked RMW
+      update_paging_entry_qword(entry_addr[level], old_entry, entry[level], MEMTYPE(eptptr_memtype), AccessReason(BX_EPT_PTE_ACCESS + level));
     }
   }
 
   // Update A/D bits if needed
   if (!(entry[leaf] & 0x100) || (write && !(entry[leaf] & 0x200))) {
+    Bit64u old_entry = entry[leaf];
     entry[leaf] |= (0x100 | (write<<9)); // Update A and possibly D bits
-    write_physical_qword(entry_addr[leaf], entry[leaf], MEMTYPE(eptptr_memtype), AccessReason(BX_EPT_PTE_ACCESS + leaf)); // should be done with locked RMW
+    update_paging_entry_qword(entry_addr[leaf], old_entry, entry[leaf], MEMTYPE(eptptr_memtype), AccessReason(BX_EPT_PTE_ACCESS + leaf));
   }
 }
 
@@ -2600,6 +2806,31 @@ void BX_CPU_C::write_physical_qword(bx_phy_address paddr, Bit64u val_64, BxMemty
   BX_NOTIFY_PHY_MEMORY_ACCESS(paddr, 8, memtype, BX_WRITE, reason, (Bit8u*)(&val_64));
 }
 
+// Accessed/dirty bits update in a paging structure entry. This is a locked
+// read-modify-write: when the processors are simulated by separate host
+// threads the entry is written only if it was not modified since it was read.
+void BX_CPU_C::update_paging_entry_dword(bx_phy_address entry_addr, Bit32u old_entry, Bit32u new_entry, BxMemtype memtype, AccessReason reason)
+{
+#if BX_SUPPORT_SMP
+  if (bx_smp_threads_running && smp_update_paging_entry(entry_addr, old_entry, new_entry, 4)) {
+    BX_NOTIFY_PHY_MEMORY_ACCESS(entry_addr, 4, memtype, BX_WRITE, reason, (Bit8u*)(&new_entry));
+    return;
+  }
+#endif
+  write_physical_dword(entry_addr, new_entry, memtype, reason);
+}
+
+void BX_CPU_C::update_paging_entry_qword(bx_phy_address entry_addr, Bit64u old_entry, Bit64u new_entry, BxMemtype memtype, AccessReason reason)
+{
+#if BX_SUPPORT_SMP
+  if (bx_smp_threads_running && smp_update_paging_entry(entry_addr, old_entry, new_entry, 8)) {
+    BX_NOTIFY_PHY_MEMORY_ACCESS(entry_addr, 8, memtype, BX_WRITE, reason, (Bit8u*)(&new_entry));
+    return;
+  }
+#endif
+  write_physical_qword(entry_addr, new_entry, memtype, reason);
+}
+
 #if BX_LARGE_RAMFILE
 bool BX_CPU_C::check_addr_in_tlb_buffers(const Bit8u *addr, const Bit8u *end)
 {
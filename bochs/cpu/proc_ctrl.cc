@@ -73,6 +73,18 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::NOP(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::MFENCE(bxInstruction_c *i)
+{
+#if BX_SUPPORT_SMP
+  // stores of this processor must become visible to the processors running
+  // in other host threads before any of the following loads is performed
+  if (bx_smp_threads_running)
+    BX_MEMORY_FENCE();
+#endif
+
+  BX_NEXT_INSTR(i);
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::PAUSE(bxInstruction_c *i)
 {
 #if BX_SUPPORT_VMX
@@ -190,6 +202,7 @@ void BX_CPU_C::enter_sleep_state(unsigned state)
 #endif
 
 #if BX_USE_IDLE_HACK
+  BX_SMP_DEVICE_LOCK();
   bx_gui->sim_is_idle();
 #endif
 }
@@ -0,0 +1,244 @@
+/////////////////////////////////////////////////////////////////////////
+// $Id$
+/////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (C) 2026  The Bochs Project
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA B 02110-1301 USA
+//
+/////////////////////////////////////////////////////////////////////////
+
+#define NEED_CPU_REG_SHORTCUTS 1
+#include "bochs.h"
+#include "cpu.h"
+#include "profiler.h"
+#include "pc_system.h"
+#define LOG_THIS genlog->
+
+#if BX_DEBUGGER
+#include "bx_debug/debug.h"
+#endif
+
+extern int fetchDecode32(const Bit8u *fetchPtr, bool is_32, bxInstruction_c *i, unsigned remainingInPage);
+#if BX_SUPPORT_X86_64
+extern int fetchDecode64(const Bit8u *fetchPtr, bxInstruction_c *i, unsigned remainingInPage);
+#endif
+
+bxProfiler_c profiler;
+
+struct bxProfileEntry_t {
+  bxProfileSample_t sample;
+  Bit64u count;         // zero for a free slot
+};
+
+BX_CPP_INLINE static bool sameSample(const bxProfileSample_t *a, const bxProfileSample_t *b)
+{
+  return a->rip == b->rip && a->laddr == b->laddr && a->cr3 == b->cr3 &&
+         a->ia_opcode == b->ia_opcode && a->cpl == b->cpl && a->halted == b->halted;
+}
+
+BX_CPP_INLINE static unsigned hashSample(const bxProfileSample_t *s)
+{
+  Bit64u hash = (s->laddr ^ (s->cr3 << 7) ^ ((Bit64u) s->ia_opcode << 48)) * BX_CONST64(0x9e3779b97f4a7c15);
+  return (unsigned)(hash >> 32) ^ s->cpl;
+}
+
+bxProfiler_c::bxProfiler_c(): path(NULL), cpus(NULL), ncpus(0)
+{
+}
+
+bxProfiler_c::~bxProfiler_c()
+{
+  if (! path) return;
+
+  for (unsigned n=0; n < ncpus; n++)
+    delete [] cpus[n].table;
+  delete [] cpus;
+  free(path);
+}
+
+void bxProfiler_c::open(const char *filename, Bit32u interval)
+{
+  if (path) return;
+
+  path = strdup(filename);
+  ncpus = BX_SMP_PROCESSORS;
+  cpus = new bxProfileCpu_t[ncpus];
+  for (unsigned n=0; n < ncpus; n++) {
+    cpus[n].head = cpus[n].tail = 0;
+    cpus[n].tableSize = 4096;
+    cpus[n].tableUsed = 0;
+    cpus[n].table = new bxProfileEntry_t[cpus[n].tableSize];
+    memset(cpus[n].table, 0, sizeof(bxProfileEntry_t) * cpus[n].tableSize);
+    cpus[n].samples = 0;
+  }
+
+  BX_INFO(("profiler: sampling every %u ticks into '%s'", interval, path));
+  bx_pc_system.register_timer_ticks(this, timerHandler, interval, 1 /* continuous */, 1, "profiler.timer");
+}
+
+void bxProfiler_c::timerHandler(void *this_ptr)
+{
+  UNUSED(this_ptr);
+
+  for (unsigned n=0; n < BX_SMP_PROCESSORS; n++) {
+#if BX_SUPPORT_SMP
+    if (bx_smp_is_remote_cpu(n)) {
+      BX_CPU(n)->smp_post_request(BX_SMP_REQ_PROFILE_SAMPLE);
+      continue;
+    }
+#endif
+    BX_CPU(n)->profileSample();
+  }
+}
+
+void bxProfiler_c::insert(bxProfileCpu_t *p, const bxProfileSample_t *sample, Bit64u count)
+{
+  // keep the table at most half full
+  if (2 * (p->tableUsed + 1) > p->tableSize) {
+    bxProfileEntry_t *old = p->table;
+    unsigned oldSize = p->tableSize;
+
+    p->tableSize *= 2;
+    p->tableUsed = 0;
+    p->table = new bxProfileEntry_t[p->tableSize];
+    memset(p->table, 0, sizeof(bxProfileEntry_t) * p->tableSize);
+    for (unsigned n=0; n < oldSize; n++) {
+      if (old[n].count) insert(p, &old[n].sample, old[n].count);
+    }
+    delete [] old;
+  }
+
+  unsigned mask = p->tableSize - 1;
+  for (unsigned slot = hashSample(sample) & mask;; slot = (slot + 1) & mask) {
+    bxProfileEntry_t *e = &p->table[slot];
+    if (! e->count) {
+      e->sample = *sample;
+      e->count = count;
+      p->tableUsed++;
+      return;
+    }
+    if (sameSample(&e->sample, sample)) {
+      e->count += count;
+      return;
+    }
+  }
+}
+
+void bxProfiler_c::fold(bxProfileCpu_t *p)
+{
+  for (; p->tail != p->head; p->tail++) {
+    insert(p, &p->ring[p->tail & (BX_PROFILE_RING_SIZE-1)], 1);
+    p->samples++;
+  }
+}
+
+static int compareProfileEntries(const void *a, const void *b)
+{
+  Bit64u ca = (*(const bxProfileEntry_t* const *) a)->count;
+  Bit64u cb = (*(const bxProfileEntry_t* const *) b)->count;
+
+  return (ca > cb) ? -1 : (ca < cb);
+}
+
+void bxProfiler_c::save(void)
+{
+  if (! path) return;
+
+  FILE *fp = fopen(path, "w");
+  if (! fp) {
+    BX_ERROR(("profiler: failed to create '%s'", path));
+    return;
+  }
+
+  Bit64u total = 0;
+
+  for (unsigned cpu=0; cpu < ncpus; cpu++) {
+    bxProfileCpu_t *p = &cpus[cpu];
+    fold(p);
+    total += p->samples;
+
+    bxProfileEntry_t **sorted = new bxProfileEntry_t*[p->tableUsed + 1];
+    unsigned num = 0;
+    for (unsigned n=0; n < p->tableSize; n++) {
+      if (p->table[n].count) sorted[num++] = &p->table[n];
+    }
+    qsort(sorted, num, sizeof(bxProfileEntry_t*), compareProfileEntries);
+
+    for (unsigned n=0; n < num; n++) {
+      const bxProfileSample_t *s = &sorted[n]->sample;
+
+      const char *symbol = NULL;
+#if BX_DEBUGGER
+      symbol = bx_dbg_symbol_name(s->cr3 >> 12, s->laddr);
+#endif
+      fprintf(fp, "cpu%u;cr3=0x" FMT_ADDRX ";cpl%u;", cpu, (bx_address) s->cr3, s->cpl);
+      if (symbol)
+        fprintf(fp, "%s;", symbol);
+      else
+        fprintf(fp, "0x" FMT_ADDRX ";", (bx_address) s->rip);
+
+      if (s->halted)
+        fprintf(fp, "[halted]");
+      else if (s->ia_opcode == BX_PROFILE_NOT_DECODED)
+        fprintf(fp, "[not decoded]");
+      else
+        fprintf(fp, "%s", get_bx_opcode_name(s->ia_opcode) + /*"BX_IA_"*/ 6);
+
+      fprintf(fp, " " FMT_LL "u\n", sorted[n]->count);
+    }
+
+    delete [] sorted;
+  }
+
+  fclose(fp);
+
+  BX_INFO(("profiler: " FMT_LL "u samples written to '%s'", total, path));
+}
+
+void BX_CPU_C::profileSample(void)
+{
+  bxProfileSample_t sample;
+
+  sample.rip = RIP;
+  sample.laddr = get_laddr(BX_SEG_REG_CS, RIP);
+  sample.cr3 = BX_CPU_THIS_PTR cr3;
+  sample.cpl = CPL;
+  sample.halted = (BX_CPU_THIS_PTR activity_state != BX_ACTIVITY_STATE_ACTIVE);
+  sample.ia_opcode = BX_PROFILE_NOT_DECODED;
+
+  // the instruction at RIP is the next one to execute, it is not always the
+  // first of a trace, decode it from the current fetch page so that the
+  // trace cache and its LRU state are left alone
+  bx_address eipBiased = RIP + BX_CPU_THIS_PTR eipPageBias;
+  if (! sample.halted && BX_CPU_THIS_PTR eipFetchPtr && eipBiased < BX_CPU_THIS_PTR eipPageWindowSize) {
+    const Bit8u *fetchPtr = BX_CPU_THIS_PTR eipFetchPtr + eipBiased;
+    unsigned remainingInPage = BX_CPU_THIS_PTR eipPageWindowSize - (Bit32u) eipBiased;
+    bxInstruction_c i;
+    int ret;
+#if BX_SUPPORT_X86_64
+    if (BX_CPU_THIS_PTR cpu_mode == BX_MODE_LONG_64)
+      ret = fetchDecode64(fetchPtr, &i, remainingInPage);
+    else
+#endif
+      ret = fetchDecode32(fetchPtr, BX_CPU_THIS_PTR sregs[BX_SEG_REG_CS].cache.u.segment.d_b, &i, remainingInPage);
+
+    // an instruction crossing the page boundary is not decoded
+    if (ret >= 0)
+      sample.ia_opcode = i.getIaOpcode();
+  }
+
+  profiler.record(BX_CPU_ID, &sample);
+}
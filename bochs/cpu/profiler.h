@@ -0,0 +1,103 @@
+/////////////////////////////////////////////////////////////////////////
+// $Id$
+/////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (C) 2026  The Bochs Project
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA B 02110-1301 USA
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef BX_PROFILER_H
+#define BX_PROFILER_H
+
+// Sampling profiler (cpu: profile=<file>, profile_interval=<ticks>)
+//
+// A continuous bx_pc_system timer samples every processor each interval
+// ticks: the guest RIP, CR3 and CPL together with the opcode of the
+// instruction at RIP, which names the emulator handler executing it. The
+// samples are buffered in a ring per processor written only by the
+// processor itself (processors simulated in their own host thread are
+// sampled through an SMP request), so no locking is needed. The ring is
+// folded into a table of distinct samples when it fills up.
+//
+// At exit the samples are written in the collapsed stack format of the
+// flame graph tools, one line per distinct sample:
+//
+//   cpu0;cr3=0x0000000000ab1000;cpl3;<guest symbol or RIP>;<opcode> <count>
+//
+// Guest symbols are taken from the symbol tables loaded into the internal
+// debugger (ldsym) if Bochs is compiled with the debugger.
+
+#define BX_PROFILE_RING_SIZE         1024   // must be a power of 2
+
+// opcode of a sample taken when the instruction at RIP could not be decoded
+// from the current fetch page
+#define BX_PROFILE_NOT_DECODED       0xffff
+
+struct bxProfileSample_t {
+  Bit64u rip;
+  Bit64u laddr;         // linear address of RIP, used for the symbol lookup
+  Bit64u cr3;
+  Bit16u ia_opcode;     // opcode of the instruction at RIP
+  Bit8u  cpl;
+  Bit8u  halted;        // the processor waits for an event (HLT, MWAIT, ...)
+};
+
+struct bxProfileEntry_t;
+
+struct bxProfileCpu_t {
+  bxProfileSample_t ring[BX_PROFILE_RING_SIZE];
+  Bit32u head, tail;
+  // distinct samples folded from the ring, open addressing hash
+  bxProfileEntry_t *table;
+  unsigned tableSize, tableUsed;
+  Bit64u samples;
+};
+
+class bxProfiler_c {
+public:
+  bxProfiler_c();
+ ~bxProfiler_c();
+
+  // allocates the rings and starts the sampling timer
+  void open(const char *path, Bit32u interval);
+  // writes the collected samples, all the processors must be stopped
+  void save(void);
+
+  BX_CPP_INLINE bool enabled(void) const { return path != NULL; }
+
+  BX_CPP_INLINE void record(unsigned cpu, const bxProfileSample_t *sample)
+  {
+    bxProfileCpu_t *p = &cpus[cpu];
+    p->ring[p->head & (BX_PROFILE_RING_SIZE-1)] = *sample;
+    if (++p->head - p->tail == BX_PROFILE_RING_SIZE)
+      fold(p);
+  }
+
+  static void timerHandler(void *this_ptr);
+
+private:
+  char *path;
+  bxProfileCpu_t *cpus;
+  unsigned ncpus;
+
+  void fold(bxProfileCpu_t *p);
+  void insert(bxProfileCpu_t *p, const bxProfileSample_t *sample, Bit64u count);
+};
+
+extern bxProfiler_c profiler;
+
+#endif
@@ -29,6 +29,7 @@
 #if BX_CPU_LEVEL >= 6
 
 #include "scalar_arith.h"
+#include "host_crypto.h"
 
 //
 // sha_f0(): A bit oriented logical operation that derives a new dword from three SHA1 state variables (dword).
@@ -117,14 +118,174 @@ BX_CPP_INLINE Bit32u sha256_transformation_rrs(Bit32u val_32, unsigned rotate1,
   return ror32(val_32, rotate1) ^ ror32(val_32, rotate2) ^ (val_32 >> shr);
 }
 
+// SHA1/SHA256 message and round operations, on the host SHA extensions when
+// available, op1 is the destination
+
+BX_CPP_INLINE void xmm_sha1nexte(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
+{
+#if BX_HOST_CRYPTO
+  if (bx_host_crypto.sha) {
+    host_sha1nexte(op1, op2);
+    return;
+  }
+#endif
+
+  Bit32u E = rol32(op1->xmm32u(3), 30);
+
+  *op1 = *op2;
+  op1->xmm32u(3) += E;
+}
+
+BX_CPP_INLINE void xmm_sha1msg1(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
+{
+#if BX_HOST_CRYPTO
+  if (bx_host_crypto.sha) {
+    host_sha1msg1(op1, op2);
+    return;
+  }
+#endif
+
+  op1->xmm32u(3) ^= op1->xmm32u(1);
+  op1->xmm32u(2) ^= op1->xmm32u(0);
+  op1->xmm32u(1) ^= op2->xmm32u(3);
+  op1->xmm32u(0) ^= op2->xmm32u(2);
+}
+
+BX_CPP_INLINE void xmm_sha1msg2(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
+{
+#if BX_HOST_CRYPTO
+  if (bx_host_crypto.sha) {
+    host_sha1msg2(op1, op2);
+    return;
+  }
+#endif
+
+  op1->xmm32u(3) = rol32(op1->xmm32u(3) ^ op2->xmm32u(2), 1);
+  op1->xmm32u(2) = rol32(op1->xmm32u(2) ^ op2->xmm32u(1), 1);
+  op1->xmm32u(1) = rol32(op1->xmm32u(1) ^ op2->xmm32u(0), 1);
+  op1->xmm32u(0) = rol32(op1->xmm32u(0) ^ op1->xmm32u(3), 1);
+}
+
+BX_CPP_INLINE void xmm_sha256rnds2(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, const BxPackedXmmRegister *wk)
+{
+#if BX_HOST_CRYPTO
+  if (bx_host_crypto.sha) {
+    host_sha256rnds2(op1, op2, wk);
+    return;
+  }
+#endif
+
+  Bit32u A[3], B[3], C[3], D[3], E[3], F[3], G[3], H[3];
+
+  A[0] = op2->xmm32u(3);
+  B[0] = op2->xmm32u(2);
+  E[0] = op2->xmm32u(1);
+  F[0] = op2->xmm32u(0);
+
+  C[0] = op1->xmm32u(3);
+  D[0] = op1->xmm32u(2);
+  G[0] = op1->xmm32u(1);
+  H[0] = op1->xmm32u(0);
+
+  for (unsigned n=0; n < 2; n++) {
+    Bit32u   tmp = sha_ch (E[n], F[n], G[n]) + sha256_transformation_rrr(E[n], 6, 11, 25) + wk->xmm32u(n) + H[n];
+    A[n+1] = tmp + sha_maj(A[n], B[n], C[n]) + sha256_transformation_rrr(A[n], 2, 13, 22);
+    B[n+1] = A[n];
+    C[n+1] = B[n];
+    D[n+1] = C[n];
+    E[n+1] = tmp + D[n];
+    F[n+1] = E[n];
+    G[n+1] = F[n];
+    H[n+1] = G[n];
+  }
+
+  op1->xmm32u(0) = F[2];
+  op1->xmm32u(1) = E[2];
+  op1->xmm32u(2) = B[2];
+  op1->xmm32u(3) = A[2];
+}
+
+BX_CPP_INLINE void xmm_sha256msg1(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
+{
+#if BX_HOST_CRYPTO
+  if (bx_host_crypto.sha) {
+    host_sha256msg1(op1, op2);
+    return;
+  }
+#endif
+
+  op1->xmm32u(0) += sha256_transformation_rrs(op1->xmm32u(1), 7, 18, 3);
+  op1->xmm32u(1) += sha256_transformation_rrs(op1->xmm32u(2), 7, 18, 3);
+  op1->xmm32u(2) += sha256_transformation_rrs(op1->xmm32u(3), 7, 18, 3);
+  op1->xmm32u(3) += sha256_transformation_rrs(op2->xmm32u(0), 7, 18, 3);
+}
+
+BX_CPP_INLINE void xmm_sha256msg2(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
+{
+#if BX_HOST_CRYPTO
+  if (bx_host_crypto.sha) {
+    host_sha256msg2(op1, op2);
+    return;
+  }
+#endif
+
+  op1->xmm32u(0) += sha256_transformation_rrs(op2->xmm32u(2), 17, 19, 10);
+  op1->xmm32u(1) += sha256_transformation_rrs(op2->xmm32u(3), 17, 19, 10);
+  op1->xmm32u(2) += sha256_transformation_rrs(op1->xmm32u(0), 17, 19, 10);
+  op1->xmm32u(3) += sha256_transformation_rrs(op1->xmm32u(1), 17, 19, 10);
+}
+
+BX_CPP_INLINE void xmm_sha1rnds4(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, unsigned imm)
+{
+  // SHA1 Constants dependent on immediate i
+  static const Bit32u sha_Ki[4] = { 0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6 };
+
+#if BX_HOST_CRYPTO
+  if (bx_host_crypto.sha) {
+    host_sha1rnds4(op1, op2, imm);
+    return;
+  }
+#endif
+  imm &= 0x3;
+  Bit32u K = sha_Ki[imm];
+
+  Bit32u A, B, C, D, E, W[4];
+
+  A = op1->xmm32u(3);
+  B = op1->xmm32u(2);
+  C = op1->xmm32u(1);
+  D = op1->xmm32u(0);
+  E = 0;
+
+  W[0] = op2->xmm32u(3);
+  W[1] = op2->xmm32u(2);
+  W[2] = op2->xmm32u(1);
+  W[3] = op2->xmm32u(0);
+
+  for (unsigned n=0; n < 4; n++) {
+    Bit32u A_next = sha_f(B, C, D, imm) + rol32(A, 5) + W[n] + E + K;
+
+    E = D;
+    D = C;
+    C = rol32(B, 30);
+    B = A;
+    A = A_next;
+  }
+
+  op1->xmm32u(3) = A;
+  op1->xmm32u(2) = B;
+  op1->xmm32u(1) = C;
+  op1->xmm32u(0) = D;
+}
+
 /* 0F 38 C8 */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::SHA1NEXTE_VdqWdqR(bxInstruction_c *i)
 {
   BxPackedXmmRegister op1 = BX_READ_XMM_REG(i->dst()), op2 = BX_READ_XMM_REG(i->src());
 
-  op2.xmm32u(3) += rol32(op1.xmm32u(3), 30);
+  xmm_sha1nexte(&op1, &op2);
 
-  BX_WRITE_XMM_REG(i->dst(), op2);
+  BX_WRITE_XMM_REG(i->dst(), op1);
 
   BX_NEXT_INSTR(i);
 }
@@ -134,10 +295,7 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SHA1MSG1_VdqWdqR(bxInstruction_c *i)
 {
   BxPackedXmmRegister op1 = BX_READ_XMM_REG(i->dst()), op2 = BX_READ_XMM_REG(i->src());
 
-  op1.xmm32u(3) ^= op1.xmm32u(1);
-  op1.xmm32u(2) ^= op1.xmm32u(0);
-  op1.xmm32u(1) ^= op2.xmm32u(3);
-  op1.xmm32u(0) ^= op2.xmm32u(2);
+  xmm_sha1msg1(&op1, &op2);
 
   BX_WRITE_XMM_REG(i->dst(), op1);
 
@@ -149,10 +307,7 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SHA1MSG2_VdqWdqR(bxInstruction_c *i)
 {
   BxPackedXmmRegister op1 = BX_READ_XMM_REG(i->dst()), op2 = BX_READ_XMM_REG(i->src());
 
-  op1.xmm32u(3) = rol32(op1.xmm32u(3) ^ op2.xmm32u(2), 1);
-  op1.xmm32u(2) = rol32(op1.xmm32u(2) ^ op2.xmm32u(1), 1);
-  op1.xmm32u(1) = rol32(op1.xmm32u(1) ^ op2.xmm32u(0), 1);
-  op1.xmm32u(0) = rol32(op1.xmm32u(0) ^ op1.xmm32u(3), 1);
+  xmm_sha1msg2(&op1, &op2);
 
   BX_WRITE_XMM_REG(i->dst(), op1);
 
@@ -164,34 +319,7 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SHA256RNDS2_VdqWdqR(bxInstruction_c *i)
 {
   BxPackedXmmRegister op1 = BX_READ_XMM_REG(i->dst()), op2 = BX_READ_XMM_REG(i->src()), wk = BX_READ_XMM_REG(0);
 
-  Bit32u A[3], B[3], C[3], D[3], E[3], F[3], G[3], H[3];
-
-  A[0] = op2.xmm32u(3);
-  B[0] = op2.xmm32u(2);
-  E[0] = op2.xmm32u(1);
-  F[0] = op2.xmm32u(0);
-
-  C[0] = op1.xmm32u(3);
-  D[0] = op1.xmm32u(2);
-  G[0] = op1.xmm32u(1);
-  H[0] = op1.xmm32u(0);
-
-  for (unsigned n=0; n < 2; n++) {
-    Bit32u   tmp = sha_ch (E[n], F[n], G[n]) + sha256_transformation_rrr(E[n], 6, 11, 25) + wk.xmm32u(n) + H[n];
-    A[n+1] = tmp + sha_maj(A[n], B[n], C[n]) + sha256_transformation_rrr(A[n], 2, 13, 22);
-    B[n+1] = A[n];
-    C[n+1] = B[n];
-    D[n+1] = C[n];
-    E[n+1] = tmp + D[n];
-    F[n+1] = E[n];
-    G[n+1] = F[n];
-    H[n+1] = G[n];
-  }
-
-  op1.xmm32u(0) = F[2];
-  op1.xmm32u(1) = E[2];
-  op1.xmm32u(2) = B[2];
-  op1.xmm32u(3) = A[2];
+  xmm_sha256rnds2(&op1, &op2, &wk);
 
   BX_WRITE_XMM_REG(i->dst(), op1);
 
@@ -201,13 +329,9 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SHA256RNDS2_VdqWdqR(bxInstruction_c *i)
 /* 0F 38 CC */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::SHA256MSG1_VdqWdqR(bxInstruction_c *i)
 {
-  BxPackedXmmRegister op1 = BX_READ_XMM_REG(i->dst());
-  Bit32u op2 = BX_READ_XMM_REG_LO_DWORD(i->src());
+  BxPackedXmmRegister op1 = BX_READ_XMM_REG(i->dst()), op2 = BX_READ_XMM_REG(i->src());
 
-  op1.xmm32u(0) += sha256_transformation_rrs(op1.xmm32u(1), 7, 18, 3);
-  op1.xmm32u(1) += sha256_transformation_rrs(op1.xmm32u(2), 7, 18, 3);
-  op1.xmm32u(2) += sha256_transformation_rrs(op1.xmm32u(3), 7, 18, 3);
-  op1.xmm32u(3) += sha256_transformation_rrs(op2,           7, 18, 3);
+  xmm_sha256msg1(&op1, &op2);
 
   BX_WRITE_XMM_REG(i->dst(), op1);
 
@@ -219,10 +343,7 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SHA256MSG2_VdqWdqR(bxInstruction_c *i)
 {
   BxPackedXmmRegister op1 = BX_READ_XMM_REG(i->dst()), op2 = BX_READ_XMM_REG(i->src());
 
-  op1.xmm32u(0) += sha256_transformation_rrs(op2.xmm32u(2), 17, 19, 10);
-  op1.xmm32u(1) += sha256_transformation_rrs(op2.xmm32u(3), 17, 19, 10);
-  op1.xmm32u(2) += sha256_transformation_rrs(op1.xmm32u(0), 17, 19, 10);
-  op1.xmm32u(3) += sha256_transformation_rrs(op1.xmm32u(1), 17, 19, 10);
+  xmm_sha256msg2(&op1, &op2);
 
   BX_WRITE_XMM_REG(i->dst(), op1);
 
@@ -232,44 +353,63 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SHA256MSG2_VdqWdqR(bxInstruction_c *i)
 /* 0F 3A CC */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::SHA1RNDS4_VdqWdqIbR(bxInstruction_c *i)
 {
-  // SHA1 Constants dependent on immediate i
-  static const Bit32u sha_Ki[4] = { 0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6 };
-
   BxPackedXmmRegister op1 = BX_READ_XMM_REG(i->dst()), op2 = BX_READ_XMM_REG(i->src());
-  unsigned imm = i->Ib() & 0x3;
-  Bit32u K = sha_Ki[imm];
 
-  Bit32u A, B, C, D, E, W[4];
+  xmm_sha1rnds4(&op1, &op2, i->Ib());
 
-  A = op1.xmm32u(3);
-  B = op1.xmm32u(2);
-  C = op1.xmm32u(1);
-  D = op1.xmm32u(0);
-  E = 0;
+  BX_WRITE_XMM_REG(i->dst(), op1);
 
-  W[0] = op2.xmm32u(3);
-  W[1] = op2.xmm32u(2);
-  W[2] = op2.xmm32u(1);
-  W[3] = op2.xmm32u(0);
+  BX_NEXT_INSTR(i);
+}
 
-  for (unsigned n=0; n < 4; n++) {
-    Bit32u A_next = sha_f(B, C, D, imm) + rol32(A, 5) + W[n] + E + K;
+#if BX_HOST_CRYPTO
 
-    E = D;
-    D = C;
-    C = rol32(B, 30);
-    B = A;
-    A = A_next;
-  }
+static void sha1nexte_test(BxPackedXmmRegister *dst, const BxPackedXmmRegister *src, const BxPackedXmmRegister *xmm0, Bit8u imm8)
+{
+  xmm_sha1nexte(dst, src);
+}
 
-  op1.xmm32u(3) = A;
-  op1.xmm32u(2) = B;
-  op1.xmm32u(1) = C;
-  op1.xmm32u(0) = D;
+static void sha1msg1_test(BxPackedXmmRegister *dst, const BxPackedXmmRegister *src, const BxPackedXmmRegister *xmm0, Bit8u imm8)
+{
+  xmm_sha1msg1(dst, src);
+}
 
-  BX_WRITE_XMM_REG(i->dst(), op1);
+static void sha1msg2_test(BxPackedXmmRegister *dst, const BxPackedXmmRegister *src, const BxPackedXmmRegister *xmm0, Bit8u imm8)
+{
+  xmm_sha1msg2(dst, src);
+}
 
-  BX_NEXT_INSTR(i);
+static void sha256rnds2_test(BxPackedXmmRegister *dst, const BxPackedXmmRegister *src, const BxPackedXmmRegister *xmm0, Bit8u imm8)
+{
+  xmm_sha256rnds2(dst, src, xmm0);
+}
+
+static void sha256msg1_test(BxPackedXmmRegister *dst, const BxPackedXmmRegister *src, const BxPackedXmmRegister *xmm0, Bit8u imm8)
+{
+  xmm_sha256msg1(dst, src);
+}
+
+static void sha256msg2_test(BxPackedXmmRegister *dst, const BxPackedXmmRegister *src, const BxPackedXmmRegister *xmm0, Bit8u imm8)
+{
+  xmm_sha256msg2(dst, src);
+}
+
+static void sha1rnds4_test(BxPackedXmmRegister *dst, const BxPackedXmmRegister *src, const BxPackedXmmRegister *xmm0, Bit8u imm8)
+{
+  xmm_sha1rnds4(dst, src, imm8);
 }
 
+const bxHostCryptoTest_t bx_sha_host_crypto_tests[] = {
+  { "SHA1RNDS4",   sha1rnds4_test,   &bx_host_crypto.sha },
+  { "SHA1NEXTE",   sha1nexte_test,   &bx_host_crypto.sha },
+  { "SHA1MSG1",    sha1msg1_test,    &bx_host_crypto.sha },
+  { "SHA1MSG2",    sha1msg2_test,    &bx_host_crypto.sha },
+  { "SHA256RNDS2", sha256rnds2_test, &bx_host_crypto.sha },
+  { "SHA256MSG1",  sha256msg1_test,  &bx_host_crypto.sha },
+  { "SHA256MSG2",  sha256msg2_test,  &bx_host_crypto.sha },
+  { NULL, NULL, NULL }
+};
+
+#endif
+
 #endif
@@ -24,70 +24,112 @@
 #ifndef BX_SIMD_INT_COMPARE_FUNCTIONS_H
 #define BX_SIMD_INT_COMPARE_FUNCTIONS_H
 
+#include "simd_host.h"
+
 // compare less than (signed)
 
 BX_CPP_INLINE void xmm_pcmpltb(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  xmm_store(op1, _mm_cmpgt_epi8(b, a));
+#else
   for(unsigned n=0; n<16; n++) {
     op1->xmmubyte(n) = (op1->xmmsbyte(n) < op2->xmmsbyte(n)) ? 0xff : 0;
   }
+#endif
 }
 
 BX_CPP_INLINE Bit32u xmm_pcmpltb_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  return _mm_movemask_epi8(_mm_cmpgt_epi8(b, a));
+#else
   Bit32u mask = 0;
   for(unsigned n=0; n<16; n++) {
     if (op1->xmmsbyte(n) < op2->xmmsbyte(n)) mask |= (1 << n);
   }
   return mask;
+#endif
 }
 
 BX_CPP_INLINE void xmm_pcmpltw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  xmm_store(op1, _mm_cmpgt_epi16(b, a));
+#else
   for(unsigned n=0; n<8; n++) {
     op1->xmm16u(n) = (op1->xmm16s(n) < op2->xmm16s(n)) ? 0xffff : 0;
   }
+#endif
 }
 
 BX_CPP_INLINE Bit32u xmm_pcmpltw_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  return xmm_movemask_w(_mm_cmpgt_epi16(b, a));
+#else
   Bit32u mask = 0;
   for(unsigned n=0; n<8; n++) {
     if (op1->xmm16s(n) < op2->xmm16s(n)) mask |= (1 << n);
   }
   return mask;
+#endif
 }
 
 BX_CPP_INLINE void xmm_pcmpltd(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  xmm_store(op1, _mm_cmpgt_epi32(b, a));
+#else
   for(unsigned n=0; n<4; n++) {
     op1->xmm32u(n) = (op1->xmm32s(n) < op2->xmm32s(n)) ? 0xffffffff : 0;
   }
+#endif
 }
 
 BX_CPP_INLINE Bit32u xmm_pcmpltd_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  return xmm_movemask_d(_mm_cmpgt_epi32(b, a));
+#else
   Bit32u mask = 0;
   for(unsigned n=0; n<4; n++) {
     if (op1->xmm32s(n) < op2->xmm32s(n)) mask |= (1 << n);
   }
   return mask;
+#endif
 }
 
 BX_CPP_INLINE void xmm_pcmpltq(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE4_2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  xmm_store(op1, _mm_cmpgt_epi64(b, a));
+#else
   for(unsigned n=0; n<2; n++) {
     op1->xmm64u(n) = (op1->xmm64s(n) < op2->xmm64s(n)) ? BX_CONST64(0xffffffffffffffff) : 0;
   }
+#endif
 }
 
 BX_CPP_INLINE Bit32u xmm_pcmpltq_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE4_2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  return xmm_movemask_q(_mm_cmpgt_epi64(b, a));
+#else
   Bit32u mask = 0;
   for(unsigned n=0; n<2; n++) {
     if (op1->xmm64s(n) < op2->xmm64s(n)) mask |= (1 << n);
   }
   return mask;
+#endif
 }
 
 // compare less than (unsigned)
@@ -167,11 +209,16 @@ BX_CPP_INLINE void xmm_pcmpleb(BxPackedXmmRegister *op1, const BxPackedXmmRegist
 
 BX_CPP_INLINE Bit32u xmm_pcmpleb_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  return 0xffff ^ _mm_movemask_epi8(_mm_cmpgt_epi8(a, b));
+#else
   Bit32u mask = 0;
   for(unsigned n=0; n<16; n++) {
     if (op1->xmmsbyte(n) <= op2->xmmsbyte(n)) mask |= (1 << n);
   }
   return mask;
+#endif
 }
 
 BX_CPP_INLINE void xmm_pcmplew(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
@@ -183,11 +230,16 @@ BX_CPP_INLINE void xmm_pcmplew(BxPackedXmmRegister *op1, const BxPackedXmmRegist
 
 BX_CPP_INLINE Bit32u xmm_pcmplew_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  return 0xff ^ xmm_movemask_w(_mm_cmpgt_epi16(a, b));
+#else
   Bit32u mask = 0;
   for(unsigned n=0; n<8; n++) {
     if (op1->xmm16s(n) <= op2->xmm16s(n)) mask |= (1 << n);
   }
   return mask;
+#endif
 }
 
 BX_CPP_INLINE void xmm_pcmpled(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
@@ -199,11 +251,16 @@ BX_CPP_INLINE void xmm_pcmpled(BxPackedXmmRegister *op1, const BxPackedXmmRegist
 
 BX_CPP_INLINE Bit32u xmm_pcmpled_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  return 0xf ^ xmm_movemask_d(_mm_cmpgt_epi32(a, b));
+#else
   Bit32u mask = 0;
   for(unsigned n=0; n<4; n++) {
     if (op1->xmm32s(n) <= op2->xmm32s(n)) mask |= (1 << n);
   }
   return mask;
+#endif
 }
 
 BX_CPP_INLINE void xmm_pcmpleq(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
@@ -215,11 +272,16 @@ BX_CPP_INLINE void xmm_pcmpleq(BxPackedXmmRegister *op1, const BxPackedXmmRegist
 
 BX_CPP_INLINE Bit32u xmm_pcmpleq_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE4_2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  return 0x3 ^ xmm_movemask_q(_mm_cmpgt_epi64(a, b));
+#else
   Bit32u mask = 0;
   for(unsigned n=0; n<2; n++) {
     if (op1->xmm64s(n) <= op2->xmm64s(n)) mask |= (1 << n);
   }
   return mask;
+#endif
 }
 
 // compare less than or equal (unsigned)
@@ -292,66 +354,106 @@ BX_CPP_INLINE Bit32u xmm_pcmpleuq_mask(const BxPackedXmmRegister *op1, const BxP
 
 BX_CPP_INLINE void xmm_pcmpgtb(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  xmm_store(op1, _mm_cmpgt_epi8(a, b));
+#else
   for(unsigned n=0; n<16; n++) {
     op1->xmmubyte(n) = (op1->xmmsbyte(n) > op2->xmmsbyte(n)) ? 0xff : 0;
   }
+#endif
 }
 
 BX_CPP_INLINE Bit32u xmm_pcmpgtb_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  return _mm_movemask_epi8(_mm_cmpgt_epi8(a, b));
+#else
   Bit32u mask = 0;
   for(unsigned n=0; n<16; n++) {
     if (op1->xmmsbyte(n) > op2->xmmsbyte(n)) mask |= (1 << n);
   }
   return mask;
+#endif
 }
 
 BX_CPP_INLINE void xmm_pcmpgtw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  xmm_store(op1, _mm_cmpgt_epi16(a, b));
+#else
   for(unsigned n=0; n<8; n++) {
     op1->xmm16u(n) = (op1->xmm16s(n) > op2->xmm16s(n)) ? 0xffff : 0;
   }
+#endif
 }
 
 BX_CPP_INLINE Bit32u xmm_pcmpgtw_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  return xmm_movemask_w(_mm_cmpgt_epi16(a, b));
+#else
   Bit32u mask = 0;
   for(unsigned n=0; n<8; n++) {
     if (op1->xmm16s(n) > op2->xmm16s(n)) mask |= (1 << n);
   }
   return mask;
+#endif
 }
 
 BX_CPP_INLINE void xmm_pcmpgtd(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  xmm_store(op1, _mm_cmpgt_epi32(a, b));
+#else
   for(unsigned n=0; n<4; n++) {
     op1->xmm32u(n) = (op1->xmm32s(n) > op2->xmm32s(n)) ? 0xffffffff : 0;
   }
+#endif
 }
 
 BX_CPP_INLINE Bit32u xmm_pcmpgtd_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  return xmm_movemask_d(_mm_cmpgt_epi32(a, b));
+#else
   Bit32u mask = 0;
   for(unsigned n=0; n<4; n++) {
     if (op1->xmm32s(n) > op2->xmm32s(n)) mask |= (1 << n);
   }
   return mask;
+#endif
 }
 
 BX_CPP_INLINE void xmm_pcmpgtq(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE4_2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  xmm_store(op1, _mm_cmpgt_epi64(a, b));
+#else
   for(unsigned n=0; n<2; n++) {
     op1->xmm64u(n) = (op1->xmm64s(n) > op2->xmm64s(n)) ? BX_CONST64(0xffffffffffffffff) : 0;
   }
+#endif
 }
 
 BX_CPP_INLINE Bit32u xmm_pcmpgtq_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE4_2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  return xmm_movemask_q(_mm_cmpgt_epi64(a, b));
+#else
   Bit32u mask = 0;
   for(unsigned n=0; n<2; n++) {
     if (op1->xmm64s(n) > op2->xmm64s(n)) mask |= (1 << n);
   }
   return mask;
+#endif
 }
 
 // compare greater than (unsigned)
@@ -431,11 +533,16 @@ BX_CPP_INLINE void xmm_pcmpgeb(BxPackedXmmRegister *op1, const BxPackedXmmRegist
 
 BX_CPP_INLINE Bit32u xmm_pcmpgeb_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  return 0xffff ^ _mm_movemask_epi8(_mm_cmpgt_epi8(b, a));
+#else
   Bit32u mask = 0;
   for(unsigned n=0; n<16; n++) {
     if (op1->xmmsbyte(n) >= op2->xmmsbyte(n)) mask |= (1 << n);
   }
   return mask;
+#endif
 }
 
 BX_CPP_INLINE void xmm_pcmpgew(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
@@ -447,11 +554,16 @@ BX_CPP_INLINE void xmm_pcmpgew(BxPackedXmmRegister *op1, const BxPackedXmmRegist
 
 BX_CPP_INLINE Bit32u xmm_pcmpgew_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  return 0xff ^ xmm_movemask_w(_mm_cmpgt_epi16(b, a));
+#else
   Bit32u mask = 0;
   for(unsigned n=0; n<8; n++) {
     if (op1->xmm16s(n) >= op2->xmm16s(n)) mask |= (1 << n);
   }
   return mask;
+#endif
 }
 
 BX_CPP_INLINE void xmm_pcmpged(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
@@ -463,11 +575,16 @@ BX_CPP_INLINE void xmm_pcmpged(BxPackedXmmRegister *op1, const BxPackedXmmRegist
 
 BX_CPP_INLINE Bit32u xmm_pcmpged_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  return 0xf ^ xmm_movemask_d(_mm_cmpgt_epi32(b, a));
+#else
   Bit32u mask = 0;
   for(unsigned n=0; n<4; n++) {
     if (op1->xmm32s(n) >= op2->xmm32s(n)) mask |= (1 << n);
   }
   return mask;
+#endif
 }
 
 BX_CPP_INLINE void xmm_pcmpgeq(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
@@ -479,11 +596,16 @@ BX_CPP_INLINE void xmm_pcmpgeq(BxPackedXmmRegister *op1, const BxPackedXmmRegist
 
 BX_CPP_INLINE Bit32u xmm_pcmpgeq_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE4_2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  return 0x3 ^ xmm_movemask_q(_mm_cmpgt_epi64(b, a));
+#else
   Bit32u mask = 0;
   for(unsigned n=0; n<2; n++) {
     if (op1->xmm64s(n) >= op2->xmm64s(n)) mask |= (1 << n);
   }
   return mask;
+#endif
 }
 
 // compare greater than or equal (unsigned)
@@ -556,132 +678,212 @@ BX_CPP_INLINE Bit32u xmm_pcmpgeuq_mask(const BxPackedXmmRegister *op1, const BxP
 
 BX_CPP_INLINE void xmm_pcmpeqb(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  xmm_store(op1, _mm_cmpeq_epi8(a, b));
+#else
   for(unsigned n=0; n<16; n++) {
     op1->xmmubyte(n) = (op1->xmmubyte(n) == op2->xmmubyte(n)) ? 0xff : 0;
   }
+#endif
 }
 
 BX_CPP_INLINE Bit32u xmm_pcmpeqb_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(a, b));
+#else
   Bit32u mask = 0;
   for(unsigned n=0; n<16; n++) {
     if (op1->xmmubyte(n) == op2->xmmubyte(n)) mask |= (1 << n);
   }
   return mask;
+#endif
 }
 
 BX_CPP_INLINE void xmm_pcmpeqw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  xmm_store(op1, _mm_cmpeq_epi16(a, b));
+#else
   for(unsigned n=0; n<8; n++) {
     op1->xmm16u(n) = (op1->xmm16u(n) == op2->xmm16u(n)) ? 0xffff : 0;
   }
+#endif
 }
 
 BX_CPP_INLINE Bit32u xmm_pcmpeqw_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  return xmm_movemask_w(_mm_cmpeq_epi16(a, b));
+#else
   Bit32u mask = 0;
   for(unsigned n=0; n<8; n++) {
     if (op1->xmm16u(n) == op2->xmm16u(n)) mask |= (1 << n);
   }
   return mask;
+#endif
 }
 
 BX_CPP_INLINE void xmm_pcmpeqd(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  xmm_store(op1, _mm_cmpeq_epi32(a, b));
+#else
   for(unsigned n=0; n<4; n++) {
     op1->xmm32u(n) = (op1->xmm32u(n) == op2->xmm32u(n)) ? 0xffffffff : 0;
   }
+#endif
 }
 
 BX_CPP_INLINE Bit32u xmm_pcmpeqd_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  return xmm_movemask_d(_mm_cmpeq_epi32(a, b));
+#else
   Bit32u mask = 0;
   for(unsigned n=0; n<4; n++) {
     if (op1->xmm32u(n) == op2->xmm32u(n)) mask |= (1 << n);
   }
   return mask;
+#endif
 }
 
 BX_CPP_INLINE void xmm_pcmpeqq(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE4_1
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  xmm_store(op1, _mm_cmpeq_epi64(a, b));
+#else
   for(unsigned n=0; n<2; n++) {
     op1->xmm64u(n) = (op1->xmm64u(n) == op2->xmm64u(n)) ? BX_CONST64(0xffffffffffffffff) : 0;
   }
+#endif
 }
 
 BX_CPP_INLINE Bit32u xmm_pcmpeqq_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE4_1
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  return xmm_movemask_q(_mm_cmpeq_epi64(a, b));
+#else
   Bit32u mask = 0;
   for(unsigned n=0; n<2; n++) {
     if (op1->xmm64u(n) == op2->xmm64u(n)) mask |= (1 << n);
   }
   return mask;
+#endif
 }
 
 // compare not equal
 
 BX_CPP_INLINE void xmm_pcmpneb(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  xmm_store(op1, _mm_xor_si128(_mm_cmpeq_epi8(a, b), _mm_cmpeq_epi32(a, a)));
+#else
   for(unsigned n=0; n<16; n++) {
     op1->xmmubyte(n) = (op1->xmmubyte(n) != op2->xmmubyte(n)) ? 0xff : 0;
   }
+#endif
 }
 
 BX_CPP_INLINE Bit32u xmm_pcmpneb_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  return 0xffff ^ _mm_movemask_epi8(_mm_cmpeq_epi8(a, b));
+#else
   Bit32u mask = 0;
   for(unsigned n=0; n<16; n++) {
     if (op1->xmmubyte(n) != op2->xmmubyte(n)) mask |= (1 << n);
   }
   return mask;
+#endif
 }
 
 BX_CPP_INLINE void xmm_pcmpnew(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  xmm_store(op1, _mm_xor_si128(_mm_cmpeq_epi16(a, b), _mm_cmpeq_epi32(a, a)));
+#else
   for(unsigned n=0; n<8; n++) {
     op1->xmm16u(n) = (op1->xmm16u(n) != op2->xmm16u(n)) ? 0xffff : 0;
   }
+#endif
 }
 
 BX_CPP_INLINE Bit32u xmm_pcmpnew_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  return 0xff ^ xmm_movemask_w(_mm_cmpeq_epi16(a, b));
+#else
   Bit32u mask = 0;
   for(unsigned n=0; n<8; n++) {
     if (op1->xmm16u(n) != op2->xmm16u(n)) mask |= (1 << n);
   }
   return mask;
+#endif
 }
 
 BX_CPP_INLINE void xmm_pcmpned(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  xmm_store(op1, _mm_xor_si128(_mm_cmpeq_epi32(a, b), _mm_cmpeq_epi32(a, a)));
+#else
   for(unsigned n=0; n<4; n++) {
     op1->xmm32u(n) = (op1->xmm32u(n) != op2->xmm32u(n)) ? 0xffffffff : 0;
   }
+#endif
 }
 
 BX_CPP_INLINE Bit32u xmm_pcmpned_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  return 0xf ^ xmm_movemask_d(_mm_cmpeq_epi32(a, b));
+#else
   Bit32u mask = 0;
   for(unsigned n=0; n<4; n++) {
     if (op1->xmm32u(n) != op2->xmm32u(n)) mask |= (1 << n);
   }
   return mask;
+#endif
 }
 
 BX_CPP_INLINE void xmm_pcmpneq(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE4_1
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  xmm_store(op1, _mm_xor_si128(_mm_cmpeq_epi64(a, b), _mm_cmpeq_epi32(a, a)));
+#else
   for(unsigned n=0; n<2; n++) {
     op1->xmm64u(n) = (op1->xmm64u(n) != op2->xmm64u(n)) ? BX_CONST64(0xffffffffffffffff) : 0;
   }
+#endif
 }
 
 BX_CPP_INLINE Bit32u xmm_pcmpneq_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE4_1
+  __m128i a = xmm_load(op1), b = xmm_load(op2);
+  return 0x3 ^ xmm_movemask_q(_mm_cmpeq_epi64(a, b));
+#else
   Bit32u mask = 0;
   for(unsigned n=0; n<2; n++) {
     if (op1->xmm64u(n) != op2->xmm64u(n)) mask |= (1 << n);
   }
   return mask;
+#endif
 }
 
 // compare true/false
@@ -729,29 +931,44 @@ BX_CPP_INLINE Bit32u xmm_pcmpfalse_mask(const BxPackedXmmRegister *op1, const Bx
 
 BX_CPP_INLINE Bit32u xmm_ptestmb_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i zero = _mm_setzero_si128();
+  return 0xffff ^ _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(xmm_load(op1), xmm_load(op2)), zero));
+#else
   Bit32u mask = 0;
   for(unsigned n=0; n<16; n++) {
     if ((op1->xmmubyte(n) & op2->xmmubyte(n)) != 0) mask |= (1 << n);
   }
   return mask;
+#endif
 }
 
 BX_CPP_INLINE Bit32u xmm_ptestmw_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i zero = _mm_setzero_si128();
+  return 0xff ^ xmm_movemask_w(_mm_cmpeq_epi16(_mm_and_si128(xmm_load(op1), xmm_load(op2)), zero));
+#else
   Bit32u mask = 0;
   for(unsigned n=0; n<8; n++) {
     if ((op1->xmm16u(n) & op2->xmm16u(n)) != 0) mask |= (1 << n);
   }
   return mask;
+#endif
 }
 
 BX_CPP_INLINE Bit32u xmm_ptestmd_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i zero = _mm_setzero_si128();
+  return 0xf ^ xmm_movemask_d(_mm_cmpeq_epi32(_mm_and_si128(xmm_load(op1), xmm_load(op2)), zero));
+#else
   Bit32u mask = 0;
   for(unsigned n=0; n<4; n++) {
     if ((op1->xmm32u(n) & op2->xmm32u(n)) != 0) mask |= (1 << n);
   }
   return mask;
+#endif
 }
 
 BX_CPP_INLINE Bit32u xmm_ptestmq_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
@@ -765,29 +982,44 @@ BX_CPP_INLINE Bit32u xmm_ptestmq_mask(const BxPackedXmmRegister *op1, const BxPa
 
 BX_CPP_INLINE Bit32u xmm_ptestnmb_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i zero = _mm_setzero_si128();
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(xmm_load(op1), xmm_load(op2)), zero));
+#else
   Bit32u mask = 0;
   for(unsigned n=0; n<16; n++) {
     if ((op1->xmmubyte(n) & op2->xmmubyte(n)) == 0) mask |= (1 << n);
   }
   return mask;
+#endif
 }
 
 BX_CPP_INLINE Bit32u xmm_ptestnmw_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i zero = _mm_setzero_si128();
+  return xmm_movemask_w(_mm_cmpeq_epi16(_mm_and_si128(xmm_load(op1), xmm_load(op2)), zero));
+#else
   Bit32u mask = 0;
   for(unsigned n=0; n<8; n++) {
     if ((op1->xmm16u(n) & op2->xmm16u(n)) == 0) mask |= (1 << n);
   }
   return mask;
+#endif
 }
 
 BX_CPP_INLINE Bit32u xmm_ptestnmd_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i zero = _mm_setzero_si128();
+  return xmm_movemask_d(_mm_cmpeq_epi32(_mm_and_si128(xmm_load(op1), xmm_load(op2)), zero));
+#else
   Bit32u mask = 0;
   for(unsigned n=0; n<4; n++) {
     if ((op1->xmm32u(n) & op2->xmm32u(n)) == 0) mask |= (1 << n);
   }
   return mask;
+#endif
 }
 
 BX_CPP_INLINE Bit32u xmm_ptestnmq_mask(const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
@@ -0,0 +1,114 @@
+/////////////////////////////////////////////////////////////////////////
+// $Id$
+/////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (C) 2026  The Bochs Project
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA B 02110-1301 USA
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef BX_SIMD_HOST_FUNCTIONS_H
+#define BX_SIMD_HOST_FUNCTIONS_H
+
+// Host SIMD implementation of the packed integer helpers (--enable-host-simd)
+//
+// On x86 hosts the helpers of simd_int.h and simd_compare.h which have an
+// exact host instruction counterpart are implemented with the compiler
+// intrinsics instead of the per element loops, the loops remain for all
+// other hosts and for the helpers without a counterpart.
+//
+// The helpers are inlined into every instruction handler, so the host
+// instruction set is selected at compile time from the compiler target:
+// SSE2 is part of every x86-64 host, the SSSE3, SSE4.1 and SSE4.2 versions
+// are used when the compiler is allowed to generate them (for example with
+// CXXFLAGS="-O3 -march=native").
+
+#if BX_SUPPORT_HOST_SIMD
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define BX_HOST_SSE2 1
+  #include <emmintrin.h>
+#endif
+
+#if defined(BX_HOST_SSE2) && (defined(__SSSE3__) || defined(__AVX__))
+  #define BX_HOST_SSSE3 1
+  #include <tmmintrin.h>
+#endif
+
+#if defined(BX_HOST_SSE2) && (defined(__SSE4_1__) || defined(__AVX__))
+  #define BX_HOST_SSE4_1 1
+  #include <smmintrin.h>
+#endif
+
+#if defined(BX_HOST_SSE2) && (defined(__SSE4_2__) || defined(__AVX__))
+  #define BX_HOST_SSE4_2 1
+  #include <nmmintrin.h>
+#endif
+
+#endif // BX_SUPPORT_HOST_SIMD
+
+#ifndef BX_HOST_SSE2
+  #define BX_HOST_SSE2 0
+#endif
+#ifndef BX_HOST_SSSE3
+  #define BX_HOST_SSSE3 0
+#endif
+#ifndef BX_HOST_SSE4_1
+  #define BX_HOST_SSE4_1 0
+#endif
+#ifndef BX_HOST_SSE4_2
+  #define BX_HOST_SSE4_2 0
+#endif
+
+#if BX_HOST_SSE2
+
+// the guest registers are not necessarily 16-byte aligned in host memory
+
+BX_CPP_INLINE __m128i xmm_load(const BxPackedXmmRegister *op)
+{
+  return _mm_loadu_si128((const __m128i *) op);
+}
+
+BX_CPP_INLINE void xmm_store(BxPackedXmmRegister *op, __m128i val)
+{
+  _mm_storeu_si128((__m128i *) op, val);
+}
+
+// shift count operand of the host shift instructions
+BX_CPP_INLINE __m128i xmm_shift_count(Bit64u shift_64)
+{
+  return _mm_loadl_epi64((const __m128i *) &shift_64);
+}
+
+BX_CPP_INLINE Bit32u xmm_movemask_w(__m128i val)
+{
+  // signed saturation keeps the sign of every word
+  return _mm_movemask_epi8(_mm_packs_epi16(val, _mm_setzero_si128()));
+}
+
+BX_CPP_INLINE Bit32u xmm_movemask_d(__m128i val)
+{
+  return _mm_movemask_ps(_mm_castsi128_ps(val));
+}
+
+BX_CPP_INLINE Bit32u xmm_movemask_q(__m128i val)
+{
+  return _mm_movemask_pd(_mm_castsi128_pd(val));
+}
+
+#endif
+
+#endif
@@ -989,4 +989,7 @@ BX_CPP_INLINE void xmm_scalefph_mask(BxPackedXmmRegister *op1, const BxPackedXmm
   }
 }
 
+// host FPU fast path of the helpers above
+#include "simd_pfp_host.h"
+
 #endif
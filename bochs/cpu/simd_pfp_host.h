@@ -0,0 +1,537 @@
+/////////////////////////////////////////////////////////////////////////
+// $Id$
+/////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (C) 2026  The Bochs Project
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA B 02110-1301 USA
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef BX_SIMD_PFP_HOST_FUNCTIONS_H
+#define BX_SIMD_PFP_HOST_FUNCTIONS_H
+
+// Host FPU fast path of the SSE/AVX floating point arithmetic (--enable-host-fpu)
+//
+// The precision exception flag is sticky. Once the guest has it set and
+// masked, a rounding to nearest add, sub, mul, div, sqrt or fused
+// multiply-add of normal (or zero) operands with a normal result which is
+// not close to the underflow threshold cannot change MXCSR or raise an
+// exception, and the host computes the same correctly rounded result as
+// softfloat. Such operations are executed with host floating point, every
+// other case (NaN, infinity or denormal operands, overflow, underflow,
+// division by zero, directed rounding, precision exception still clear or
+// unmasked) is emulated element by element with softfloat.
+//
+// The host must evaluate float and double expressions in their own
+// precision (FLT_EVAL_METHOD == 0, e.g. SSE2 math), x87 extended precision
+// would round twice. The fused multiply-add uses the host fma() only when
+// the compiler maps it to a host instruction (FP_FAST_FMA).
+//
+// Every host_xxx helper below is a drop-in replacement of the softfloat
+// function or simd_pfp.h helper given as template argument, without a host
+// implementation it just calls the softfloat version.
+
+#if BX_SUPPORT_HOST_FPU
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#if defined(FLT_EVAL_METHOD) && (FLT_EVAL_METHOD == 0)
+  #define BX_HOST_FPU 1
+#endif
+
+#if defined(BX_HOST_FPU) && defined(FP_FAST_FMAF) && defined(FP_FAST_FMA)
+  #define BX_HOST_FPU_FMA 1
+#endif
+
+#endif // BX_SUPPORT_HOST_FPU
+
+#ifndef BX_HOST_FPU
+  #define BX_HOST_FPU 0
+#endif
+#ifndef BX_HOST_FPU_FMA
+  #define BX_HOST_FPU_FMA 0
+#endif
+
+// round to nearest with the precision exception masked and already signalled
+BX_CPP_INLINE bool host_fpu_ok(const softfloat_status_t &status, bx_mxcsr_t mxcsr)
+{
+#if BX_HOST_FPU
+  return status.softfloat_roundingMode == softfloat_round_near_even && mxcsr.get_PE() && mxcsr.get_PM();
+#else
+  return false;
+#endif
+}
+
+template <float32 (*func)(float32, softfloat_status_t *)>
+BX_CPP_INLINE float32 host_f32_1op(float32 a, softfloat_status_t *status) { return (func)(a, status); }
+template <float32 (*func)(float32, float32, softfloat_status_t *)>
+BX_CPP_INLINE float32 host_f32_2op(float32 a, float32 b, softfloat_status_t *status) { return (func)(a, b, status); }
+template <float32 (*func)(float32, float32, float32, softfloat_status_t *)>
+BX_CPP_INLINE float32 host_f32_3op(float32 a, float32 b, float32 c, softfloat_status_t *status) { return (func)(a, b, c, status); }
+
+template <float64 (*func)(float64, softfloat_status_t *)>
+BX_CPP_INLINE float64 host_f64_1op(float64 a, softfloat_status_t *status) { return (func)(a, status); }
+template <float64 (*func)(float64, float64, softfloat_status_t *)>
+BX_CPP_INLINE float64 host_f64_2op(float64 a, float64 b, softfloat_status_t *status) { return (func)(a, b, status); }
+template <float64 (*func)(float64, float64, float64, softfloat_status_t *)>
+BX_CPP_INLINE float64 host_f64_3op(float64 a, float64 b, float64 c, softfloat_status_t *status) { return (func)(a, b, c, status); }
+
+template <xmm_pfp_1op func>
+BX_CPP_INLINE void host_xmm_pfp_1op(BxPackedXmmRegister *op, softfloat_status_t &status) { (func)(op, status); }
+template <xmm_pfp_2op func>
+BX_CPP_INLINE void host_xmm_pfp_2op(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, softfloat_status_t &status) { (func)(op1, op2, status); }
+template <xmm_pfp_3op func>
+BX_CPP_INLINE void host_xmm_pfp_3op(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, const BxPackedXmmRegister *op3, softfloat_status_t &status) { (func)(op1, op2, op3, status); }
+
+#if BX_HOST_FPU
+
+BX_CPP_INLINE float host_float(float32 a)
+{
+  float f;
+  memcpy(&f, &a, sizeof(f));
+  return f;
+}
+
+BX_CPP_INLINE float32 host_float32(float f)
+{
+  float32 a;
+  memcpy(&a, &f, sizeof(a));
+  return a;
+}
+
+BX_CPP_INLINE double host_double(float64 a)
+{
+  double d;
+  memcpy(&d, &a, sizeof(d));
+  return d;
+}
+
+BX_CPP_INLINE float64 host_float64(double d)
+{
+  float64 a;
+  memcpy(&a, &d, sizeof(a));
+  return a;
+}
+
+BX_CPP_INLINE bool host_f32_is_zero(float32 a) { return (Bit32u)(a << 1) == 0; }
+BX_CPP_INLINE bool host_f64_is_zero(float64 a) { return (Bit64u)(a << 1) == 0; }
+
+// no NaN, infinity or denormal (the host would also take a slow microcode assist on it)
+BX_CPP_INLINE bool host_f32_operand_ok(float32 a)
+{
+  return (((a >> 23) & 0xff) - 1) < 0xfe || host_f32_is_zero(a);
+}
+
+BX_CPP_INLINE bool host_f64_operand_ok(float64 a)
+{
+  return (((a >> 52) & 0x7ff) - 1) < 0x7fe || host_f64_is_zero(a);
+}
+
+// finite, and at least twice the smallest normal so no underflow was possible before rounding
+BX_CPP_INLINE bool host_f32_result_ok(float32 r)
+{
+  return (((r >> 23) & 0xff) - 2) < 0xfd;
+}
+
+BX_CPP_INLINE bool host_f64_result_ok(float64 r)
+{
+  return (((r >> 52) & 0x7ff) - 2) < 0x7fd;
+}
+
+// single precision
+
+// exact cancellation gives +0 in round to nearest, same as softfloat
+template <>
+BX_CPP_INLINE float32 host_f32_2op<f32_add>(float32 a, float32 b, softfloat_status_t *status)
+{
+  if (! host_f32_operand_ok(a) || ! host_f32_operand_ok(b))
+    return f32_add(a, b, status);
+
+  float32 r = host_float32(host_float(a) + host_float(b));
+  if (host_f32_result_ok(r) || host_f32_is_zero(r))
+    return r;
+
+  return f32_add(a, b, status);
+}
+
+template <>
+BX_CPP_INLINE float32 host_f32_2op<f32_sub>(float32 a, float32 b, softfloat_status_t *status)
+{
+  if (! host_f32_operand_ok(a) || ! host_f32_operand_ok(b))
+    return f32_sub(a, b, status);
+
+  float32 r = host_float32(host_float(a) - host_float(b));
+  if (host_f32_result_ok(r) || host_f32_is_zero(r))
+    return r;
+
+  return f32_sub(a, b, status);
+}
+
+template <>
+BX_CPP_INLINE float32 host_f32_2op<f32_mul>(float32 a, float32 b, softfloat_status_t *status)
+{
+  if (! host_f32_operand_ok(a) || ! host_f32_operand_ok(b))
+    return f32_mul(a, b, status);
+
+  float32 r = host_float32(host_float(a) * host_float(b));
+  if (host_f32_result_ok(r) || (host_f32_is_zero(a) || host_f32_is_zero(b)))
+    return r;
+
+  return f32_mul(a, b, status);
+}
+
+// division by zero is left to softfloat
+template <>
+BX_CPP_INLINE float32 host_f32_2op<f32_div>(float32 a, float32 b, softfloat_status_t *status)
+{
+  if (! host_f32_operand_ok(a) || ! host_f32_operand_ok(b) || host_f32_is_zero(b))
+    return f32_div(a, b, status);
+
+  float32 r = host_float32(host_float(a) / host_float(b));
+  if (host_f32_result_ok(r) || host_f32_is_zero(a))
+    return r;
+
+  return f32_div(a, b, status);
+}
+
+// sqrt of a negative operand (other than -0) is invalid
+template <>
+BX_CPP_INLINE float32 host_f32_1op<f32_sqrt>(float32 a, softfloat_status_t *status)
+{
+  if (! host_f32_operand_ok(a) || ((a >> 31) != 0 && ! host_f32_is_zero(a)))
+    return f32_sqrt(a, status);
+
+  float32 r = host_float32(sqrtf(host_float(a)));
+  if (host_f32_result_ok(r) || host_f32_is_zero(a))
+    return r;
+
+  return f32_sqrt(a, status);
+}
+
+// double precision
+
+template <>
+BX_CPP_INLINE float64 host_f64_2op<f64_add>(float64 a, float64 b, softfloat_status_t *status)
+{
+  if (! host_f64_operand_ok(a) || ! host_f64_operand_ok(b))
+    return f64_add(a, b, status);
+
+  float64 r = host_float64(host_double(a) + host_double(b));
+  if (host_f64_result_ok(r) || host_f64_is_zero(r))
+    return r;
+
+  return f64_add(a, b, status);
+}
+
+template <>
+BX_CPP_INLINE float64 host_f64_2op<f64_sub>(float64 a, float64 b, softfloat_status_t *status)
+{
+  if (! host_f64_operand_ok(a) || ! host_f64_operand_ok(b))
+    return f64_sub(a, b, status);
+
+  float64 r = host_float64(host_double(a) - host_double(b));
+  if (host_f64_result_ok(r) || host_f64_is_zero(r))
+    return r;
+
+  return f64_sub(a, b, status);
+}
+
+template <>
+BX_CPP_INLINE float64 host_f64_2op<f64_mul>(float64 a, float64 b, softfloat_status_t *status)
+{
+  if (! host_f64_operand_ok(a) || ! host_f64_operand_ok(b))
+    return f64_mul(a, b, status);
+
+  float64 r = host_float64(host_double(a) * host_double(b));
+  if (host_f64_result_ok(r) || (host_f64_is_zero(a) || host_f64_is_zero(b)))
+    return r;
+
+  return f64_mul(a, b, status);
+}
+
+template <>
+BX_CPP_INLINE float64 host_f64_2op<f64_div>(float64 a, float64 b, softfloat_status_t *status)
+{
+  if (! host_f64_operand_ok(a) || ! host_f64_operand_ok(b) || host_f64_is_zero(b))
+    return f64_div(a, b, status);
+
+  float64 r = host_float64(host_double(a) / host_double(b));
+  if (host_f64_result_ok(r) || host_f64_is_zero(a))
+    return r;
+
+  return f64_div(a, b, status);
+}
+
+template <>
+BX_CPP_INLINE float64 host_f64_1op<f64_sqrt>(float64 a, softfloat_status_t *status)
+{
+  if (! host_f64_operand_ok(a) || ((a >> 63) != 0 && ! host_f64_is_zero(a)))
+    return f64_sqrt(a, status);
+
+  float64 r = host_float64(sqrt(host_double(a)));
+  if (host_f64_result_ok(r) || host_f64_is_zero(a))
+    return r;
+
+  return f64_sqrt(a, status);
+}
+
+#if BX_HOST_FPU_FMA
+
+// zero results of the fused multiply-add are left to softfloat for the sign rules
+
+template <>
+BX_CPP_INLINE float32 host_f32_3op<f32_fmadd>(float32 a, float32 b, float32 c, softfloat_status_t *status)
+{
+  if (! host_f32_operand_ok(a) || ! host_f32_operand_ok(b) || ! host_f32_operand_ok(c))
+    return f32_fmadd(a, b, c, status);
+
+  float32 r = host_float32(fmaf(host_float(a), host_float(b), host_float(c)));
+  if (host_f32_result_ok(r))
+    return r;
+
+  return f32_fmadd(a, b, c, status);
+}
+
+template <>
+BX_CPP_INLINE float32 host_f32_3op<f32_fmsub>(float32 a, float32 b, float32 c, softfloat_status_t *status)
+{
+  if (! host_f32_operand_ok(a) || ! host_f32_operand_ok(b) || ! host_f32_operand_ok(c))
+    return f32_fmsub(a, b, c, status);
+
+  float32 r = host_float32(fmaf(host_float(a), host_float(b), -host_float(c)));
+  if (host_f32_result_ok(r))
+    return r;
+
+  return f32_fmsub(a, b, c, status);
+}
+
+template <>
+BX_CPP_INLINE float32 host_f32_3op<f32_fnmadd>(float32 a, float32 b, float32 c, softfloat_status_t *status)
+{
+  if (! host_f32_operand_ok(a) || ! host_f32_operand_ok(b) || ! host_f32_operand_ok(c))
+    return f32_fnmadd(a, b, c, status);
+
+  float32 r = host_float32(fmaf(-host_float(a), host_float(b), host_float(c)));
+  if (host_f32_result_ok(r))
+    return r;
+
+  return f32_fnmadd(a, b, c, status);
+}
+
+template <>
+BX_CPP_INLINE float32 host_f32_3op<f32_fnmsub>(float32 a, float32 b, float32 c, softfloat_status_t *status)
+{
+  if (! host_f32_operand_ok(a) || ! host_f32_operand_ok(b) || ! host_f32_operand_ok(c))
+    return f32_fnmsub(a, b, c, status);
+
+  float32 r = host_float32(-fmaf(host_float(a), host_float(b), host_float(c)));
+  if (host_f32_result_ok(r))
+    return r;
+
+  return f32_fnmsub(a, b, c, status);
+}
+
+template <>
+BX_CPP_INLINE float64 host_f64_3op<f64_fmadd>(float64 a, float64 b, float64 c, softfloat_status_t *status)
+{
+  if (! host_f64_operand_ok(a) || ! host_f64_operand_ok(b) || ! host_f64_operand_ok(c))
+    return f64_fmadd(a, b, c, status);
+
+  float64 r = host_float64(fma(host_double(a), host_double(b), host_double(c)));
+  if (host_f64_result_ok(r))
+    return r;
+
+  return f64_fmadd(a, b, c, status);
+}
+
+template <>
+BX_CPP_INLINE float64 host_f64_3op<f64_fmsub>(float64 a, float64 b, float64 c, softfloat_status_t *status)
+{
+  if (! host_f64_operand_ok(a) || ! host_f64_operand_ok(b) || ! host_f64_operand_ok(c))
+    return f64_fmsub(a, b, c, status);
+
+  float64 r = host_float64(fma(host_double(a), host_double(b), -host_double(c)));
+  if (host_f64_result_ok(r))
+    return r;
+
+  return f64_fmsub(a, b, c, status);
+}
+
+template <>
+BX_CPP_INLINE float64 host_f64_3op<f64_fnmadd>(float64 a, float64 b, float64 c, softfloat_status_t *status)
+{
+  if (! host_f64_operand_ok(a) || ! host_f64_operand_ok(b) || ! host_f64_operand_ok(c))
+    return f64_fnmadd(a, b, c, status);
+
+  float64 r = host_float64(fma(-host_double(a), host_double(b), host_double(c)));
+  if (host_f64_result_ok(r))
+    return r;
+
+  return f64_fnmadd(a, b, c, status);
+}
+
+template <>
+BX_CPP_INLINE float64 host_f64_3op<f64_fnmsub>(float64 a, float64 b, float64 c, softfloat_status_t *status)
+{
+  if (! host_f64_operand_ok(a) || ! host_f64_operand_ok(b) || ! host_f64_operand_ok(c))
+    return f64_fnmsub(a, b, c, status);
+
+  float64 r = host_float64(-fma(host_double(a), host_double(b), host_double(c)));
+  if (host_f64_result_ok(r))
+    return r;
+
+  return f64_fnmsub(a, b, c, status);
+}
+
+#endif // BX_HOST_FPU_FMA
+
+// packed helpers of simd_pfp.h, elements which cannot use the host fall back one by one
+
+template <>
+BX_CPP_INLINE void host_xmm_pfp_2op<xmm_addps>(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, softfloat_status_t &status)
+{
+  for (unsigned n=0;n<4;n++)
+    op1->xmm32u(n) = host_f32_2op<f32_add>(op1->xmm32u(n), op2->xmm32u(n), &status);
+}
+
+template <>
+BX_CPP_INLINE void host_xmm_pfp_2op<xmm_addpd>(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, softfloat_status_t &status)
+{
+  for (unsigned n=0;n<2;n++)
+    op1->xmm64u(n) = host_f64_2op<f64_add>(op1->xmm64u(n), op2->xmm64u(n), &status);
+}
+
+template <>
+BX_CPP_INLINE void host_xmm_pfp_2op<xmm_subps>(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, softfloat_status_t &status)
+{
+  for (unsigned n=0;n<4;n++)
+    op1->xmm32u(n) = host_f32_2op<f32_sub>(op1->xmm32u(n), op2->xmm32u(n), &status);
+}
+
+template <>
+BX_CPP_INLINE void host_xmm_pfp_2op<xmm_subpd>(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, softfloat_status_t &status)
+{
+  for (unsigned n=0;n<2;n++)
+    op1->xmm64u(n) = host_f64_2op<f64_sub>(op1->xmm64u(n), op2->xmm64u(n), &status);
+}
+
+template <>
+BX_CPP_INLINE void host_xmm_pfp_2op<xmm_mulps>(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, softfloat_status_t &status)
+{
+  for (unsigned n=0;n<4;n++)
+    op1->xmm32u(n) = host_f32_2op<f32_mul>(op1->xmm32u(n), op2->xmm32u(n), &status);
+}
+
+template <>
+BX_CPP_INLINE void host_xmm_pfp_2op<xmm_mulpd>(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, softfloat_status_t &status)
+{
+  for (unsigned n=0;n<2;n++)
+    op1->xmm64u(n) = host_f64_2op<f64_mul>(op1->xmm64u(n), op2->xmm64u(n), &status);
+}
+
+template <>
+BX_CPP_INLINE void host_xmm_pfp_2op<xmm_divps>(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, softfloat_status_t &status)
+{
+  for (unsigned n=0;n<4;n++)
+    op1->xmm32u(n) = host_f32_2op<f32_div>(op1->xmm32u(n), op2->xmm32u(n), &status);
+}
+
+template <>
+BX_CPP_INLINE void host_xmm_pfp_2op<xmm_divpd>(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, softfloat_status_t &status)
+{
+  for (unsigned n=0;n<2;n++)
+    op1->xmm64u(n) = host_f64_2op<f64_div>(op1->xmm64u(n), op2->xmm64u(n), &status);
+}
+
+template <>
+BX_CPP_INLINE void host_xmm_pfp_1op<xmm_sqrtps>(BxPackedXmmRegister *op, softfloat_status_t &status)
+{
+  for (unsigned n=0;n<4;n++)
+    op->xmm32u(n) = host_f32_1op<f32_sqrt>(op->xmm32u(n), &status);
+}
+
+template <>
+BX_CPP_INLINE void host_xmm_pfp_1op<xmm_sqrtpd>(BxPackedXmmRegister *op, softfloat_status_t &status)
+{
+  for (unsigned n=0;n<2;n++)
+    op->xmm64u(n) = host_f64_1op<f64_sqrt>(op->xmm64u(n), &status);
+}
+
+#if BX_HOST_FPU_FMA
+
+template <>
+BX_CPP_INLINE void host_xmm_pfp_3op<xmm_fmaddps>(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, const BxPackedXmmRegister *op3, softfloat_status_t &status)
+{
+  for (unsigned n=0;n<4;n++)
+    op1->xmm32u(n) = host_f32_3op<f32_fmadd>(op1->xmm32u(n), op2->xmm32u(n), op3->xmm32u(n), &status);
+}
+
+template <>
+BX_CPP_INLINE void host_xmm_pfp_3op<xmm_fmaddpd>(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, const BxPackedXmmRegister *op3, softfloat_status_t &status)
+{
+  for (unsigned n=0;n<2;n++)
+    op1->xmm64u(n) = host_f64_3op<f64_fmadd>(op1->xmm64u(n), op2->xmm64u(n), op3->xmm64u(n), &status);
+}
+
+template <>
+BX_CPP_INLINE void host_xmm_pfp_3op<xmm_fmsubps>(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, const BxPackedXmmRegister *op3, softfloat_status_t &status)
+{
+  for (unsigned n=0;n<4;n++)
+    op1->xmm32u(n) = host_f32_3op<f32_fmsub>(op1->xmm32u(n), op2->xmm32u(n), op3->xmm32u(n), &status);
+}
+
+template <>
+BX_CPP_INLINE void host_xmm_pfp_3op<xmm_fmsubpd>(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, const BxPackedXmmRegister *op3, softfloat_status_t &status)
+{
+  for (unsigned n=0;n<2;n++)
+    op1->xmm64u(n) = host_f64_3op<f64_fmsub>(op1->xmm64u(n), op2->xmm64u(n), op3->xmm64u(n), &status);
+}
+
+template <>
+BX_CPP_INLINE void host_xmm_pfp_3op<xmm_fnmaddps>(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, const BxPackedXmmRegister *op3, softfloat_status_t &status)
+{
+  for (unsigned n=0;n<4;n++)
+    op1->xmm32u(n) = host_f32_3op<f32_fnmadd>(op1->xmm32u(n), op2->xmm32u(n), op3->xmm32u(n), &status);
+}
+
+template <>
+BX_CPP_INLINE void host_xmm_pfp_3op<xmm_fnmaddpd>(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, const BxPackedXmmRegister *op3, softfloat_status_t &status)
+{
+  for (unsigned n=0;n<2;n++)
+    op1->xmm64u(n) = host_f64_3op<f64_fnmadd>(op1->xmm64u(n), op2->xmm64u(n), op3->xmm64u(n), &status);
+}
+
+template <>
+BX_CPP_INLINE void host_xmm_pfp_3op<xmm_fnmsubps>(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, const BxPackedXmmRegister *op3, softfloat_status_t &status)
+{
+  for (unsigned n=0;n<4;n++)
+    op1->xmm32u(n) = host_f32_3op<f32_fnmsub>(op1->xmm32u(n), op2->xmm32u(n), op3->xmm32u(n), &status);
+}
+
+template <>
+BX_CPP_INLINE void host_xmm_pfp_3op<xmm_fnmsubpd>(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, const BxPackedXmmRegister *op3, softfloat_status_t &status)
+{
+  for (unsigned n=0;n<2;n++)
+    op1->xmm64u(n) = host_f64_3op<f64_fnmsub>(op1->xmm64u(n), op2->xmm64u(n), op3->xmm64u(n), &status);
+}
+
+#endif // BX_HOST_FPU_FMA
+
+#endif // BX_HOST_FPU
+
+#endif
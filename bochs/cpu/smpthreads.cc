@@ -0,0 +1,625 @@
+/////////////////////////////////////////////////////////////////////////
+// $Id$
+/////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (C) 2026  The Bochs Project
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA B 02110-1301 USA
+//
+/////////////////////////////////////////////////////////////////////////
+
+#define NEED_CPU_REG_SHORTCUTS 1
+#include "bochs.h"
+#include "cpu.h"
+#define LOG_THIS BX_CPU_THIS_PTR
+
+#if BX_SUPPORT_SMP
+
+#include "gui/siminterface.h"
+#include "param_names.h"
+#include "apic.h"
+#include "iodev/iodev.h"
+#include "cpustats.h"
+
+// longjmp() value used to execute the current instruction again
+#define BX_SMP_RESTART_INSTRUCTION 2
+
+// upper limit for the length of a round, in instructions
+#define BX_SMP_MAX_ROUND_LENGTH (1024*1024)
+
+// busy wait iterations before a waiting CPU thread yields the host CPU
+#define BX_SMP_WAIT_SPINS 256
+
+volatile bool bx_smp_threads_running = false;
+thread_local unsigned bx_smp_thread_cpu = BX_SMP_NO_CPU;
+
+//////////////////////////
+// big emulator lock
+//////////////////////////
+
+static BX_MUTEX(bx_smp_device_mutex);
+static thread_local unsigned bx_smp_device_lock_depth = 0;
+
+void bx_smp_device_lock(void)
+{
+  if (bx_smp_device_lock_depth++ == 0) {
+    BX_LOCK(bx_smp_device_mutex);
+  }
+}
+
+void bx_smp_device_unlock(void)
+{
+  if (--bx_smp_device_lock_depth == 0) {
+    BX_UNLOCK(bx_smp_device_mutex);
+  }
+}
+
+// exception or VMEXIT could longjmp out of the locked region
+static void bx_smp_device_lock_release(void)
+{
+  if (bx_smp_device_lock_depth) {
+    bx_smp_device_lock_depth = 0;
+    BX_UNLOCK(bx_smp_device_mutex);
+  }
+}
+
+//////////////////////////
+// CPU request queue
+//////////////////////////
+
+bx_smp_request_queue_c::bx_smp_request_queue_c():
+  has_requests(false), queue(NULL), taken(NULL), count(0), size(0), taken_size(0)
+{
+  BX_INIT_MUTEX(lock);
+}
+
+bx_smp_request_queue_c::~bx_smp_request_queue_c()
+{
+  BX_FINI_MUTEX(lock);
+  delete [] queue;
+  delete [] taken;
+}
+
+void bx_smp_request_queue_c::post(unsigned type, Bit32u data, Bit64u addr)
+{
+  BX_LOCK(lock);
+  if (count == size) {
+    unsigned new_size = size ? size*2 : 16;
+    bx_smp_request_t *new_queue = new bx_smp_request_t[new_size];
+    if (count)
+      memcpy(new_queue, queue, count * sizeof(bx_smp_request_t));
+    delete [] queue;
+    queue = new_queue;
+    size = new_size;
+  }
+  queue[count].type = type;
+  queue[count].data = data;
+  queue[count].addr = addr;
+  count++;
+  has_requests = true;
+  BX_UNLOCK(lock);
+}
+
+unsigned bx_smp_request_queue_c::fetch(bx_smp_request_t **requests)
+{
+  BX_LOCK(lock);
+  bx_smp_request_t *tmp = taken;
+  taken = queue;
+  queue = tmp;
+  unsigned tmp_size = taken_size;
+  taken_size = size;
+  size = tmp_size;
+  unsigned n = count;
+  count = 0;
+  has_requests = false;
+  BX_UNLOCK(lock);
+
+  *requests = taken;
+  return n;
+}
+
+//////////////////////////
+// rounds
+//////////////////////////
+
+struct bx_smp_cpu_thread_t {
+  BX_THREAD_VAR(thread);
+  bx_thread_sem_t start;      // next round was started
+  bx_thread_sem_t wakeup;     // parked CPU got a request or the round is over
+  unsigned id;
+  bool in_round;
+  Bit64u round_start;         // icount when the CPU entered the round
+  bool parked;
+  bool round_over;
+  volatile Bit32u trace_seq;  // odd while the CPU executes a trace
+  Bit32u *wait_seq;           // traces of other CPUs executing invalidated code
+  bool wait_pending;
+};
+
+static struct {
+  BX_MUTEX(lock);
+  bx_thread_sem_t done;       // all CPUs left the round
+  bx_smp_cpu_thread_t *cpu;
+  unsigned active;            // CPUs still executing the current round
+  Bit32u length;              // instructions each CPU executes in the round
+  volatile bool stop;         // leave the round as soon as possible
+  bool quit;
+  bool reset_request;
+  unsigned reset_type;
+} bx_smp;
+
+// called with bx_smp.lock held by the CPU thread which left the round last
+static void bx_smp_end_round(void)
+{
+  for (unsigned n=0; n < BX_SMP_PROCESSORS; n++) {
+    bx_smp_cpu_thread_t *t = &bx_smp.cpu[n];
+    if (t->parked) {
+      t->parked = false;
+      t->round_over = true;
+      bx_set_sem(&t->wakeup);
+    }
+  }
+
+  bx_set_sem(&bx_smp.done);
+}
+
+static void bx_smp_leave_round(bx_smp_cpu_thread_t *t)
+{
+  BX_LOCK(bx_smp.lock);
+  t->in_round = false;
+  if (--bx_smp.active == 0)
+    bx_smp_end_round();
+  BX_UNLOCK(bx_smp.lock);
+}
+
+// The CPU is halted: sleep until another CPU sends it an interrupt or the
+// round is over. A parked CPU does not keep the round from ending.
+static void bx_smp_park(bx_smp_cpu_thread_t *t)
+{
+  BX_LOCK(bx_smp.lock);
+  if (BX_CPU(t->id)->smp_requests.pending()) {
+    BX_UNLOCK(bx_smp.lock);
+    return;
+  }
+  t->parked = true;
+  t->round_over = false;
+  if (--bx_smp.active == 0)
+    bx_smp_end_round();
+  BX_UNLOCK(bx_smp.lock);
+
+  bx_wait_sem(&t->wakeup);
+  if (t->round_over)
+    t->in_round = false;
+}
+
+static void bx_smp_wakeup(unsigned cpu)
+{
+  bx_smp_cpu_thread_t *t = &bx_smp.cpu[cpu];
+
+  BX_LOCK(bx_smp.lock);
+  if (t->parked) {
+    t->parked = false;
+    bx_smp.active++;
+    bx_set_sem(&t->wakeup);
+  }
+  BX_UNLOCK(bx_smp.lock);
+}
+
+// Called by the CPU thread which invalidated trace cache entries of another
+// CPU after the request was posted. If that CPU is in the middle of a trace
+// the calling CPU stops after the current instruction and waits until the
+// other one left the trace, it applies the request before the next one.
+void bx_smp_stop_remote_trace(unsigned cpu)
+{
+  if (bx_smp_thread_cpu == BX_SMP_NO_CPU) return;
+
+  BX_MEMORY_FENCE();
+  Bit32u seq = bx_smp.cpu[cpu].trace_seq;
+  if (seq & 1) {
+    bx_smp_cpu_thread_t *t = &bx_smp.cpu[bx_smp_thread_cpu];
+    t->wait_seq[cpu] = seq;
+    t->wait_pending = true;
+    BX_CPU(bx_smp_thread_cpu)->async_event |= BX_ASYNC_EVENT_STOP_TRACE;
+  }
+}
+
+// called between the traces, without the big emulator lock
+static void bx_smp_wait_remote_traces(bx_smp_cpu_thread_t *t)
+{
+  for (unsigned n=0; n < BX_SMP_PROCESSORS; n++) {
+    if (t->wait_seq[n]) {
+      // traces are short, spin for a while before giving up the host CPU
+      for (unsigned spin = 0; bx_smp.cpu[n].trace_seq == t->wait_seq[n]; spin++) {
+        if (spin >= BX_SMP_WAIT_SPINS)
+          BX_THREAD_YIELD();
+        BX_MEMORY_FENCE();
+      }
+      t->wait_seq[n] = 0;
+    }
+  }
+  t->wait_pending = false;
+}
+
+void bx_smp_request_reset(unsigned type)
+{
+  BX_LOCK(bx_smp.lock);
+  if (! bx_smp.reset_request || type == BX_RESET_HARDWARE)
+    bx_smp.reset_type = type;
+  bx_smp.reset_request = true;
+  bx_smp.stop = true;
+  BX_UNLOCK(bx_smp.lock);
+
+  // the requesting CPU stops after the current instruction
+  if (bx_smp_thread_cpu != BX_SMP_NO_CPU)
+    BX_CPU(bx_smp_thread_cpu)->async_event = 1;
+}
+
+static void bx_smp_cpu_rounds(bx_smp_cpu_thread_t *t)
+{
+  BX_CPU_C *cpu = BX_CPU(t->id);
+
+  switch (setjmp(BX_CPU_C::jmp_buf_env)) {
+    case 0:
+      break;
+    case BX_SMP_RESTART_INSTRUCTION:
+      bx_smp_device_lock_release();
+      break;
+    default:
+      // can get here only from exception function or VMEXIT
+      cpu->icount++;
+      cpu->smp_rmw.atomic = false;
+      cpu->smp_rmw.bus_locked = false;
+      bx_smp_device_lock_release();
+      break;
+  }
+
+  // the trace was left by longjmp
+  if (t->trace_seq & 1)
+    t->trace_seq++;
+
+  while (1) {
+    if (! t->in_round) {
+      bx_wait_sem(&t->start);
+      if (bx_smp.quit) break;
+      t->in_round = true;
+      t->round_start = cpu->get_icount();
+    }
+
+    // this CPU invalidated code other CPUs were executing
+    if (t->wait_pending)
+      bx_smp_wait_remote_traces(t);
+
+    // requests posted from now on make bx_smp_stop_remote_trace() wait
+    // for the end of the trace
+    t->trace_seq++;
+    BX_MEMORY_FENCE();
+
+    if (cpu->smp_requests.pending())
+      cpu->smp_process_requests();
+
+    if (bx_smp.stop || bx_pc_system.kill_bochs_request || bx_pc_system.snapshot_request ||
+        (Bit32u)(cpu->get_icount() - t->round_start) >= bx_smp.length)
+    {
+      t->trace_seq++;
+      bx_smp_leave_round(t);
+      continue;
+    }
+
+    // trace linking stops after the quantum or when a request was posted,
+    // then the requests are checked
+    cpu->icount_last_sync = cpu->get_icount();
+    cpu->cpu_run_trace();
+    t->trace_seq++;
+
+    // read-modify-write instruction which did not write back its operand
+    cpu->smp_unlock_RMW();
+
+    if (cpu->activity_state != BX_CPU_C::BX_ACTIVITY_STATE_ACTIVE)
+      bx_smp_park(t);
+  }
+}
+
+static BX_THREAD_FUNC(bx_smp_cpu_thread, indata)
+{
+  bx_smp_cpu_thread_t *t = (bx_smp_cpu_thread_t *) indata;
+
+  bx_smp_thread_cpu = t->id;
+  bx_smp_cpu_rounds(t);
+
+  BX_THREAD_EXIT;
+}
+
+void bx_smp_threads_loop(void)
+{
+  unsigned n, processors = BX_SMP_PROCESSORS;
+  Bit32u quantum = SIM->get_param_num(BXPN_SMP_QUANTUM)->get();
+
+  BX_INIT_MUTEX(bx_smp_device_mutex);
+  BX_INIT_MUTEX(bx_smp.lock);
+  bx_create_sem(&bx_smp.done);
+  bx_smp.quit = false;
+  bx_smp.reset_request = false;
+
+  bx_smp.cpu = new bx_smp_cpu_thread_t[processors];
+  for (n=0; n < processors; n++) {
+    bx_smp_cpu_thread_t *t = &bx_smp.cpu[n];
+    t->id = n;
+    t->in_round = false;
+    t->parked = false;
+    t->round_over = false;
+    t->trace_seq = 0;
+    t->wait_seq = new Bit32u[processors];
+    memset(t->wait_seq, 0, sizeof(Bit32u) * processors);
+    t->wait_pending = false;
+    bx_create_sem(&t->start);
+    bx_create_sem(&t->wakeup);
+    BX_THREAD_CREATE(bx_smp_cpu_thread, t, t->thread);
+  }
+
+  while (1) {
+    // run until the next timer event, all CPUs advance the system time by
+    // the same amount of instructions
+    Bit32u length = bx_pc_system.getNumCpuTicksLeftNextEvent();
+    if (length < quantum) length = quantum;
+    if (length > BX_SMP_MAX_ROUND_LENGTH) length = BX_SMP_MAX_ROUND_LENGTH;
+
+    bx_smp.length = length;
+    bx_smp.active = processors;
+    bx_smp.stop = false;
+    bx_smp_threads_running = true;
+    for (n=0; n < processors; n++)
+      bx_set_sem(&bx_smp.cpu[n].start);
+
+    bx_wait_sem(&bx_smp.done);
+    bx_smp_threads_running = false;
+
+    // all CPU threads are waiting for the next round now, apply requests
+    // which were posted to CPUs that already left the round
+    for (n=0; n < processors; n++) {
+      if (BX_CPU(n)->smp_requests.pending())
+        BX_CPU(n)->smp_process_requests();
+    }
+
+    if (bx_smp.reset_request) {
+      bx_smp.reset_request = false;
+      bx_pc_system.Reset(bx_smp.reset_type);
+    }
+
+    BX_TICKN(length);
+    // all the processors halted: skip to the next timer event
+    bx_pc_system.idle_skip();
+
+    if (bx_pc_system.snapshot_request)
+      bx_snapshot_process();
+
+    if (bx_pc_system.kill_bochs_request)
+      break;
+  }
+
+  bx_smp.quit = true;
+  for (n=0; n < processors; n++)
+    bx_set_sem(&bx_smp.cpu[n].start);
+  for (n=0; n < processors; n++) {
+    BX_THREAD_JOIN(bx_smp.cpu[n].thread);
+    bx_destroy_sem(&bx_smp.cpu[n].start);
+    bx_destroy_sem(&bx_smp.cpu[n].wakeup);
+    delete [] bx_smp.cpu[n].wait_seq;
+  }
+  delete [] bx_smp.cpu;
+  bx_destroy_sem(&bx_smp.done);
+}
+
+//////////////////////////
+// CPU side
+//////////////////////////
+
+void BX_CPU_C::smp_post_request(unsigned type, Bit32u data, Bit64u addr)
+{
+  BX_CPU_THIS_PTR smp_requests.post(type, data, addr);
+
+  // invalidations could wait until the CPU wakes up for another reason
+  if (type <= BX_SMP_REQ_CHECK_MONITOR)
+    bx_smp_wakeup(BX_CPU_ID);
+}
+
+void BX_CPU_C::smp_process_requests(void)
+{
+  bx_smp_request_t *req;
+  unsigned count = BX_CPU_THIS_PTR smp_requests.fetch(&req);
+
+  for (unsigned n=0; n < count; n++, req++) {
+    switch(req->type) {
+      case BX_SMP_REQ_APIC_DELIVER:
+#if BX_SUPPORT_APIC
+        BX_CPU_THIS_PTR lapic->deliver(req->data & 0xff, (req->data >> 8) & 0xff, (req->data >> 16) & 0xff);
+#endif
+        break;
+      case BX_SMP_REQ_RAISE_INTR:
+        raise_INTR();
+        break;
+      case BX_SMP_REQ_CLEAR_INTR:
+        clear_INTR();
+        break;
+      case BX_SMP_REQ_DELIVER_NMI:
+        deliver_NMI();
+        break;
+      case BX_SMP_REQ_DELIVER_SMI:
+        deliver_SMI();
+        break;
+      case BX_SMP_REQ_DELIVER_INIT:
+        deliver_INIT();
+        break;
+      case BX_SMP_REQ_ASYNC_EVENT:
+        BX_CPU_THIS_PTR async_event = 1;
+        break;
+      case BX_SMP_REQ_CHECK_MONITOR:
+#if BX_SUPPORT_MONITOR_MWAIT
+        check_monitor((bx_phy_address) req->addr, req->data);
+#endif
+        break;
+      case BX_SMP_REQ_TLB_FLUSH:
+        TLB_flush();
+        break;
+      case BX_SMP_REQ_TLB_INVLPG:
+        TLB_invlpg((bx_address) req->addr);
+        break;
+      case BX_SMP_REQ_ICACHE_FLUSH:
+        BX_CPU_THIS_PTR iCache.flushICacheEntries();
+        BX_CPU_THIS_PTR async_event |= BX_ASYNC_EVENT_STOP_TRACE;
+        break;
+      case BX_SMP_REQ_ICACHE_SMC:
+        INC_SMC_STAT(BX_CPU_THIS, smc);
+        BX_CPU_THIS_PTR iCache.handleSMC((bx_phy_address) req->addr, req->data);
+        BX_CPU_THIS_PTR async_event |= BX_ASYNC_EVENT_STOP_TRACE;
+        break;
+      case BX_SMP_REQ_PROFILE_SAMPLE:
+        profileSample();
+        break;
+      default:
+        BX_PANIC(("smp_process_requests: unknown request %d", req->type));
+    }
+  }
+}
+
+// The memory operand of a read-modify-write instruction was read through a
+// host pointer. Save what is needed to execute the instruction again if
+// another processor modifies the operand before it is written back.
+void BX_CPU_C::smp_begin_RMW(Bit64u value)
+{
+  BX_CPU_THIS_PTR smp_rmw.atomic = true;
+  BX_CPU_THIS_PTR smp_rmw.value = value;
+  BX_CPU_THIS_PTR smp_rmw.eflags = BX_CPU_THIS_PTR eflags;
+  BX_CPU_THIS_PTR smp_rmw.oszapc = BX_CPU_THIS_PTR oszapc;
+  memcpy(BX_CPU_THIS_PTR smp_rmw.gen_reg, BX_CPU_THIS_PTR gen_reg, sizeof(BX_CPU_THIS_PTR gen_reg));
+}
+
+// The operand of a read-modify-write instruction is read the slow way,
+// hold the big emulator lock until it is written back
+void BX_CPU_C::smp_lock_RMW(void)
+{
+  BX_CPU_THIS_PTR smp_rmw.atomic = false;
+  if (! BX_CPU_THIS_PTR smp_rmw.bus_locked) {
+    bx_smp_device_lock();
+    BX_CPU_THIS_PTR smp_rmw.bus_locked = true;
+  }
+}
+
+// The operand was read the slow way, usually after a TLB miss. Switch to
+// compare-and-swap if it is in host memory, only split and MMIO operands
+// keep the big emulator lock.
+void BX_CPU_C::smp_locked_RMW_read(Bit64u value, unsigned len)
+{
+  if (BX_CPU_THIS_PTR address_xlation.pages != 1) return;
+
+  bx_phy_address pAddr = BX_CPU_THIS_PTR address_xlation.paddress1;
+  Bit8u *hostAddr = BX_MEM(0)->getHostMemAddr(BX_CPU_THIS, pAddr, BX_WRITE);
+  if (hostAddr) {
+    pageWriteStampTable.decWriteStamp(pAddr, len);
+    BX_CPU_THIS_PTR address_xlation.pages = (bx_ptr_equiv_t) hostAddr;
+    smp_unlock_RMW();
+    smp_begin_RMW(value);
+  }
+}
+
+void BX_CPU_C::smp_unlock_RMW(void)
+{
+  if (BX_CPU_THIS_PTR smp_rmw.bus_locked) {
+    BX_CPU_THIS_PTR smp_rmw.bus_locked = false;
+    bx_smp_device_unlock();
+  }
+}
+
+void BX_CPU_C::smp_commit_RMW(void *hostAddr, Bit64u val, unsigned len)
+{
+  Bit64u value = BX_CPU_THIS_PTR smp_rmw.value;
+  bool done = false;
+
+  BX_CPU_THIS_PTR smp_rmw.atomic = false;
+
+  switch(len) {
+    case 1:
+      done = BX_ATOMIC_CAS8((Bit8u *) hostAddr, (Bit8u) value, (Bit8u) val);
+      break;
+    case 2:
+      {
+        Bit16u expected16, val16;
+        WriteHostWordToLittleEndian(&expected16, (Bit16u) value);
+        WriteHostWordToLittleEndian(&val16, (Bit16u) val);
+        done = BX_ATOMIC_CAS16((Bit16u *) hostAddr, expected16, val16);
+      }
+      break;
+    case 4:
+      {
+        Bit32u expected32, val32;
+        WriteHostDWordToLittleEndian(&expected32, (Bit32u) value);
+        WriteHostDWordToLittleEndian(&val32, (Bit32u) val);
+        done = BX_ATOMIC_CAS32((Bit32u *) hostAddr, expected32, val32);
+      }
+      break;
+    case 8:
+      {
+        Bit64u expected64, val64;
+        WriteHostQWordToLittleEndian(&expected64, value);
+        WriteHostQWordToLittleEndian(&val64, val);
+        done = BX_ATOMIC_CAS64((Bit64u *) hostAddr, expected64, val64);
+      }
+      break;
+    default:
+      BX_PANIC(("smp_commit_RMW: unsupported length %d", len));
+  }
+
+  if (! done)
+    smp_restart_RMW();
+}
+
+void BX_CPU_C::smp_restart_RMW(void)
+{
+  BX_CPU_THIS_PTR eflags = BX_CPU_THIS_PTR smp_rmw.eflags;
+  BX_CPU_THIS_PTR oszapc = BX_CPU_THIS_PTR smp_rmw.oszapc;
+  memcpy(BX_CPU_THIS_PTR gen_reg, BX_CPU_THIS_PTR smp_rmw.gen_reg, sizeof(BX_CPU_THIS_PTR gen_reg));
+  RIP = BX_CPU_THIS_PTR prev_rip;
+
+  longjmp(BX_CPU_THIS_PTR jmp_buf_env, BX_SMP_RESTART_INSTRUCTION);
+}
+
+// Set accessed/dirty bits in a paging structure entry with host
+// compare-and-swap. Leave the entry alone if another processor modified it
+// after it was read by the page walk. Returns false if the entry is not in
+// host memory and has to be written the regular way.
+bool BX_CPU_C::smp_update_paging_entry(bx_phy_address entry_addr, Bit64u old_entry, Bit64u new_entry, unsigned len)
+{
+  Bit8u *hostAddr = BX_MEM(0)->getHostMemAddr(BX_CPU_THIS, entry_addr, BX_WRITE);
+  if (! hostAddr)
+    return false;
+
+  pageWriteStampTable.decWriteStamp(entry_addr, len);
+
+  if (len == 8) {
+    Bit64u expected64, val64;
+    WriteHostQWordToLittleEndian(&expected64, old_entry);
+    WriteHostQWordToLittleEndian(&val64, new_entry);
+    BX_ATOMIC_CAS64((Bit64u *) hostAddr, expected64, val64);
+  }
+  else {
+    Bit32u expected32, val32;
+    WriteHostDWordToLittleEndian(&expected32, (Bit32u) old_entry);
+    WriteHostDWordToLittleEndian(&val32, (Bit32u) new_entry);
+    BX_ATOMIC_CAS32((Bit32u *) hostAddr, expected32, val32);
+  }
+
+  return true;
+}
+
+#endif // BX_SUPPORT_SMP
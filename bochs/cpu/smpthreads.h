@@ -0,0 +1,134 @@
+/////////////////////////////////////////////////////////////////////////
+// $Id$
+/////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (C) 2026  The Bochs Project
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA B 02110-1301 USA
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef BX_SMP_THREADS_H
+#define BX_SMP_THREADS_H
+
+#if BX_SUPPORT_SMP
+
+#include "bxthread.h"
+
+// Multi-threaded SMP simulation (cpu: smp_threads=1)
+//
+// Every emulated processor is executed by its own host thread. The CPUs run
+// in rounds: the main thread lets all of them execute the same amount of
+// instructions (up to the next timer event) and advances the system time
+// when all CPU threads reached the end of the round. Timers and GUI are only
+// serviced by the main thread between the rounds.
+//
+// While a round is running:
+//  - devices, physical memory accesses which do not go through a host
+//    pointer and the system timers are serialized by the big emulator lock;
+//  - read-modify-write instructions with the operand in host memory are
+//    committed with host compare-and-swap, the instruction is restarted if
+//    another processor modified the operand since it was read;
+//  - anything one CPU does to another one (interrupts and IPIs, TLB and
+//    trace cache invalidations, MONITOR wakeups) is posted as a request to
+//    the target CPU which applies it between the traces. A CPU which
+//    invalidated code the target is executing waits after the current
+//    instruction until the target left its trace.
+
+#define BX_SMP_NO_CPU (~0u)
+
+// set by the main thread while the CPU threads are executing a round. It is
+// written only by the main thread before it releases the CPU threads for the
+// round and after all of them left it, the round semaphores order it with
+// the CPU thread reads.
+extern volatile bool bx_smp_threads_running;
+// id of the CPU executed by the calling host thread
+extern thread_local unsigned bx_smp_thread_cpu;
+
+// true if the CPU is executed by another host thread than the caller
+BX_CPP_INLINE bool bx_smp_is_remote_cpu(unsigned cpu)
+{
+  return bx_smp_threads_running && (cpu != bx_smp_thread_cpu);
+}
+
+// big emulator lock, recursive
+extern void bx_smp_device_lock(void);
+extern void bx_smp_device_unlock(void);
+
+// scoped big emulator lock, does nothing unless the CPU threads are running
+class bx_smp_device_lock_c {
+  bool locked;
+public:
+  bx_smp_device_lock_c(): locked(bx_smp_threads_running) {
+    if (locked) bx_smp_device_lock();
+  }
+ ~bx_smp_device_lock_c() {
+    if (locked) bx_smp_device_unlock();
+  }
+};
+
+#define BX_SMP_DEVICE_LOCK() bx_smp_device_lock_c bx_smp_device_lock_guard
+
+extern void bx_smp_stop_remote_trace(unsigned cpu);
+extern void bx_smp_request_reset(unsigned type);
+extern void bx_smp_threads_loop(void);
+
+// requests posted to a CPU from another host thread
+enum {
+  BX_SMP_REQ_APIC_DELIVER,    // data = vector | delivery_mode << 8 | trig_mode << 16
+  BX_SMP_REQ_RAISE_INTR,
+  BX_SMP_REQ_CLEAR_INTR,
+  BX_SMP_REQ_DELIVER_NMI,
+  BX_SMP_REQ_DELIVER_SMI,
+  BX_SMP_REQ_DELIVER_INIT,
+  BX_SMP_REQ_ASYNC_EVENT,
+  BX_SMP_REQ_CHECK_MONITOR,   // addr = physical address, data = length
+  BX_SMP_REQ_TLB_FLUSH,
+  BX_SMP_REQ_TLB_INVLPG,      // addr = linear address
+  BX_SMP_REQ_ICACHE_FLUSH,
+  BX_SMP_REQ_ICACHE_SMC,      // addr = physical address, data = mask of lines
+  BX_SMP_REQ_PROFILE_SAMPLE
+};
+
+struct bx_smp_request_t {
+  unsigned type;
+  Bit32u data;
+  Bit64u addr;
+};
+
+class bx_smp_request_queue_c {
+public:
+  bx_smp_request_queue_c();
+ ~bx_smp_request_queue_c();
+
+  void post(unsigned type, Bit32u data, Bit64u addr);
+  BX_CPP_INLINE bool pending() const { return has_requests; }
+  // take all posted requests, valid until the next fetch()
+  unsigned fetch(bx_smp_request_t **requests);
+
+private:
+  BX_MUTEX(lock);
+  volatile bool has_requests;
+  bx_smp_request_t *queue, *taken;
+  unsigned count, size, taken_size;
+};
+
+#else
+
+#define BX_SMP_DEVICE_LOCK()
+
+#endif // BX_SUPPORT_SMP
+
+#endif
@@ -904,7 +904,10 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SQRTSD_VsdWsdR(bxInstruction_c *i)
   float64 op = BX_READ_XMM_REG_LO_QWORD(i->src());
 
   softfloat_status_t status = mxcsr_to_softfloat_status_word(MXCSR);
-  op = f64_sqrt(op, &status);
+  if (host_fpu_ok(status, MXCSR))
+    op = host_f64_1op<f64_sqrt>(op, &status);
+  else
+    op = f64_sqrt(op, &status);
   check_exceptionsSSE(softfloat_getExceptionFlags(&status));
   BX_WRITE_XMM_REG_LO_QWORD(i->dst(), op);
 #endif
@@ -923,7 +926,10 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SQRTSS_VssWssR(bxInstruction_c *i)
   float32 op = BX_READ_XMM_REG_LO_DWORD(i->src());
 
   softfloat_status_t status = mxcsr_to_softfloat_status_word(MXCSR);
-  op = f32_sqrt(op, &status);
+  if (host_fpu_ok(status, MXCSR))
+    op = host_f32_1op<f32_sqrt>(op, &status);
+  else
+    op = f32_sqrt(op, &status);
   check_exceptionsSSE(softfloat_getExceptionFlags(&status));
   BX_WRITE_XMM_REG_LO_DWORD(i->dst(), op);
 #endif
@@ -940,7 +946,10 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SQRTSS_VssWssR(bxInstruction_c *i)
     float32 op1 = BX_READ_XMM_REG_LO_DWORD(i->dst()), op2 = BX_READ_XMM_REG_LO_DWORD(i->src()); \
                                                                                                 \
     softfloat_status_t status = mxcsr_to_softfloat_status_word(MXCSR);                          \
-    op1 = (func)(op1, op2, &status);                                                            \
+    if (host_fpu_ok(status, MXCSR))                                                             \
+      op1 = host_f32_2op<func>(op1, op2, &status);                                              \
+    else                                                                                        \
+      op1 = (func)(op1, op2, &status);                                                          \
     check_exceptionsSSE(softfloat_getExceptionFlags(&status));                                  \
     BX_WRITE_XMM_REG_LO_DWORD(i->dst(), op1);                                                   \
     BX_NEXT_INSTR(i);                                                                           \
@@ -973,7 +982,10 @@ SSE_SCALAR_SINGLE_FP_CPU_LEVEL6(MAXSS_VssWssR, f32_max);
     float64 op1 = BX_READ_XMM_REG_LO_QWORD(i->dst()), op2 = BX_READ_XMM_REG_LO_QWORD(i->src()); \
                                                                                                 \
     softfloat_status_t status = mxcsr_to_softfloat_status_word(MXCSR);                          \
-    op1 = (func)(op1, op2, &status);                                                            \
+    if (host_fpu_ok(status, MXCSR))                                                             \
+      op1 = host_f64_2op<func>(op1, op2, &status);                                              \
+    else                                                                                        \
+      op1 = (func)(op1, op2, &status);                                                          \
     check_exceptionsSSE(softfloat_getExceptionFlags(&status));                                  \
     BX_WRITE_XMM_REG_LO_QWORD(i->dst(), op1);                                                   \
     BX_NEXT_INSTR(i);                                                                           \
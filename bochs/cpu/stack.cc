@@ -40,7 +40,7 @@ void BX_CPP_AttrRegparmN(2) BX_CPU_C::stackPrefetch(bx_address offset, unsigned
 
   len--;
 
-#if BX_SUPPORT_X86_64
+  // flat SS: the limit checks are not needed, the window is the whole page
   if (long64_mode() || (BX_CPU_THIS_PTR sregs[BX_SEG_REG_SS].cache.valid & SegAccessWOK4G)) {
     laddr = offset;
     pageOffset = PAGE_OFFSET(offset);
@@ -52,9 +52,7 @@ void BX_CPP_AttrRegparmN(2) BX_CPU_C::stackPrefetch(bx_address offset, unsigned
 
     BX_CPU_THIS_PTR espPageWindowSize = 4096;
   }
-  else
-#endif
-  {
+  else {
     laddr = get_laddr32(BX_SEG_REG_SS, (Bit32u) offset);
     pageOffset = PAGE_OFFSET(laddr);
     if (pageOffset + len >= 4096) // don't care for page split accesses
@@ -121,6 +119,9 @@ void BX_CPP_AttrRegparmN(2) BX_CPU_C::stackPrefetch(bx_address offset, unsigned
 #endif
 #if BX_SUPPORT_SMP == 0
       BX_CPU_THIS_PTR espPageFineGranularityMapping = pageWriteStampTable.getFineGranularityMapping(tlbEntry->ppf);
+      // the stack writes must reach the dirty page log
+      if (pageWriteStampTable.dirtyLogEnabled())
+        BX_CPU_THIS_PTR espPageFineGranularityMapping |= 1;
 #endif
     }
   }
@@ -168,23 +169,13 @@ void BX_CPP_AttrRegparmN(2) BX_CPU_C::stack_write_word(bx_address offset, Bit16u
   }
 
   if (BX_CPU_THIS_PTR espHostPtr) {
-    Bit16u *hostPageAddr = (Bit16u*)(BX_CPU_THIS_PTR espHostPtr + espBiased);
-    bx_phy_address pAddr = BX_CPU_THIS_PTR pAddrStackPage + espBiased;
 #if BX_CPU_LEVEL >= 4 && BX_SUPPORT_ALIGNMENT_CHECK
-    if (BX_CPU_THIS_PTR alignment_check() && (pAddr & 1) != 0) {
+    if (BX_CPU_THIS_PTR alignment_check() && ((BX_CPU_THIS_PTR pAddrStackPage + espBiased) & 1) != 0) {
       BX_ERROR(("stack_write_word(): #AC misaligned access"));
       exception(BX_AC_EXCEPTION, 0);
     }
 #endif
-    BX_NOTIFY_LIN_MEMORY_ACCESS(get_laddr(BX_SEG_REG_SS, offset), pAddr, 2,
-                                MEMTYPE(BX_CPU_THIS_PTR espPageMemtype), BX_WRITE, (Bit8u*) &data);
-
-#if BX_SUPPORT_SMP == 0
-    if (BX_CPU_THIS_PTR espPageFineGranularityMapping)
-#endif
-      pageWriteStampTable.decWriteStamp(pAddr, 2);
-
-    WriteHostWordToLittleEndian(hostPageAddr, data);
+    stack_window_write_word(offset, data);
   }
   else {
     write_virtual_word(BX_SEG_REG_SS, offset, data);
@@ -201,23 +192,13 @@ void BX_CPP_AttrRegparmN(2) BX_CPU_C::stack_write_dword(bx_address offset, Bit32
   }
 
   if (BX_CPU_THIS_PTR espHostPtr) {
-    Bit32u *hostPageAddr = (Bit32u*)(BX_CPU_THIS_PTR espHostPtr + espBiased);
-    bx_phy_address pAddr = BX_CPU_THIS_PTR pAddrStackPage + espBiased;
 #if BX_CPU_LEVEL >= 4 && BX_SUPPORT_ALIGNMENT_CHECK
-    if (BX_CPU_THIS_PTR alignment_check() && (pAddr & 3) != 0) {
+    if (BX_CPU_THIS_PTR alignment_check() && ((BX_CPU_THIS_PTR pAddrStackPage + espBiased) & 3) != 0) {
       BX_ERROR(("stack_write_dword(): #AC misaligned access"));
       exception(BX_AC_EXCEPTION, 0);
     }
 #endif
-    BX_NOTIFY_LIN_MEMORY_ACCESS(get_laddr(BX_SEG_REG_SS, offset), pAddr, 4,
-                                MEMTYPE(BX_CPU_THIS_PTR espPageMemtype), BX_WRITE, (Bit8u*) &data);
-
-#if BX_SUPPORT_SMP == 0
-    if (BX_CPU_THIS_PTR espPageFineGranularityMapping)
-#endif
-      pageWriteStampTable.decWriteStamp(pAddr, 4);
-
-    WriteHostDWordToLittleEndian(hostPageAddr, data);
+    stack_window_write_dword(offset, data);
   }
   else {
     write_virtual_dword(BX_SEG_REG_SS, offset, data);
@@ -234,23 +215,13 @@ void BX_CPP_AttrRegparmN(2) BX_CPU_C::stack_write_qword(bx_address offset, Bit64
   }
 
   if (BX_CPU_THIS_PTR espHostPtr) {
-    Bit64u *hostPageAddr = (Bit64u*)(BX_CPU_THIS_PTR espHostPtr + espBiased);
-    bx_phy_address pAddr = BX_CPU_THIS_PTR pAddrStackPage + espBiased;
 #if BX_CPU_LEVEL >= 4 && BX_SUPPORT_ALIGNMENT_CHECK
-    if (BX_CPU_THIS_PTR alignment_check() && (pAddr & 7) != 0) {
+    if (BX_CPU_THIS_PTR alignment_check() && ((BX_CPU_THIS_PTR pAddrStackPage + espBiased) & 7) != 0) {
       BX_ERROR(("stack_write_qword(): #AC misaligned access"));
       exception(BX_AC_EXCEPTION, 0);
     }
 #endif
-    BX_NOTIFY_LIN_MEMORY_ACCESS(get_laddr(BX_SEG_REG_SS, offset), pAddr, 8,
-                                MEMTYPE(BX_CPU_THIS_PTR espPageMemtype), BX_WRITE, (Bit8u*) &data);
-
-#if BX_SUPPORT_SMP == 0
-    if (BX_CPU_THIS_PTR espPageFineGranularityMapping)
-#endif
-      pageWriteStampTable.decWriteStamp(pAddr, 8);
-
-    WriteHostQWordToLittleEndian(hostPageAddr, data);
+    stack_window_write_qword(offset, data);
   }
   else {
     write_virtual_qword(BX_SEG_REG_SS, offset, data);
@@ -289,7 +260,6 @@ Bit16u BX_CPP_AttrRegparmN(1) BX_CPU_C::stack_read_word(bx_address offset)
   }
 
   if (BX_CPU_THIS_PTR espHostPtr) {
-    Bit16u *hostPageAddr = (Bit16u*)(BX_CPU_THIS_PTR espHostPtr + espBiased), data;
 #if BX_CPU_LEVEL >= 4 && BX_SUPPORT_ALIGNMENT_CHECK
     if (BX_CPU_THIS_PTR alignment_check()) {
       bx_phy_address pAddr = BX_CPU_THIS_PTR pAddrStackPage + espBiased;
@@ -299,11 +269,7 @@ Bit16u BX_CPP_AttrRegparmN(1) BX_CPU_C::stack_read_word(bx_address offset)
       }
     }
 #endif
-    data = ReadHostWordFromLittleEndian(hostPageAddr);
-    BX_NOTIFY_LIN_MEMORY_ACCESS(get_laddr(BX_SEG_REG_SS, offset),
-        (BX_CPU_THIS_PTR pAddrStackPage + espBiased), 2,
-         MEMTYPE(BX_CPU_THIS_PTR espPageMemtype), BX_READ, (Bit8u*) &data);
-    return data;
+    return stack_window_read_word(offset);
   }
   else {
     return read_virtual_word(BX_SEG_REG_SS, offset);
@@ -320,7 +286,6 @@ Bit32u BX_CPP_AttrRegparmN(1) BX_CPU_C::stack_read_dword(bx_address offset)
   }
 
   if (BX_CPU_THIS_PTR espHostPtr) {
-    Bit32u *hostPageAddr = (Bit32u*)(BX_CPU_THIS_PTR espHostPtr + espBiased), data;
 #if BX_CPU_LEVEL >= 4 && BX_SUPPORT_ALIGNMENT_CHECK
     if (BX_CPU_THIS_PTR alignment_check()) {
       bx_phy_address pAddr = BX_CPU_THIS_PTR pAddrStackPage + espBiased;
@@ -330,11 +295,7 @@ Bit32u BX_CPP_AttrRegparmN(1) BX_CPU_C::stack_read_dword(bx_address offset)
       }
     }
 #endif
-    data = ReadHostDWordFromLittleEndian(hostPageAddr);
-    BX_NOTIFY_LIN_MEMORY_ACCESS(get_laddr(BX_SEG_REG_SS, offset),
-        (BX_CPU_THIS_PTR pAddrStackPage + espBiased), 4,
-         MEMTYPE(BX_CPU_THIS_PTR espPageMemtype), BX_READ, (Bit8u*) &data);
-    return data;
+    return stack_window_read_dword(offset);
   }
   else {
     return read_virtual_dword(BX_SEG_REG_SS, offset);
@@ -351,7 +312,6 @@ Bit64u BX_CPP_AttrRegparmN(1) BX_CPU_C::stack_read_qword(bx_address offset)
   }
 
   if (BX_CPU_THIS_PTR espHostPtr) {
-    Bit64u *hostPageAddr = (Bit64u*)(BX_CPU_THIS_PTR espHostPtr + espBiased), data;
 #if BX_CPU_LEVEL >= 4 && BX_SUPPORT_ALIGNMENT_CHECK
     if (BX_CPU_THIS_PTR alignment_check()) {
       bx_phy_address pAddr = BX_CPU_THIS_PTR pAddrStackPage + espBiased;
@@ -361,11 +321,7 @@ Bit64u BX_CPP_AttrRegparmN(1) BX_CPU_C::stack_read_qword(bx_address offset)
       }
     }
 #endif
-    data = ReadHostQWordFromLittleEndian(hostPageAddr);
-    BX_NOTIFY_LIN_MEMORY_ACCESS(get_laddr(BX_SEG_REG_SS, offset),
-        (BX_CPU_THIS_PTR pAddrStackPage + espBiased), 8,
-         MEMTYPE(BX_CPU_THIS_PTR espPageMemtype), BX_READ, (Bit8u*) &data);
-    return data;
+    return stack_window_read_qword(offset);
   }
   else {
     return read_virtual_qword(BX_SEG_REG_SS, offset);
@@ -24,23 +24,161 @@
 #ifndef BX_PUSHPOP_H
 #define BX_PUSHPOP_H
 
+// The push and pop helpers access the stack directly through the host
+// pointer of the stack page window set up by stackPrefetch. The window
+// already includes the SS limit checks, accesses outside of it (and any
+// access when the alignment check is enabled) are handled by the out of
+// line stack_read/stack_write methods, which use the same window accessors
+// once the page is prefetched.
+
+BX_CPP_INLINE bool BX_CPU_C::stackWindowHit(bx_address offset)
+{
+  // the window is empty unless there is a host pointer for the page
+  if ((offset + BX_CPU_THIS_PTR espPageBias) >= BX_CPU_THIS_PTR espPageWindowSize)
+    return false;
+#if BX_CPU_LEVEL >= 4 && BX_SUPPORT_ALIGNMENT_CHECK
+  if (BX_CPU_THIS_PTR alignment_check())
+    return false;
+#endif
+  return true;
+}
+
+BX_CPP_INLINE void BX_CPU_C::stack_window_write_word(bx_address offset, Bit16u data)
+{
+  bx_address espBiased = offset + BX_CPU_THIS_PTR espPageBias;
+  bx_phy_address pAddr = BX_CPU_THIS_PTR pAddrStackPage + espBiased;
+  BX_NOTIFY_LIN_MEMORY_ACCESS(get_laddr(BX_SEG_REG_SS, offset), pAddr, 2,
+                              MEMTYPE(BX_CPU_THIS_PTR espPageMemtype), BX_WRITE, (Bit8u*) &data);
+#if BX_SUPPORT_SMP == 0
+  if (BX_CPU_THIS_PTR espPageFineGranularityMapping)
+#endif
+    pageWriteStampTable.decWriteStamp(pAddr, 2);
+
+  WriteHostWordToLittleEndian((Bit16u*)(BX_CPU_THIS_PTR espHostPtr + espBiased), data);
+}
+
+BX_CPP_INLINE Bit16u BX_CPU_C::stack_window_read_word(bx_address offset)
+{
+  bx_address espBiased = offset + BX_CPU_THIS_PTR espPageBias;
+  Bit16u data = ReadHostWordFromLittleEndian((Bit16u*)(BX_CPU_THIS_PTR espHostPtr + espBiased));
+  BX_NOTIFY_LIN_MEMORY_ACCESS(get_laddr(BX_SEG_REG_SS, offset),
+      (BX_CPU_THIS_PTR pAddrStackPage + espBiased), 2,
+       MEMTYPE(BX_CPU_THIS_PTR espPageMemtype), BX_READ, (Bit8u*) &data);
+  return data;
+}
+
+BX_CPP_INLINE void BX_CPU_C::stack_window_write_dword(bx_address offset, Bit32u data)
+{
+  bx_address espBiased = offset + BX_CPU_THIS_PTR espPageBias;
+  bx_phy_address pAddr = BX_CPU_THIS_PTR pAddrStackPage + espBiased;
+  BX_NOTIFY_LIN_MEMORY_ACCESS(get_laddr(BX_SEG_REG_SS, offset), pAddr, 4,
+                              MEMTYPE(BX_CPU_THIS_PTR espPageMemtype), BX_WRITE, (Bit8u*) &data);
+#if BX_SUPPORT_SMP == 0
+  if (BX_CPU_THIS_PTR espPageFineGranularityMapping)
+#endif
+    pageWriteStampTable.decWriteStamp(pAddr, 4);
+
+  WriteHostDWordToLittleEndian((Bit32u*)(BX_CPU_THIS_PTR espHostPtr + espBiased), data);
+}
+
+BX_CPP_INLINE Bit32u BX_CPU_C::stack_window_read_dword(bx_address offset)
+{
+  bx_address espBiased = offset + BX_CPU_THIS_PTR espPageBias;
+  Bit32u data = ReadHostDWordFromLittleEndian((Bit32u*)(BX_CPU_THIS_PTR espHostPtr + espBiased));
+  BX_NOTIFY_LIN_MEMORY_ACCESS(get_laddr(BX_SEG_REG_SS, offset),
+      (BX_CPU_THIS_PTR pAddrStackPage + espBiased), 4,
+       MEMTYPE(BX_CPU_THIS_PTR espPageMemtype), BX_READ, (Bit8u*) &data);
+  return data;
+}
+
+BX_CPP_INLINE void BX_CPU_C::stack_window_write_qword(bx_address offset, Bit64u data)
+{
+  bx_address espBiased = offset + BX_CPU_THIS_PTR espPageBias;
+  bx_phy_address pAddr = BX_CPU_THIS_PTR pAddrStackPage + espBiased;
+  BX_NOTIFY_LIN_MEMORY_ACCESS(get_laddr(BX_SEG_REG_SS, offset), pAddr, 8,
+                              MEMTYPE(BX_CPU_THIS_PTR espPageMemtype), BX_WRITE, (Bit8u*) &data);
+#if BX_SUPPORT_SMP == 0
+  if (BX_CPU_THIS_PTR espPageFineGranularityMapping)
+#endif
+    pageWriteStampTable.decWriteStamp(pAddr, 8);
+
+  WriteHostQWordToLittleEndian((Bit64u*)(BX_CPU_THIS_PTR espHostPtr + espBiased), data);
+}
+
+BX_CPP_INLINE Bit64u BX_CPU_C::stack_window_read_qword(bx_address offset)
+{
+  bx_address espBiased = offset + BX_CPU_THIS_PTR espPageBias;
+  Bit64u data = ReadHostQWordFromLittleEndian((Bit64u*)(BX_CPU_THIS_PTR espHostPtr + espBiased));
+  BX_NOTIFY_LIN_MEMORY_ACCESS(get_laddr(BX_SEG_REG_SS, offset),
+      (BX_CPU_THIS_PTR pAddrStackPage + espBiased), 8,
+       MEMTYPE(BX_CPU_THIS_PTR espPageMemtype), BX_READ, (Bit8u*) &data);
+  return data;
+}
+
+BX_CPP_INLINE void BX_CPU_C::stack_push_word(bx_address offset, Bit16u data)
+{
+  if (stackWindowHit(offset))
+    stack_window_write_word(offset, data);
+  else
+    stack_write_word(offset, data);
+}
+
+BX_CPP_INLINE Bit16u BX_CPU_C::stack_pop_word(bx_address offset)
+{
+  if (stackWindowHit(offset))
+    return stack_window_read_word(offset);
+  return stack_read_word(offset);
+}
+
+BX_CPP_INLINE void BX_CPU_C::stack_push_dword(bx_address offset, Bit32u data)
+{
+  if (stackWindowHit(offset))
+    stack_window_write_dword(offset, data);
+  else
+    stack_write_dword(offset, data);
+}
+
+BX_CPP_INLINE Bit32u BX_CPU_C::stack_pop_dword(bx_address offset)
+{
+  if (stackWindowHit(offset))
+    return stack_window_read_dword(offset);
+  return stack_read_dword(offset);
+}
+
+#if BX_SUPPORT_X86_64
+BX_CPP_INLINE void BX_CPU_C::stack_push_qword(bx_address offset, Bit64u data)
+{
+  if (stackWindowHit(offset))
+    stack_window_write_qword(offset, data);
+  else
+    stack_write_qword(offset, data);
+}
+
+BX_CPP_INLINE Bit64u BX_CPU_C::stack_pop_qword(bx_address offset)
+{
+  if (stackWindowHit(offset))
+    return stack_window_read_qword(offset);
+  return stack_read_qword(offset);
+}
+#endif
+
   BX_CPP_INLINE void BX_CPP_AttrRegparmN(1)
 BX_CPU_C::push_16(Bit16u value16)
 {
 #if BX_SUPPORT_X86_64
   if (long64_mode()) { /* StackAddrSize = 64 */
-    stack_write_word(RSP-2, value16);
+    stack_push_word(RSP-2, value16);
     RSP -= 2;
   }
   else
 #endif
   if (BX_CPU_THIS_PTR sregs[BX_SEG_REG_SS].cache.u.segment.d_b) { /* StackAddrSize = 32 */
-    stack_write_word((Bit32u) (ESP-2), value16);
+    stack_push_word((Bit32u) (ESP-2), value16);
     ESP -= 2;
   }
   else /* StackAddrSize = 16 */
   {
-    stack_write_word((Bit16u) (SP-2), value16);
+    stack_push_word((Bit16u) (SP-2), value16);
     SP -= 2;
   }
 }
@@ -50,18 +188,18 @@ BX_CPU_C::push_32(Bit32u value32)
 {
 #if BX_SUPPORT_X86_64
   if (long64_mode()) { /* StackAddrSize = 64 */
-    stack_write_dword(RSP-4, value32);
+    stack_push_dword(RSP-4, value32);
     RSP -= 4;
   }
   else
 #endif
   if (BX_CPU_THIS_PTR sregs[BX_SEG_REG_SS].cache.u.segment.d_b) { /* StackAddrSize = 32 */
-    stack_write_dword((Bit32u) (ESP-4), value32);
+    stack_push_dword((Bit32u) (ESP-4), value32);
     ESP -= 4;
   }
   else /* StackAddrSize = 16 */
   {
-    stack_write_dword((Bit16u) (SP-4), value32);
+    stack_push_dword((Bit16u) (SP-4), value32);
     SP -= 4;
   }
 }
@@ -72,7 +210,7 @@ BX_CPU_C::push_32(Bit32u value32)
 BX_CPU_C::push_64(Bit64u value64)
 {
   /* StackAddrSize = 64 */
-  stack_write_qword(RSP-8, value64);
+  stack_push_qword(RSP-8, value64);
   RSP -= 8;
 }
 #endif
@@ -84,17 +222,17 @@ BX_CPP_INLINE Bit16u BX_CPU_C::pop_16(void)
 
 #if BX_SUPPORT_X86_64
   if (long64_mode()) { /* StackAddrSize = 64 */
-    value16 = stack_read_word(RSP);
+    value16 = stack_pop_word(RSP);
     RSP += 2;
   }
   else
 #endif
   if (BX_CPU_THIS_PTR sregs[BX_SEG_REG_SS].cache.u.segment.d_b) { /* StackAddrSize = 32 */
-    value16 = stack_read_word(ESP);
+    value16 = stack_pop_word(ESP);
     ESP += 2;
   }
   else { /* StackAddrSize = 16 */
-    value16 = stack_read_word(SP);
+    value16 = stack_pop_word(SP);
     SP += 2;
   }
 
@@ -108,17 +246,17 @@ BX_CPP_INLINE Bit32u BX_CPU_C::pop_32(void)
 
 #if BX_SUPPORT_X86_64
   if (long64_mode()) { /* StackAddrSize = 64 */
-    value32 = stack_read_dword(RSP);
+    value32 = stack_pop_dword(RSP);
     RSP += 4;
   }
   else
 #endif
   if (BX_CPU_THIS_PTR sregs[BX_SEG_REG_SS].cache.u.segment.d_b) { /* StackAddrSize = 32 */
-    value32 = stack_read_dword(ESP);
+    value32 = stack_pop_dword(ESP);
     ESP += 4;
   }
   else { /* StackAddrSize = 16 */
-    value32 = stack_read_dword(SP);
+    value32 = stack_pop_dword(SP);
     SP += 4;
   }
 
@@ -130,7 +268,7 @@ BX_CPP_INLINE Bit32u BX_CPU_C::pop_32(void)
 BX_CPP_INLINE Bit64u BX_CPU_C::pop_64(void)
 {
   /* StackAddrSize = 64 */
-  Bit64u value64 = stack_read_qword(RSP);
+  Bit64u value64 = stack_pop_qword(RSP);
   RSP += 8;
   return value64;
 }
@@ -110,6 +110,13 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::REP_MOVSQ_YqXq(bxInstruction_c *i)
 // 16 bit address size
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::MOVSB16_YbXb(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  /* If conditions are right, we can transfer the data in host memory
+   * in a batch, rather than one iteration at a time */
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepMOVS(i, 1);
+#endif
+
   Bit8u temp8 = read_virtual_byte_32(i->seg(), SI);
   write_virtual_byte_32(BX_SEG_REG_ES, DI, temp8);
 
@@ -126,89 +133,68 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::MOVSB16_YbXb(bxInstruction_c *i)
 // 32 bit address size
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::MOVSB32_YbXb(bxInstruction_c *i)
 {
-  Bit32s increment = 0;
-
 #if BX_SUPPORT_REPEAT_SPEEDUPS
-  /* If conditions are right, we can transfer IO to physical memory
-   * in a batch, rather than one instruction at a time */
-  if (i->repUsedL() && !BX_CPU_THIS_PTR get_DF() && !BX_CPU_THIS_PTR async_event)
-  {
-    Bit32u byteCount = FastRepMOVSB(i->seg(), ESI, BX_SEG_REG_ES, EDI, ECX, 1);
-    if (byteCount) {
-      // Decrement the ticks count by the number of iterations, minus
-      // one, since the main cpu loop will decrement one.  Also,
-      // the count is predecremented before examined, so definitely
-      // don't roll it under zero.
-      BX_TICKN(byteCount-1);
-
-      // Decrement eCX. Note, the main loop will decrement 1 also, so
-      // decrement by one less than expected, like the case above.
-      RCX = ECX - (byteCount-1);
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepMOVS(i, 1);
+#endif
 
-      increment = byteCount;
-    }
-  }
+  Bit32u esi = ESI;
+  Bit32u edi = EDI;
 
-  if (increment == 0)
-#endif
-  {
-    Bit8u temp8 = read_virtual_byte(i->seg(), ESI);
-    write_virtual_byte(BX_SEG_REG_ES, EDI, temp8);
+  Bit8u temp8 = read_virtual_byte(i->seg(), esi);
+  write_virtual_byte(BX_SEG_REG_ES, edi, temp8);
 
-    increment = BX_CPU_THIS_PTR get_DF() ? -1 : 1;
+  if (BX_CPU_THIS_PTR get_DF()) {
+    esi--;
+    edi--;
+  }
+  else {
+    esi++;
+    edi++;
   }
 
-  RSI = ESI + increment;
-  RDI = EDI + increment;
+  // zero extension of RSI/RDI
+  RSI = esi;
+  RDI = edi;
 }
 
 #if BX_SUPPORT_X86_64
 // 64 bit address size
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::MOVSB64_YbXb(bxInstruction_c *i)
 {
-  Bit32s increment = 0;
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepMOVS(i, 1);
+#endif
 
   Bit64u rsi = RSI;
   Bit64u rdi = RDI;
 
-#if BX_SUPPORT_REPEAT_SPEEDUPS
-  /* If conditions are right, we can transfer IO to physical memory
-   * in a batch, rather than one instruction at a time */
-  if (i->repUsedL() && !BX_CPU_THIS_PTR get_DF() && !BX_CPU_THIS_PTR async_event)
-  {
-    Bit32u byteCount = FastRepMOVSB(get_laddr64(i->seg(), rsi), rdi, ECX, 1);
-    if (byteCount) {
-      // Decrement the ticks count by the number of iterations, minus
-      // one, since the main cpu loop will decrement one.  Also,
-      // the count is predecremented before examined, so definitely
-      // don't roll it under zero.
-      BX_TICKN(byteCount-1);
-
-      // Decrement RCX. Note, the main loop will decrement 1 also, so
-      // decrement by one less than expected, like the case above.
-      RCX -= (byteCount-1);
+  Bit8u temp8 = read_linear_byte(i->seg(), get_laddr64(i->seg(), rsi));
+  write_linear_byte(BX_SEG_REG_ES, rdi, temp8);
 
-      increment = byteCount;
-    }
+  if (BX_CPU_THIS_PTR get_DF()) {
+    rsi--;
+    rdi--;
   }
-
-  if (increment == 0)
-#endif
-  {
-    Bit8u temp8 = read_linear_byte(i->seg(), get_laddr64(i->seg(), rsi));
-    write_linear_byte(BX_SEG_REG_ES, rdi, temp8);
-
-    increment = BX_CPU_THIS_PTR get_DF() ? -1 : 1;
+  else {
+    rsi++;
+    rdi++;
   }
 
-  RSI = rsi + increment;
-  RDI = rdi + increment;
+  RSI = rsi;
+  RDI = rdi;
 }
 #endif
 
 /* 16 bit opsize mode, 16 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::MOVSW16_YwXw(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepMOVS(i, 2);
+#endif
+
   Bit16u si = SI;
   Bit16u di = DI;
 
@@ -231,6 +217,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::MOVSW16_YwXw(bxInstruction_c *i)
 /* 16 bit opsize mode, 32 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::MOVSW32_YwXw(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepMOVS(i, 2);
+#endif
+
   Bit32u esi = ESI;
   Bit32u edi = EDI;
 
@@ -255,6 +246,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::MOVSW32_YwXw(bxInstruction_c *i)
 /* 16 bit opsize mode, 64 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::MOVSW64_YwXw(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepMOVS(i, 2);
+#endif
+
   Bit64u rsi = RSI;
   Bit64u rdi = RDI;
 
@@ -278,6 +274,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::MOVSW64_YwXw(bxInstruction_c *i)
 /* 32 bit opsize mode, 16 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::MOVSD16_YdXd(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepMOVS(i, 4);
+#endif
+
   Bit16u si = SI;
   Bit16u di = DI;
 
@@ -300,47 +301,29 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::MOVSD16_YdXd(bxInstruction_c *i)
 /* 32 bit opsize mode, 32 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::MOVSD32_YdXd(bxInstruction_c *i)
 {
-  Bit32s increment = 0;
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepMOVS(i, 4);
+#endif
 
   Bit32u esi = ESI;
   Bit32u edi = EDI;
 
-#if BX_SUPPORT_REPEAT_SPEEDUPS
-  /* If conditions are right, we can transfer IO to physical memory
-   * in a batch, rather than one instruction at a time.
-   */
-  if (i->repUsedL() && !BX_CPU_THIS_PTR get_DF() && !BX_CPU_THIS_PTR async_event)
-  {
-    Bit32u byteCount = FastRepMOVSB(i->seg(), esi, BX_SEG_REG_ES, edi, ECX*4, 4);
-    if (byteCount) {
-      Bit32u dwordCount = byteCount >> 2;
-
-      // Decrement the ticks count by the number of iterations, minus
-      // one, since the main cpu loop will decrement one.  Also,
-      // the count is predecremented before examined, so definitely
-      // don't roll it under zero.
-      BX_TICKN(dwordCount-1);
-
-      // Decrement eCX. Note, the main loop will decrement 1 also, so
-      // decrement by one less than expected, like the case above.
-      RCX = ECX - (dwordCount-1);
+  Bit32u temp32 = read_virtual_dword(i->seg(), esi);
+  write_virtual_dword(BX_SEG_REG_ES, edi, temp32);
 
-      increment = byteCount;
-    }
+  if (BX_CPU_THIS_PTR get_DF()) {
+    esi -= 4;
+    edi -= 4;
   }
-
-  if (increment == 0)
-#endif
-  {
-    Bit32u temp32 = read_virtual_dword(i->seg(), esi);
-    write_virtual_dword(BX_SEG_REG_ES, edi, temp32);
-
-    increment = BX_CPU_THIS_PTR get_DF() ? -4 : 4;
+  else {
+    esi += 4;
+    edi += 4;
   }
 
   // zero extension of RSI/RDI
-  RSI = esi + increment;
-  RDI = edi + increment;
+  RSI = esi;
+  RDI = edi;
 }
 
 #if BX_SUPPORT_X86_64
@@ -348,51 +331,38 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::MOVSD32_YdXd(bxInstruction_c *i)
 /* 32 bit opsize mode, 64 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::MOVSD64_YdXd(bxInstruction_c *i)
 {
-  Bit32s increment = 0;
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepMOVS(i, 4);
+#endif
 
   Bit64u rsi = RSI;
   Bit64u rdi = RDI;
 
-#if BX_SUPPORT_REPEAT_SPEEDUPS
-  /* If conditions are right, we can transfer IO to physical memory
-   * in a batch, rather than one instruction at a time.
-   */
-  if (i->repUsedL() && !BX_CPU_THIS_PTR get_DF() && !BX_CPU_THIS_PTR async_event)
-  {
-    Bit32u byteCount = FastRepMOVSB(get_laddr64(i->seg(), rsi), rdi, ECX*4, 4);
-    if (byteCount) {
-      Bit32u dwordCount = byteCount >> 2;
+  Bit32u temp32 = read_linear_dword(i->seg(), get_laddr64(i->seg(), rsi));
+  write_linear_dword(BX_SEG_REG_ES, rdi, temp32);
 
-      // Decrement the ticks count by the number of iterations, minus
-      // one, since the main cpu loop will decrement one.  Also,
-      // the count is predecremented before examined, so definitely
-      // don't roll it under zero.
-      BX_TICKN(dwordCount-1);
-
-      // Decrement RCX. Note, the main loop will decrement 1 also, so
-      // decrement by one less than expected, like the case above.
-      RCX -= (dwordCount-1);
-
-      increment = byteCount;
-    }
+  if (BX_CPU_THIS_PTR get_DF()) {
+    rsi -= 4;
+    rdi -= 4;
   }
-
-  if (increment == 0)
-#endif
-  {
-    Bit32u temp32 = read_linear_dword(i->seg(), get_laddr64(i->seg(), rsi));
-    write_linear_dword(BX_SEG_REG_ES, rdi, temp32);
-
-    increment = BX_CPU_THIS_PTR get_DF() ? -4 : 4;
+  else {
+    rsi += 4;
+    rdi += 4;
   }
 
-  RSI = rsi + increment;
-  RDI = rdi + increment;
+  RSI = rsi;
+  RDI = rdi;
 }
 
 /* 64 bit opsize mode, 32 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::MOVSQ32_YqXq(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepMOVS(i, 8);
+#endif
+
   Bit32u esi = ESI;
   Bit32u edi = EDI;
 
@@ -416,46 +386,28 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::MOVSQ32_YqXq(bxInstruction_c *i)
 /* 64 bit opsize mode, 64 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::MOVSQ64_YqXq(bxInstruction_c *i)
 {
-  Bit32s increment = 0;
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepMOVS(i, 8);
+#endif
 
   Bit64u rsi = RSI;
   Bit64u rdi = RDI;
 
-#if BX_SUPPORT_REPEAT_SPEEDUPS
-  /* If conditions are right, we can transfer IO to physical memory
-   * in a batch, rather than one instruction at a time.
-   */
-  if (i->repUsedL() && !BX_CPU_THIS_PTR get_DF() && !BX_CPU_THIS_PTR async_event)
-  {
-    Bit32u byteCount = FastRepMOVSB(get_laddr64(i->seg(), rsi), rdi, ECX*8, 8);
-    if (byteCount) {
-      Bit32u qwordCount = byteCount >> 3;
-
-      // Decrement the ticks count by the number of iterations, minus
-      // one, since the main cpu loop will decrement one.  Also,
-      // the count is predecremented before examined, so definitely
-      // don't roll it under zero.
-      BX_TICKN(qwordCount-1);
+  Bit64u temp64 = read_linear_qword(i->seg(), get_laddr64(i->seg(), rsi));
+  write_linear_qword(BX_SEG_REG_ES, rdi, temp64);
 
-      // Decrement RCX. Note, the main loop will decrement 1 also, so
-      // decrement by one less than expected, like the case above.
-      RCX -= (qwordCount-1);
-
-      increment = byteCount;
-    }
+  if (BX_CPU_THIS_PTR get_DF()) {
+    rsi -= 8;
+    rdi -= 8;
   }
-
-  if (increment == 0)
-#endif
-  {
-    Bit64u temp64 = read_linear_qword(i->seg(), get_laddr64(i->seg(), rsi));
-    write_linear_qword(BX_SEG_REG_ES, rdi, temp64);
-
-    increment = BX_CPU_THIS_PTR get_DF() ? -8 : 8;
+  else {
+    rsi += 8;
+    rdi += 8;
   }
 
-  RSI = rsi + increment;
-  RDI = rdi + increment;
+  RSI = rsi;
+  RDI = rdi;
 }
 
 #endif
@@ -547,6 +499,14 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::REP_CMPSQ_XqYq(bxInstruction_c *i)
 /* 16 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMPSB16_XbYb(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  /* If conditions are right, we can skip the elements which do not
+   * terminate the repeat in host memory, rather than one iteration
+   * at a time */
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepCMPS(i, 1);
+#endif
+
   Bit8u op1_8, op2_8, diff_8;
 
   Bit16u si = SI;
@@ -575,6 +535,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMPSB16_XbYb(bxInstruction_c *i)
 /* 32 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMPSB32_XbYb(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepCMPS(i, 1);
+#endif
+
   Bit8u op1_8, op2_8, diff_8;
 
   Bit32u esi = ESI;
@@ -605,6 +570,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMPSB32_XbYb(bxInstruction_c *i)
 /* 64 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMPSB64_XbYb(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepCMPS(i, 1);
+#endif
+
   Bit8u op1_8, op2_8, diff_8;
 
   Bit64u rsi = RSI;
@@ -634,6 +604,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMPSB64_XbYb(bxInstruction_c *i)
 /* 16 bit opsize mode, 16 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMPSW16_XwYw(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepCMPS(i, 2);
+#endif
+
   Bit16u op1_16, op2_16, diff_16;
 
   Bit16u si = SI;
@@ -662,6 +637,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMPSW16_XwYw(bxInstruction_c *i)
 /* 16 bit opsize mode, 32 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMPSW32_XwYw(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepCMPS(i, 2);
+#endif
+
   Bit16u op1_16, op2_16, diff_16;
 
   Bit32u esi = ESI;
@@ -692,6 +672,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMPSW32_XwYw(bxInstruction_c *i)
 /* 16 bit opsize mode, 64 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMPSW64_XwYw(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepCMPS(i, 2);
+#endif
+
   Bit16u op1_16, op2_16, diff_16;
 
   Bit64u rsi = RSI;
@@ -721,6 +706,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMPSW64_XwYw(bxInstruction_c *i)
 /* 32 bit opsize mode, 16 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMPSD16_XdYd(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepCMPS(i, 4);
+#endif
+
   Bit32u op1_32, op2_32, diff_32;
 
   Bit16u si = SI;
@@ -749,6 +739,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMPSD16_XdYd(bxInstruction_c *i)
 /* 32 bit opsize mode, 32 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMPSD32_XdYd(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepCMPS(i, 4);
+#endif
+
   Bit32u op1_32, op2_32, diff_32;
 
   Bit32u esi = ESI;
@@ -780,6 +775,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMPSD32_XdYd(bxInstruction_c *i)
 /* 32 bit opsize mode, 64 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMPSD64_XdYd(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepCMPS(i, 4);
+#endif
+
   Bit32u op1_32, op2_32, diff_32;
 
   Bit64u rsi = RSI;
@@ -808,6 +808,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMPSD64_XdYd(bxInstruction_c *i)
 /* 64 bit opsize mode, 32 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMPSQ32_XqYq(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepCMPS(i, 8);
+#endif
+
   Bit64u op1_64, op2_64, diff_64;
 
   Bit32u esi = ESI;
@@ -837,6 +842,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMPSQ32_XqYq(bxInstruction_c *i)
 /* 64 bit opsize mode, 64 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMPSQ64_XqYq(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepCMPS(i, 8);
+#endif
+
   Bit64u op1_64, op2_64, diff_64;
 
   Bit64u rsi = RSI;
@@ -947,6 +957,14 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::REP_SCASQ_RAXYq(bxInstruction_c *i)
 /* 16 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::SCASB16_ALYb(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  /* If conditions are right, we can skip the elements which do not
+   * terminate the repeat in host memory, rather than one iteration
+   * at a time */
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepSCAS(i, 1, AL);
+#endif
+
   Bit8u op1_8 = AL, op2_8, diff_8;
 
   Bit16u di = DI;
@@ -970,6 +988,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SCASB16_ALYb(bxInstruction_c *i)
 /* 32 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::SCASB32_ALYb(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepSCAS(i, 1, AL);
+#endif
+
   Bit8u op1_8 = AL, op2_8, diff_8;
 
   Bit32u edi = EDI;
@@ -994,6 +1017,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SCASB32_ALYb(bxInstruction_c *i)
 /* 64 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::SCASB64_ALYb(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepSCAS(i, 1, AL);
+#endif
+
   Bit8u op1_8 = AL, op2_8, diff_8;
 
   Bit64u rdi = RDI;
@@ -1018,6 +1046,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SCASB64_ALYb(bxInstruction_c *i)
 /* 16 bit opsize mode, 16 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::SCASW16_AXYw(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepSCAS(i, 2, AX);
+#endif
+
   Bit16u op1_16 = AX, op2_16, diff_16;
 
   Bit16u di = DI;
@@ -1040,6 +1073,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SCASW16_AXYw(bxInstruction_c *i)
 /* 16 bit opsize mode, 32 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::SCASW32_AXYw(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepSCAS(i, 2, AX);
+#endif
+
   Bit16u op1_16 = AX, op2_16, diff_16;
 
   Bit32u edi = EDI;
@@ -1064,6 +1102,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SCASW32_AXYw(bxInstruction_c *i)
 /* 16 bit opsize mode, 64 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::SCASW64_AXYw(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepSCAS(i, 2, AX);
+#endif
+
   Bit16u op1_16 = AX, op2_16, diff_16;
 
   Bit64u rdi = RDI;
@@ -1088,6 +1131,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SCASW64_AXYw(bxInstruction_c *i)
 /* 32 bit opsize mode, 16 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::SCASD16_EAXYd(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepSCAS(i, 4, EAX);
+#endif
+
   Bit32u op1_32 = EAX, op2_32, diff_32;
 
   Bit16u di = DI;
@@ -1110,6 +1158,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SCASD16_EAXYd(bxInstruction_c *i)
 /* 32 bit opsize mode, 32 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::SCASD32_EAXYd(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepSCAS(i, 4, EAX);
+#endif
+
   Bit32u op1_32 = EAX, op2_32, diff_32;
 
   Bit32u edi = EDI;
@@ -1135,6 +1188,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SCASD32_EAXYd(bxInstruction_c *i)
 /* 32 bit opsize mode, 64 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::SCASD64_EAXYd(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepSCAS(i, 4, EAX);
+#endif
+
   Bit32u op1_32 = EAX, op2_32, diff_32;
 
   Bit64u rdi = RDI;
@@ -1158,6 +1216,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SCASD64_EAXYd(bxInstruction_c *i)
 /* 64 bit opsize mode, 32 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::SCASQ32_RAXYq(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepSCAS(i, 8, RAX);
+#endif
+
   Bit64u op1_64 = RAX, op2_64, diff_64;
 
   Bit32u edi = EDI;
@@ -1182,6 +1245,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SCASQ32_RAXYq(bxInstruction_c *i)
 /* 64 bit opsize mode, 64 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::SCASQ64_RAXYq(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepSCAS(i, 8, RAX);
+#endif
+
   Bit64u op1_64 = RAX, op2_64, diff_64;
 
   Bit64u rdi = RDI;
@@ -1284,6 +1352,13 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::REP_STOSQ_YqRAX(bxInstruction_c *i)
 // 16 bit address size
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::STOSB16_YbAL(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  /* If conditions are right, we can transfer the data in host memory
+   * in a batch, rather than one iteration at a time */
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepSTOS(i, 1, AL);
+#endif
+
   Bit16u di = DI;
 
   write_virtual_byte_32(BX_SEG_REG_ES, di, AL);
@@ -1301,87 +1376,58 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::STOSB16_YbAL(bxInstruction_c *i)
 // 32 bit address size
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::STOSB32_YbAL(bxInstruction_c *i)
 {
-  Bit32s increment = 0;
-  Bit32u edi = EDI;
-
 #if BX_SUPPORT_REPEAT_SPEEDUPS
-  /* If conditions are right, we can transfer IO to physical memory
-   * in a batch, rather than one instruction at a time.
-   */
-  if (i->repUsedL() && !BX_CPU_THIS_PTR get_DF() && !BX_CPU_THIS_PTR async_event)
-  {
-    Bit32u byteCount = FastRepSTOSB(BX_SEG_REG_ES, edi, AL, ECX);
-    if (byteCount) {
-      // Decrement the ticks count by the number of iterations, minus
-      // one, since the main cpu loop will decrement one.  Also,
-      // the count is predecremented before examined, so definitely
-      // don't roll it under zero.
-      BX_TICKN(byteCount-1);
-
-      // Decrement eCX.  Note, the main loop will decrement 1 also, so
-      // decrement by one less than expected, like the case above.
-      RCX = ECX - (byteCount-1);
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepSTOS(i, 1, AL);
+#endif
 
-      increment = byteCount;
-    }
-  }
+  Bit32u edi = EDI;
 
-  if (increment == 0)
-#endif
-  {
-    write_virtual_byte(BX_SEG_REG_ES, edi, AL);
+  write_virtual_byte(BX_SEG_REG_ES, edi, AL);
 
-    increment = BX_CPU_THIS_PTR get_DF() ? -1 : 1;
+  if (BX_CPU_THIS_PTR get_DF()) {
+    edi--;
+  }
+  else {
+    edi++;
   }
 
   // zero extension of RDI
-  RDI = edi + increment;
+  RDI = edi;
 }
 
 #if BX_SUPPORT_X86_64
 // 64 bit address size
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::STOSB64_YbAL(bxInstruction_c *i)
 {
-  Bit64u rdi = RDI;
-  Bit32s increment = 0;
-
 #if BX_SUPPORT_REPEAT_SPEEDUPS
-  /* If conditions are right, we can transfer IO to physical memory
-   * in a batch, rather than one instruction at a time.
-   */
-  if (i->repUsedL() && !BX_CPU_THIS_PTR get_DF() && !BX_CPU_THIS_PTR async_event)
-  {
-    Bit32u byteCount = FastRepSTOSB(rdi, AL, ECX);
-    if (byteCount) {
-      // Decrement the ticks count by the number of iterations, minus
-      // one, since the main cpu loop will decrement one.  Also,
-      // the count is predecremented before examined, so definitely
-      // don't roll it under zero.
-      BX_TICKN(byteCount-1);
-
-      // Decrement RCX.  Note, the main loop will decrement 1 also, so
-      // decrement by one less than expected, like the case above.
-      RCX -= (byteCount-1);
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepSTOS(i, 1, AL);
+#endif
 
-      increment = byteCount;
-    }
-  }
+  Bit64u rdi = RDI;
 
-  if (increment == 0)
-#endif
-  {
-    write_linear_byte(BX_SEG_REG_ES, rdi, AL);
+  write_linear_byte(BX_SEG_REG_ES, rdi, AL);
 
-    increment = BX_CPU_THIS_PTR get_DF() ? -1 : 1;
+  if (BX_CPU_THIS_PTR get_DF()) {
+    rdi--;
+  }
+  else {
+    rdi++;
   }
 
-  RDI = rdi + increment;
+  RDI = rdi;
 }
 #endif
 
 /* 16 bit opsize mode, 16 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::STOSW16_YwAX(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepSTOS(i, 2, AX);
+#endif
+
   Bit16u di = DI;
 
   write_virtual_word_32(BX_SEG_REG_ES, di, AX);
@@ -1399,6 +1445,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::STOSW16_YwAX(bxInstruction_c *i)
 /* 16 bit opsize mode, 32 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::STOSW32_YwAX(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepSTOS(i, 2, AX);
+#endif
+
   Bit32u edi = EDI;
 
   write_virtual_word(BX_SEG_REG_ES, edi, AX);
@@ -1418,6 +1469,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::STOSW32_YwAX(bxInstruction_c *i)
 /* 16 bit opsize mode, 32 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::STOSW64_YwAX(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepSTOS(i, 2, AX);
+#endif
+
   Bit64u rdi = RDI;
 
   write_linear_word(BX_SEG_REG_ES, rdi, AX);
@@ -1436,6 +1492,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::STOSW64_YwAX(bxInstruction_c *i)
 /* 32 bit opsize mode, 16 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::STOSD16_YdEAX(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepSTOS(i, 4, EAX);
+#endif
+
   Bit16u di = DI;
 
   write_virtual_dword_32(BX_SEG_REG_ES, di, EAX);
@@ -1453,6 +1514,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::STOSD16_YdEAX(bxInstruction_c *i)
 /* 32 bit opsize mode, 32 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::STOSD32_YdEAX(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepSTOS(i, 4, EAX);
+#endif
+
   Bit32u edi = EDI;
 
   write_virtual_dword(BX_SEG_REG_ES, edi, EAX);
@@ -1473,6 +1539,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::STOSD32_YdEAX(bxInstruction_c *i)
 /* 32 bit opsize mode, 32 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::STOSD64_YdEAX(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepSTOS(i, 4, EAX);
+#endif
+
   Bit64u rdi = RDI;
 
   write_linear_dword(BX_SEG_REG_ES, rdi, EAX);
@@ -1490,6 +1561,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::STOSD64_YdEAX(bxInstruction_c *i)
 /* 64 bit opsize mode, 32 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::STOSQ32_YqRAX(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepSTOS(i, 8, RAX);
+#endif
+
   Bit32u edi = EDI;
 
   write_linear_qword(BX_SEG_REG_ES, edi, RAX);
@@ -1508,6 +1584,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::STOSQ32_YqRAX(bxInstruction_c *i)
 /* 64 bit opsize mode, 64 bit address size */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::STOSQ64_YqRAX(bxInstruction_c *i)
 {
+#if BX_SUPPORT_REPEAT_SPEEDUPS
+  if (i->repUsedL() && !BX_CPU_THIS_PTR async_event)
+    FastRepSTOS(i, 8, RAX);
+#endif
+
   Bit64u rdi = RDI;
 
   write_linear_qword(BX_SEG_REG_ES, rdi, RAX);
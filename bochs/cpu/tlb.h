@@ -49,17 +49,18 @@ BX_CPP_INLINE bx_address AlignedAccessLPFOf(bx_address laddr, unsigned alignment
   return laddr & (LPF_MASK | alignment_mask);
 }
 
-// BX_TLB_INDEX_OF(lpf): This macro is passed the linear page frame
-//   (top bits of the linear address).  It must map these bits to
-//   one of the TLB cache slots, given the size of BX_TLB_SIZE.
-//   There will be a many-to-one mapping to each TLB cache slot.
-//   When there are collisions, the old entry is overwritten with
-//   one for the newest access.
+// BX_DTLB_ENTRY_OF(lpf, len): Returns the TLB entry caching the linear
+//   page frame (top bits of the linear address) if there is one in the
+//   set the page frame maps to. Otherwise an invalid entry which does not
+//   belong to the TLB is returned and the TLB is left unchanged.
 #define BX_DTLB_ENTRY_OF(lpf, len) (BX_CPU_THIS_PTR DTLB.get_entry_of((lpf), (len)))
-#define BX_DTLB_INDEX_OF(lpf, len) (BX_CPU_THIS_PTR DTLB.get_index_of((lpf), (len)))
 
-#define BX_ITLB_ENTRY_OF(lpf) (BX_CPU_THIS_PTR ITLB.get_entry_of(lpf))
-#define BX_ITLB_INDEX_OF(lpf) (BX_CPU_THIS_PTR ITLB.get_index_of(lpf))
+// BX_DTLB_FILL_ENTRY_OF(lpf, len): Same on a hit. On a miss the least
+//   recently used entry of the set is invalidated and returned, it is
+//   filled by translate_linear().
+#define BX_DTLB_FILL_ENTRY_OF(lpf, len) (BX_CPU_THIS_PTR DTLB.get_fill_entry_of((lpf), (len)))
+
+#define BX_ITLB_ENTRY_OF(lpf) (BX_CPU_THIS_PTR ITLB.get_fill_entry_of(lpf))
 
 typedef bx_ptr_equiv_t bx_hostpageaddr_t;
 
@@ -162,6 +163,7 @@ struct bx_TLB_entry
 #if BX_SUPPORT_MEMTYPE
   Bit32u memtype;       // keep it Bit32u for alignment
 #endif
+  Bit32u pcid;          // PCID the translation was cached for
 
   bx_TLB_entry() { invalidate(); }
 
@@ -175,25 +177,126 @@ struct bx_TLB_entry
   BX_CPP_INLINE Bit32u get_memtype() const { return MEMTYPE(memtype); }
 };
 
-template <unsigned size>
+// Large pages (2M/4M/1G) are cached in a separate small direct mapped
+// array indexed by the 2M frame of the linear address. The 4K TLB is
+// refilled from it without a page walk, the 4K entry is the one the
+// memory access fast paths use.
+#define BX_LARGE_TLB_SIZE 64 /* must be power of two */
+
+struct bx_large_TLB_entry
+{
+  bx_address lpf;       // linear frame of the large page
+  bx_phy_address ppf;   // physical frame of the large page
+  Bit32u lpf_mask;      // linear address mask of the page size
+  Bit32u accessBits;
+#if BX_SUPPORT_PKEYS
+  Bit32u pkey;
+#endif
+  Bit32u combined_access; // page walk info (effective page tables memory type)
+  Bit32u pcid;
+
+  bx_large_TLB_entry() { invalidate(); }
+
+  BX_CPP_INLINE bool valid() const { return lpf != BX_INVALID_TLB_ENTRY; }
+
+  BX_CPP_INLINE void invalidate() {
+    lpf = BX_INVALID_TLB_ENTRY;
+    accessBits = 0;
+  }
+};
+
+// size entries organized in sets of ways entries with LRU replacement, the
+// entries of a set are kept ordered from the most recently used one
+template <unsigned size, unsigned ways>
 struct TLB {
   bx_TLB_entry entry[size];
+  bx_large_TLB_entry large_entry[BX_LARGE_TLB_SIZE];
+  bx_TLB_entry miss_entry; // always invalid, returned by get_entry_of() on a miss
+  Bit32u pcid;          // PCID the lookups are done for
 #if BX_CPU_LEVEL >= 5
   bool split_large;
 #endif
 
 public:
-  TLB() { flush(); }
+  TLB() { pcid = 0; flush(); }
 
   BX_CPP_INLINE unsigned get_index_of(bx_address lpf, unsigned len = 0)
   {
-    const Bit32u tlb_mask = ((size-1) << 12);
-    return (((unsigned(lpf) + len) & tlb_mask) >> 12);
+    const Bit32u tlb_mask = ((size/ways-1) << 12);
+    return (((unsigned(lpf) + len) & tlb_mask) >> 12) * ways;
+  }
+
+  // global translations are valid for any PCID
+  BX_CPP_INLINE bool match(const bx_TLB_entry *tlbEntry, bx_address lpf) const
+  {
+    return LPFOf(tlbEntry->lpf) == lpf &&
+          (tlbEntry->pcid == pcid || (tlbEntry->accessBits & TLB_GlobalPage) != 0);
+  }
+
+  // the entry at the way becomes the first (most recently used) in the set
+  BX_CPP_INLINE void move_to_front(bx_TLB_entry *set, unsigned way)
+  {
+    bx_TLB_entry tmp = set[way];
+    for (; way > 0; way--)
+      set[way] = set[way-1];
+    set[0] = tmp;
+  }
+
+  // returns the first entry of the set after a hit, NULL on a miss
+  BX_CPP_INLINE bx_TLB_entry *lookup(bx_TLB_entry *set, bx_address lpf)
+  {
+    if (match(set, lpf)) return set;
+
+    for (unsigned way=1; way < ways; way++) {
+      if (match(&set[way], lpf)) {
+        move_to_front(set, way);
+        return set;
+      }
+    }
+    return NULL;
   }
 
   BX_CPP_INLINE bx_TLB_entry *get_entry_of(bx_address lpf, unsigned len = 0)
   {
-    return &entry[get_index_of(lpf, len)];
+    bx_TLB_entry *tlbEntry = lookup(&entry[get_index_of(lpf, len)], LPFOf(lpf + len));
+    return tlbEntry ? tlbEntry : &miss_entry;
+  }
+
+  BX_CPP_INLINE bx_TLB_entry *get_fill_entry_of(bx_address lpf, unsigned len = 0)
+  {
+    bx_TLB_entry *set = &entry[get_index_of(lpf, len)];
+    bx_TLB_entry *tlbEntry = lookup(set, LPFOf(lpf + len));
+    if (tlbEntry) return tlbEntry;
+
+    // miss: the least recently used entry becomes the first in the set, it
+    // could cache the page for another PCID and must not look like a hit
+    move_to_front(set, ways-1);
+    set->invalidate();
+    return set;
+  }
+
+  // lookup without changing the TLB state, NULL if the page is not cached
+  BX_CPP_INLINE bx_TLB_entry *find_entry_of(bx_address lpf)
+  {
+    bx_TLB_entry *set = &entry[get_index_of(lpf)];
+    for (unsigned way=0; way < ways; way++) {
+      if (match(&set[way], LPFOf(lpf))) return &set[way];
+    }
+    return NULL;
+  }
+
+  BX_CPP_INLINE bx_large_TLB_entry *get_large_entry_of(bx_address laddr)
+  {
+    return &large_entry[(laddr >> 21) & (BX_LARGE_TLB_SIZE-1)];
+  }
+
+  BX_CPP_INLINE bx_large_TLB_entry *find_large_entry_of(bx_address laddr)
+  {
+    bx_large_TLB_entry *largeEntry = get_large_entry_of(laddr);
+    if (largeEntry->valid() && (laddr & ~((bx_address) largeEntry->lpf_mask)) == largeEntry->lpf &&
+        (largeEntry->pcid == pcid || (largeEntry->accessBits & TLB_GlobalPage) != 0))
+      return largeEntry;
+    return NULL;
   }
 
   BX_CPP_INLINE void flush(void)
@@ -201,32 +304,48 @@ public:
     for (unsigned n=0; n < size; n++)
       entry[n].invalidate();
 
+    for (unsigned n=0; n < BX_LARGE_TLB_SIZE; n++)
+      large_entry[n].invalidate();
+
 #if BX_CPU_LEVEL >= 5
     split_large = false;  // flushing whole TLB
 #endif
   }
 
 #if BX_CPU_LEVEL >= 6
-  BX_CPP_INLINE void flushNonGlobal(void)
+  // invalidate non global entries, of all PCIDs or of a single one
+  BX_CPP_INLINE void flushNonGlobal(bool all_pcids = true, Bit32u flush_pcid = 0)
   {
     Bit32u lpf_mask = 0;
 
     for (unsigned n=0; n<size; n++) {
       bx_TLB_entry *tlbEntry = &entry[n];
       if (tlbEntry->valid()) {
-        if (!(tlbEntry->accessBits & TLB_GlobalPage))
+        if (!(tlbEntry->accessBits & TLB_GlobalPage) && (all_pcids || tlbEntry->pcid == flush_pcid))
           tlbEntry->invalidate();
         else
           lpf_mask |= tlbEntry->lpf_mask;
       }
     }
 
+    for (unsigned n=0; n < BX_LARGE_TLB_SIZE; n++) {
+      bx_large_TLB_entry *largeEntry = &large_entry[n];
+      if (!(largeEntry->accessBits & TLB_GlobalPage) && (all_pcids || largeEntry->pcid == flush_pcid))
+        largeEntry->invalidate();
+    }
+
     split_large = (lpf_mask > 0xfff);
   }
 #endif
 
   BX_CPP_INLINE void invlpg(bx_address laddr)
   {
+    for (unsigned n=0; n < BX_LARGE_TLB_SIZE; n++) {
+      bx_large_TLB_entry *largeEntry = &large_entry[n];
+      if (largeEntry->valid() && (laddr & ~((bx_address) largeEntry->lpf_mask)) == largeEntry->lpf)
+        largeEntry->invalidate();
+    }
+
 #if BX_CPU_LEVEL >= 5
     if (split_large) {
       Bit32u lpf_mask = 0;
@@ -250,11 +369,120 @@ public:
     else
 #endif
     {
-      bx_TLB_entry *tlbEntry = get_entry_of(laddr);
-      if (LPFOf(tlbEntry->lpf) == LPFOf(laddr))
-        tlbEntry->invalidate();
+      // the page could be cached for several PCIDs
+      bx_TLB_entry *set = &entry[get_index_of(laddr)];
+      for (unsigned way=0; way < ways; way++) {
+        if (LPFOf(set[way].lpf) == LPFOf(laddr))
+          set[way].invalidate();
+      }
     }
   }
 };
 
+#if BX_SUPPORT_X86_64
+
+// Paging structure cache for the long mode page walk
+//
+// Keeps the recently used non-leaf paging structure entries, one table per
+// level (PDE, PDPTE and PML4E). An entry is tagged with the linear address
+// bits translated by its level and all the levels above it and remembers
+// the U/S, R/W and NX permissions accumulated down to it, so the page walk
+// of a TLB miss can start below the deepest cached level. Only entries of
+// successful page walks (present, with the accessed bit set) are cached.
+// The cache is flushed together with the TLBs and on every CR3 write.
+
+#define BX_PWC_SIZE 32 /* entries per level, must be power of 2 */
+
+struct bx_PWC_entry {
+  bx_address tag;          // laddr >> (12 + 9*level)
+  Bit64u entry;            // paging structure entry, points to the next level table
+  Bit32u combined_access;  // U/S and R/W of this and the upper levels
+  bool nx_page;            // NX set in this or the upper levels
+};
+
+struct bx_PWC {
+  bx_PWC_entry entry[3][BX_PWC_SIZE];  // PDE, PDPTE and PML4E levels
+
+  static BX_CPP_INLINE bx_address get_tag(bx_address laddr, unsigned level)
+  {
+    return laddr >> (12 + 9*level);
+  }
+
+  // returns the cached entry of the level for the linear address or NULL
+  BX_CPP_INLINE bx_PWC_entry *find_entry_of(bx_address laddr, unsigned level)
+  {
+    bx_address tag = get_tag(laddr, level);
+    bx_PWC_entry *e = &entry[level-1][tag & (BX_PWC_SIZE-1)];
+    return (e->tag == tag) ? e : NULL;
+  }
+
+  BX_CPP_INLINE void set_entry(bx_address laddr, unsigned level, Bit64u pte, Bit32u combined_access, bool nx_page)
+  {
+    bx_address tag = get_tag(laddr, level);
+    bx_PWC_entry *e = &entry[level-1][tag & (BX_PWC_SIZE-1)];
+    e->tag = tag;
+    e->entry = pte;
+    e->combined_access = combined_access;
+    e->nx_page = nx_page;
+  }
+
+  BX_CPP_INLINE void flush(void)
+  {
+    for (unsigned level=0; level < 3; level++)
+      for (unsigned n=0; n < BX_PWC_SIZE; n++)
+        entry[level][n].tag = BX_INVALID_TLB_ENTRY;
+  }
+};
+
+#endif
+
+#if BX_SUPPORT_VMX >= 2 || BX_SUPPORT_SVM
+
+// Guest physical to host physical translation cache for the accesses of
+// the guest page walk to the guest paging structures, which otherwise need
+// a full EPT or NPT walk each. Flushed together with the TLBs, which covers
+// VM entry and exit, INVEPT and EPTP switching.
+
+#define BX_NESTED_PWC_SIZE 64 /* must be power of 2 */
+
+struct bx_nested_PWC_entry {
+  bx_phy_address gpf;   // guest physical page frame
+  bx_phy_address hpf;   // host physical page frame
+  bool write;           // translated for write access (dirty bits are set)
+};
+
+struct bx_nested_PWC {
+  bx_nested_PWC_entry entry[BX_NESTED_PWC_SIZE];
+
+  BX_CPP_INLINE bx_nested_PWC_entry *get_entry_of(bx_phy_address guest_paddr)
+  {
+    return &entry[(guest_paddr >> 12) & (BX_NESTED_PWC_SIZE-1)];
+  }
+
+  // returns the entry translating the guest physical address for the access or NULL
+  BX_CPP_INLINE bx_nested_PWC_entry *find_entry_of(bx_phy_address guest_paddr, unsigned rw)
+  {
+    bx_nested_PWC_entry *e = get_entry_of(guest_paddr);
+    if (e->gpf == (guest_paddr & PPF_MASK) && (e->write || !(rw & 1)))
+      return e;
+    return NULL;
+  }
+
+  BX_CPP_INLINE void set_entry(bx_phy_address guest_paddr, bx_phy_address host_paddr, unsigned rw)
+  {
+    bx_nested_PWC_entry *e = get_entry_of(guest_paddr);
+    e->gpf = guest_paddr & PPF_MASK;
+    e->hpf = host_paddr & PPF_MASK;
+    e->write = (rw & 1);
+  }
+
+  BX_CPP_INLINE void flush(void)
+  {
+    for (unsigned n=0; n < BX_NESTED_PWC_SIZE; n++)
+      entry[n].gpf = (bx_phy_address) BX_INVALID_TLB_ENTRY;
+  }
+};
+
+#endif
+
 #endif
@@ -0,0 +1,561 @@
+/////////////////////////////////////////////////////////////////////////
+// $Id$
+/////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (C) 2026  The Bochs Project
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA B 02110-1301 USA
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include "bochs.h"
+#include "bxversion.h"
+#include "cpu.h"
+#include "tracefile.h"
+#define LOG_THIS genlog->
+
+#include "decoder/ia_opcodes.h"
+
+#ifndef WIN32
+#include <unistd.h>
+#endif
+#if BX_HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+bxTraceFile_c traceFile;
+
+#define BX_TRACE_FILE_MAGIC      "BXTRACE2"
+#define BX_TRACE_FILE_BYTE_ORDER 0x01020304
+// pages kept in the file, the pages recorded in the last run come first
+#define BX_TRACE_FILE_MAX_FILE_PAGES (2 * BX_TRACE_FILE_MAX_PAGES)
+#define BX_TRACE_FILE_RECORD_INDEX   (2 * BX_TRACE_FILE_MAX_PAGES)
+
+struct bxTraceFileHeader_t {
+  char   magic[8];
+  Bit64u signature;
+  Bit64u build;         // key of the binary which wrote the file
+  Bit32u byteOrder;
+  Bit32u instrSize;
+  Bit32u numPages;
+  Bit32u reserved;
+};
+
+struct bxTraceFileRecord_t {
+  bx_phy_address ppf;
+  unsigned mode;
+  Bit64u hash;
+  Bit8u page[BX_TRACE_FILE_PAGE_SIZE];
+  Bit8u started[BX_TRACE_FILE_PAGE_SIZE / 8]; // offsets with a recorded trace
+  bxTraceFileTrace_t *traces;
+  unsigned ntraces, maxTraces;
+  bxInstruction_c *instr;
+  unsigned ninstr, maxInstr;
+  int source;           // loaded record with the same content or -1
+  bool modified;        // the page was modified after it was recorded
+};
+
+BX_CPP_INLINE static size_t traceDescSize(unsigned ntraces)
+{
+  return (sizeof(bxTraceFileTrace_t) * ntraces + 7) & ~7;
+}
+
+BX_CPP_INLINE static size_t pageRecordSize(unsigned ntraces, unsigned ninstr)
+{
+  return sizeof(bxTraceFilePage_t) + BX_TRACE_FILE_PAGE_SIZE +
+         traceDescSize(ntraces) + sizeof(bxInstruction_c) * ninstr;
+}
+
+static Bit64u hashBytes(Bit64u hash, const void *data, size_t len)
+{
+  const Bit8u *p = (const Bit8u *) data;
+  for (; len >= 8; len -= 8, p += 8) {
+    Bit64u val;
+    memcpy(&val, p, 8);
+    hash = (hash ^ val) * BX_CONST64(0x9e3779b97f4a7c15);
+    hash ^= hash >> 29;
+  }
+  for (; len; len--, p++)
+    hash = (hash ^ *p) * BX_CONST64(0x100000001b3);
+  return hash;
+}
+
+// the decoded instructions are only valid for the binary which wrote them,
+// a rebuild could change the layout of bxInstruction_c keeping its size
+static Bit64u buildKey(void)
+{
+  Bit64u hash = BX_CONST64(0xcbf29ce484222325);
+  hash = hashBytes(hash, REL_STRING, strlen(REL_STRING));
+#if defined(__DATE__) && defined(__TIME__)
+  hash = hashBytes(hash, __DATE__ " " __TIME__, strlen(__DATE__ " " __TIME__));
+#endif
+  return hash;
+}
+
+// checksum of a page record, the age is updated in place and not covered
+static Bit32u recordChecksum(const bxTraceFilePage_t *rec, const Bit8u *page,
+     const bxTraceFileTrace_t *traces, const void *instr)
+{
+  Bit32u fields[3] = { rec->mode, rec->ntraces, rec->ninstr };
+  Bit64u hash = BX_CONST64(0xcbf29ce484222325);
+  hash = hashBytes(hash, &rec->hash, sizeof(rec->hash));
+  hash = hashBytes(hash, fields, sizeof(fields));
+  hash = hashBytes(hash, page, BX_TRACE_FILE_PAGE_SIZE);
+  hash = hashBytes(hash, traces, sizeof(bxTraceFileTrace_t) * rec->ntraces);
+  hash = hashBytes(hash, instr, sizeof(bxInstruction_c) * rec->ninstr);
+  return (Bit32u)(hash ^ (hash >> 32));
+}
+
+BX_CPP_INLINE static unsigned recordSlot(bx_phy_address ppf, unsigned mode)
+{
+  return ((unsigned)(ppf >> 12) * 4 + mode) & (BX_TRACE_FILE_RECORD_INDEX-1);
+}
+
+bxTraceFile_c::bxTraceFile_c(): path(NULL), signature(0),
+  image(NULL), imageSize(0), imageMapped(false),
+  loaded(NULL), numLoaded(0), adopted(NULL), used(NULL), loadedIndex(NULL), loadedIndexMask(0),
+  recorded(NULL), numRecorded(0), recordIndex(NULL), dirty(false)
+{
+}
+
+bxTraceFile_c::~bxTraceFile_c()
+{
+  if (! path) return;
+
+  for (unsigned n=0; n < numRecorded; n++) {
+    delete [] recorded[n]->traces;
+    delete [] recorded[n]->instr;
+    delete recorded[n];
+  }
+  delete [] recorded;
+  delete [] recordIndex;
+  unmapImage();
+  free(path);
+  BX_FINI_MUTEX(lock);
+}
+
+Bit64u bxTraceFile_c::hashPage(const Bit8u *page)
+{
+  Bit64u hash = BX_CONST64(0xcbf29ce484222325);
+
+  for (unsigned n=0; n < BX_TRACE_FILE_PAGE_SIZE; n += 8) {
+    Bit64u val;
+    memcpy(&val, page + n, 8);
+    hash = (hash ^ val) * BX_CONST64(0x9e3779b97f4a7c15);
+    hash ^= hash >> 29;
+  }
+
+  return hash;
+}
+
+void bxTraceFile_c::open(const char *filename, Bit64u sig)
+{
+  if (path) return;
+
+  path = strdup(filename);
+  signature = sig;
+  BX_INIT_MUTEX(lock);
+
+  recorded = new bxTraceFileRecord_t*[BX_TRACE_FILE_MAX_PAGES];
+  recordIndex = new Bit32u[BX_TRACE_FILE_RECORD_INDEX];
+  memset(recordIndex, 0, sizeof(Bit32u) * BX_TRACE_FILE_RECORD_INDEX);
+
+  loadImage();
+}
+
+void bxTraceFile_c::loadImage(void)
+{
+  FILE *fp = fopen(path, "rb");
+  if (! fp) {
+    BX_INFO(("trace cache file '%s' not found, it will be created", path));
+    return;
+  }
+
+  long size = -1;
+  if (! fseek(fp, 0, SEEK_END)) size = ftell(fp);
+  if (size < (long) sizeof(bxTraceFileHeader_t)) {
+    BX_ERROR(("trace cache file '%s' is truncated, ignored", path));
+    fclose(fp);
+    return;
+  }
+  imageSize = (size_t) size;
+
+#ifdef _POSIX_MAPPED_FILES
+  void *mem = mmap(NULL, imageSize, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+  if (mem != MAP_FAILED) {
+    image = (Bit8u *) mem;
+    imageMapped = true;
+  }
+#endif
+  if (! image) {
+    image = new Bit8u[imageSize];
+    if (fseek(fp, 0, SEEK_SET) || fread(image, 1, imageSize, fp) != imageSize) {
+      BX_ERROR(("failed to read trace cache file '%s', ignored", path));
+      fclose(fp);
+      unmapImage();
+      return;
+    }
+  }
+  fclose(fp);
+
+  const bxTraceFileHeader_t *header = (const bxTraceFileHeader_t *) image;
+  if (memcmp(header->magic, BX_TRACE_FILE_MAGIC, 8) || header->byteOrder != BX_TRACE_FILE_BYTE_ORDER ||
+      header->instrSize != sizeof(bxInstruction_c) || header->signature != signature ||
+      header->build != buildKey())
+  {
+    BX_INFO(("trace cache file '%s' was written by another configuration, ignored", path));
+    unmapImage();
+    return;
+  }
+
+  unsigned numPages = header->numPages;
+  if (numPages > BX_TRACE_FILE_MAX_FILE_PAGES) {
+    BX_ERROR(("trace cache file '%s' is corrupted, ignored", path));
+    unmapImage();
+    return;
+  }
+
+  loaded = new const bxTraceFilePage_t*[numPages];
+  adopted = new bool[numPages];
+  used = new bool[numPages];
+
+  // check every record before using any of them, a damaged record is dropped
+  // and its page is decoded again from the guest memory
+  unsigned dropped = 0;
+  size_t pos = sizeof(bxTraceFileHeader_t);
+  for (unsigned n=0; n < numPages; n++) {
+    const bxTraceFilePage_t *rec = (const bxTraceFilePage_t *)(image + pos);
+    bool ok = (imageSize - pos) >= sizeof(bxTraceFilePage_t);
+    if (ok) {
+      ok = rec->ntraces <= BX_TRACE_FILE_PAGE_SIZE && rec->ninstr <= BX_TRACE_FILE_PAGE_SIZE &&
+           rec->size == pageRecordSize(rec->ntraces, rec->ninstr) && rec->size <= (imageSize - pos);
+    }
+    if (! ok) {
+      // the following records cannot be located anymore
+      dropped += numPages - n;
+      break;
+    }
+    pos += rec->size;
+
+    const bxTraceFileTrace_t *t = (const bxTraceFileTrace_t *)
+       ((const Bit8u *)(rec + 1) + BX_TRACE_FILE_PAGE_SIZE);
+    const Bit8u *instr = (const Bit8u *) t + traceDescSize(rec->ntraces);
+    ok = recordChecksum(rec, (const Bit8u *)(rec + 1), t, instr) == rec->checksum;
+    if (ok) {
+      unsigned total = 0;
+      for (unsigned k=0; ok && k < rec->ntraces; k++, t++) {
+        unsigned offset = t->offset;
+        ok = t->len > 0 && (total + t->len) <= rec->ninstr;
+        for (unsigned j=0; ok && j < t->len; j++, total++) {
+          bxInstruction_c i;
+          memcpy(&i, instr + total * sizeof(bxInstruction_c), sizeof(bxInstruction_c));
+          ok = i.getIaOpcode() < BX_IA_LAST && i.ilen() > 0 && (offset + i.ilen()) <= BX_TRACE_FILE_PAGE_SIZE;
+          offset += i.ilen();
+        }
+      }
+      ok = ok && total == rec->ninstr;
+    }
+    if (! ok) {
+      dropped++;
+      continue;
+    }
+    loaded[numLoaded] = rec;
+    adopted[numLoaded] = false;
+    used[numLoaded] = false;
+    numLoaded++;
+  }
+
+  if (dropped)
+    BX_ERROR(("trace cache file '%s': %u corrupted pages dropped", path, dropped));
+
+  unsigned indexSize = 1;
+  while (indexSize < numLoaded * 2) indexSize <<= 1;
+  loadedIndex = new Bit32u[indexSize];
+  memset(loadedIndex, 0, sizeof(Bit32u) * indexSize);
+  loadedIndexMask = indexSize - 1;
+
+  for (unsigned n=0; n < numLoaded; n++) {
+    unsigned slot = (unsigned)(loaded[n]->hash ^ loaded[n]->mode) & loadedIndexMask;
+    while (loadedIndex[slot]) slot = (slot + 1) & loadedIndexMask;
+    loadedIndex[slot] = n + 1;
+  }
+
+  BX_INFO(("trace cache file '%s': %u pages loaded", path, numLoaded));
+}
+
+void bxTraceFile_c::unmapImage(void)
+{
+  if (image) {
+#ifdef _POSIX_MAPPED_FILES
+    if (imageMapped)
+      munmap(image, imageSize);
+    else
+#endif
+      delete [] image;
+  }
+  image = NULL;
+  imageSize = 0;
+  imageMapped = false;
+
+  delete [] loaded;
+  delete [] adopted;
+  delete [] used;
+  delete [] loadedIndex;
+  loaded = NULL;
+  adopted = NULL;
+  used = NULL;
+  loadedIndex = NULL;
+  numLoaded = 0;
+  loadedIndexMask = 0;
+}
+
+int bxTraceFile_c::findLoaded(const Bit8u *page, Bit64u hash, unsigned mode) const
+{
+  if (! numLoaded) return -1;
+
+  unsigned slot = (unsigned)(hash ^ mode) & loadedIndexMask;
+  while (loadedIndex[slot]) {
+    const bxTraceFilePage_t *rec = loaded[loadedIndex[slot] - 1];
+    if (rec->hash == hash && rec->mode == mode && ! memcmp(rec + 1, page, BX_TRACE_FILE_PAGE_SIZE))
+      return loadedIndex[slot] - 1;
+    slot = (slot + 1) & loadedIndexMask;
+  }
+
+  return -1;
+}
+
+bool bxTraceFile_c::lookup(const Bit8u *page, unsigned mode, bxTraceFileView_t *view)
+{
+  int n = findLoaded(page, hashPage(page), mode);
+  if (n < 0) return false;
+
+  // the processors could race on the flag, they all store the same value
+  used[n] = true;
+
+  const bxTraceFilePage_t *rec = loaded[n];
+  view->page = (const Bit8u *)(rec + 1);
+  view->traces = (const bxTraceFileTrace_t *)(view->page + BX_TRACE_FILE_PAGE_SIZE);
+  view->ntraces = rec->ntraces;
+  view->instr = (const Bit8u *) view->traces + traceDescSize(rec->ntraces);
+  return true;
+}
+
+bxTraceFileRecord_t* bxTraceFile_c::newRecord(bx_phy_address ppf, unsigned mode, const Bit8u *page)
+{
+  bxTraceFileRecord_t *r = new bxTraceFileRecord_t;
+
+  r->ppf = ppf;
+  r->mode = mode;
+  memcpy(r->page, page, BX_TRACE_FILE_PAGE_SIZE);
+  r->hash = hashPage(r->page);
+  memset(r->started, 0, sizeof(r->started));
+  r->traces = NULL;
+  r->ntraces = r->maxTraces = 0;
+  r->instr = NULL;
+  r->ninstr = r->maxInstr = 0;
+  r->modified = false;
+
+  // keep the traces of the same page loaded from the file
+  r->source = findLoaded(r->page, r->hash, mode);
+  if (r->source >= 0) {
+    bxTraceFileView_t view;
+    lookup(r->page, mode, &view);
+    r->ntraces = r->maxTraces = view.ntraces;
+    r->traces = new bxTraceFileTrace_t[r->maxTraces];
+    memcpy(r->traces, view.traces, sizeof(bxTraceFileTrace_t) * r->ntraces);
+    r->ninstr = r->maxInstr = loaded[r->source]->ninstr;
+    r->instr = new bxInstruction_c[r->maxInstr];
+    memcpy((void *) r->instr, view.instr, sizeof(bxInstruction_c) * r->ninstr);
+    for (unsigned k=0; k < r->ntraces; k++)
+      r->started[r->traces[k].offset >> 3] |= 1 << (r->traces[k].offset & 7);
+    adopted[r->source] = true;
+  }
+
+  recorded[numRecorded++] = r;
+  return r;
+}
+
+void bxTraceFile_c::record(bx_phy_address ppf, unsigned mode, const Bit8u *page,
+     unsigned offset, const bxInstruction_c *i, unsigned len)
+{
+  BX_LOCK(lock);
+
+  unsigned slot = recordSlot(ppf, mode);
+  bxTraceFileRecord_t *r = NULL;
+  while (recordIndex[slot]) {
+    r = recorded[recordIndex[slot] - 1];
+    if (r->ppf == ppf && r->mode == mode) break;
+    r = NULL;
+    slot = (slot + 1) & (BX_TRACE_FILE_RECORD_INDEX-1);
+  }
+
+  // generated or patched code is unlikely to be seen again in the next run,
+  // the page is not recorded anymore once it was modified
+  if (r && ! r->modified && memcmp(r->page, page, BX_TRACE_FILE_PAGE_SIZE)) {
+    r->modified = true;
+    if (r->source >= 0) adopted[r->source] = false;
+  }
+
+  if (r && r->modified) {
+    BX_UNLOCK(lock);
+    return;
+  }
+
+  if (! r) {
+    if (numRecorded == BX_TRACE_FILE_MAX_PAGES) {
+      BX_UNLOCK(lock);
+      return;
+    }
+    r = newRecord(ppf, mode, page);
+    recordIndex[slot] = numRecorded;
+  }
+
+  if (r->started[offset >> 3] & (1 << (offset & 7))) {
+    BX_UNLOCK(lock);
+    return;
+  }
+  r->started[offset >> 3] |= 1 << (offset & 7);
+
+  if (r->ntraces == r->maxTraces) {
+    r->maxTraces = r->maxTraces ? r->maxTraces * 2 : 16;
+    bxTraceFileTrace_t *traces = new bxTraceFileTrace_t[r->maxTraces];
+    if (r->ntraces) memcpy(traces, r->traces, sizeof(bxTraceFileTrace_t) * r->ntraces);
+    delete [] r->traces;
+    r->traces = traces;
+  }
+  if (r->ninstr + len > r->maxInstr) {
+    while (r->ninstr + len > r->maxInstr)
+      r->maxInstr = r->maxInstr ? r->maxInstr * 2 : 128;
+    bxInstruction_c *instr = new bxInstruction_c[r->maxInstr];
+    if (r->ninstr) memcpy((void *) instr, r->instr, sizeof(bxInstruction_c) * r->ninstr);
+    delete [] r->instr;
+    r->instr = instr;
+  }
+
+  r->traces[r->ntraces].offset = offset;
+  r->traces[r->ntraces].len = len;
+  r->ntraces++;
+
+  // the handlers are host pointers, they are assigned again on load
+  bxInstruction_c *dst = r->instr + r->ninstr;
+  memcpy((void *) dst, i, sizeof(bxInstruction_c) * len);
+  for (unsigned n=0; n < len; n++, dst++) {
+    dst->execute1 = NULL;
+    dst->handlers.execute2 = NULL;
+  }
+  r->ninstr += len;
+
+  dirty = true;
+
+  BX_UNLOCK(lock);
+}
+
+void bxTraceFile_c::save(void)
+{
+  if (! path || ! dirty) return;
+
+  char tmpname[BX_PATHNAME_LEN + 32];
+#ifdef WIN32
+  snprintf(tmpname, sizeof(tmpname), "%s.%u.tmp", path, (unsigned) GetCurrentProcessId());
+#else
+  snprintf(tmpname, sizeof(tmpname), "%s.%u.tmp", path, (unsigned) getpid());
+#endif
+
+  FILE *fp = fopen(tmpname, "wb");
+  if (! fp) {
+    BX_ERROR(("failed to create trace cache file '%s'", tmpname));
+    return;
+  }
+
+  bxTraceFileHeader_t header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, BX_TRACE_FILE_MAGIC, 8);
+  header.signature = signature;
+  header.build = buildKey();
+  header.byteOrder = BX_TRACE_FILE_BYTE_ORDER;
+  header.instrSize = sizeof(bxInstruction_c);
+  fwrite(&header, sizeof(header), 1, fp);
+
+  static const Bit8u zero[8] = { 0 };
+  bool ok = true;
+
+  // the same code could be loaded into several physical pages, keep one
+  Bit64u *written = new Bit64u[numRecorded];
+  unsigned numWritten = 0;
+
+  for (int n = numRecorded - 1; n >= 0 && header.numPages < BX_TRACE_FILE_MAX_FILE_PAGES; n--) {
+    const bxTraceFileRecord_t *r = recorded[n];
+    if (r->modified || ! r->ntraces) continue;
+    bool dup = false;
+    for (unsigned k=0; k < numWritten && !dup; k++)
+      dup = (written[k] == (r->hash ^ r->mode));
+    if (dup) continue;
+    written[numWritten++] = r->hash ^ r->mode;
+
+    bxTraceFilePage_t rec;
+    rec.hash = r->hash;
+    rec.mode = r->mode;
+    rec.ntraces = r->ntraces;
+    rec.ninstr = r->ninstr;
+    rec.size = (Bit32u) pageRecordSize(r->ntraces, r->ninstr);
+    rec.age = 0;
+    rec.checksum = recordChecksum(&rec, r->page, r->traces, r->instr);
+
+    size_t desc = sizeof(bxTraceFileTrace_t) * r->ntraces;
+    ok &= fwrite(&rec, sizeof(rec), 1, fp) == 1;
+    ok &= fwrite(r->page, BX_TRACE_FILE_PAGE_SIZE, 1, fp) == 1;
+    ok &= fwrite(r->traces, 1, desc, fp) == desc;
+    ok &= fwrite(zero, 1, traceDescSize(r->ntraces) - desc, fp) == traceDescSize(r->ntraces) - desc;
+    ok &= fwrite(r->instr, sizeof(bxInstruction_c), r->ninstr, fp) == r->ninstr;
+    header.numPages++;
+  }
+  delete [] written;
+
+  // the pages which were not recorded in this run are kept after the new ones
+  // unless they were not used for BX_TRACE_FILE_MAX_AGE runs
+  for (unsigned n=0; n < numLoaded && header.numPages < BX_TRACE_FILE_MAX_FILE_PAGES; n++) {
+    if (adopted[n]) continue;
+
+    bxTraceFilePage_t rec = *loaded[n];
+    rec.age = used[n] ? 0 : rec.age + 1;
+    if (rec.age > BX_TRACE_FILE_MAX_AGE) continue;
+
+    ok &= fwrite(&rec, sizeof(rec), 1, fp) == 1;
+    ok &= fwrite(loaded[n] + 1, rec.size - sizeof(rec), 1, fp) == 1;
+    header.numPages++;
+  }
+
+  fseek(fp, 0, SEEK_SET);
+  ok &= fwrite(&header, sizeof(header), 1, fp) == 1;
+  ok &= fclose(fp) == 0;
+
+  if (! ok) {
+    BX_ERROR(("failed to write trace cache file '%s'", tmpname));
+    remove(tmpname);
+    return;
+  }
+
+#ifdef WIN32
+  remove(path);
+#endif
+  if (rename(tmpname, path)) {
+    BX_ERROR(("failed to replace trace cache file '%s'", path));
+    remove(tmpname);
+    return;
+  }
+
+  BX_INFO(("trace cache file '%s': %u pages written", path, header.numPages));
+  dirty = false;
+}
@@ -0,0 +1,128 @@
+/////////////////////////////////////////////////////////////////////////
+// $Id$
+/////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (C) 2026  The Bochs Project
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA B 02110-1301 USA
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef BX_TRACE_FILE_H
+#define BX_TRACE_FILE_H
+
+#include "bxthread.h"
+
+// Persistent decoded trace cache (cpu: trace_cache_file=<file>)
+//
+// The traces decoded on trace cache miss are recorded together with a copy
+// of the physical page they were decoded from and written to the file when
+// the simulation ends. The next run maps the file into memory, the first
+// miss in a page whose content and decode mode match a record fills the
+// trace cache with all the traces recorded for the page without decoding
+// them again.
+//
+// The instructions are stored as decoded, without the handler pointers: the
+// handlers are assigned again from the opcode when a trace is loaded, using
+// the fetch mode at that time. The file is tied to the decoder tables, the
+// CPU model and the build of the binary which wrote it, other files are
+// ignored. Page records with a bad checksum are dropped and decoded again.
+
+#define BX_TRACE_FILE_PAGE_SIZE  4096
+#define BX_TRACE_FILE_MAX_PAGES  4096  // pages recorded in one run
+#define BX_TRACE_FILE_MAX_AGE    4     // runs an unused page is kept in the file
+
+// fetch mode bits which select the decoder
+#define BX_TRACE_FILE_MODE_MASK  (BX_FETCH_MODE_IS32_MASK | BX_FETCH_MODE_IS64_MASK)
+
+struct bxTraceFileTrace_t {
+  Bit16u offset;        // page offset of the first instruction
+  Bit16u len;           // amount of instructions
+};
+
+// page record as stored in the file
+struct bxTraceFilePage_t {
+  Bit64u hash;          // hash of the page content
+  Bit32u mode;          // BX_FETCH_MODE_IS32_MASK | BX_FETCH_MODE_IS64_MASK
+  Bit32u ntraces;
+  Bit32u ninstr;
+  Bit32u size;          // size of the record including this header
+  Bit32u age;           // runs since the page was last used
+  Bit32u checksum;      // of the record without the age
+  // followed by the page content, the trace descriptors (padded to 8 bytes)
+  // and the instructions
+};
+
+// page record looked up for the trace cache
+struct bxTraceFileView_t {
+  const Bit8u *page;
+  const bxTraceFileTrace_t *traces;
+  unsigned ntraces;
+  const Bit8u *instr;   // not necessarily aligned, copied with memcpy
+};
+
+struct bxTraceFileRecord_t;
+
+class bxTraceFile_c {
+public:
+  bxTraceFile_c();
+ ~bxTraceFile_c();
+
+  // maps the file if it exists and enables the recording
+  void open(const char *path, Bit64u signature);
+  // writes the loaded and the recorded pages if anything new was recorded
+  void save(void);
+
+  BX_CPP_INLINE bool enabled(void) const { return path != NULL; }
+
+  bool lookup(const Bit8u *page, unsigned mode, bxTraceFileView_t *view);
+
+  void record(bx_phy_address ppf, unsigned mode, const Bit8u *page,
+     unsigned offset, const bxInstruction_c *i, unsigned len);
+
+  static Bit64u hashPage(const Bit8u *page);
+
+private:
+  char *path;
+  Bit64u signature;
+
+  // file mapped in memory, the records are never modified
+  Bit8u *image;
+  size_t imageSize;
+  bool imageMapped;
+  const bxTraceFilePage_t **loaded;
+  unsigned numLoaded;
+  bool *adopted;        // loaded records superseded by recorded ones
+  bool *used;           // loaded records used in this run
+  Bit32u *loadedIndex;  // open addressing hash of loaded record + 1
+  unsigned loadedIndexMask;
+
+  // pages recorded in this run, one current record per physical page
+  bxTraceFileRecord_t **recorded;
+  unsigned numRecorded;
+  Bit32u *recordIndex;  // open addressing hash of recorded record + 1
+  bool dirty;
+
+  BX_MUTEX(lock);
+
+  int findLoaded(const Bit8u *page, Bit64u hash, unsigned mode) const;
+  bxTraceFileRecord_t *newRecord(bx_phy_address ppf, unsigned mode, const Bit8u *page);
+  void loadImage(void);
+  void unmapImage(void);
+};
+
+extern bxTraceFile_c traceFile;
+
+#endif
@@ -4098,7 +4098,7 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::INVPCID(bxInstruction_c *i)
       BX_ERROR(("INVPCID: invalid PCID"));
       exception(BX_GP_EXCEPTION, 0);
     }
-    TLB_flushNonGlobal(); // Invalidate all mappings for LADDR tagged with PCID except globals
+    TLB_invlpg((bx_address) invpcid_desc.xmm64u(1)); // Invalidate all mappings for LADDR tagged with PCID except globals
     break;
 
   case BX_INVPCID_SINGLE_CONTEXT_NON_GLOBAL_INVALIDATION:
@@ -4106,7 +4106,11 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::INVPCID(bxInstruction_c *i)
       BX_ERROR(("INVPCID: invalid PCID"));
       exception(BX_GP_EXCEPTION, 0);
     }
-    TLB_flushNonGlobal(); // Invalidate all mappings tagged with PCID except globals
+#if BX_SUPPORT_X86_64
+    TLB_flushPCID(pcid); // Invalidate all mappings tagged with PCID except globals
+#else
+    TLB_flushNonGlobal();
+#endif
     break;
 
   case BX_INVPCID_ALL_CONTEXT_INVALIDATION:
@@ -475,6 +475,11 @@ static void debug_loop(void)
 
         stub_trace_flag = 0;
         bx_cpu.cpu_loop();
+        // keep running after an in-memory snapshot request of the guest
+        while (bx_pc_system.snapshot_request) {
+          bx_snapshot_process();
+          bx_cpu.cpu_loop();
+        }
 
         SIM->refresh_vga();
 
@@ -509,6 +514,8 @@ static void debug_loop(void)
         BX_INFO(("stepping"));
         stub_trace_flag = 1;
         bx_cpu.cpu_loop();
+        if (bx_pc_system.snapshot_request)
+          bx_snapshot_process();
         SIM->refresh_vga();
         stub_trace_flag = 0;
         BX_INFO(("stopped with %x", last_stop_reason));
@@ -115,6 +115,13 @@ protected:
   void *device;
 public:
   enum {
+    // If set, this parameter is left out of the saved state. Its owner sets
+    // it while saving when the data is stored in another way (e.g. guest
+    // RAM in an incremental checkpoint)
+    SAVE_SKIP = (1<<29),
+    // If set, this parameter is not captured by in-memory snapshots, its
+    // owner handles the state itself (e.g. guest RAM)
+    SNAPSHOT_SKIP = (1<<30),
     // If set, this parameter is available in CI only. In bochsrc, it is set
     // indirectly from one or more other options (e.g. cpu count)
     CI_ONLY = (1<<31)
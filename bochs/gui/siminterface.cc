@@ -59,6 +59,15 @@ typedef struct _rt_conf_entry_t {
   struct _rt_conf_entry_t *next;
 } rt_conf_entry_t;
 
+// in-memory snapshot entry, the parameters are stored in tree order and the
+// children of a list are followed by an entry for the end of the list
+typedef struct {
+  bx_param_c *param;
+  Bit64s value;
+  Bit8u *data;      // copy of string and data parameters
+  bool list_end;
+} snapshot_entry_t;
+
 typedef struct _addon_option_t {
   const char *name;
   addon_option_parser_t parser;
@@ -84,6 +93,8 @@ class bx_real_sim_c : public bx_simulator_interface_c {
   bool bx_debug_gui;
   bool bx_log_viewer;
   bool wxsel;
+  snapshot_entry_t *snapshot;
+  unsigned snapshot_entries, snapshot_size;
 public:
   bx_real_sim_c();
   virtual ~bx_real_sim_c() {}
@@ -226,6 +237,9 @@ public:
     return (bx_list_c*)get_param("bochs", NULL);
   }
   virtual bool restore_bochs_param(bx_list_c *root, const char *sr_path, const char *restore_name);
+  virtual bool save_snapshot();
+  virtual bool restore_snapshot();
+  virtual void free_snapshot();
   // special config parameter and options functions for plugins
   virtual bool opt_plugin_ctrl(const char *plugname, bool load);
 #if BX_NETWORKING
@@ -250,6 +264,8 @@ public:
 
 private:
   bool save_sr_param(FILE *fp, bx_param_c *node, const char *sr_path, int level);
+  bool save_snapshot_param(bx_param_c *node);
+  snapshot_entry_t *add_snapshot_entry(bx_param_c *param);
 };
 
 // recursive function to find parameters from the path
@@ -404,6 +420,9 @@ bx_real_sim_c::bx_real_sim_c()
   param_id = BXP_NEW_PARAM_ID;
   rt_conf_entries = NULL;
   addon_options = NULL;
+  snapshot = NULL;
+  snapshot_entries = 0;
+  snapshot_size = 0;
 }
 
 int bx_real_sim_c::set_init_done(bool n)
@@ -1145,6 +1164,7 @@ void bx_real_sim_c::cleanup_save_restore()
 {
   bx_list_c *list = get_bochs_root();
 
+  free_snapshot();
   if (list != NULL) {
     list->clear();
   }
@@ -1426,6 +1446,8 @@ bool bx_real_sim_c::save_sr_param(FILE *fp, bx_param_c *node, const char *sr_pat
   char pname[BX_PATHNAME_LEN], tmpstr[BX_PATHNAME_LEN+1];
   FILE *fp2;
 
+  if ((node != NULL) && (node->get_options() & bx_param_c::SAVE_SKIP))
+    return 1;
   for (i=0; i<level; i++)
     fprintf(fp, "  ");
   if (node == NULL) {
@@ -1525,6 +1547,142 @@ bool bx_real_sim_c::save_sr_param(FILE *fp, bx_param_c *node, const char *sr_pat
   return 1;
 }
 
+snapshot_entry_t *bx_real_sim_c::add_snapshot_entry(bx_param_c *param)
+{
+  if (snapshot_entries == snapshot_size) {
+    snapshot_size = snapshot_size ? snapshot_size * 2 : 4096;
+    snapshot_entry_t *entries = new snapshot_entry_t[snapshot_size];
+    if (snapshot_entries > 0)
+      memcpy(entries, snapshot, snapshot_entries * sizeof(snapshot_entry_t));
+    delete [] snapshot;
+    snapshot = entries;
+  }
+  snapshot_entry_t *entry = &snapshot[snapshot_entries++];
+  entry->param = param;
+  entry->value = 0;
+  entry->data = NULL;
+  entry->list_end = 0;
+  return entry;
+}
+
+bool bx_real_sim_c::save_snapshot_param(bx_param_c *node)
+{
+  snapshot_entry_t *entry;
+  int i;
+
+  if (node->get_options() & bx_param_c::SNAPSHOT_SKIP)
+    return 1;
+
+  switch (node->get_type()) {
+    case BXT_PARAM_NUM:
+    case BXT_PARAM_BOOL:
+    case BXT_PARAM_ENUM:
+      entry = add_snapshot_entry(node);
+      entry->value = ((bx_param_num_c*)node)->get64();
+      break;
+    case BXT_PARAM_STRING:
+    case BXT_PARAM_BYTESTRING:
+      {
+        int len = ((bx_param_string_c*)node)->get_maxsize() * 3 + 1;
+        entry = add_snapshot_entry(node);
+        entry->data = new Bit8u[len];
+        node->dump_param((char*)entry->data, len);
+      }
+      break;
+    case BXT_PARAM_DATA:
+      {
+        bx_shadow_data_c *dparam = (bx_shadow_data_c*)node;
+        entry = add_snapshot_entry(node);
+        entry->data = new Bit8u[dparam->get_size()];
+        memcpy(entry->data, dparam->getptr(), dparam->get_size());
+      }
+      break;
+    case BXT_LIST:
+      {
+        bx_list_c *list = (bx_list_c*)node;
+        add_snapshot_entry(node);
+        for (i=0; i < list->get_size(); i++) {
+          if (!save_snapshot_param(list->get(i)))
+            return 0;
+        }
+        entry = add_snapshot_entry(node);
+        entry->list_end = 1;
+        break;
+      }
+    case BXT_PARAM_FILEDATA:
+      // stored in files, not part of the snapshot
+      break;
+    default:
+      BX_ERROR(("save_snapshot(): unknown parameter type"));
+      return 0;
+  }
+
+  return 1;
+}
+
+// The device state is copied from the save/restore tree like save_state()
+// does. The parameters storing their state in files are left out, an empty
+// restore path tells their handlers to skip them.
+bool bx_real_sim_c::save_snapshot()
+{
+  bx_param_string_c *restore_path = get_param_string(BXPN_RESTORE_PATH);
+  char path[BX_PATHNAME_LEN];
+
+  free_snapshot();
+  restore_path->get(path, BX_PATHNAME_LEN);
+  restore_path->set("");
+  bool ret = save_snapshot_param(get_bochs_root());
+  restore_path->set(path);
+  if (!ret) free_snapshot();
+  return ret;
+}
+
+bool bx_real_sim_c::restore_snapshot()
+{
+  bx_param_string_c *restore_path = get_param_string(BXPN_RESTORE_PATH);
+  char path[BX_PATHNAME_LEN];
+
+  if (snapshot_entries == 0)
+    return 0;
+
+  restore_path->get(path, BX_PATHNAME_LEN);
+  restore_path->set("");
+  for (unsigned n=0; n < snapshot_entries; n++) {
+    snapshot_entry_t *entry = &snapshot[n];
+    switch (entry->param->get_type()) {
+      case BXT_PARAM_NUM:
+      case BXT_PARAM_BOOL:
+      case BXT_PARAM_ENUM:
+        ((bx_param_num_c*)entry->param)->set(entry->value);
+        break;
+      case BXT_PARAM_STRING:
+      case BXT_PARAM_BYTESTRING:
+        entry->param->parse_param((const char*)entry->data);
+        break;
+      case BXT_PARAM_DATA:
+        memcpy(((bx_shadow_data_c*)entry->param)->getptr(), entry->data,
+               ((bx_shadow_data_c*)entry->param)->get_size());
+        break;
+      case BXT_LIST:
+        if (entry->list_end)
+          ((bx_list_c*)entry->param)->restore();
+        break;
+    }
+  }
+  restore_path->set(path);
+  return 1;
+}
+
+void bx_real_sim_c::free_snapshot()
+{
+  for (unsigned n=0; n < snapshot_entries; n++)
+    delete [] snapshot[n].data;
+  delete [] snapshot;
+  snapshot = NULL;
+  snapshot_entries = 0;
+  snapshot_size = 0;
+}
+
 bool bx_real_sim_c::opt_plugin_ctrl(const char *plugname, bool load)
 {
   bx_list_c *plugin_ctrl = (bx_list_c*)SIM->get_param(BXPN_PLUGIN_CTRL);
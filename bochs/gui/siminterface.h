@@ -535,6 +535,12 @@ enum {
 };
 #define BX_CLOCK_SYNC_LAST       BX_CLOCK_SYNC_BOTH
 
+enum {
+  BX_MEM_BACKING_HEAP,
+  BX_MEM_BACKING_MMAP,
+  BX_MEM_BACKING_FILE
+};
+
 enum {
   BX_PCI_CHIPSET_I430FX,
   BX_PCI_CHIPSET_I440FX,
@@ -779,6 +785,10 @@ public:
   virtual bool restore_hardware() {return 0;}
   virtual bx_list_c *get_bochs_root() {return NULL;}
   virtual bool restore_bochs_param(bx_list_c *root, const char *sr_path, const char *restore_name) { return 0; }
+  // in-memory snapshot of the save/restore tree (guest RAM is not included)
+  virtual bool save_snapshot() {return 0;}
+  virtual bool restore_snapshot() {return 0;}
+  virtual void free_snapshot() {}
 
   // special config parameter and options functions for plugins
   virtual bool opt_plugin_ctrl(const char *plugname, bool load) {return 0;}
@@ -0,0 +1,187 @@
+/////////////////////////////////////////////////////////////////////////
+// $Id$
+/////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (C) 2026  The Bochs Project
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+// Opcode pair histogram
+//
+// Counts pairs of instructions executed one after another without a taken
+// branch, interrupt or exception between them - the candidates for the
+// instruction fusion done when a trace is decoded (cpu/fusion.cc). The
+// histogram of all CPUs is written to opcode_pairs.txt when Bochs exits
+// (also after a panic or a shutdown request), one pair per line sorted by
+// count:
+//
+//   <count> <percent> <first opcode> /<r|m> <second opcode> /<r|m>
+
+#include <assert.h>
+
+#include "bochs.h"
+#include "cpu/cpu.h"
+#include "cpu/decoder/ia_opcodes.h"
+
+#define BX_PAIR_STATS_ENTRIES (64*1024) /* must be power of 2 */
+#define BX_PAIR_STATS_TOP     1000
+
+#define BX_PAIR_NONE 0xffffffff
+
+struct bx_pair_entry {
+   Bit32u pair;  // first opcode index << 16 | second opcode index
+   Bit64u cnt;
+};
+
+static struct bx_instr_pair_stats {
+   bool active;
+   Bit32u prev;  // opcode index of the previous instruction
+   Bit64u total_cnt;
+   Bit64u dropped_cnt;
+   bx_pair_entry entry[BX_PAIR_STATS_ENTRIES];
+} *pair_stats;
+
+static void bx_dump_pair_stats(void);
+
+void bx_instr_initialize(unsigned cpu)
+{
+  assert(cpu < BX_SMP_PROCESSORS);
+
+  if (pair_stats == NULL) {
+      pair_stats = new bx_instr_pair_stats[BX_SMP_PROCESSORS];
+      atexit(bx_dump_pair_stats);
+  }
+
+  pair_stats[cpu].active = 0;
+
+  fprintf(stderr, "Initialize cpu %u instrumentation module\n", cpu);
+}
+
+void bx_instr_reset(unsigned cpu, unsigned type)
+{
+  pair_stats[cpu].active = 1;
+  pair_stats[cpu].prev = BX_PAIR_NONE;
+  pair_stats[cpu].total_cnt = pair_stats[cpu].dropped_cnt = 0;
+
+  for(int n=0; n < BX_PAIR_STATS_ENTRIES; n++) {
+    pair_stats[cpu].entry[n].pair = BX_PAIR_NONE;
+    pair_stats[cpu].entry[n].cnt = 0;
+  }
+}
+
+void bx_instr_interrupt(unsigned cpu, unsigned vector)
+{
+  pair_stats[cpu].prev = BX_PAIR_NONE;
+}
+
+void bx_instr_exception(unsigned cpu, unsigned vector, unsigned error_code)
+{
+  pair_stats[cpu].prev = BX_PAIR_NONE;
+}
+
+void bx_instr_hwinterrupt(unsigned cpu, unsigned vector, Bit16u cs, bx_address eip)
+{
+  pair_stats[cpu].prev = BX_PAIR_NONE;
+}
+
+void bx_instr_branch_taken(unsigned cpu)
+{
+  // the instructions before and after a taken branch are never in the same trace
+  pair_stats[cpu].prev = BX_PAIR_NONE;
+}
+
+// returns the histogram entry of the pair, NULL if the table is (almost) full
+static bx_pair_entry *bx_find_pair(bx_instr_pair_stats *stats, Bit32u pair)
+{
+  unsigned hash = (pair * 2654435761u) >> 16;
+
+  for (unsigned n=0; n < 16; n++) {
+    bx_pair_entry *e = &stats->entry[(hash + n) & (BX_PAIR_STATS_ENTRIES-1)];
+    if (e->pair == pair) return e;
+    if (e->pair == BX_PAIR_NONE) {
+      e->pair = pair;
+      e->cnt = 0;
+      return e;
+    }
+  }
+
+  return NULL;
+}
+
+void bx_instr_before_execution(unsigned cpu, bxInstruction_c *i)
+{
+  bx_instr_pair_stats *stats = &pair_stats[cpu];
+  if (! stats->active) return;
+
+  Bit32u index = i->getIaOpcode() * 2 + !!i->modC0();
+
+  if (stats->prev != BX_PAIR_NONE) {
+    bx_pair_entry *e = bx_find_pair(stats, (stats->prev << 16) | index);
+    if (e) e->cnt++;
+    else stats->dropped_cnt++;
+    stats->total_cnt++;
+  }
+
+  stats->prev = index;
+}
+
+static int pair_entry_cmp(const void *a, const void *b)
+{
+  Bit64u cnt_a = ((const bx_pair_entry *) a)->cnt;
+  Bit64u cnt_b = ((const bx_pair_entry *) b)->cnt;
+
+  return (cnt_a < cnt_b) ? 1 : (cnt_a > cnt_b) ? -1 : 0;
+}
+
+static void bx_dump_pair_stats(void)
+{
+  if (pair_stats == NULL) return;
+
+  // merge the histograms of all CPUs into the first one
+  bx_instr_pair_stats *stats = &pair_stats[0];
+  for (unsigned cpu=1; cpu < BX_SMP_PROCESSORS; cpu++) {
+    stats->total_cnt += pair_stats[cpu].total_cnt;
+    stats->dropped_cnt += pair_stats[cpu].dropped_cnt;
+    for (int n=0; n < BX_PAIR_STATS_ENTRIES; n++) {
+      bx_pair_entry *src = &pair_stats[cpu].entry[n];
+      if (src->pair == BX_PAIR_NONE) continue;
+      bx_pair_entry *e = bx_find_pair(stats, src->pair);
+      if (e) e->cnt += src->cnt;
+      else stats->dropped_cnt += src->cnt;
+    }
+  }
+
+  qsort(stats->entry, BX_PAIR_STATS_ENTRIES, sizeof(bx_pair_entry), pair_entry_cmp);
+
+  FILE *fp = fopen("opcode_pairs.txt", "w");
+  if (fp == NULL) {
+    fprintf(stderr, "Failed to create opcode_pairs.txt\n");
+    return;
+  }
+
+  fprintf(fp, "# %" FMT_64 "u instruction pairs, %" FMT_64 "u not counted\n", stats->total_cnt, stats->dropped_cnt);
+  for (int n=0; n < BX_PAIR_STATS_TOP && stats->entry[n].cnt != 0; n++) {
+    Bit32u first = stats->entry[n].pair >> 16, second = stats->entry[n].pair & 0xffff;
+    fprintf(fp, "%12" FMT_64 "u %7.3f%% %s /%c %s /%c\n", stats->entry[n].cnt,
+        stats->entry[n].cnt * 100.0 / stats->total_cnt,
+        get_bx_opcode_name(first/2), (first & 1) ? 'r' : 'm',
+        get_bx_opcode_name(second/2), (second & 1) ? 'r' : 'm');
+  }
+
+  fclose(fp);
+
+  delete [] pair_stats;
+  pair_stats = NULL;
+}
@@ -24,6 +24,7 @@
 
 
 #include "iodev.h"
+#include "cpu/smpthreads.h"
 #include "gui/keymap.h"
 #include "instrument.h"
 
@@ -1087,6 +1088,7 @@ bx_devices_c::inp(Bit16u addr, unsigned io_len)
   struct io_handler_struct *io_read_handler;
   Bit32u ret;
 
+  BX_SMP_DEVICE_LOCK();
   BX_INSTR_INP(addr, io_len);
 
   io_read_handler = read_port_to_handler[addr];
@@ -1119,6 +1121,7 @@ bx_devices_c::outp(Bit16u addr, Bit32u value, unsigned io_len)
 {
   struct io_handler_struct *io_write_handler;
 
+  BX_SMP_DEVICE_LOCK();
   BX_INSTR_OUTP(addr, io_len, value);
   BX_DBG_IO_REPORT(addr, io_len, BX_WRITE, value);
 
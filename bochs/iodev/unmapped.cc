@@ -64,6 +64,8 @@ void bx_unmapped_c::init(void)
   s.port80 = 0x00;
   s.port8e = 0x00;
   s.shutdown = 0;
+  s.snapshot = s.revert = s.fork = 0;
+  s.snapshots_enabled = SIM->get_param_bool(BXPN_MEM_SNAPSHOTS)->get();
   s.port_e9_hack = SIM->get_param_bool(BXPN_PORT_E9_HACK)->get();
   SIM->get_param_num(BXPN_PORT_E9_HACK)->set_handler(param_handler);
 }
@@ -111,6 +113,12 @@ Bit32u bx_unmapped_c::read(Bit32u address, unsigned io_len)
       }
       break;
 
+    // Shutdown port: the clone number (0 in the original process) in
+    // bits 0-15, the number of reverts to the current snapshot in bits 16-31
+    case 0x8900:
+      retval = (bx_pc_system.snapshot_reverts << 16) | (bx_pc_system.clone_id & 0xffff);
+      break;
+
     case 0x03df:
       retval = 0xffffffff;
       BX_DEBUG(("unsupported IO read from port %04x (CGA)", address));
@@ -248,6 +256,16 @@ void bx_unmapped_c::write(Bit32u address, Bit32u value, unsigned io_len)
         bx_user_quit = 1;
         BX_FATAL(("Shutdown port: shutdown requested"));
       }
+      // in-memory snapshot of the running machine, only if enabled with
+      // memory: snapshots=1
+      if (BX_UM_THIS s.snapshots_enabled) {
+        if (match_command(&BX_UM_THIS s.snapshot, "Snapshot", value))
+          bx_pc_system.request_snapshot(BX_SNAPSHOT_SAVE);
+        if (match_command(&BX_UM_THIS s.revert, "Revert", value))
+          bx_pc_system.request_snapshot(BX_SNAPSHOT_REVERT);
+        if (match_command(&BX_UM_THIS s.fork, "Fork", value))
+          bx_pc_system.request_snapshot(BX_SNAPSHOT_FORK);
+      }
       break;
     default:
       break;
@@ -269,6 +287,20 @@ void bx_unmapped_c::write(Bit32u address, Bit32u value, unsigned io_len)
   }
 }
 
+bool bx_unmapped_c::match_command(Bit8u *progress, const char *command, Bit32u value)
+{
+  if (value == (Bit8u) command[*progress])
+    (*progress)++;
+  else
+    *progress = (value == (Bit8u) command[0]);
+
+  if (command[*progress] == 0) {
+    *progress = 0;
+    return 1;
+  }
+  return 0;
+}
+
 Bit64s bx_unmapped_c::param_handler(bx_param_c *param, bool set, Bit64s val)
 {
   if (set) {
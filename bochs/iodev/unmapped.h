@@ -45,11 +45,14 @@ private:
   void   write(Bit32u address, Bit32u value, unsigned io_len);
 #endif
   static Bit64s param_handler(bx_param_c *param, bool set, Bit64s val);
+  static bool match_command(Bit8u *progress, const char *command, Bit32u value);
 
   struct {
     Bit8u port80;
     Bit8u port8e;
     Bit8u shutdown;
+    Bit8u snapshot, revert, fork;   // progress of the snapshot commands
+    bool snapshots_enabled;
     bool port_e9_hack;
   } s;  // state information
 };
@@ -40,6 +40,10 @@
 #include <locale.h>
 #endif
 
+#if BX_HAVE_FORK
+#include <sys/wait.h>
+#endif
+
 #if BX_WITH_SDL || BX_WITH_SDL2
 // since SDL redefines main() to SDL_main(), we must include SDL.h so that the
 // C language prototype is found.  Otherwise SDL_main() will get its name
@@ -570,6 +574,9 @@ void print_usage(void)
     "  -dumpstats N     dump Bochs stats every N millions of emulated ticks\n"
 #endif
     "  -r path          restore the Bochs state from path\n"
+    "  -checkpoint N path\n"
+    "                   save an incremental checkpoint into a new folder in\n"
+    "                   path every N millions of emulated ticks\n"
     "  -log filename    specify Bochs log file name\n"
     "  -unlock          unlock Bochs images leftover from previous session\n"
 #if BX_DEBUGGER
@@ -767,6 +774,13 @@ int bx_init_main(int argc, char *argv[])
       else SIM->get_param_num(BXPN_DUMP_STATS)->set(atoi(argv[arg]));
     }
 #endif
+    else if (!strcmp("-checkpoint", argv[arg])) {
+      if (arg + 2 >= argc) BX_PANIC(("-checkpoint must be followed by a number and a path"));
+      else {
+        SIM->get_param_num(BXPN_CHECKPOINT)->set(atoi(argv[++arg]));
+        SIM->get_param_string(BXPN_CHECKPOINT_PATH)->set(argv[++arg]);
+      }
+    }
     else if (!strcmp("-r", argv[arg])) {
       if (++arg >= argc) BX_PANIC(("-r must be followed by a path"));
       else {
@@ -1086,11 +1100,17 @@ int bx_begin_simulation(int argc, char *argv[])
           BX_CPU(0)->cpu_loop();
           if (bx_pc_system.kill_bochs_request)
             break;
+          if (bx_pc_system.snapshot_request)
+            bx_snapshot_process();
         }
         // for one processor, the only reason for cpu_loop to return is
         // that kill_bochs_request was set by the GUI interface.
       }
 #if BX_SUPPORT_SMP
+      else if (SIM->get_param_bool(BXPN_SMP_THREADS)->get()) {
+        // SMP simulation: each processor is simulated by its own host thread
+        bx_smp_threads_loop();
+      }
       else {
         // SMP simulation: do a few instructions on each processor, then switch
         // to another.  Increasing quantum speeds up overall performance, but
@@ -1124,12 +1144,16 @@ int bx_begin_simulation(int argc, char *argv[])
              processor = 0;
              BX_TICKN(executed / BX_SMP_PROCESSORS);
              executed %= BX_SMP_PROCESSORS;
+             // all the processors halted: skip to the next timer event
+             bx_pc_system.idle_skip();
            }
 
            BX_CPU(processor)->icount_last_sync = BX_CPU(processor)->get_icount();
 
            if (bx_pc_system.kill_bochs_request)
              break;
+           if (bx_pc_system.snapshot_request)
+             bx_snapshot_process();
         }
       }
 #endif /* BX_SUPPORT_SMP */
@@ -1153,6 +1177,7 @@ void bx_stop_simulation(void)
 
 void bx_sr_after_restore_state(void)
 {
+  bx_pc_system.after_restore_state();
 #if BX_SUPPORT_SMP == 0
   BX_CPU(0)->after_restore_state();
 #else
@@ -1163,6 +1188,140 @@ void bx_sr_after_restore_state(void)
   DEV_after_restore_state();
 }
 
+#if BX_HAVE_FORK
+static unsigned bx_clones = 0; // running clones forked by the original process
+static unsigned bx_clones_forked = 0; // all clones forked so far, numbers the clones
+
+// A clone shares the open files of the original process and does not get
+// copies of its threads, so fork is refused while writable disk images,
+// host windows, network backends or sound output are active. Returns the
+// reason for refusing it or NULL.
+static const char *bx_fork_refused(void)
+{
+  char pname[BX_PATHNAME_LEN];
+
+  if (SIM->get_first_hd() != NULL)
+    return "a hard disk image is attached";
+  for (int i = 0; i < 2; i++) {
+    sprintf(pname, "floppy.%d", i);
+    bx_list_c *base = (bx_list_c*) SIM->get_param(pname);
+    if ((SIM->get_param_enum("devtype", base)->get() != BX_FDD_NONE) &&
+        (SIM->get_param_enum("status", base)->get() == BX_INSERTED) &&
+        !SIM->get_param_bool("readonly", base)->get())
+      return "a writable floppy image is inserted";
+  }
+  const char *gui = SIM->get_param_enum(BXPN_SEL_DISPLAY_LIBRARY)->get_selected();
+  if (strcmp(gui, "nogui") && strcmp(gui, "term"))
+    return "the display library is not nogui or term";
+  static const char *nics[] = { BXPN_NE2K, BXPN_E1000, BXPN_PNIC, NULL };
+  for (int i = 0; nics[i] != NULL; i++) {
+    bx_list_c *base = (bx_list_c*) SIM->get_param(nics[i]);
+    if ((base != NULL) && SIM->get_param_bool("enabled", base)->get() &&
+        strcmp(SIM->get_param_enum("ethmod", base)->get_selected(), "null"))
+      return "a network backend is active";
+  }
+#if BX_SUPPORT_SOUNDLOW
+  static const char *sound[] = { BXPN_SOUND_SB16, BXPN_SOUND_ES1370, NULL };
+  for (int i = 0; sound[i] != NULL; i++) {
+    bx_list_c *base = (bx_list_c*) SIM->get_param(sound[i]);
+    if ((base != NULL) && SIM->get_param_bool("enabled", base)->get() &&
+        strcmp(SIM->get_param_enum(BXPN_SOUND_WAVEOUT_DRV)->get_selected(), "dummy"))
+      return "sound output is active";
+  }
+#endif
+  return NULL;
+}
+#endif
+
+// Processes the in-memory snapshot request and a pending periodic checkpoint,
+// called when all the processors left the cpu loop. The snapshot consists of
+// the copy-on-write snapshot of guest RAM and a copy of the device state tree,
+// disk images are not part of it.
+void bx_snapshot_process(void)
+{
+  unsigned request = bx_pc_system.snapshot_request;
+#if BX_HAVE_FORK
+  const char *reason;
+#endif
+  bx_pc_system.snapshot_request = BX_SNAPSHOT_NONE;
+
+  switch (request) {
+    case BX_SNAPSHOT_SAVE:
+      if (! BX_MEM(0)->snapshot_ram() || ! SIM->save_snapshot()) {
+        BX_ERROR(("snapshot: failed to take the snapshot"));
+        break;
+      }
+      bx_pc_system.snapshot_reverts = 0;
+      BX_INFO(("snapshot: saved at tick " FMT_LL "u", bx_pc_system.time_ticks()));
+      break;
+    case BX_SNAPSHOT_REVERT:
+      if (! BX_MEM(0)->revert_ram() || ! SIM->restore_snapshot()) {
+        BX_ERROR(("snapshot: failed to revert to the snapshot"));
+        break;
+      }
+      bx_sr_after_restore_state();
+      flushICaches();
+      bx_pc_system.snapshot_reverts++;
+      BX_DEBUG(("snapshot: reverted"));
+      break;
+    case BX_SNAPSHOT_FORK:
+#if BX_HAVE_FORK
+#if BX_SUPPORT_SMP
+      if (SIM->get_param_bool(BXPN_SMP_THREADS)->get()) {
+        BX_ERROR(("snapshot: fork is not supported with SMP threads"));
+        break;
+      }
+#endif
+      if (SIM->get_param_enum(BXPN_MEM_BACKING)->get() == BX_MEM_BACKING_FILE) {
+        BX_ERROR(("snapshot: fork is not supported with a shared guest RAM file"));
+        break;
+      }
+      if ((reason = bx_fork_refused()) != NULL) {
+        BX_ERROR(("snapshot: fork is not supported when %s", reason));
+        break;
+      }
+      if (bx_pc_system.clone_id != 0) {
+        BX_ERROR(("snapshot: only the original process can fork clones"));
+        break;
+      }
+      // reap the clones which exited already
+      while (bx_clones > 0 && waitpid(-1, NULL, WNOHANG) > 0)
+        bx_clones--;
+      if (bx_clones >= SIM->get_param_num(BXPN_MEM_CLONES)->get()) {
+        BX_ERROR(("snapshot: fork refused, %u clones are running (memory: clones)", bx_clones));
+        break;
+      }
+      {
+        unsigned id = bx_clones_forked + 1;
+        // don't let the clone write out buffered output again
+        fflush(NULL);
+        pid_t pid = fork();
+        if (pid < 0) {
+          BX_ERROR(("snapshot: fork failed"));
+        }
+        else if (pid == 0) {
+          bx_pc_system.clone_id = id;
+          bx_clones = 0;
+          BX_INFO(("snapshot: clone %u started", id));
+        }
+        else {
+          bx_clones++;
+          bx_clones_forked++;
+          BX_INFO(("snapshot: clone %u forked (pid %d)", id, (int) pid));
+        }
+      }
+#else
+      BX_ERROR(("snapshot: fork is not supported on this host"));
+#endif
+      break;
+    case BX_SNAPSHOT_CHECKPOINT:
+      break;
+  }
+
+  if (bx_pc_system.checkpoint_request)
+    bx_pc_system.save_checkpoint();
+}
+
 void bx_set_log_actions_by_device(bool panic_flag)
 {
   int id, l, m, val;
@@ -1226,7 +1385,8 @@ void bx_init_hardware()
   BX_INFO(("IPS is set to %d", (Bit32u) SIM->get_param_num(BXPN_IPS)->get()));
   BX_INFO(("CPU configuration"));
 #if BX_SUPPORT_SMP
-  BX_INFO(("  SMP support: yes, quantum=%d", SIM->get_param_num(BXPN_SMP_QUANTUM)->get()));
+  BX_INFO(("  SMP support: yes, quantum=%d%s", SIM->get_param_num(BXPN_SMP_QUANTUM)->get(),
+      SIM->get_param_bool(BXPN_SMP_THREADS)->get() ? ", host thread per processor" : ""));
 #else
   BX_INFO(("  SMP support: no"));
 #endif
@@ -1311,6 +1471,15 @@ void bx_init_hardware()
 
   BX_MEM(0)->init_memory(memSize, hostMemSize, memBlockSize);
 
+#if BX_SUPPORT_SMP
+  // a block swapped out by one processor thread could still be in use by
+  // another one through its TLB, the threads need all guest RAM allocated
+  if (SIM->get_param_bool(BXPN_SMP_THREADS)->get() && BX_MEM(0)->blocks_can_swap()) {
+    BX_ERROR(("smp_threads disabled, guest RAM blocks can be swapped out (memory: host < guest)"));
+    SIM->get_param_bool(BXPN_SMP_THREADS)->set(0);
+  }
+#endif
+
   // First load the system BIOS (VGABIOS loading moved to the vga code)
   BX_MEM(0)->load_ROM(SIM->get_param_string(BXPN_ROM_PATH)->getptr(),
                       SIM->get_param_num(BXPN_ROM_ADDRESS)->get(), 0);
@@ -1380,6 +1549,16 @@ void bx_init_hardware()
     SIM->ml_message_box_kill(hwnd);
   }
 
+  // set periodic timer for the incremental checkpoints, it is registered
+  // after the state was restored and is not part of the saved state
+  int checkpoint = SIM->get_param_num(BXPN_CHECKPOINT)->get();
+  if (checkpoint) {
+    BX_INFO(("Save a checkpoint into '%s' every %d millions of ticks",
+             SIM->get_param_string(BXPN_CHECKPOINT_PATH)->getptr(), checkpoint));
+    bx_pc_system.register_timer_ticks(&bx_pc_system, bx_pc_system_c::checkpointTimer,
+        (Bit64u) checkpoint * 1000000, 1 /* continuous */, 1, "checkpoint.timer");
+  }
+
   bx_gui->init_signal_handlers();
   bx_pc_system.start_timers();
 
@@ -1459,6 +1638,12 @@ int bx_atexit(void)
   SIM->cleanup_statistics();
   SIM->set_init_done(0);
 
+#if BX_HAVE_FORK
+  // the clones share the console and the log file, wait for them
+  while (bx_clones > 0 && wait(NULL) > 0)
+    bx_clones--;
+#endif
+
   return 0;
 }
 
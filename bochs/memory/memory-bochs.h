@@ -48,6 +48,7 @@ protected:
   Bit32u  block_size;      // individual block size, must be power of 2
   Bit8u   *actual_vector;
   Bit8u   *vector;   // aligned correctly
+  Bit64u  mapped_len;      // size of guest RAM mapped from the host kernel (memory: backing=mmap|file)
   Bit8u  **blocks;
   Bit8u   *rom;      // 512k BIOS rom space + 128k expansion rom space
   Bit8u   *bogus;    // 4k for unexisting memory
@@ -86,6 +87,14 @@ public:
   BX_MEM_SMF Bit64u get_memory_len(void);
   BX_MEM_SMF void allocate_block(Bit32u index);
   BX_MEM_SMF Bit8u* alloc_vector_aligned(Bit64u bytes, Bit64u alignment);
+#if BX_HAVE_SYS_MMAN_H
+  BX_MEM_SMF Bit8u* map_vector(Bit64u bytes, unsigned backing, const char *path, bool hugepages, bool overwrite);
+#endif
+  // copy-on-write snapshot of mapped guest RAM
+  BX_MEM_SMF bool snapshot_ram(void);
+  BX_MEM_SMF bool revert_ram(void);
+  BX_MEM_SMF void prepare_host_write(Bit8u *hostAddr, Bit64u len);
+  BX_MEM_SMF bool blocks_can_swap(void);
 
 #if BX_SUPPORT_MONITOR_MWAIT
   BX_MEM_SMF bool is_monitor(bx_phy_address begin_addr, unsigned len);
@@ -116,6 +125,9 @@ struct memory_handler_struct {
 #define BIOS_ROM_EXTENDED 0x02
 #define BIOS_ROM_1MEG     0x04
 
+// incremental checkpoints after the last full RAM image
+#define BX_CHECKPOINT_MAX_DEPTH 16
+
 enum memory_area_t {
   BX_MEM_AREA_C0000 = 0,
   BX_MEM_AREA_C4000,
@@ -151,9 +163,17 @@ private:
   Bit8u   flash_wsm_state;
   bool    flash_modified;
 
+  // incremental checkpoints
+  char    checkpoint_parent[BX_PATHNAME_LEN]; // last checkpoint saved or restored
+  bool    checkpoint_delta;                   // save only the dirty pages of RAM
+  unsigned checkpoint_depth;                  // deltas since the last full RAM image
+
   BX_MEM_SMF Bit8u flash_read(Bit32u addr);
   BX_MEM_SMF void  flash_write(Bit32u addr, Bit8u data);
 
+  BX_MEM_SMF bool  save_ram_delta(const char *path);
+  BX_MEM_SMF bool  load_ram_image(const char *path, unsigned max_depth = BX_CHECKPOINT_MAX_DEPTH);
+
 public:
   BX_MEM_C();
   virtual ~BX_MEM_C();
@@ -183,6 +203,10 @@ public:
   BX_MEM_SMF bool    load_flash_data(const char *path);
   BX_MEM_SMF bool    save_flash_data(const char *path);
 
+  // saves the state to <path>, only the guest RAM pages written since the
+  // previous checkpoint are stored
+  BX_MEM_SMF bool    save_checkpoint(const char *path);
+
   BX_MEM_SMF void    load_ROM(const char *path, bx_phy_address romaddress, Bit8u type);
   BX_MEM_SMF void    load_RAM(const char *path, bx_phy_address romaddress);
 
@@ -23,10 +23,21 @@
 #include "bochs.h"
 #include "pc_system.h"
 #include "param_names.h"
+#include "gui/siminterface.h"
 #include "cpu/cpu.h"
 #include "memory/memory-bochs.h"
 #define LOG_THIS BX_MEM(0)->
 
+#if BX_HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sched.h>
+#include "bxthread.h"
+#endif
+
 // block size must be power of two
 BX_CPP_INLINE bool is_power_of_2(Bit64u x)
 {
@@ -35,6 +46,8 @@ BX_CPP_INLINE bool is_power_of_2(Bit64u x)
 
 // alignment of memory vector, must be a power of 2
 #define BX_MEM_VECTOR_ALIGN 4096
+// alignment of mapped guest RAM backed by huge pages
+#define BX_MEM_HUGEPAGE_ALIGN (2*1024*1024)
 
 #if BX_LARGE_RAMFILE
 Bit8u* const BX_MEMORY_STUB_C::swapped_out = ((Bit8u*)NULL - sizeof(Bit8u));
@@ -49,6 +62,7 @@ BX_MEMORY_STUB_C::BX_MEMORY_STUB_C()
 
   vector = NULL;
   actual_vector = NULL;
+  mapped_len = 0;
   blocks = NULL;
   rom    = NULL;
   bogus  = NULL;
@@ -96,6 +110,289 @@ Bit8u* BX_MEMORY_STUB_C::alloc_vector_aligned(Bit64u bytes, Bit64u alignment)
   return vector;
 }
 
+#if BX_HAVE_SYS_MMAN_H
+// Guest RAM mapped from the host kernel: the pages are populated on the
+// first touch and paged by the kernel, so no host memory is committed for
+// guest RAM that was never touched.
+Bit8u* BX_MEMORY_STUB_C::map_vector(Bit64u bytes, unsigned backing, const char *path, bool hugepages, bool overwrite)
+{
+  const Bit64u alignment = hugepages ? BX_MEM_HUGEPAGE_ALIGN : BX_MEM_VECTOR_ALIGN;
+  int fd = -1;
+
+  if ((size_t)(bytes + alignment) != bytes + alignment) {
+    BX_PANIC(("map_vector: guest RAM does not fit into the host address space !"));
+    return NULL;
+  }
+
+  if (backing == BX_MEM_BACKING_FILE) {
+    fd = open(path, O_RDWR | O_CREAT, 0600);
+    if (fd < 0) {
+      BX_PANIC(("map_vector: could not open guest RAM file '%s'", path));
+      return NULL;
+    }
+    // do not destroy a file which was not created for guest RAM
+    struct stat st;
+    if (!overwrite && (fstat(fd, &st) < 0 || st.st_size > 0)) {
+      close(fd);
+      BX_PANIC(("map_vector: guest RAM file '%s' is not empty, set overwrite=1 to clear it", path));
+      return NULL;
+    }
+    // guest RAM starts as a sparse file of zeroes
+    if ((ftruncate(fd, 0) < 0) || (ftruncate(fd, (off_t) bytes) < 0)) {
+      close(fd);
+      BX_PANIC(("map_vector: could not resize guest RAM file '%s'", path));
+      return NULL;
+    }
+  }
+
+  // reserve an aligned range of address space and map guest RAM over it
+  size_t reserved = (size_t)(bytes + alignment);
+  Bit8u *base = (Bit8u *) mmap(NULL, reserved, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (base == (Bit8u *) MAP_FAILED) {
+    if (fd >= 0) close(fd);
+    BX_PANIC(("map_vector: unable to reserve host address space for guest RAM !"));
+    return NULL;
+  }
+  Bit8u *vector = (Bit8u *)(((bx_ptr_equiv_t) base + (bx_ptr_equiv_t)(alignment - 1)) & ~(bx_ptr_equiv_t)(alignment - 1));
+
+  void *mem;
+  if (fd >= 0) {
+    mem = mmap(vector, (size_t) bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    close(fd);
+  }
+  else {
+    mem = mmap(vector, (size_t) bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+  }
+  if (mem == MAP_FAILED) {
+    munmap(base, reserved);
+    BX_PANIC(("map_vector: unable to map guest RAM !"));
+    return NULL;
+  }
+
+  // release the unused head and tail of the reservation
+  if (vector > base)
+    munmap(base, vector - base);
+  if (vector + bytes < base + reserved)
+    munmap(vector + bytes, (base + reserved) - (vector + bytes));
+
+  if (hugepages) {
+#ifdef MADV_HUGEPAGE
+    if (madvise(vector, (size_t) bytes, MADV_HUGEPAGE) < 0)
+      BX_ERROR(("map_vector: huge pages are not available for guest RAM"));
+#else
+    BX_ERROR(("map_vector: huge pages are not supported on this host"));
+#endif
+  }
+
+  return vector;
+}
+#endif
+
+#if BX_HAVE_SYS_MMAN_H
+// Copy-on-write snapshot of mapped guest RAM: the snapshot write protects
+// guest RAM and the first write to a host page after the snapshot faults,
+// the fault handler saves the page into the snapshot store and makes it
+// writable again. Reverting copies the saved pages back, so the cost of a
+// snapshot and of a revert depends on the pages written in between only.
+// host page state in the snapshot
+#define BX_SNAPSHOT_PAGE_CLEAN  0  // write protected, not saved
+#define BX_SNAPSHOT_PAGE_SAVING 1  // being saved by another thread
+#define BX_SNAPSHOT_PAGE_SAVED  2  // saved and writable
+
+static struct {
+  Bit8u *vector;
+  Bit64u len;
+  size_t page_size;
+  Bit8u *store;         // saved pages, same layout as guest RAM
+  Bit8u *dirty;         // one entry per host page, BX_SNAPSHOT_PAGE_xxx
+  bool handler_installed;
+  struct sigaction old_action;
+} ram_snapshot;
+
+// Saves a host page of guest RAM into the snapshot store and makes it
+// writable, returns 0 if another thread is saving it
+static bool ram_snapshot_save_page(Bit64u page)
+{
+  if (! BX_ATOMIC_CAS8(&ram_snapshot.dirty[page], BX_SNAPSHOT_PAGE_CLEAN, BX_SNAPSHOT_PAGE_SAVING))
+    return ram_snapshot.dirty[page] == BX_SNAPSHOT_PAGE_SAVED;
+
+  Bit64u offset = page * ram_snapshot.page_size;
+  memcpy(ram_snapshot.store + offset, ram_snapshot.vector + offset, ram_snapshot.page_size);
+  mprotect(ram_snapshot.vector + offset, ram_snapshot.page_size, PROT_READ | PROT_WRITE);
+  BX_ATOMIC_CAS8(&ram_snapshot.dirty[page], BX_SNAPSHOT_PAGE_SAVING, BX_SNAPSHOT_PAGE_SAVED);
+  return 1;
+}
+
+static void ram_snapshot_fault(int sig, siginfo_t *info, void *context)
+{
+  Bit8u *addr = (Bit8u *) info->si_addr;
+
+  if (ram_snapshot.store == NULL || addr < ram_snapshot.vector ||
+      addr >= ram_snapshot.vector + ram_snapshot.len)
+  {
+    // not a write to snapshot guest RAM
+    if (ram_snapshot.old_action.sa_flags & SA_SIGINFO) {
+      if (ram_snapshot.old_action.sa_sigaction != NULL) {
+        ram_snapshot.old_action.sa_sigaction(sig, info, context);
+        return;
+      }
+    }
+    else if (ram_snapshot.old_action.sa_handler != SIG_DFL &&
+             ram_snapshot.old_action.sa_handler != SIG_IGN) {
+      ram_snapshot.old_action.sa_handler(sig);
+      return;
+    }
+    // the faulting access is restarted with the default action
+    sigaction(SIGSEGV, &ram_snapshot.old_action, NULL);
+    return;
+  }
+
+  // the first processor to fault saves the page, the others fault again
+  // until it is writable
+  ram_snapshot_save_page((Bit64u)(addr - ram_snapshot.vector) / ram_snapshot.page_size);
+}
+
+static void free_ram_snapshot(void)
+{
+  if (ram_snapshot.store != NULL) {
+    munmap(ram_snapshot.store, (size_t) ram_snapshot.len);
+    delete [] ram_snapshot.dirty;
+    ram_snapshot.store = NULL;
+    ram_snapshot.dirty = NULL;
+    ram_snapshot.vector = NULL;
+    ram_snapshot.len = 0;
+  }
+}
+#endif
+
+bool BX_MEMORY_STUB_C::snapshot_ram(void)
+{
+#if BX_HAVE_SYS_MMAN_H
+  if (! BX_MEM_THIS mapped_len) {
+    BX_ERROR(("snapshot_ram: snapshots require mapped guest RAM (memory: backing=mmap|file)"));
+    return 0;
+  }
+
+  ram_snapshot.page_size = sysconf(_SC_PAGESIZE);
+  Bit64u pages = (BX_MEM_THIS mapped_len + ram_snapshot.page_size - 1) / ram_snapshot.page_size;
+  if (ram_snapshot.store == NULL) {
+    ram_snapshot.store = (Bit8u *) mmap(NULL, (size_t) BX_MEM_THIS mapped_len, PROT_READ | PROT_WRITE,
+                                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (ram_snapshot.store == (Bit8u *) MAP_FAILED) {
+      ram_snapshot.store = NULL;
+      BX_ERROR(("snapshot_ram: unable to map the snapshot store"));
+      return 0;
+    }
+    ram_snapshot.dirty = new Bit8u[pages];
+    ram_snapshot.vector = BX_MEM_THIS vector;
+    ram_snapshot.len = BX_MEM_THIS mapped_len;
+  }
+  else {
+    // drop the pages saved for the previous snapshot
+    madvise(ram_snapshot.store, (size_t) ram_snapshot.len, MADV_DONTNEED);
+  }
+  memset(ram_snapshot.dirty, 0, (size_t) pages);
+
+  if (! ram_snapshot.handler_installed) {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = ram_snapshot_fault;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGSEGV, &action, &ram_snapshot.old_action) < 0) {
+      BX_ERROR(("snapshot_ram: unable to install the write fault handler"));
+      return 0;
+    }
+    ram_snapshot.handler_installed = 1;
+  }
+
+  if (mprotect(BX_MEM_THIS vector, (size_t) BX_MEM_THIS mapped_len, PROT_READ) < 0) {
+    BX_ERROR(("snapshot_ram: unable to write protect guest RAM"));
+    return 0;
+  }
+  return 1;
+#else
+  BX_ERROR(("snapshot_ram: snapshots are not supported on this host"));
+  return 0;
+#endif
+}
+
+// The host kernel does not raise the write fault for a write protected page,
+// a read() or fread() into snapshot guest RAM fails with EFAULT instead. Host
+// writes to guest RAM that don't go through a CPU store (DMA, file loads)
+// save and unprotect the pages of the range first.
+void BX_MEMORY_STUB_C::prepare_host_write(Bit8u *hostAddr, Bit64u len)
+{
+#if BX_HAVE_SYS_MMAN_H
+  if (ram_snapshot.store == NULL || len == 0 || hostAddr + len <= ram_snapshot.vector ||
+      hostAddr >= ram_snapshot.vector + ram_snapshot.len)
+    return;
+
+  Bit64u first = (hostAddr < ram_snapshot.vector) ? 0 :
+      (Bit64u)(hostAddr - ram_snapshot.vector) / ram_snapshot.page_size;
+  Bit64u end = (Bit64u)(hostAddr + len - ram_snapshot.vector);
+  if (end > ram_snapshot.len) end = ram_snapshot.len;
+  Bit64u last = (end - 1) / ram_snapshot.page_size;
+  for (Bit64u page = first; page <= last; page++) {
+    // wait for another thread saving the same page
+    while (! ram_snapshot_save_page(page))
+      sched_yield();
+  }
+#endif
+}
+
+bool BX_MEMORY_STUB_C::revert_ram(void)
+{
+#if BX_HAVE_SYS_MMAN_H
+  if (ram_snapshot.store == NULL || ram_snapshot.vector != BX_MEM_THIS vector) {
+    BX_ERROR(("revert_ram: no snapshot of guest RAM"));
+    return 0;
+  }
+
+  Bit64u pages = (ram_snapshot.len + ram_snapshot.page_size - 1) / ram_snapshot.page_size;
+  Bit64u reverted = 0;
+
+  // the reverted guest pages differ from the last incremental checkpoint
+  if (pageWriteStampTable.dirtyLogEnabled()) {
+    Bit32u num_blocks = (Bit32u)(BX_MEM_THIS len / BX_MEM_THIS block_size);
+    for (Bit32u idx = 0; idx < num_blocks; idx++) {
+      Bit8u *block = BX_MEM_THIS blocks[idx];
+      // skips the unallocated and the swapped out blocks too
+      if (block < BX_MEM_THIS vector || block >= BX_MEM_THIS vector + ram_snapshot.len)
+        continue;
+      Bit64u offset = block - BX_MEM_THIS vector;
+      for (Bit32u n = 0; n < BX_MEM_THIS block_size; n += 4096) {
+        if (ram_snapshot.dirty[(offset + n) / ram_snapshot.page_size])
+          pageWriteStampTable.markDirty(bx_phy_address(idx) * BX_MEM_THIS block_size + n);
+      }
+    }
+  }
+
+  for (Bit64u page = 0; page < pages;) {
+    if (! ram_snapshot.dirty[page]) {
+      page++;
+      continue;
+    }
+    // copy back and write protect a run of saved pages at once
+    Bit64u first = page;
+    while (page < pages && ram_snapshot.dirty[page]) {
+      ram_snapshot.dirty[page] = BX_SNAPSHOT_PAGE_CLEAN;
+      page++;
+    }
+    Bit64u offset = first * ram_snapshot.page_size;
+    size_t size = (size_t)((page - first) * ram_snapshot.page_size);
+    memcpy(BX_MEM_THIS vector + offset, ram_snapshot.store + offset, size);
+    mprotect(BX_MEM_THIS vector + offset, size, PROT_READ);
+    reverted += page - first;
+  }
+  BX_DEBUG(("revert_ram: " FMT_LL "u pages reverted", reverted));
+  return 1;
+#else
+  BX_ERROR(("revert_ram: snapshots are not supported on this host"));
+  return 0;
+#endif
+}
+
 void BX_MEMORY_STUB_C::init_memory(Bit64u guest, Bit64u host, Bit32u block_size)
 {
   // accept only memory size which is multiply of 1M
@@ -109,18 +406,51 @@ void BX_MEMORY_STUB_C::init_memory(Bit64u guest, Bit64u host, Bit32u block_size)
   if (BX_MEM_THIS actual_vector != NULL) {
     BX_INFO(("freeing existing memory vector"));
     delete [] BX_MEM_THIS actual_vector;
+#if BX_HAVE_SYS_MMAN_H
+    if (BX_MEM_THIS mapped_len)
+      munmap(BX_MEM_THIS vector, (size_t) BX_MEM_THIS mapped_len);
+    free_ram_snapshot();
+#endif
+    BX_MEM_THIS mapped_len = 0;
     BX_MEM_THIS actual_vector = NULL;
     BX_MEM_THIS vector = NULL;
     BX_MEM_THIS blocks = NULL;
   }
-  BX_MEM_THIS vector = alloc_vector_aligned(host + BIOSROMSZ + EXROMSIZE + 4096, BX_MEM_VECTOR_ALIGN);
-  BX_INFO(("allocated memory at %p. after alignment, vector=%p, block_size = %dK",
-        BX_MEM_THIS actual_vector, BX_MEM_THIS vector, block_size/1024));
+
+  unsigned backing = SIM->get_param_enum(BXPN_MEM_BACKING)->get();
+#if BX_HAVE_SYS_MMAN_H
+  if (backing == BX_MEM_BACKING_FILE && SIM->get_param_string(BXPN_MEM_FILE)->isempty()) {
+    BX_PANIC(("memory: backing=file requires a guest RAM file"));
+    backing = BX_MEM_BACKING_MMAP;
+  }
+  if (backing != BX_MEM_BACKING_HEAP) {
+    // the host kernel pages mapped guest RAM, so all of it is mapped
+    host = guest;
+    BX_MEM_THIS vector = map_vector(guest, backing, SIM->get_param_string(BXPN_MEM_FILE)->getptr(),
+                                    SIM->get_param_bool(BXPN_MEM_HUGEPAGES)->get(),
+                                    SIM->get_param_bool(BXPN_MEM_OVERWRITE)->get());
+    BX_MEM_THIS mapped_len = guest;
+    BX_MEM_THIS rom = alloc_vector_aligned(BIOSROMSZ + EXROMSIZE + 4096, BX_MEM_VECTOR_ALIGN);
+    BX_INFO(("mapped guest RAM at %p (%s), block_size = %dK", BX_MEM_THIS vector,
+          (backing == BX_MEM_BACKING_FILE) ? SIM->get_param_string(BXPN_MEM_FILE)->getptr() : "anonymous",
+          block_size/1024));
+  }
+  else
+#else
+  if (backing != BX_MEM_BACKING_HEAP) {
+    BX_ERROR(("memory: mapped guest RAM is not supported on this host, using the heap"));
+  }
+#endif
+  {
+    BX_MEM_THIS vector = alloc_vector_aligned(host + BIOSROMSZ + EXROMSIZE + 4096, BX_MEM_VECTOR_ALIGN);
+    BX_MEM_THIS rom = &BX_MEM_THIS vector[host];
+    BX_INFO(("allocated memory at %p. after alignment, vector=%p, block_size = %dK",
+          BX_MEM_THIS actual_vector, BX_MEM_THIS vector, block_size/1024));
+  }
 
   BX_MEM_THIS len = guest;
   BX_MEM_THIS allocated = host;
-  BX_MEM_THIS rom   = &BX_MEM_THIS vector[host];
-  BX_MEM_THIS bogus = &BX_MEM_THIS vector[host + BIOSROMSZ + EXROMSIZE];
+  BX_MEM_THIS bogus = &BX_MEM_THIS rom[BIOSROMSZ + EXROMSIZE];
   memset(BX_MEM_THIS rom, 0xff, BIOSROMSZ + EXROMSIZE + 4096);
 
   BX_MEM_THIS block_size = block_size;
@@ -131,8 +461,8 @@ void BX_MEMORY_STUB_C::init_memory(Bit64u guest, Bit64u host, Bit32u block_size)
   BX_INFO(("%.2fMB", (float)(BX_MEM_THIS len / (1024.0*1024.0))));
   BX_INFO(("mem block size = 0x%08x, blocks=%u", BX_MEM_THIS block_size, num_blocks));
   BX_MEM_THIS blocks = new Bit8u* [num_blocks];
-  if (0) {
-    // all guest memory is allocated, just map it
+  if (BX_MEM_THIS mapped_len) {
+    // all guest memory is mapped, the host kernel populates it on demand
     for (unsigned idx = 0; idx < num_blocks; idx++) {
       BX_MEM_THIS blocks[idx] = BX_MEM_THIS vector + (idx * BX_MEM_THIS block_size);
     }
@@ -160,6 +490,17 @@ Bit8u* BX_MEMORY_STUB_C::get_vector(bx_phy_address addr)
   return BX_MEM_THIS blocks[block] + (Bit32u)(addr & (BX_MEM_THIS block_size-1));
 }
 
+// Returns true if guest RAM blocks can be swapped out to the overflow file,
+// which happens when less host memory than guest memory is allocated
+bool BX_MEMORY_STUB_C::blocks_can_swap(void)
+{
+#if BX_LARGE_RAMFILE
+  return !BX_MEM_THIS mapped_len && (BX_MEM_THIS allocated < BX_MEM_THIS len);
+#else
+  return 0;
+#endif
+}
+
 #if BX_LARGE_RAMFILE
 void BX_MEMORY_STUB_C::read_block(Bit32u block)
 {
@@ -179,6 +520,17 @@ void BX_MEMORY_STUB_C::allocate_block(Bit32u block)
 {
   const Bit32u max_blocks = (Bit32u)(BX_MEM_THIS allocated / BX_MEM_THIS block_size);
 
+  // get_vector() is called without the big emulator lock, another processor
+  // thread could have allocated the block meanwhile. Blocks are never swapped
+  // out with processor threads, see blocks_can_swap().
+  BX_SMP_DEVICE_LOCK();
+#if BX_LARGE_RAMFILE
+  if (BX_MEM_THIS blocks[block] && BX_MEM_THIS blocks[block] != BX_MEM_THIS swapped_out)
+#else
+  if (BX_MEM_THIS blocks[block])
+#endif
+    return;
+
 #if BX_LARGE_RAMFILE
   /*
    * Match block to vector address
@@ -247,6 +599,12 @@ void BX_MEMORY_STUB_C::cleanup_memory()
 {
   if (BX_MEM_THIS vector != NULL) {
     delete [] BX_MEM_THIS actual_vector;
+#if BX_HAVE_SYS_MMAN_H
+    if (BX_MEM_THIS mapped_len)
+      munmap(BX_MEM_THIS vector, (size_t) BX_MEM_THIS mapped_len);
+    free_ram_snapshot();
+#endif
+    BX_MEM_THIS mapped_len = 0;
     BX_MEM_THIS actual_vector = NULL;
     BX_MEM_THIS vector = NULL;
     BX_MEM_THIS rom = NULL;
@@ -296,6 +654,7 @@ bool BX_MEMORY_STUB_C::dbg_set_mem(BX_CPU_C *cpu, bx_phy_address addr, unsigned
 
   for (; len>0; len--) {
     *(BX_MEM_THIS get_vector(a20addr)) = *buf;
+    pageWriteStampTable.markDirty(a20addr);
     buf++;
     a20addr++;
   }
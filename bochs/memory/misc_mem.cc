@@ -70,6 +70,13 @@ void BX_MEM_C::init_memory(Bit64u guest, Bit64u host, Bit32u block_size)
   BX_MEM_THIS flash_status = 0x80;
   BX_MEM_THIS flash_wsm_state = FLASH_READ_ARRAY;
   BX_MEM_THIS flash_modified = false;
+  BX_MEM_THIS checkpoint_parent[0] = 0;
+  BX_MEM_THIS checkpoint_delta = false;
+  BX_MEM_THIS checkpoint_depth = 0;
+
+  // the dirty page log is only needed for the periodic checkpoints
+  if (SIM->get_param_num(BXPN_CHECKPOINT)->get() > 0)
+    pageWriteStampTable.enableDirtyLog(BX_MEM_THIS len);
 
   for (i = 0; i < 65; i++)
     BX_MEM_THIS rom_present[i] = false;
@@ -132,6 +139,20 @@ Bit64s memory_param_save_handler(void *devptr, bx_param_c *param)
       ret = BX_MEM_THIS save_flash_data(path);
     }
     return ret;
+  } else if (!strcmp(pname, "delta")) {
+    // decides if only the dirty pages of RAM are saved, "ram" follows
+    bx_param_c *ram = ((bx_list_c*) param->get_parent())->get_by_name("ram");
+    bool delta = false;
+    if (BX_MEM_THIS checkpoint_delta && !SIM->get_param_string(BXPN_RESTORE_PATH)->isempty()) {
+      delta = BX_MEM_THIS save_ram_delta(SIM->get_param_string(BXPN_RESTORE_PATH)->getptr());
+    }
+    // tells save_checkpoint() if the full RAM image was saved instead
+    BX_MEM_THIS checkpoint_delta = delta;
+    if (delta)
+      ram->set_options(ram->get_options() | bx_param_c::SAVE_SKIP);
+    else
+      ram->set_options(ram->get_options() & ~bx_param_c::SAVE_SKIP);
+    return delta;
   }
   return -1;
 }
@@ -170,6 +191,18 @@ void memory_param_restore_handler(void *devptr, bx_param_c *param, Bit64s val)
       sprintf(path, "%s/%s", SIM->get_param_string(BXPN_RESTORE_PATH)->getptr(), imgname);
       BX_MEM_THIS load_flash_data(path);
     }
+  } else if (!strcmp(pname, "delta")) {
+    if (SIM->get_param_string(BXPN_RESTORE_PATH)->isempty()) {
+      return;
+    }
+    const char *sr_path = SIM->get_param_string(BXPN_RESTORE_PATH)->getptr();
+    BX_MEM_THIS checkpoint_depth = 0;
+    if (val && !BX_MEM_THIS load_ram_image(sr_path)) {
+      BX_PANIC(("restore: failed to load the RAM of checkpoint '%s'", sr_path));
+    }
+    // the next incremental checkpoint is relative to the restored one
+    strncpy(BX_MEM_THIS checkpoint_parent, sr_path, BX_PATHNAME_LEN - 1);
+    BX_MEM_THIS checkpoint_parent[BX_PATHNAME_LEN - 1] = 0;
   }
 }
 
@@ -179,16 +212,24 @@ void BX_MEM_C::register_state()
 
   bx_list_c *list = new bx_list_c(SIM->get_bochs_root(), "memory", "Memory State");
   Bit32u num_blocks = (Bit32u)(BX_MEM_THIS len / BX_MEM_THIS block_size);
+  // must precede "ram", the RAM of an incremental checkpoint is in memory.dirty
+  bx_param_bool_c *delta = new bx_param_bool_c(list, "delta", "", "", false);
+  delta->set_sr_handlers(this, memory_param_save_handler, memory_param_restore_handler);
+  delta->set_options(bx_param_c::SNAPSHOT_SKIP);
 #if BX_LARGE_RAMFILE
   bx_shadow_filedata_c *ramfile = new bx_shadow_filedata_c(list, "ram", &(BX_MEM_THIS overflow_file));
   ramfile->set_sr_handlers(this, ramfile_save_handler, (filedata_restore_handler)NULL);
+  ramfile->set_options(bx_param_c::SNAPSHOT_SKIP);
   BXRS_DEC_PARAM_FIELD(list, next_swapout_idx, BX_MEM_THIS next_swapout_idx);
 #else
-  new bx_shadow_data_c(list, "ram", BX_MEM_THIS vector, BX_MEM_THIS allocated);
+  bx_shadow_data_c *ram = new bx_shadow_data_c(list, "ram", BX_MEM_THIS vector, BX_MEM_THIS allocated);
+  ram->set_options(bx_param_c::SNAPSHOT_SKIP);
 #endif
   BXRS_DEC_PARAM_FIELD(list, used_blocks, BX_MEM_THIS used_blocks);
 
+  // guest RAM is handled by snapshot_ram() / revert_ram()
   bx_list_c *mapping = new bx_list_c(list, "mapping");
+  mapping->set_options(bx_param_c::SNAPSHOT_SKIP);
   for (Bit32u blk=0; blk < num_blocks; blk++) {
     sprintf(param_name, "blk%d", blk);
     bx_param_num_c *param = new bx_param_num_c(mapping, param_name, "", "", -2, BX_MAX_BIT32U, 0);
@@ -211,6 +252,8 @@ void BX_MEM_C::register_state()
 
 void BX_MEM_C::cleanup_memory()
 {
+  pageWriteStampTable.disableDirtyLog();
+
   if (BX_MEM_THIS flash_modified) {
     bx_param_string_c *flash_data = SIM->get_param_string(BXPN_ROM_FLASH_DATA);
     if (!flash_data->isempty()) {
@@ -287,6 +330,224 @@ bool BX_MEM_C::save_flash_data(const char *path)
   return (fd >= 0);
 }
 
+// An incremental checkpoint stores the guest RAM pages written since the
+// previous (parent) checkpoint in memory.dirty instead of the full image in
+// memory.ram. Each page is preceded by its offset in the full image, which
+// is the guest address with BX_LARGE_RAMFILE (the image is the overflow file)
+// and the offset into the RAM vector otherwise. The chain of deltas is
+// bounded: the full image is saved again after BX_CHECKPOINT_MAX_DEPTH deltas
+// or when at least half of the pages are dirty.
+
+#define BX_RAM_DELTA_MAGIC "BXDELTA"
+#define BX_RAM_DELTA_PAGE  4096
+
+struct ram_delta_header_t {
+  char   magic[8];
+  Bit32u page_size;
+  Bit32u depth;         // number of deltas up to the full RAM image
+  Bit64u pages;         // number of pages following the header
+  Bit64u image_size;    // size of the full RAM image
+  char   parent[BX_PATHNAME_LEN];
+};
+
+bool BX_MEM_C::save_checkpoint(const char *path)
+{
+  Bit64u pages = BX_MEM_THIS len / BX_RAM_DELTA_PAGE;
+
+  // the first checkpoint of a session saves the full RAM image
+  BX_MEM_THIS checkpoint_delta = (BX_MEM_THIS checkpoint_parent[0] != 0) &&
+    (BX_MEM_THIS checkpoint_depth < BX_CHECKPOINT_MAX_DEPTH) &&
+    (pageWriteStampTable.countDirtyPages() < pages / 2);
+  bool ret = SIM->save_state(path);
+  if (ret) {
+    if (BX_MEM_THIS checkpoint_delta)
+      BX_MEM_THIS checkpoint_depth++;
+    else
+      BX_MEM_THIS checkpoint_depth = 0;
+    pageWriteStampTable.clearDirtyLog();
+    strncpy(BX_MEM_THIS checkpoint_parent, path, BX_PATHNAME_LEN - 1);
+    BX_MEM_THIS checkpoint_parent[BX_PATHNAME_LEN - 1] = 0;
+  }
+  BX_MEM_THIS checkpoint_delta = false;
+  return ret;
+}
+
+bool BX_MEM_C::save_ram_delta(const char *path)
+{
+  char fname[BX_PATHNAME_LEN+16];
+#if BX_LARGE_RAMFILE
+  Bit8u buffer[BX_RAM_DELTA_PAGE];
+#endif
+  ram_delta_header_t header;
+
+  sprintf(fname, "%s/memory.dirty", path);
+  FILE *fp = fopen(fname, "wb");
+  if (fp == NULL) {
+    BX_ERROR(("checkpoint: cannot create '%s'", fname));
+    return 0;
+  }
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, BX_RAM_DELTA_MAGIC, sizeof(header.magic));
+  header.page_size = BX_RAM_DELTA_PAGE;
+  header.depth = BX_MEM_THIS checkpoint_depth + 1;
+#if BX_LARGE_RAMFILE
+  header.image_size = BX_MEM_THIS len;
+#else
+  header.image_size = BX_MEM_THIS allocated;
+#endif
+  strcpy(header.parent, BX_MEM_THIS checkpoint_parent);
+  // the header is written again with the number of pages at the end
+  bool ok = (fwrite(&header, sizeof(header), 1, fp) == 1);
+
+  Bit64u pages = BX_MEM_THIS len / BX_RAM_DELTA_PAGE;
+  for (Bit64u page = 0; ok && page < pages; page++) {
+    if (! pageWriteStampTable.isPageDirty(page)) continue;
+
+    bx_phy_address addr = bx_phy_address(page) * BX_RAM_DELTA_PAGE;
+    Bit8u *block = BX_MEM_THIS blocks[addr / BX_MEM_THIS block_size];
+    Bit32u block_offset = (Bit32u)(addr & (BX_MEM_THIS block_size-1));
+    if (! block) continue;
+#if BX_LARGE_RAMFILE
+    Bit64u offset = addr;
+    const Bit8u *data = buffer;
+    if (block == BX_MEM_THIS swapped_out) {
+      ok = !fseeko64(BX_MEM_THIS overflow_file, addr, SEEK_SET) &&
+           fread(buffer, BX_RAM_DELTA_PAGE, 1, BX_MEM_THIS overflow_file) == 1;
+    } else {
+      data = block + block_offset;
+    }
+#else
+    Bit64u offset = (block - BX_MEM_THIS vector) + block_offset;
+    const Bit8u *data = block + block_offset;
+#endif
+    ok = ok && fwrite(&offset, sizeof(offset), 1, fp) == 1 &&
+               fwrite(data, BX_RAM_DELTA_PAGE, 1, fp) == 1;
+    header.pages++;
+  }
+
+  if (ok) {
+    ok = !fseek(fp, 0, SEEK_SET) && fwrite(&header, sizeof(header), 1, fp) == 1;
+  }
+  if (fclose(fp) != 0) ok = 0;
+  if (! ok) {
+    // a partial file would be taken for the RAM of this checkpoint
+    BX_ERROR(("checkpoint: failed to write '%s', saving the full RAM image", fname));
+    remove(fname);
+    return 0;
+  }
+
+  BX_INFO(("checkpoint '%s': " FMT_LL "u dirty pages of RAM saved", path, header.pages));
+  return 1;
+}
+
+// Loads the full RAM image of the root checkpoint and applies the pages of
+// all the incremental checkpoints from there to <path>, oldest first. The
+// depth stored in each delta must decrease along the chain, which bounds the
+// recursion even if the files refer to each other.
+bool BX_MEM_C::load_ram_image(const char *path, unsigned max_depth)
+{
+  char fname[BX_PATHNAME_LEN+16];
+  Bit8u buffer[BX_RAM_DELTA_PAGE];
+  ram_delta_header_t header;
+  Bit64u offset;
+
+#if BX_LARGE_RAMFILE
+  Bit64u image_size = BX_MEM_THIS len;
+#else
+  Bit64u image_size = BX_MEM_THIS allocated;
+#endif
+
+  sprintf(fname, "%s/memory.dirty", path);
+  FILE *fp = fopen(fname, "rb");
+  if (fp == NULL) {
+    // full checkpoint
+    sprintf(fname, "%s/memory.ram", path);
+    fp = fopen(fname, "rb");
+    if (fp == NULL) {
+      BX_ERROR(("restore: cannot open '%s'", fname));
+      return 0;
+    }
+    BX_INFO(("restoring '%s'", fname));
+#if BX_LARGE_RAMFILE
+    if (BX_MEM_THIS overflow_file == NULL) {
+      BX_MEM_THIS overflow_file = tmpfile64();
+      if (BX_MEM_THIS overflow_file == NULL)
+        BX_PANIC(("Unable to allocate memory overflow file"));
+    } else {
+      fseeko64(BX_MEM_THIS overflow_file, 0, SEEK_SET);
+    }
+    size_t chars;
+    Bit64u size = 0;
+    while ((chars = fread(buffer, 1, BX_RAM_DELTA_PAGE, fp)) > 0) {
+      if (fwrite(buffer, 1, chars, BX_MEM_THIS overflow_file) != chars) break;
+      size += chars;
+    }
+    fflush(BX_MEM_THIS overflow_file);
+#else
+    BX_MEM_THIS prepare_host_write(BX_MEM_THIS vector, image_size);
+    Bit64u size = fread(BX_MEM_THIS vector, 1, (size_t) image_size, fp);
+#endif
+    fclose(fp);
+    if (size != image_size) {
+      BX_ERROR(("restore: '%s' is truncated", fname));
+      return 0;
+    }
+    BX_MEM_THIS checkpoint_depth = 0;
+    return 1;
+  }
+
+  bool ok = (fread(&header, sizeof(header), 1, fp) == 1);
+  // the parent chain may be long, do not keep the files open meanwhile
+  fclose(fp);
+  if (!ok || memcmp(header.magic, BX_RAM_DELTA_MAGIC, sizeof(header.magic)) ||
+      header.page_size != BX_RAM_DELTA_PAGE || header.parent[0] == 0) {
+    BX_ERROR(("restore: '%s' is not a RAM delta file", fname));
+    return 0;
+  }
+  if (header.image_size != image_size) {
+    BX_ERROR(("restore: '%s' was saved with a different memory size", fname));
+    return 0;
+  }
+  header.parent[BX_PATHNAME_LEN - 1] = 0;
+  if (header.depth == 0 || header.depth > max_depth || !strcmp(header.parent, path)) {
+    BX_ERROR(("restore: '%s' has a broken checkpoint chain", fname));
+    return 0;
+  }
+  if (! BX_MEM_THIS load_ram_image(header.parent, header.depth - 1))
+    return 0;
+
+  BX_INFO(("restoring '%s'", fname));
+  fp = fopen(fname, "rb");
+  if (fp == NULL || fseek(fp, sizeof(header), SEEK_SET)) {
+    BX_ERROR(("restore: cannot open '%s'", fname));
+    if (fp) fclose(fp);
+    return 0;
+  }
+  for (Bit64u n = 0; ok && n < header.pages; n++) {
+    ok = fread(&offset, sizeof(offset), 1, fp) == 1 &&
+         fread(buffer, BX_RAM_DELTA_PAGE, 1, fp) == 1 &&
+         offset + BX_RAM_DELTA_PAGE <= image_size;
+    if (! ok) break;
+#if BX_LARGE_RAMFILE
+    ok = !fseeko64(BX_MEM_THIS overflow_file, offset, SEEK_SET) &&
+         fwrite(buffer, BX_RAM_DELTA_PAGE, 1, BX_MEM_THIS overflow_file) == 1;
+#else
+    memcpy(BX_MEM_THIS vector + offset, buffer, BX_RAM_DELTA_PAGE);
+#endif
+  }
+  fclose(fp);
+#if BX_LARGE_RAMFILE
+  fflush(BX_MEM_THIS overflow_file);
+#endif
+  if (! ok) {
+    BX_ERROR(("restore: '%s' is truncated or corrupted", fname));
+    return 0;
+  }
+  BX_MEM_THIS checkpoint_depth = header.depth;
+  return 1;
+}
+
 //
 // Values for type:
 //   0 : System Bios
@@ -497,6 +758,7 @@ void BX_MEM_C::load_RAM(const char *path, bx_phy_address ramaddress)
 
   offset = (unsigned long)ramaddress;
   while (size > 0) {
+    BX_MEM_THIS prepare_host_write(BX_MEM_THIS get_vector(offset), size);
     ret = read(fd, (bx_ptr_t) BX_MEM_THIS get_vector(offset), size);
     if (ret <= 0) {
       BX_PANIC(("RAM: read failed on RAM image: '%s'",path));
@@ -651,6 +913,7 @@ bool BX_MEM_C::dbg_set_mem(BX_CPU_C *cpu, bx_phy_address addr, unsigned len, Bit
       if (BX_MEM_THIS memory_type[area][1] == true) {
         // Write to ShadowRAM
         *(BX_MEM_THIS get_vector(a20addr)) = *buf;
+        pageWriteStampTable.markDirty(a20addr);
       } else {
         // Ignore write to ROM
       }
@@ -659,6 +922,7 @@ bool BX_MEM_C::dbg_set_mem(BX_CPU_C *cpu, bx_phy_address addr, unsigned len, Bit
     else if ((a20addr < 0x000c0000 || a20addr >= 0x00100000) && !is_bios)
     {
       *(BX_MEM_THIS get_vector(a20addr)) = *buf;
+      pageWriteStampTable.markDirty(a20addr);
     }
     buf++;
     a20addr++;
@@ -695,16 +959,21 @@ Bit8u *BX_MEM_C::getHostMemAddr(BX_CPU_C *cpu, bx_phy_address addr, unsigned rw)
   }
 #endif
 
-  struct memory_handler_struct *memory_handler = BX_MEM_THIS memory_handlers[a20addr >> 20];
-  while (memory_handler) {
-    if (memory_handler->begin <= a20addr &&
-        memory_handler->end >= a20addr) {
-      if (memory_handler->da_handler)
-        return memory_handler->da_handler(a20addr, rw, memory_handler->param);
-      else
-        return(NULL); // Vetoed! memory handler for i/o apic, vram, mmio and PCI PnP
+  if (BX_MEM_THIS memory_handlers[a20addr >> 20]) {
+    // the handlers are registered and called with the big emulator lock
+    // held, plain RAM is looked up without it
+    BX_SMP_DEVICE_LOCK();
+    struct memory_handler_struct *memory_handler = BX_MEM_THIS memory_handlers[a20addr >> 20];
+    while (memory_handler) {
+      if (memory_handler->begin <= a20addr &&
+          memory_handler->end >= a20addr) {
+        if (memory_handler->da_handler)
+          return memory_handler->da_handler(a20addr, rw, memory_handler->param);
+        else
+          return(NULL); // Vetoed! memory handler for i/o apic, vram, mmio and PCI PnP
+      }
+      memory_handler = memory_handler->next;
     }
-    memory_handler = memory_handler->next;
   }
 
   if (! write) {
@@ -30,6 +30,8 @@
 #define BXPN_BOCHS_START                 "general.start_mode"
 #define BXPN_BOCHS_BENCHMARK             "general.benchmark"
 #define BXPN_DUMP_STATS                  "general.dumpstats"
+#define BXPN_CHECKPOINT                  "general.checkpoint"
+#define BXPN_CHECKPOINT_PATH             "general.checkpoint_path"
 #define BXPN_RESTORE_FLAG                "general.restore"
 #define BXPN_RESTORE_PATH                "general.restore_path"
 #define BXPN_DEBUG_RUNNING               "general.debug_running"
@@ -43,16 +45,31 @@
 #define BXPN_CPU_EXCLUDE_FEATURES        "cpu.exclude_features"
 #define BXPN_IPS                         "cpu.ips"
 #define BXPN_SMP_QUANTUM                 "cpu.quantum"
+#define BXPN_SMP_THREADS                 "cpu.smp_threads"
 #define BXPN_RESET_ON_TRIPLE_FAULT       "cpu.reset_on_triple_fault"
 #define BXPN_IGNORE_BAD_MSRS             "cpu.ignore_bad_msrs"
 #define BXPN_CONFIGURABLE_MSRS_PATH      "cpu.msrs"
 #define BXPN_CPUID_LIMIT_WINNT           "cpu.cpuid_limit_winnt"
 #define BXPN_MWAIT_IS_NOP                "cpu.mwait_is_nop"
+#define BXPN_CPU_JIT                      "cpu.jit"
+#define BXPN_CPU_JIT_VERIFY               "cpu.jit_verify"
+#define BXPN_CPU_TRACE_LENGTH            "cpu.trace_length"
+#define BXPN_CPU_DECODE_AHEAD            "cpu.decode_ahead"
+#define BXPN_CPU_TRACE_CACHE_FILE        "cpu.trace_cache_file"
+#define BXPN_CPU_STATS                   "cpu.stats"
+#define BXPN_CPU_PROFILE                 "cpu.profile"
+#define BXPN_CPU_PROFILE_INTERVAL        "cpu.profile_interval"
 #define BXPN_BRAND_STRING                "cpu.brand_string"
 #define BXPN_MEMORY                      "memory.standard.ram"
 #define BXPN_MEM_SIZE                    "memory.standard.ram.guest"
 #define BXPN_HOST_MEM_SIZE               "memory.standard.ram.host"
 #define BXPN_MEM_BLOCK_SIZE              "memory.standard.ram.block_size"
+#define BXPN_MEM_BACKING                 "memory.standard.ram.backing"
+#define BXPN_MEM_FILE                    "memory.standard.ram.file"
+#define BXPN_MEM_OVERWRITE               "memory.standard.ram.overwrite"
+#define BXPN_MEM_HUGEPAGES               "memory.standard.ram.hugepages"
+#define BXPN_MEM_SNAPSHOTS               "memory.standard.ram.snapshots"
+#define BXPN_MEM_CLONES                  "memory.standard.ram.clones"
 #define BXPN_ROMIMAGE                    "memory.standard.rom"
 #define BXPN_ROM_PATH                    "memory.standard.rom.file"
 #define BXPN_ROM_ADDRESS                 "memory.standard.rom.address"
@@ -65,6 +82,7 @@
 #define BXPN_CLOCK_SYNC                  "clock_cmos.clock_sync"
 #define BXPN_CLOCK_TIME0                 "clock_cmos.time0"
 #define BXPN_CLOCK_RTC_SYNC              "clock_cmos.rtc_sync"
+#define BXPN_CLOCK_IDLE_SKIP             "clock_cmos.idle_skip"
 #define BXPN_CMOSIMAGE_ENABLED           "clock_cmos.cmosimage.enabled"
 #define BXPN_CMOSIMAGE_PATH              "clock_cmos.cmosimage.path"
 #define BXPN_CMOSIMAGE_RTC_INIT          "clock_cmos.cmosimage.rtc_init"
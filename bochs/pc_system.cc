@@ -38,6 +38,18 @@ double     m_ips; // Millions of Instructions Per Second
 
 const Bit64u bx_pc_system_c::NullTimerInterval = 0xffffffff;
 
+#if BX_ENABLE_STATISTICS
+// host time for the timer callback statistics
+static BX_CPP_INLINE Bit64u timer_host_usec(void)
+{
+#if BX_HAVE_REALTIME_USEC
+  return bx_get_realtime64_usec();
+#else
+  return 0;
+#endif
+}
+#endif
+
   // constructor
 bx_pc_system_c::bx_pc_system_c()
 {
@@ -45,30 +57,62 @@ bx_pc_system_c::bx_pc_system_c()
 
   BX_ASSERT(numTimers == 0);
 
+  maxTimers = BX_INITIAL_TIMERS;
+  timer = new bx_timer_t*[maxTimers];
+  memset(timer, 0, sizeof(bx_timer_t*) * maxTimers);
+  timerHeap = new unsigned[maxTimers];
+  heapSize = 0;
+
   // Timer[0] is the null timer.  It is initialized as a special
   // case here.  It should never be turned off or modified, and its
   // duration should always remain the same.
   ticksTotal = 0; // Reset ticks since emulator started.
-  timer[0].inUse      = 1;
-  timer[0].period     = NullTimerInterval;
-  timer[0].active     = 1;
-  timer[0].continuous = 1;
-  timer[0].funct      = nullTimer;
-  timer[0].this_ptr   = this;
+  timer[0] = new bx_timer_t;
+  memset(timer[0], 0, sizeof(bx_timer_t));
+  timer[0]->inUse      = 1;
+  timer[0]->period     = NullTimerInterval;
+  timer[0]->timeToFire = NullTimerInterval;
+  timer[0]->active     = 1;
+  timer[0]->continuous = 1;
+  timer[0]->funct      = nullTimer;
+  timer[0]->this_ptr   = this;
+  strcpy(timer[0]->id, "null");
   numTimers = 1; // So far, only the nullTimer.
+  heapInsert(0);
 }
 
 void bx_pc_system_c::initialize(Bit32u ips)
 {
   ticksTotal = 0;
-  timer[0].timeToFire = NullTimerInterval;
+  timer[0]->timeToFire = NullTimerInterval;
+  heapRebuild();
+#if BX_ENABLE_STATISTICS
+  // timers registered before the statistics tree was set up
+  for (unsigned i = 0; i < numTimers; i++) {
+    if (timer[i]->inUse)
+      registerTimerStats(i);
+  }
+#endif
   currCountdown       = NullTimerInterval;
   currCountdownPeriod = NullTimerInterval;
   lastTimeUsec = 0;
   usecSinceLast = 0;
   triggeredTimer = 0;
+#if BX_ENABLE_STATISTICS
+  timerStats = 0;
+#endif
   HRQ = 0;
   kill_bochs_request = 0;
+  snapshot_request = BX_SNAPSHOT_NONE;
+  snapshot_reverts = 0;
+  clone_id = 0;
+  checkpoint_request = 0;
+
+  idleSkip = SIM->get_param_bool(BXPN_CLOCK_IDLE_SKIP)->get();
+  idleSleep = idleSkip &&
+    (SIM->get_param_enum(BXPN_CLOCK_SYNC)->get() != BX_CLOCK_SYNC_NONE);
+  idleStartTicks = idleStartUsec = 0;
+  idleEndTicks = BX_MAX_BIT64U;
 
   // parameter 'ips' is the processor speed in Instructions-Per-Second
   m_ips = double(ips) / 1000000.0L;
@@ -79,8 +123,15 @@ void bx_pc_system_c::initialize(Bit32u ips)
 void bx_pc_system_c::set_HRQ(bool val)
 {
   HRQ = val;
-  if (val)
+  if (val) {
+#if BX_SUPPORT_SMP
+    if (bx_smp_is_remote_cpu(0)) {
+      BX_CPU(0)->smp_post_request(BX_SMP_REQ_ASYNC_EVENT);
+      return;
+    }
+#endif
     BX_CPU(0)->async_event = 1;
+  }
 }
 
 void bx_pc_system_c::raise_INTR(void)
@@ -174,14 +225,28 @@ bool bx_pc_system_c::get_enable_a20(void)
 
 void bx_pc_system_c::MemoryMappingChanged(void)
 {
-  for (unsigned i=0; i<BX_SMP_PROCESSORS; i++)
+  for (unsigned i=0; i<BX_SMP_PROCESSORS; i++) {
+#if BX_SUPPORT_SMP
+    if (bx_smp_is_remote_cpu(i)) {
+      BX_CPU(i)->smp_post_request(BX_SMP_REQ_TLB_FLUSH);
+      continue;
+    }
+#endif
     BX_CPU(i)->TLB_flush();
+  }
 }
 
 void bx_pc_system_c::invlpg(bx_address addr)
 {
-  for (unsigned i=0; i<BX_SMP_PROCESSORS; i++)
+  for (unsigned i=0; i<BX_SMP_PROCESSORS; i++) {
+#if BX_SUPPORT_SMP
+    if (bx_smp_is_remote_cpu(i)) {
+      BX_CPU(i)->smp_post_request(BX_SMP_REQ_TLB_INVLPG, 0, addr);
+      continue;
+    }
+#endif
     BX_CPU(i)->TLB_invlpg(addr);
+  }
 }
 
 int bx_pc_system_c::Reset(unsigned type)
@@ -189,6 +254,14 @@ int bx_pc_system_c::Reset(unsigned type)
   // type is BX_RESET_HARDWARE or BX_RESET_SOFTWARE
   BX_INFO(("bx_pc_system_c::Reset(%s) called",type==BX_RESET_HARDWARE?"HARDWARE":"SOFTWARE"));
 
+#if BX_SUPPORT_SMP
+  // processors simulated by host threads are reset between the rounds
+  if (bx_smp_threads_running) {
+    bx_smp_request_reset(type);
+    return(0);
+  }
+#endif
+
   set_enable_a20(1);
 
   // Always reset cpu
@@ -213,6 +286,7 @@ void bx_pc_system_c::exit(void)
 {
   // delete all registered timers (exception: null timer and APIC timer)
   numTimers = 1 + BX_SUPPORT_APIC;
+  heapRebuild();
   bx_devices.exit();
   if (bx_gui) {
     bx_gui->cleanup();
@@ -237,15 +311,21 @@ void bx_pc_system_c::register_state(void)
     char name[12];
     sprintf(name, "%u", i);
     bx_list_c *bxtimer = new bx_list_c(timers, name);
-    BXRS_PARAM_BOOL(bxtimer, inUse, timer[i].inUse);
-    BXRS_DEC_PARAM_FIELD(bxtimer, period, timer[i].period);
-    BXRS_DEC_PARAM_FIELD(bxtimer, timeToFire, timer[i].timeToFire);
-    BXRS_PARAM_BOOL(bxtimer, active, timer[i].active);
-    BXRS_PARAM_BOOL(bxtimer, continuous, timer[i].continuous);
-    BXRS_DEC_PARAM_FIELD(bxtimer, param, timer[i].param);
+    BXRS_PARAM_BOOL(bxtimer, inUse, timer[i]->inUse);
+    BXRS_DEC_PARAM_FIELD(bxtimer, period, timer[i]->period);
+    BXRS_DEC_PARAM_FIELD(bxtimer, timeToFire, timer[i]->timeToFire);
+    BXRS_PARAM_BOOL(bxtimer, active, timer[i]->active);
+    BXRS_PARAM_BOOL(bxtimer, continuous, timer[i]->continuous);
+    BXRS_DEC_PARAM_FIELD(bxtimer, param, timer[i]->param);
   }
 }
 
+void bx_pc_system_c::after_restore_state(void)
+{
+  // the times to fire and active flags were restored
+  heapRebuild();
+}
+
 // ================================================
 // Bochs internal timer delivery framework features
 // ================================================
@@ -274,14 +354,29 @@ int bx_pc_system_c::register_timer_ticks(void* this_ptr, bx_timer_handler_t func
 
   // search for new timer (i = 0 is reserved for NullTimer)
   for (i = 1; i < numTimers; i++) {
-    if (timer[i].inUse == 0)
+    if (timer[i]->inUse == 0)
       break;
   }
 
-  if (numTimers >= BX_MAX_TIMERS) {
-    BX_PANIC(("register_timer: too many registered timers"));
-    return -1;
+  if (i == maxTimers) {
+    if (maxTimers * 2 > BX_NULL_TIMER_HANDLE) {
+      BX_PANIC(("register_timer: too many registered timers"));
+      return -1;
+    }
+    // grow the timer table, the timers themselves stay in place
+    bx_timer_t **newTimer = new bx_timer_t*[maxTimers * 2];
+    memcpy(newTimer, timer, sizeof(bx_timer_t*) * maxTimers);
+    memset(newTimer + maxTimers, 0, sizeof(bx_timer_t*) * maxTimers);
+    unsigned *newHeap = new unsigned[maxTimers * 2];
+    memcpy(newHeap, timerHeap, sizeof(unsigned) * heapSize);
+    delete [] timer;
+    delete [] timerHeap;
+    timer = newTimer;
+    timerHeap = newHeap;
+    maxTimers *= 2;
   }
+  if (timer[i] == NULL)
+    timer[i] = new bx_timer_t;
 #if BX_TIMER_DEBUG
   if (this_ptr == NULL)
     BX_PANIC(("register_timer_ticks: this_ptr is NULL!"));
@@ -289,18 +384,27 @@ int bx_pc_system_c::register_timer_ticks(void* this_ptr, bx_timer_handler_t func
     BX_PANIC(("register_timer_ticks: funct is NULL!"));
 #endif
 
-  timer[i].inUse      = 1;
-  timer[i].period     = ticks;
-  timer[i].timeToFire = (ticksTotal + Bit64u(currCountdownPeriod-currCountdown)) + ticks;
-  timer[i].active     = active;
-  timer[i].continuous = continuous;
-  timer[i].funct      = funct;
-  timer[i].this_ptr   = this_ptr;
-  strncpy(timer[i].id, id, BxMaxTimerIDLen);
-  timer[i].id[BxMaxTimerIDLen-1] = 0; // Null terminate if not already.
-  timer[i].param      = 0;
+  timer[i]->inUse      = 1;
+  timer[i]->period     = ticks;
+  timer[i]->timeToFire = (ticksTotal + Bit64u(currCountdownPeriod-currCountdown)) + ticks;
+  timer[i]->active     = active;
+  timer[i]->continuous = continuous;
+  timer[i]->funct      = funct;
+  timer[i]->this_ptr   = this_ptr;
+  strncpy(timer[i]->id, id, BxMaxTimerIDLen);
+  timer[i]->id[BxMaxTimerIDLen-1] = 0; // Null terminate if not already.
+  timer[i]->param      = 0;
+
+  // If we didn't find a free slot, increment the bound, numTimers.
+  if (i==numTimers)
+    numTimers++; // One new timer installed.
+
+#if BX_ENABLE_STATISTICS
+  registerTimerStats(i);
+#endif
 
   if (active) {
+    heapInsert(i);
     if (ticks < Bit64u(currCountdown)) {
       // This new timer needs to fire before the current countdown.
       // Skew the current countdown and countdown period to be smaller
@@ -311,9 +415,6 @@ int bx_pc_system_c::register_timer_ticks(void* this_ptr, bx_timer_handler_t func
   }
 
   BX_DEBUG(("timer id %d registered for '%s'", i, id));
-  // If we didn't find a free slot, increment the bound, numTimers.
-  if (i==numTimers)
-    numTimers++; // One new timer installed.
 
   // Return timer id.
   return i;
@@ -321,9 +422,9 @@ int bx_pc_system_c::register_timer_ticks(void* this_ptr, bx_timer_handler_t func
 
 void bx_pc_system_c::countdownEvent(void)
 {
-  unsigned i, first = numTimers, last = 0;
-  Bit64u   minTimeToFire;
-  bool  triggered[BX_MAX_TIMERS];
+  // most of the time a single timer fires, the buffer is replaced by
+  // a table large enough for all the timers if needed
+  unsigned triggeredBuf[16], *triggered = triggeredBuf, numTriggered = 0;
 
   // The countdown decremented to 0.  We need to service all the active
   // timers, and invoke callbacks from those timers which have fired.
@@ -335,36 +436,33 @@ void bx_pc_system_c::countdownEvent(void)
   // Increment global ticks counter by number of ticks which have
   // elapsed since the last update.
   ticksTotal += Bit64u(currCountdownPeriod);
-  minTimeToFire = (Bit64u) -1;
 
-  for (i = 0; i < numTimers; i++) {
-    triggered[i] = 0; // Reset triggered flag.
-    if (timer[i].active) {
 #if BX_TIMER_DEBUG
-      if (ticksTotal > timer[i].timeToFire)
-        BX_PANIC(("countdownEvent: ticksTotal > timeToFire[%u], D " FMT_LL "u", i,
-                  timer[i].timeToFire-ticksTotal));
+  if (ticksTotal > timer[timerHeap[0]]->timeToFire)
+    BX_PANIC(("countdownEvent: ticksTotal > timeToFire[%u], D " FMT_LL "u", timerHeap[0],
+              timer[timerHeap[0]]->timeToFire-ticksTotal));
 #endif
-      if (ticksTotal == timer[i].timeToFire) {
-        // This timer is ready to fire.
-        triggered[i] = 1;
-
-        if (timer[i].continuous==0) {
-          // If triggered timer is one-shot, deactive.
-          timer[i].active = 0;
-        } else {
-          // Continuous timer, increment time-to-fire by period.
-          timer[i].timeToFire += timer[i].period;
-          if (timer[i].timeToFire < minTimeToFire)
-            minTimeToFire = timer[i].timeToFire;
-        }
-        if (i < first) first = i;
-        last = i;
-      } else {
-        // This timer is not ready to fire yet.
-        if (timer[i].timeToFire < minTimeToFire)
-          minTimeToFire = timer[i].timeToFire;
-      }
+
+  // The timers ready to fire are on the top of the heap, they come out
+  // in the order of their ids. The null timer is always active, so the
+  // heap is never empty.
+  while (timer[timerHeap[0]]->timeToFire == ticksTotal) {
+    unsigned i = timerHeap[0];
+
+    if (numTriggered == 16 && triggered == triggeredBuf) {
+      triggered = new unsigned[numTimers];
+      memcpy(triggered, triggeredBuf, sizeof(triggeredBuf));
+    }
+    triggered[numTriggered++] = i;
+
+    if (timer[i]->continuous==0) {
+      // If triggered timer is one-shot, deactive.
+      timer[i]->active = 0;
+      heapRemove(i);
+    } else {
+      // Continuous timer, increment time-to-fire by period.
+      timer[i]->timeToFire += timer[i]->period;
+      heapSiftDown(0);
     }
   }
 
@@ -372,19 +470,140 @@ void bx_pc_system_c::countdownEvent(void)
   // any of the callbacks, as they may call timer features, which need
   // to be advanced to the next countdown cycle.
   currCountdown = currCountdownPeriod =
-      Bit32u(minTimeToFire - ticksTotal);
+      Bit32u(timer[timerHeap[0]]->timeToFire - ticksTotal);
 
-  for (i = first; i <= last; i++) {
+  for (unsigned n = 0; n < numTriggered; n++) {
+    unsigned i = triggered[n];
     // Call requested timer function.  It may request a different
     // timer period or deactivate etc.
-    if (triggered[i] && (timer[i].funct != NULL)) {
+    if (timer[i]->funct != NULL) {
       triggeredTimer = i;
-      timer[i].funct(timer[i].this_ptr);
+#if BX_ENABLE_STATISTICS
+      if (timerStats) {
+        Bit64u start = timer_host_usec();
+        timer[i]->funct(timer[i]->this_ptr);
+        timer[i]->hostUsec += timer_host_usec() - start;
+      } else {
+        timer[i]->funct(timer[i]->this_ptr);
+      }
+      timer[i]->fired++;
+#else
+      timer[i]->funct(timer[i]->this_ptr);
+#endif
       triggeredTimer = 0;
     }
   }
+
+  if (triggered != triggeredBuf)
+    delete [] triggered;
+}
+
+void bx_pc_system_c::heapSiftUp(unsigned pos)
+{
+  unsigned i = timerHeap[pos];
+
+  while (pos > 0) {
+    unsigned parent = (pos - 1) / 2;
+    if (! heapBefore(i, timerHeap[parent])) break;
+    timerHeap[pos] = timerHeap[parent];
+    timer[timerHeap[pos]]->heapIndex = pos;
+    pos = parent;
+  }
+
+  timerHeap[pos] = i;
+  timer[i]->heapIndex = pos;
+}
+
+void bx_pc_system_c::heapSiftDown(unsigned pos)
+{
+  unsigned i = timerHeap[pos];
+
+  while (1) {
+    unsigned child = 2 * pos + 1;
+    if (child >= heapSize) break;
+    if (child + 1 < heapSize && heapBefore(timerHeap[child + 1], timerHeap[child]))
+      child++;
+    if (! heapBefore(timerHeap[child], i)) break;
+    timerHeap[pos] = timerHeap[child];
+    timer[timerHeap[pos]]->heapIndex = pos;
+    pos = child;
+  }
+
+  timerHeap[pos] = i;
+  timer[i]->heapIndex = pos;
+}
+
+void bx_pc_system_c::heapInsert(unsigned i)
+{
+  unsigned pos = heapSize++;
+  timerHeap[pos] = i;
+  heapSiftUp(pos);
+}
+
+void bx_pc_system_c::heapRemove(unsigned i)
+{
+  unsigned pos = timer[i]->heapIndex;
+  unsigned last = timerHeap[--heapSize];
+
+  if (pos != heapSize) {
+    // move the last timer into the hole
+    timerHeap[pos] = last;
+    timer[last]->heapIndex = pos;
+    heapUpdate(last);
+  }
+}
+
+// the time to fire of an active timer has changed
+void bx_pc_system_c::heapUpdate(unsigned i)
+{
+  unsigned pos = timer[i]->heapIndex;
+
+  if (pos > 0 && heapBefore(i, timerHeap[(pos - 1) / 2]))
+    heapSiftUp(pos);
+  else
+    heapSiftDown(pos);
+}
+
+void bx_pc_system_c::heapRebuild(void)
+{
+  heapSize = 0;
+  for (unsigned i = 0; i < numTimers; i++) {
+    if (timer[i]->active)
+      heapInsert(i);
+  }
+}
+
+#if BX_ENABLE_STATISTICS
+void bx_pc_system_c::timerStatsName(unsigned i, char *name, unsigned len)
+{
+  snprintf(name, len, "%s_%u", timer[i]->id, i);
+  for (; *name; name++) {
+    if (! isalnum(*name)) *name = '_';
+  }
 }
 
+// statistics.timers.<id>_<n>: callbacks and host time spent in them
+void bx_pc_system_c::registerTimerStats(unsigned i)
+{
+  bx_list_c *root = SIM->get_statistics_root();
+  if (root == NULL) return;
+
+  bx_list_c *timers = (bx_list_c*) root->get_by_name("timers");
+  if (timers == NULL)
+    timers = new bx_list_c(root, "timers", "Timers");
+
+  char name[BxMaxTimerIDLen + 16];
+  timerStatsName(i, name, sizeof(name));
+  timers->remove(name);
+
+  bx_list_c *list = new bx_list_c(timers, name, timer[i]->id);
+  timer[i]->fired = 0;
+  timer[i]->hostUsec = 0;
+  new bx_shadow_num_c(list, "fired", &timer[i]->fired);
+  new bx_shadow_num_c(list, "hostUsec", &timer[i]->hostUsec);
+}
+#endif
+
 void bx_pc_system_c::nullTimer(void* this_ptr)
 {
   // This function is always inserted in timer[0].  It is sort of
@@ -402,15 +621,28 @@ void bx_pc_system_c::nullTimer(void* this_ptr)
 #if SpewPeriodicTimerInfo
   BX_INFO(("==================================="));
   for (unsigned i=0; i < bx_pc_system.numTimers; i++) {
-    if (bx_pc_system.timer[i].active) {
+    if (bx_pc_system.timer[i]->active) {
       BX_INFO(("BxTimer(%s): period=" FMT_LL "u, continuous=%u",
-               bx_pc_system.timer[i].id, bx_pc_system.timer[i].period,
-               bx_pc_system.timer[i].continuous));
+               bx_pc_system.timer[i]->id, bx_pc_system.timer[i]->period,
+               bx_pc_system.timer[i]->continuous));
     }
   }
 #endif
 }
 
+void bx_pc_system_c::request_snapshot(unsigned request)
+{
+  snapshot_request = request;
+  // make the processors leave the cpu loop, the CPU threads check the
+  // request between the traces
+  for (unsigned n=0; n < BX_SMP_PROCESSORS; n++) {
+#if BX_SUPPORT_SMP
+    if (bx_smp_is_remote_cpu(n)) continue;
+#endif
+    BX_CPU(n)->async_event = 1;
+  }
+}
+
 void bx_pc_system_c::benchmarkTimer(void* this_ptr)
 {
   bx_pc_system_c *class_ptr = (bx_pc_system_c *) this_ptr;
@@ -427,6 +659,40 @@ void bx_pc_system_c::dumpStatsTimer(void* this_ptr)
 }
 #endif
 
+void bx_pc_system_c::checkpointTimer(void* this_ptr)
+{
+  bx_pc_system_c *class_ptr = (bx_pc_system_c *) this_ptr;
+  // the timer can fire in the middle of an instruction, the state is saved
+  // by bx_snapshot_process() once the processors left the cpu loop
+  class_ptr->checkpoint_request = 1;
+  if (class_ptr->snapshot_request == BX_SNAPSHOT_NONE)
+    class_ptr->request_snapshot(BX_SNAPSHOT_CHECKPOINT);
+}
+
+void bx_pc_system_c::save_checkpoint(void)
+{
+  static unsigned seq = 0;
+  char path[BX_PATHNAME_LEN+16];
+  const char *base = SIM->get_param_string(BXPN_CHECKPOINT_PATH)->getptr();
+
+  checkpoint_request = 0;
+
+  // never overwrite a checkpoint, it could be the parent of another one
+  do {
+    sprintf(path, "%s/%u", base, ++seq);
+#ifndef WIN32
+  } while (mkdir(path, 0755) < 0 && errno == EEXIST);
+#else
+  } while (!CreateDirectory(path, NULL) && GetLastError() == ERROR_ALREADY_EXISTS);
+#endif
+
+  if (BX_MEM(0)->save_checkpoint(path)) {
+    BX_INFO(("checkpoint saved to '%s' at tick " FMT_LL "u", path, time_ticks()));
+  } else {
+    BX_ERROR(("failed to save a checkpoint to '%s'", path));
+  }
+}
+
 #if BX_DEBUGGER
 void bx_pc_system_c::timebp_handler(void* this_ptr)
 {
@@ -471,16 +737,61 @@ Bit64u bx_pc_system_c::time_nsec()
 
 void bx_pc_system_c::start_timers(void) { }
 
+bool bx_pc_system_c::idle_skip(void)
+{
+  if (! idleSkip) return 0;
+
+  // DMA transfers proceed while the processors are halted
+  if (HRQ) return 0;
+
+  for (unsigned n=0; n < BX_SMP_PROCESSORS; n++) {
+    if (! BX_CPU(n)->isWaitingForEvent()) return 0;
+  }
+
+  Bit32u ticks = currCountdown;
+
+#if BX_HAVE_REALTIME_USEC
+  if (idleSleep) {
+    Bit64u now = time_ticks();
+    if (now != idleEndTicks) {
+      // the processors did something since the last skip
+      idleStartTicks = now;
+      idleStartUsec = bx_get_realtime64_usec();
+    }
+    Bit64u wakeup = idleStartUsec +
+      (Bit64u) (((double)(Bit64s)(now + ticks - idleStartTicks)) / m_ips);
+    // sleep in slices to stay responsive to a quit request
+    while (! kill_bochs_request) {
+      Bit64u usec = bx_get_realtime64_usec();
+      if (usec >= wakeup) break;
+      usec = BX_MIN(wakeup - usec, 100000);
+#if BX_HAVE_USLEEP
+      usleep((Bit32u) usec);
+#else
+      msleep((Bit32u) (usec + 999) / 1000);
+#endif
+    }
+    if (kill_bochs_request) return 1;
+  }
+#endif
+
+  tickn(ticks);
+  idleEndTicks = time_ticks();
+  return 1;
+}
+
 void bx_pc_system_c::activate_timer_ticks(unsigned i, Bit64u ticks, bool continuous)
 {
+  BX_SMP_DEVICE_LOCK();
+
 #if BX_TIMER_DEBUG
   if (i >= numTimers)
     BX_PANIC(("activate_timer_ticks: timer %u OOB", i));
   if (i == 0)
     BX_PANIC(("activate_timer_ticks: timer 0 is the NullTimer!"));
-  if (timer[i].period < MinAllowableTimerPeriod)
+  if (timer[i]->period < MinAllowableTimerPeriod)
     BX_PANIC(("activate_timer_ticks: timer[%u].period of " FMT_LL "u < min of %u",
-              i, timer[i].period, MinAllowableTimerPeriod));
+              i, timer[i]->period, MinAllowableTimerPeriod));
 #endif
 
   // If the timer frequency is rediculously low, make it more sane.
@@ -491,10 +802,15 @@ void bx_pc_system_c::activate_timer_ticks(unsigned i, Bit64u ticks, bool continu
     ticks = MinAllowableTimerPeriod;
   }
 
-  timer[i].period = ticks;
-  timer[i].timeToFire = (ticksTotal + Bit64u(currCountdownPeriod-currCountdown)) + ticks;
-  timer[i].active     = 1;
-  timer[i].continuous = continuous;
+  timer[i]->period = ticks;
+  timer[i]->timeToFire = (ticksTotal + Bit64u(currCountdownPeriod-currCountdown)) + ticks;
+  timer[i]->continuous = continuous;
+  if (timer[i]->active) {
+    heapUpdate(i);
+  } else {
+    timer[i]->active = 1;
+    heapInsert(i);
+  }
 
   if (ticks < Bit64u(currCountdown)) {
     // This new timer needs to fire before the current countdown.
@@ -519,7 +835,7 @@ void bx_pc_system_c::activate_timer(unsigned i, Bit32u useconds, bool continuous
   // if useconds = 0, use default stored in period field
   // else set new period from useconds
   if (useconds==0) {
-    ticks = timer[i].period;
+    ticks = timer[i]->period;
   } else {
     // convert useconds to number of ticks
     ticks = (Bit64u) (double(useconds) * m_ips);
@@ -530,7 +846,7 @@ void bx_pc_system_c::activate_timer(unsigned i, Bit32u useconds, bool continuous
       ticks = MinAllowableTimerPeriod;
     }
 
-    timer[i].period = ticks;
+    timer[i]->period = ticks;
   }
 
   activate_timer_ticks(i, ticks, continuous);
@@ -543,7 +859,7 @@ void bx_pc_system_c::activate_timer_nsec(unsigned i, Bit64u nseconds, bool conti
   // if nseconds = 0, use default stored in period field
   // else set new period from useconds
   if (nseconds==0) {
-    ticks = timer[i].period;
+    ticks = timer[i]->period;
   } else {
     // convert nseconds to number of ticks
     ticks = (Bit64u) (double(nseconds) * m_ips / 1000.0);
@@ -554,7 +870,7 @@ void bx_pc_system_c::activate_timer_nsec(unsigned i, Bit64u nseconds, bool conti
       ticks = MinAllowableTimerPeriod;
     }
 
-    timer[i].period = ticks;
+    timer[i]->period = ticks;
   }
 
   activate_timer_ticks(i, ticks, continuous);
@@ -562,6 +878,8 @@ void bx_pc_system_c::activate_timer_nsec(unsigned i, Bit64u nseconds, bool conti
 
 void bx_pc_system_c::deactivate_timer(unsigned i)
 {
+  BX_SMP_DEVICE_LOCK();
+
 #if BX_TIMER_DEBUG
   if (i >= numTimers)
     BX_PANIC(("deactivate_timer: timer %u OOB", i));
@@ -569,7 +887,10 @@ void bx_pc_system_c::deactivate_timer(unsigned i)
     BX_PANIC(("deactivate_timer: timer 0 is the nullTimer!"));
 #endif
 
-  timer[i].active = 0;
+  if (timer[i]->active) {
+    timer[i]->active = 0;
+    heapRemove(i);
+  }
 }
 
 bool bx_pc_system_c::unregisterTimer(unsigned timerIndex)
@@ -579,23 +900,32 @@ bool bx_pc_system_c::unregisterTimer(unsigned timerIndex)
     BX_PANIC(("unregisterTimer: timer %u OOB", timerIndex));
   if (timerIndex == 0)
     BX_PANIC(("unregisterTimer: timer 0 is the nullTimer!"));
-  if (timer[timerIndex].inUse == 0)
+  if (timer[timerIndex]->inUse == 0)
     BX_PANIC(("unregisterTimer: timer %u is not in-use!", timerIndex));
 #endif
 
-  if (timer[timerIndex].active) {
-    BX_PANIC(("unregisterTimer: timer '%s' is still active!", timer[timerIndex].id));
+  if (timer[timerIndex]->active) {
+    BX_PANIC(("unregisterTimer: timer '%s' is still active!", timer[timerIndex]->id));
     return 0; // Fail.
   }
 
   // Reset timer fields for good measure.
-  timer[timerIndex].inUse      = 0; // No longer registered.
-  timer[timerIndex].period     = BX_MAX_BIT64S; // Max value (invalid)
-  timer[timerIndex].timeToFire = BX_MAX_BIT64S; // Max value (invalid)
-  timer[timerIndex].continuous = 0;
-  timer[timerIndex].funct      = NULL;
-  timer[timerIndex].this_ptr   = NULL;
-  memset(timer[timerIndex].id, 0, BxMaxTimerIDLen);
+  timer[timerIndex]->inUse      = 0; // No longer registered.
+  timer[timerIndex]->period     = BX_MAX_BIT64S; // Max value (invalid)
+  timer[timerIndex]->timeToFire = BX_MAX_BIT64S; // Max value (invalid)
+  timer[timerIndex]->continuous = 0;
+  timer[timerIndex]->funct      = NULL;
+  timer[timerIndex]->this_ptr   = NULL;
+#if BX_ENABLE_STATISTICS
+  bx_list_c *timers = SIM->get_statistics_root() ?
+    (bx_list_c*) SIM->get_statistics_root()->get_by_name("timers") : NULL;
+  if (timers != NULL) {
+    char name[BxMaxTimerIDLen + 16];
+    timerStatsName(timerIndex, name, sizeof(name));
+    timers->remove(name);
+  }
+#endif
+  memset(timer[timerIndex]->id, 0, BxMaxTimerIDLen);
 
   if (timerIndex == (numTimers - 1)) numTimers--;
 
@@ -608,7 +938,7 @@ void bx_pc_system_c::setTimerParam(unsigned timerIndex, Bit32u param)
   if (timerIndex >= numTimers)
     BX_PANIC(("setTimerParam: timer %u OOB", timerIndex));
 #endif
-  timer[timerIndex].param = param;
+  timer[timerIndex]->param = param;
 }
 
 void bx_pc_system_c::isa_bus_delay(void)
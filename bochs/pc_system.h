@@ -23,9 +23,16 @@
 #ifndef BX_PCSYS_H
 #define BX_PCSYS_H
 
-#define BX_MAX_TIMERS 64
+// the timer table grows on demand, the timer ids stay below the null handle
+#define BX_INITIAL_TIMERS 64
 #define BX_NULL_TIMER_HANDLE 10000
 
+#define BX_SNAPSHOT_NONE    0
+#define BX_SNAPSHOT_SAVE    1
+#define BX_SNAPSHOT_REVERT  2
+#define BX_SNAPSHOT_FORK    3
+#define BX_SNAPSHOT_CHECKPOINT 4
+
 typedef void (*bx_timer_handler_t)(void *);
 
 BOCHSAPI extern class bx_pc_system_c bx_pc_system;
@@ -41,7 +48,7 @@ private:
   // Timer oriented private features
   // ===============================
 
-  struct {
+  struct bx_timer_t {
     bool inUse;      // Timer slot is in-use (currently registered).
     Bit64u  period;     // Timer periodocity in cpu ticks.
     Bit64u  timeToFire; // Time to fire next (in absolute ticks).
@@ -54,9 +61,36 @@ private:
 #define BxMaxTimerIDLen 32
     char id[BxMaxTimerIDLen];  // String ID of timer.
     Bit32u param;              // Device-specific value assigned to timer (optional)
-  } timer[BX_MAX_TIMERS];
+    unsigned heapIndex;        // Position in the heap of active timers.
+#if BX_ENABLE_STATISTICS
+    Bit64u fired;              // Number of callbacks.
+    Bit64u hostUsec;           // Host time spent in the callbacks (timerStats).
+#endif
+  } **timer;  // Allocated one by one, the save/restore params point to them.
 
+  unsigned   maxTimers;  // Size of the timer table.
   unsigned   numTimers;  // Number of currently allocated timers.
+
+  // The active timers are kept in a binary min-heap ordered by the time to
+  // fire (and the timer id, so timers firing together are called in the
+  // order of their ids). The root is the timer ending the countdown.
+  unsigned  *timerHeap;
+  unsigned   heapSize;
+
+  BX_CPP_INLINE bool heapBefore(unsigned a, unsigned b) const {
+    return (timer[a]->timeToFire < timer[b]->timeToFire) ||
+           (timer[a]->timeToFire == timer[b]->timeToFire && a < b);
+  }
+  void heapSiftUp(unsigned pos);
+  void heapSiftDown(unsigned pos);
+  void heapInsert(unsigned i);
+  void heapRemove(unsigned i);
+  void heapUpdate(unsigned i);
+  void heapRebuild(void);
+#if BX_ENABLE_STATISTICS
+  void timerStatsName(unsigned i, char *name, unsigned len);
+  void registerTimerStats(unsigned i);
+#endif
   unsigned   triggeredTimer;  // ID of the actually triggered timer.
   Bit32u     currCountdown; // Current countdown ticks value (decrements to 0).
   Bit32u     currCountdownPeriod; // Length of current countdown period.
@@ -64,6 +98,16 @@ private:
   Bit64u     lastTimeUsec; // Last sequentially read time in usec.
   Bit64u     usecSinceLast; // Number of useconds claimed since then.
 
+  // Idle time skipping: when all the processors are halted the time is
+  // advanced straight to the next timer event. With a clock synchronisation
+  // the host sleeps meanwhile, so the time of an idle period follows the
+  // host clock.
+  bool       idleSkip;
+  bool       idleSleep;
+  Bit64u     idleStartTicks; // Start of the current idle period.
+  Bit64u     idleStartUsec;  // Host time at the start of the idle period.
+  Bit64u     idleEndTicks;   // Time reached by the last skip.
+
   // A special null timer is always inserted in the timer[0] slot.  This
   // make sure that at least one timer is always active, and that the
   // duration is always less than a maximum 32-bit integer, so a 32-bit
@@ -101,7 +145,7 @@ public:
     return triggeredTimer;
   }
   Bit32u triggeredTimerParam(void) {
-    return timer[triggeredTimer].param;
+    return timer[triggeredTimer]->param;
   }
   static BX_CPP_INLINE void tick1(void) {
     if (--bx_pc_system.currCountdown == 0) {
@@ -124,6 +168,10 @@ public:
                            bool continuous, bool active, const char *id);
   void activate_timer_ticks(unsigned index, Bit64u instructions, bool continuous);
 
+  // advances the time to the next timer event if all the processors wait
+  // for an event, returns false if the time was not advanced
+  bool idle_skip(void);
+
   Bit64u time_usec();
   Bit64u time_nsec();
   Bit64u time_usec_sequential();
@@ -142,6 +190,7 @@ public:
 #if BX_ENABLE_STATISTICS
   static void dumpStatsTimer(void* this_ptr);
 #endif
+  static void checkpointTimer(void* this_ptr);
   void isa_bus_delay(void);
 
   // ===========================
@@ -167,6 +216,22 @@ public:
 
   volatile bool kill_bochs_request;
 
+#if BX_ENABLE_STATISTICS
+  // time the timer callbacks on the host, set by the cpu option stats=timers
+  bool timerStats;
+#endif
+
+  // in-memory snapshot request (BX_SNAPSHOT_xxx), processed by
+  // bx_snapshot_process() when the processors left the cpu loop
+  volatile unsigned snapshot_request;
+  Bit32u snapshot_reverts;  // number of reverts to the current snapshot
+  unsigned clone_id;        // number of the forked clone, 0 in the original process
+  void request_snapshot(unsigned request);
+  // periodic checkpoint posted by the checkpoint timer, saved together with
+  // the snapshot request so a pending guest request is not lost
+  volatile bool checkpoint_request;
+  void save_checkpoint(void);
+
   void set_HRQ(bool val);  // set the Hold ReQuest line
 
   void raise_INTR(void);
@@ -186,6 +251,7 @@ public:
   void    invlpg(bx_address addr);    // flush TLB page in all CPUs
   void    exit(void);
   void    register_state(void);
+  void    after_restore_state(void);
 };
 
 #define BX_TICK1()                  bx_pc_system.tick1()